@@ -1,5 +1,4 @@
 #version 450
-#define MAX_POINT_LIGHTS 256
 out vec4 FragColor; //The color of this fragment
 
 in vec2 UV;
@@ -7,17 +6,30 @@ in vec2 UV;
 uniform layout(binding = 0) sampler2D _gPositions;
 uniform layout(binding = 1) sampler2D _gNormals;
 uniform layout(binding = 2) sampler2D _gAlbedo;
-
-vec4 LightSpacePos;
-uniform mat4 _LightViewProj;
-
-uniform sampler2D _ShadowMap;
+uniform layout(binding = 4) sampler2D _gDepth;
+
+#include "gbuffer.glsl"
+//Compact G-buffer: no position texture, normals octahedral-encoded
+uniform bool _CompactGBuffer = false;
+uniform mat4 _InverseViewProjection;
+
+//Cascaded shadow map, one layer per slice of the view frustum (ew::fitShadowCascades)
+#define MAX_CASCADES 4 //ew::MAX_SHADOW_CASCADES
+uniform sampler2DArray _ShadowMap;
+uniform int _NumCascades;
+uniform float _CascadeSplits[MAX_CASCADES]; //View depth where each cascade ends
+uniform mat4 _CascadeViewProjections[MAX_CASCADES];
+uniform float _CascadeTexelSizes[MAX_CASCADES];
+uniform float _CascadeDepthRanges[MAX_CASCADES];
+uniform mat4 _View;
+uniform bool _ShowCascades = false;
 uniform vec3 _EyePos;
 uniform vec3 _LightDirection;
 uniform vec3 _LightColor = vec3(1.0);
 uniform vec3 _AmbientColor = vec3(0.3,0.4,0.46);
-uniform float _minBias = 0.02;
-uniform float _maxBias = 0.2;
+//In shadow texels, so the bias follows each cascade's resolution
+uniform float _minBias = 1.0;
+uniform float _maxBias = 4.0;
 
 struct PointLight{
 	vec3 position;
@@ -25,7 +37,23 @@ struct PointLight{
 	vec4 color;
 };
 
-uniform PointLight _PointLights[MAX_POINT_LIGHTS];
+//Point lights packed std430 by ew::LightBuffer
+layout(std430, binding = 1) readonly buffer PointLights{
+	PointLight _PointLights[];
+};
+uniform int _NumPointLights;
+
+//Per-tile light lists (ew::LightGridBuffer), used instead of looping every light when enabled
+layout(std430, binding = 2) readonly buffer TileLightCounts{
+	uint _TileLightCounts[];
+};
+layout(std430, binding = 3) readonly buffer TileLightIndices{
+	uint _TileLightIndices[];
+};
+uniform bool _UseTiledLights = false;
+uniform int _TileSize = 16;
+uniform int _TilesX;
+uniform int _MaxLightsPerTile;
 
 struct Material{
 	float Ka; //Ambient coefficient (0-1)
@@ -35,29 +63,46 @@ struct Material{
 };
 uniform Material _Material;
 
-float calcShadow(sampler2D shadowMap, vec4 lightSpacePos, float bias){
+//First cascade whose slice contains worldPos, or _NumCascades past the last one
+int selectCascade(vec3 worldPos){
+	float viewDepth = -(_View * vec4(worldPos, 1.0)).z;
+	for(int i = 0; i < _NumCascades; i++){
+		if(viewDepth < _CascadeSplits[i]){
+			return i;
+		}
+	}
+	return _NumCascades;
+}
+
+float calcShadow(sampler2DArray shadowMap, int cascade, vec3 worldPos, float biasTexels){
+	if(cascade >= _NumCascades){
+		return 0.0;
+	}
+	vec4 lightSpacePos = _CascadeViewProjections[cascade] * vec4(worldPos, 1.0);
 	//Homogeneous Clip space to NDC [-w,w] to [-1,1]
     vec3 sampleCoord = lightSpacePos.xyz / lightSpacePos.w;
     //Convert from [-1,1] to [0,1]
     sampleCoord = sampleCoord * 0.5 + 0.5;
+	//Orthographic depth is linear, so a world space bias is a fraction of the cascade's depth range
+	float bias = biasTexels * _CascadeTexelSizes[cascade] / _CascadeDepthRanges[cascade];
 	float myDepth = sampleCoord.z - bias; 
 
 	float totalShadow = 0;
 
-	vec2 texelOffset = 1.0 / textureSize(shadowMap,0);
+	vec2 texelOffset = 1.0 / textureSize(shadowMap,0).xy;
 	for(int y = -1; y <= 1; y++)
 	{
 		for(int x = -1; x <= 1; x++)
 		{
 			vec2 _uv = sampleCoord.xy + vec2(x * texelOffset.x, y * texelOffset.y);
-			totalShadow+=step(texture(shadowMap,_uv).r, myDepth);
+			totalShadow+=step(texture(shadowMap,vec3(_uv, cascade)).r, myDepth);
 		}
 	}
 
 	return totalShadow/=9.0;
 }
 
-vec3 CalcLight(vec3 normal, vec3 worldPos, vec3 albedo)
+vec3 CalcLight(vec3 normal, vec3 worldPos, vec3 albedo, int cascade)
 {
 	//Light pointing straight down
 	vec3 toLight = -_LightDirection;
@@ -73,7 +118,7 @@ vec3 CalcLight(vec3 normal, vec3 worldPos, vec3 albedo)
 
 	float bias = max(_maxBias * (1.0 - dot(normal,toLight)),_minBias);
 	//1: in shadow, 0: out of shadow
-	float shadow = calcShadow(_ShadowMap, LightSpacePos, bias); 
+	float shadow = calcShadow(_ShadowMap, cascade, worldPos, bias); 
 	return lightColor * (1.0 - shadow);
 	//light += _AmbientColor * _Material.Ka;
 }
@@ -108,18 +153,36 @@ void main(){
 	vec3 normal = texture(_gNormals,UV).xyz;
 	vec3 worldPos = texture(_gPositions,UV).xyz;
 	vec3 albedo = texture(_gAlbedo,UV).xyz;
+	if(_CompactGBuffer){
+		normal = octDecode(normal.xy);
+		worldPos = reconstructWorldPos(UV, texture(_gDepth,UV).r, _InverseViewProjection);
+	}
 	
 	vec3 light = vec3(0);
 
-	light += CalcLight(normal, worldPos, albedo);
-
-	//LightSpacePos = _LightViewProj * vec4(worldPos, 1);
+	int cascade = selectCascade(worldPos);
+	light += CalcLight(normal, worldPos, albedo, cascade);
 
-	for(int i = 0; i < MAX_POINT_LIGHTS; i++){
-		light += calcPointLight( _PointLights[i], normal, worldPos);
+	if(_UseTiledLights){
+		ivec2 tile = ivec2(gl_FragCoord.xy) / _TileSize;
+		int tileIndex = tile.y * _TilesX + tile.x;
+		uint count = _TileLightCounts[tileIndex];
+		for(uint i = 0; i < count; i++){
+			uint lightIndex = _TileLightIndices[tileIndex * _MaxLightsPerTile + i];
+			light += calcPointLight( _PointLights[lightIndex], normal, worldPos);
+		}
+	}
+	else{
+		for(int i = 0; i < _NumPointLights; i++){
+			light += calcPointLight( _PointLights[i], normal, worldPos);
+		}
 	}
 
 
+	if(_ShowCascades && cascade < _NumCascades){
+		const vec3 cascadeColors[4] = vec3[](vec3(1.0, 0.4, 0.4), vec3(0.4, 1.0, 0.4), vec3(0.4, 0.4, 1.0), vec3(1.0, 1.0, 0.4));
+		light *= cascadeColors[cascade];
+	}
 	FragColor = vec4(albedo * light,1.0);
 }
 
@@ -1,8 +1,12 @@
 #version 450
 layout (location = 0) in vec3 vPos;
+//Position dequantization for ew::VertexFormat::PACKED, set per draw by ew::Mesh (identity for full float meshes)
+layout(location = 7) in vec3 vPositionScale;
+layout(location = 8) in vec3 vPositionOffset;
 uniform mat4 _ViewProjection;
 uniform mat4 _Model;
 void main()
 {
-    gl_Position = _ViewProjection * _Model * vec4(vPos, 1.0);
+    vec3 pos = vPos * vPositionScale + vPositionOffset;
+    gl_Position = _ViewProjection * _Model * vec4(pos, 1.0);
 }  
@@ -0,0 +1,26 @@
+#version 450
+layout (location = 0) in vec3 vPos;
+//Position dequantization for ew::VertexFormat::PACKED, set per draw by ew::Mesh (identity for full float meshes)
+layout(location = 7) in vec3 vPositionScale;
+layout(location = 8) in vec3 vPositionOffset;
+//First instance of a multi-draw indirect command (ew::GeometryArena), 0 for single draws
+layout(location = 9) in uint vBaseInstance;
+
+//Per-instance model matrices (ew::InstanceBuffer)
+layout(std430, binding = 0) readonly buffer InstanceData{
+	mat4 _Models[];
+};
+//Visible instance ids from GPU culling (ew::GpuInstanceCuller), only read when _UseInstanceIds is set
+layout(std430, binding = 4) readonly buffer InstanceIds{
+	uint _InstanceIds[];
+};
+uniform bool _UseInstanceIds;
+//First instance of this draw, for draws over a slice of the buffer
+uniform int _InstanceOffset;
+uniform mat4 _ViewProjection;
+void main()
+{
+    vec3 pos = vPos * vPositionScale + vPositionOffset;
+    uint instance = _InstanceOffset + vBaseInstance + gl_InstanceID;
+    gl_Position = _ViewProjection * _Models[_UseInstanceIds ? _InstanceIds[instance] : instance] * vec4(pos, 1.0);
+}
@@ -0,0 +1,28 @@
+//gbuffer.glsl
+//Shared G-buffer encode/decode helpers. Pulled in with #include "gbuffer.glsl" (see ew::loadShaderSourceFromFile)
+//Compact layout: normals octahedral-encoded in RG16_SNORM, albedo in RGBA8, positions rebuilt from depth.
+
+vec2 signNotZero(vec2 v){
+	return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+//Maps a unit vector onto the octahedron, then unfolds the lower half so it fits in [-1,1]^2
+vec2 octEncode(vec3 n){
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signNotZero(n.xy);
+}
+
+vec3 octDecode(vec2 e){
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if(n.z < 0.0){
+		n.xy = (1.0 - abs(n.yx)) * signNotZero(n.xy);
+	}
+	return normalize(n);
+}
+
+//uv and depth are both [0,1], as sampled from the depth attachment
+vec3 reconstructWorldPos(vec2 uv, float depth, mat4 inverseViewProjection){
+	vec4 ndc = vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	vec4 worldPos = inverseViewProjection * ndc;
+	return worldPos.xyz / worldPos.w;
+}
@@ -4,6 +4,8 @@ layout(location = 0) out vec3 gPosition; //Worldspace position
 layout(location = 1) out vec3 gNormal; //Worldspace normal 
 layout(location = 2) out vec3 gAlbedo;
 
+#include "gbuffer.glsl"
+
 in Surface{
 	vec3 WorldPos; 
 	vec3 WorldNormal;
@@ -11,8 +13,13 @@ in Surface{
 }fs_in;
 
 uniform sampler2D _MainTex;
+//Compact G-buffer has no position attachment and stores octahedral normals in RG
+uniform bool _CompactGBuffer = false;
 void main(){
 	gPosition = fs_in.WorldPos;
 	gAlbedo = texture(_MainTex,fs_in.TexCoord).rgb;
 	gNormal = normalize(fs_in.WorldNormal);
+	if(_CompactGBuffer){
+		gNormal = vec3(octEncode(gNormal),0.0);
+	}
 }
@@ -3,12 +3,12 @@
 layout(location = 0) in vec3 vPos;
 layout(location = 1) in vec3 vNormal;
 layout(location = 2) in vec2 vTexCoord;
+//Position dequantization for ew::VertexFormat::PACKED, set per draw by ew::Mesh (identity for full float meshes)
+layout(location = 7) in vec3 vPositionScale;
+layout(location = 8) in vec3 vPositionOffset;
 
 uniform mat4 _Model; 
 uniform mat4 _ViewProjection;
-uniform mat4 _LightViewProj;
-
-out vec4 LightSpacePos;
 
 out Surface{
 	vec3 WorldPos; //Vertex position in world space
@@ -17,13 +17,13 @@ out Surface{
 }vs_out;
 
 void main(){
+	vec3 pos = vPos * vPositionScale + vPositionOffset;
 	//Transform vertex position to World Space.
-	vs_out.WorldPos = vec3(_Model * vec4(vPos,1.0));
+	vs_out.WorldPos = vec3(_Model * vec4(pos,1.0));
 	//Transform vertex normal to world space using Normal Matrix
 	vs_out.WorldNormal = transpose(inverse(mat3(_Model))) * vNormal;
 	vs_out.TexCoord = vTexCoord;
-	LightSpacePos = _LightViewProj * _Model * vec4(vPos,1);
 
-	gl_Position = _ViewProjection * _Model * vec4(vPos,1);
+	gl_Position = _ViewProjection * _Model * vec4(pos,1);
 }
 
@@ -0,0 +1,42 @@
+#version 450
+//Vertex attributes
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 2) in vec2 vTexCoord;
+//Position dequantization for ew::VertexFormat::PACKED, set per draw by ew::Mesh (identity for full float meshes)
+layout(location = 7) in vec3 vPositionScale;
+layout(location = 8) in vec3 vPositionOffset;
+//First instance of a multi-draw indirect command (ew::GeometryArena), 0 for single draws
+layout(location = 9) in uint vBaseInstance;
+
+//Per-instance model matrices (ew::InstanceBuffer)
+layout(std430, binding = 0) readonly buffer InstanceData{
+	mat4 _Models[];
+};
+//Visible instance ids from GPU culling (ew::GpuInstanceCuller), only read when _UseInstanceIds is set
+layout(std430, binding = 4) readonly buffer InstanceIds{
+	uint _InstanceIds[];
+};
+uniform bool _UseInstanceIds;
+//First instance of this draw, for draws over a slice of the buffer
+uniform int _InstanceOffset;
+uniform mat4 _ViewProjection;
+
+out Surface{
+	vec3 WorldPos; //Vertex position in world space
+	vec3 WorldNormal; //Vertex normal in world space
+	vec2 TexCoord;
+}vs_out;
+
+void main(){
+	vec3 pos = vPos * vPositionScale + vPositionOffset;
+	uint instance = _InstanceOffset + vBaseInstance + gl_InstanceID;
+	mat4 model = _Models[_UseInstanceIds ? _InstanceIds[instance] : instance];
+	//Transform vertex position to World Space.
+	vs_out.WorldPos = vec3(model * vec4(pos,1.0));
+	//Transform vertex normal to world space using Normal Matrix
+	vs_out.WorldNormal = transpose(inverse(mat3(model))) * vNormal;
+	vs_out.TexCoord = vTexCoord;
+
+	gl_Position = _ViewProjection * vec4(vs_out.WorldPos,1);
+}
@@ -2,8 +2,8 @@
 #version 450 core
 out vec4 FragColor;
 
-uniform vec3 _Color;
+flat in vec3 Color;
 
 void main(){
-	FragColor = vec4(_Color,1.0);
+	FragColor = vec4(Color,1.0);
 }
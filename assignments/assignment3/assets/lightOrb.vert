@@ -3,9 +3,23 @@
 //Vertex attributes
 layout(location = 0) in vec3 vPos;
 
-uniform mat4 _Model; 
+//One orb per point light, drawn instanced
+struct PointLight{
+	vec3 position;
+	float radius;
+	vec4 color;
+};
+layout(std430, binding = 1) readonly buffer PointLights{
+	PointLight _PointLights[];
+};
+
 uniform mat4 _ViewProjection;
+uniform float _OrbRadius = 0.2;
+
+flat out vec3 Color;
 
 void main(){
-	gl_Position = _ViewProjection * _Model * vec4(vPos,1.0);
+	PointLight light = _PointLights[gl_InstanceID];
+	Color = light.color.rgb;
+	gl_Position = _ViewProjection * vec4(light.position + vPos * _OrbRadius,1.0);
 }
@@ -0,0 +1,72 @@
+#version 450
+//Shades only the pixels covered by one point light volume. Blended additively over the directional pass.
+out vec4 FragColor;
+
+flat in int LightIndex;
+
+uniform layout(binding = 0) sampler2D _gPositions;
+uniform layout(binding = 1) sampler2D _gNormals;
+uniform layout(binding = 2) sampler2D _gAlbedo;
+uniform layout(binding = 4) sampler2D _gDepth;
+
+#include "gbuffer.glsl"
+//Compact G-buffer: no position texture, normals octahedral-encoded
+uniform bool _CompactGBuffer = false;
+uniform mat4 _InverseViewProjection;
+
+uniform vec3 _EyePos;
+
+struct PointLight{
+	vec3 position;
+	float radius;
+	vec4 color;
+};
+layout(std430, binding = 1) readonly buffer PointLights{
+	PointLight _PointLights[];
+};
+
+struct Material{
+	float Ka; //Ambient coefficient (0-1)
+	float Kd; //Diffuse coefficient (0-1)
+	float Ks; //Specular coefficient (0-1)
+	float Shininess; //Affects size of specular highlight
+};
+uniform Material _Material;
+
+float attenuate( float d, float radius){
+	float i = clamp(1.0 - pow(d/radius,4.0),0.0,1.0);
+	return i * i;
+}
+
+vec3 calcPointLight(PointLight light, vec3 normal, vec3 pos){
+	vec3 diff = light.position - pos;
+	//Direction toward light position
+	vec3 toLight = normalize(diff);
+
+	float diffuseFactor = max(dot(normal,toLight),0.0);
+	//Calculate specularly reflected light
+	vec3 toEye = normalize(_EyePos - pos);
+	//Blinn-phong uses half angle
+	vec3 h = normalize(toLight + toEye);
+	float specularFactor = pow(max(dot(normal,h),0.0),_Material.Shininess);
+
+	vec3 lightColor = (diffuseFactor + specularFactor) * light.color.rgb;
+	//Attenuation
+	float d = length(diff); //Distance to light
+	lightColor *= attenuate( d, light.radius);
+	return lightColor;
+}
+
+void main(){
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec3 normal = texelFetch(_gNormals,pixel,0).xyz;
+	vec3 worldPos = texelFetch(_gPositions,pixel,0).xyz;
+	vec3 albedo = texelFetch(_gAlbedo,pixel,0).xyz;
+	if(_CompactGBuffer){
+		normal = octDecode(normal.xy);
+		vec2 uv = (vec2(pixel) + 0.5) / vec2(textureSize(_gDepth,0));
+		worldPos = reconstructWorldPos(uv, texelFetch(_gDepth,pixel,0).r, _InverseViewProjection);
+	}
+
+	FragColor = vec4(albedo * calcPointLight(_PointLights[LightIndex], normal, worldPos),1.0);
+}
@@ -0,0 +1,25 @@
+#version 450
+//Point light volume: the unit sphere mesh scaled to each light's radius, one instance per light
+layout(location = 0) in vec3 vPos;
+
+struct PointLight{
+	vec3 position;
+	float radius;
+	vec4 color;
+};
+layout(std430, binding = 1) readonly buffer PointLights{
+	PointLight _PointLights[];
+};
+
+uniform mat4 _ViewProjection;
+//Pushes the faceted sphere out far enough to contain the true sphere
+uniform float _VolumeScale = 1.0;
+
+flat out int LightIndex;
+
+void main(){
+	PointLight light = _PointLights[gl_InstanceID];
+	LightIndex = gl_InstanceID;
+	vec3 worldPos = light.position + vPos * light.radius * _VolumeScale;
+	gl_Position = _ViewProjection * vec4(worldPos,1.0);
+}
@@ -8,277 +8,39 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
-#include <ew/shader.h>
-#include <ew/model.h>
-#include <ew/camera.h>
-#include <ew/transform.h>
 #include <ew/cameraController.h>
-#include <ew/texture.h>
 
-#include <ew/procGen.h>
+#include "scene.h"
 
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 GLFWwindow* initWindow(const char* title, int width, int height);
-void drawUI();
+void drawUI(const ew::Terrain& terrain, const ew::ShaderBatch& shaderBatch);
+void drawProfilerUI();
 
 //Global state
-int screenWidth = 1080;
-int screenHeight = 720;
 float prevFrameTime;
 float deltaTime;
 
-ew::Camera camera;
-ew::Transform monkeyTransform, planeTransform;
 ew::CameraController cameraController;
 
-struct Material {
-	float Ka = 1.0;
-	float Kd = 0.5;
-	float Ks = 0.5;
-	float Shininess = 128;
-}material;
-
-struct Framebuffer {
-	unsigned int fbo;
-	unsigned int colorBuffer[8];
-	unsigned int depthBuffer;
-	unsigned int width;
-	unsigned int height;
-}framebuffer;
-
-Framebuffer gBuffer;
-
-struct ShadowMap {
-	unsigned int fbo;
-	unsigned int depthBuffer;
-	unsigned int width;
-	unsigned int height;
-}shadowMap;
-
-struct Light {
-	glm::vec3 direction = glm::vec3(0,-1,0);
-	glm::vec3 color;
-}light;
-
-struct Shadow {
-	float minBias = .06f;
-	float maxBias = .2f;
-}shadow;
-
-struct ShadowCamera {
-
-	glm::vec3 target = glm::vec3(0.0f, 0.0f, 0.0f);
-
-	float nearPlane = 0.01f;
-	float farPlane = 25.0f;
-	float orthoHeight = 5.0f;
-	float aspectRatio = 1;
-
-	inline glm::vec3 position()const {
-		return target - light.direction * 5.f;
-	}
-
-	inline glm::mat4 lightView()const {
-		glm::vec3 toTarget = glm::normalize(target - position());
-		glm::vec3 up = glm::vec3(0, 1, 0);
-		//If camera is aligned with up vector, choose a new one
-		if (glm::abs(glm::dot(toTarget, up)) >= 1.0f - glm::epsilon<float>()) {
-			up = glm::vec3(0, 0, 1);
-		}
-		return glm::lookAt(position(), target, up);
-	}
-	inline glm::mat4 lightProj()const 
-	{
-		float width = orthoHeight * aspectRatio;
-		float r = width / 2;
-		float l = -r;
-		float t = orthoHeight / 2;
-		float b = -t;
-		return glm::ortho(l, r, b, t, nearPlane, farPlane);
-	}
-
-}shadowCamera;
-
-struct PointLight {
-	glm::vec3 position;
-	float radius;
-	glm::vec4 color;
-};
-const int MAX_POINT_LIGHTS = 256;
-PointLight pointLights[MAX_POINT_LIGHTS];
-
-void createPointLights() {
-	float scalar = 4.5;
-	int index = 0;
-	for (int i = -8; i < 8; i++, index++)
-	{
-		for (int j = -8; j < 8; j++, index++)
-		{
-			glm::vec3 position = glm::vec3(i * scalar + (0.5 * scalar), 0, j * scalar + (0.5 * scalar));
-			pointLights[index].position = position;
-			pointLights[index].color = glm::vec4(rand() % 2, rand() % 2, rand() % 2, 1);
-			pointLights[index].radius = 10;
-		}
-	}
-}
-
-Framebuffer createFrameBuffer(unsigned int width, unsigned int height, int colorFormat)
-{
-	framebuffer.width = width;
-	framebuffer.height = height;
-
-	//create Framebuffer Object
-	glCreateFramebuffers(1, &framebuffer.fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
-	//Create Color Buffer
-	glGenTextures(1, &framebuffer.colorBuffer[0]);
-	glBindTexture(GL_TEXTURE_2D, framebuffer.colorBuffer[0]);
-	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, framebuffer.width, framebuffer.height);
-	//Attach color buffer to framebuffer
-	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, framebuffer.colorBuffer[0], 0);
-
-	glGenTextures(1, &framebuffer.depthBuffer);
-	glBindTexture(GL_TEXTURE_2D, framebuffer.depthBuffer);
-	//Create depth buffer
-	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT16, framebuffer.width, framebuffer.height);
-	//Attach to framebuffer
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, framebuffer.depthBuffer, 0);
-
-	GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
-		printf("Framebuffer incomplete: %d", fboStatus);
-	}
-
-	return framebuffer;
-}
-
-ShadowMap createShadowMap(unsigned int width, unsigned int height , unsigned int* dummyVAO)
-{
-	shadowMap.width = width;
-	shadowMap.height = height;
-
-	glCreateFramebuffers(1, &shadowMap.fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowMap.fbo);
-	glGenTextures(1, &shadowMap.depthBuffer);
-	glBindTexture(GL_TEXTURE_2D, shadowMap.depthBuffer);
-	//16 bit depth values, 2k resolution 
-	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT16, 2048, 2048);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	//Pixels outside of frustum should have max distance (white)
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	float borderColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMap.depthBuffer, 0);
-
-	glCreateVertexArrays(1, dummyVAO);
-
-	glDrawBuffer(GL_NONE);
-	glReadBuffer(GL_NONE);
-
-	return shadowMap;
-}
-
-Framebuffer createGBuffer(unsigned int width, unsigned int height) 
-{
-	Framebuffer framebuffer;
-
-	framebuffer.width = width;
-	framebuffer.height = height;
-
-	glCreateFramebuffers( 1, &framebuffer.fbo);
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
-
-	int formats[3] = {
-		GL_RGB32F, //world Pos
-		GL_RGB16F, //world norm
-		GL_RGB16F  //albedo
-	};
-
-	//create 3 color textures
-	for (size_t i = 0; i < 3; i++) 
-	{
-		glGenTextures( 1, &framebuffer.colorBuffer[i]);
-		glBindTexture(GL_TEXTURE_2D, framebuffer.colorBuffer[i]);
-		glTexStorage2D(GL_TEXTURE_2D, 1, formats[i], width, height);
-
-		//prevent wrapping by clamping
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, framebuffer.colorBuffer[i], 0);
-	}
-	//tell gl what color attatchments we'll draw to
-	const GLenum drawBuffers[3] = {
-		GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2
-	};
-	glDrawBuffers(3, drawBuffers);
-
-	glGenTextures(1, &framebuffer.depthBuffer);
-	glBindTexture(GL_TEXTURE_2D, framebuffer.depthBuffer);
-	//Create depth buffer
-	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT16, framebuffer.width, framebuffer.height);
-	//Attach to framebuffer
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, framebuffer.depthBuffer, 0);
-
-	GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
-		printf("Framebuffer incomplete: %d", fboStatus);
-	}
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-
-	return framebuffer;
-}
-
-void drawScene(ew::Model monkeyModel, ew::Mesh planeMesh, ew::Shader &shader);
-
-
 int main() {
 	GLFWwindow* window = initWindow("Assignment 2", screenWidth, screenHeight);
 	glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+	gpuProfiler.create();
 
-	ew::Shader litShader = ew::Shader("assets/lit.vert", "assets/lit.frag");
-	ew::Shader blurShader = ew::Shader("assets/blur.vert", "assets/blur.frag");
-	ew::Shader depthOnlyShader = ew::Shader("assets/depthOnly.vert", "assets/depthOnly.frag");
-	ew::Shader geoShader = ew::Shader("assets/geo.vert", "assets/geo.frag");
-	ew::Shader defferedShader = ew::Shader("assets/deferredLit.vert", "assets/deferredLit.frag");
-	ew::Shader lightOrbShader = ew::Shader("assets/lightOrb.vert", "assets/lightOrb.frag");
-	ew::Model monkeyModel = ew::Model("assets/suzanne.obj");
-	GLuint rockTexture = ew::loadTexture("assets/Rock037_2K-PNG/Rock037_2K-PNG_Color.png");
-	ew::Mesh planeMesh = ew::Mesh(ew::createPlane(10, 10, 5));
-
-	planeTransform.position.y += -1;
-	//planeTransform.scale *= 100;
+	//The driver compiles every program at once, in the background where it can, while the scene loads
+	ew::setShaderCompilerThreads(glfwGetProcAddress, 0xFFFFFFFF);
+	ew::ShaderBatch shaderBatch;
+	addSceneShaders(shaderBatch);
+	shaderBatch.submit();
+	Scene scene(shaderBatch);
 
 	camera.position = glm::vec3(0.0f, 0.0f, 5.0f);
 	camera.target = glm::vec3(0.0f, 0.0f, 0.0f); //Look at the center of the scene
 	camera.aspectRatio = (float)screenWidth / screenHeight;
 	camera.fov = 60.0f; //Vertical field of view, in degrees
 
-	unsigned int dummyVAO;
-
-	createPointLights();
-	ew::Mesh sphereMesh = ew::Mesh(ew::createSphere(1.0f, 8));
-	
-	gBuffer = createGBuffer(screenWidth, screenHeight);
-	createFrameBuffer(screenWidth, screenHeight, 0);//idk what color format is yet
-	createShadowMap(2048, 2048, &dummyVAO);
-
-	glEnable(GL_CULL_FACE);
-	glEnable(GL_DEPTH_TEST); //Depth testing
-
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
 	while (!glfwWindowShouldClose(window)) {
 		glfwPollEvents();
 
@@ -286,116 +48,16 @@ int main() {
 		deltaTime = time - prevFrameTime;
 		prevFrameTime = time;
 
-		//rotate monkey
-		//monkeyTransform.rotation = glm::rotate(monkeyTransform.rotation, deltaTime, glm::vec3(0.0, 1.0, 0.0));
+		gpuProfiler.beginFrame();
 		//camera controls
 		cameraController.move(window, &camera, deltaTime);
+		scene.update(time);
+		scene.render(0);
 
-		glm::mat4 lightViewProjection = shadowCamera.lightProj() * shadowCamera.lightView(); //Based on light type, direction
-
-		//ShadowMap Pass
-
-		glBindFramebuffer(GL_FRAMEBUFFER, shadowMap.fbo);
-		glViewport(0, 0, shadowMap.width, shadowMap.height);
-		glClear(GL_DEPTH_BUFFER_BIT);
-		glCullFace(GL_FRONT);
-
-		depthOnlyShader.use();
-		//Render scene from lights point of view
-		depthOnlyShader.setMat4("_ViewProjection", lightViewProjection);
-		drawScene(monkeyModel, planeMesh, depthOnlyShader);
-
-
-		//geo pass
-
-		glBindFramebuffer(GL_FRAMEBUFFER, gBuffer.fbo);
-		glViewport( 0, 0, gBuffer.width, gBuffer.height);
-		glClearColor( 0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		glCullFace(GL_BACK);
-
-		glBindTextureUnit(1, rockTexture);
-		glBindTextureUnit(0, framebuffer.fbo);
-
-		geoShader.use();
-
-		geoShader.setInt("_MainTex", 1);
-		geoShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
-		geoShader.setMat4("_LightViewProj", lightViewProjection);
-		drawScene(monkeyModel, planeMesh, geoShader);
-
-		
-		//LIGHTING PASS
-		//if using post processing, we draw to our offscreen framebuffer
-		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
-		glViewport(0, 0, framebuffer.width, framebuffer.height);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		defferedShader.use();
-
-		//Bind g-buffer textures
-		glBindTextureUnit(0, gBuffer.colorBuffer[0]);
-		glBindTextureUnit(1, gBuffer.colorBuffer[1]);
-		glBindTextureUnit(2, gBuffer.colorBuffer[2]);
-		glBindTextureUnit(3, shadowMap.depthBuffer); //For shadow mapping
-		
-		for (int i = 0; i < MAX_POINT_LIGHTS; i++) {
-			defferedShader.setVec3("_PointLights[" + std::to_string(i) + "].position", pointLights[i].position);
-			defferedShader.setFloat("_PointLights[" + std::to_string(i) + "].radius", pointLights[i].radius);
-			defferedShader.setVec4("_PointLights[" + std::to_string(i) + "].color", pointLights[i].color);
-		}
-
-		defferedShader.setFloat("_Material.Ka", material.Ka);
-		defferedShader.setFloat("_Material.Kd", material.Kd);
-		defferedShader.setFloat("_Material.Ks", material.Ks);
-		defferedShader.setFloat("_Material.Shininess", material.Shininess);
-		defferedShader.setVec3("_EyePos", camera.position);
-		defferedShader.setVec3("_LightDirection", light.direction);
-		defferedShader.setFloat("_minBias", shadow.minBias);
-		defferedShader.setFloat("_maxBias", shadow.maxBias);
-		defferedShader.setInt("_ShadowMap", 3);
-		//litShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
-		defferedShader.setMat4("_LightViewProj", lightViewProjection);
-
-		glBindVertexArray(dummyVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		//LightOrb stuff?
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer.fbo); //Read from gBuffer 
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer.fbo); //Write to current fbo
-		glBlitFramebuffer(
-			0, 0, screenWidth, screenHeight, 0, 0, screenWidth, screenHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST
-		);
-
-		//Draw all light orbs
-		lightOrbShader.use();
-		lightOrbShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
-		for (int i = 0; i < MAX_POINT_LIGHTS; i++)
-		{
-			glm::mat4 m = glm::mat4(1.0f);
-			m = glm::translate(m, pointLights[i].position);
-			m = glm::scale(m, glm::vec3(0.2f)); //Whatever radius you want
-
-			lightOrbShader.setMat4("_Model", m);
-			lightOrbShader.setVec3("_Color", pointLights[i].color);
-			sphereMesh.draw();
-		}
-
-
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		blurShader.use();
-
-		glBindTextureUnit(0, framebuffer.colorBuffer[0]);
-		glBindVertexArray(dummyVAO);
-
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-
-		blurShader.setInt("_MainTex", 0);
-
-		drawUI();
+		gpuProfiler.beginScope("UI");
+		drawUI(scene.getTerrain(), shaderBatch);
+		gpuProfiler.endScope();
+		gpuProfiler.endFrame();
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
@@ -405,31 +67,13 @@ int main() {
 	printf("Shutting down...");
 }
 
-void drawScene(ew::Model monkeyModel, ew::Mesh planeMesh, ew::Shader &shader) {//Draws scene using current shader
-	float scalar = 4.5;
-	for (int i = -25; i < 25; i++)
-	{
-		for (int j = -25; j < 25; j++) 
-		{
-			ew::Transform temp = monkeyTransform;
-			glm::vec3 offset = glm::vec3( i*scalar, 0, j*scalar);
-			temp.position += offset;
-			shader.setMat4("_Model", temp.modelMatrix());
-			monkeyModel.draw();
-			temp.position -= glm::vec3(0, 1, 0);
-			shader.setMat4("_Model", temp.modelMatrix());
-			planeMesh.draw();
-		}
-	}
-}
-
 void resetCamera(ew::Camera* camera, ew::CameraController* controller) {
 	camera->position = glm::vec3(0, 0, 5.0f);
 	camera->target = glm::vec3(0);
 	controller->yaw = controller->pitch = 0;
 }
 
-void drawUI() {
+void drawUI(const ew::Terrain& terrain, const ew::ShaderBatch& shaderBatch) {
 	ImGui_ImplGlfw_NewFrame();
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui::NewFrame();
@@ -438,6 +82,49 @@ void drawUI() {
 	if (ImGui::Button("Reset Camera")) {
 		resetCamera(&camera, &cameraController);
 	}
+	ImGui::Checkbox("Instanced Drawing", &useInstancing);
+	if (useInstancing) {
+		ImGui::Checkbox("Multi-Draw Indirect", &useMultiDrawIndirect);
+		if (useMultiDrawIndirect) {
+			ImGui::Checkbox("GPU Culling", &useGpuCulling);
+		}
+	}
+	ImGui::Checkbox("Frustum Culling", &useFrustumCulling);
+	ImGui::Checkbox("Occlusion Culling", &useOcclusionCulling);
+	//Anything that changes what the static casters look like invalidates the cached shadows
+	if (ImGui::Checkbox("LODs", &useLods)) {
+		shadowCache.invalidateAll();
+	}
+	if (ImGui::Checkbox("Terrain", &useTerrain)) {
+		shadowCache.invalidateAll();
+	}
+	if (useTerrain) {
+		ImGui::Text("Terrain tiles: %d/%d resident, %d loading", terrain.getNumResidentTiles(), terrain.getNumSlots(), terrain.getNumPendingTiles());
+	}
+	ImGui::SliderFloat("LOD Bias", &lodBias, 0.25f, 16.0f);
+	if (ImGui::SliderFloat("Shadow LOD Bias", &shadowLodBias, 0.25f, 16.0f)) {
+		shadowCache.invalidateAll();
+	}
+	if (ImGui::Checkbox("Compact G-Buffer", &compactGBuffer)) {
+		createRenderTargets(gBuffer.width, gBuffer.height);
+	}
+	const ew::DrawStats& drawStats = ew::getDrawStats();
+	ImGui::Text("Draw calls: %u", drawStats.drawCalls);
+	ImGui::Text("Instances: %u", drawStats.instances);
+	ImGui::Text("Triangles: %u", drawStats.triangles);
+	if (ImGui::CollapsingHeader("Shaders")) {
+		if (ImGui::Button("Reload Shaders")) {
+			reloadShaders = true;
+		}
+		if (!shaderBatch.isDone()) {
+			ImGui::Text("Compiling %d programs", shaderBatch.getNumPending());
+		}
+		//Times from the last batch, in ms
+		for (const ew::ShaderCompileStats& stats : shaderBatch.getStats()) {
+			const char* note = stats.fromCache ? " (cached)" : (stats.linked ? "" : " (failed)");
+			ImGui::Text("%s: compile %.1f, link %.1f, blocked %.1f%s", stats.name.c_str(), stats.compileTime, stats.linkTime, stats.blockedTime, note);
+		}
+	}
 	if (ImGui::CollapsingHeader("Material")) {
 		ImGui::SliderFloat("AmbientK", &material.Ka, 0.0f, 1.0f);
 		ImGui::SliderFloat("DiffuseK", &material.Kd, 0.0f, 1.0f);
@@ -446,20 +133,37 @@ void drawUI() {
 	}
 	if (ImGui::CollapsingHeader("Light")) {
 		ImGui::SliderFloat3("Direction", (float*)&light.direction, -1, 1);
-		ImGui::SliderFloat("Min Bias", &shadow.minBias, 0, 0.1);
-		ImGui::SliderFloat("Max Bias", &shadow.maxBias, 0, 1);
+		ImGui::SliderFloat("Min Bias", &shadow.minBias, 0, 4);
+		ImGui::SliderFloat("Max Bias", &shadow.maxBias, 0, 16);
+		ImGui::SliderInt("Cascades", &shadowCascadeSettings.numCascades, 1, ew::MAX_SHADOW_CASCADES);
+		ImGui::SliderFloat("Split Lambda", &shadowCascadeSettings.splitLambda, 0.0f, 1.0f);
+		ImGui::SliderFloat("Shadow Distance", &shadowCascadeSettings.shadowDistance, 5.0f, 100.0f);
+		ImGui::Checkbox("Show Cascades", &showCascades);
+		ImGui::Checkbox("Cache Static Shadows", &useShadowCache);
+		ImGui::Checkbox("Moving Monkey", &useMovingMonkey);
+		const ew::ShadowCacheStats& cacheStats = shadowCache.getStats();
+		ImGui::Text("Cascades redrawn: %d full, %d partial, %d skipped", cacheStats.redrawn, cacheStats.partial, cacheStats.skipped);
+		ImGui::Text("Skipped %llu of %llu cascade redraws", cacheStats.totalSkipped, cacheStats.totalRedrawn + cacheStats.totalPartial + cacheStats.totalSkipped);
+		if (ImGui::SliderInt("Point Lights", &numPointLights, 0, MAX_POINT_LIGHTS)) {
+			createPointLights(numPointLights);
+		}
+		ImGui::Combo("Lighting Mode", &lightingMode, lightingModeNames, IM_ARRAYSIZE(lightingModeNames));
 	}
 	//ImGui::Text("Add Controls Here!");
 	ImGui::End();
 
+	drawProfilerUI();
+
 	ImGui::Begin("Shadow Map");
+	ImGui::SliderInt("Cascade", &shownCascade, 0, shadowCascades.numCascades - 1);
+	shownCascade = glm::clamp(shownCascade, 0, shadowCascades.numCascades - 1);
 	//Using a Child allow to fill all the space of the window.
 	ImGui::BeginChild("Shadow Map");
 	//Stretch image to be window size
 	ImVec2 windowSize = ImGui::GetWindowSize();
 	//Invert 0-1 V to flip vertically for ImGui display
-	//shadowMap is the texture2D handle
-	ImGui::Image((ImTextureID)shadowMap.depthBuffer, windowSize, ImVec2(0, 1), ImVec2(1, 0));
+	//A texture2D view of one layer of the shadow map array
+	ImGui::Image((ImTextureID)getLitShadowMap().layerViews[shownCascade], windowSize, ImVec2(0, 1), ImVec2(1, 0));
 	ImGui::EndChild();
 	ImGui::End();
 
@@ -467,7 +171,9 @@ void drawUI() {
 	ImVec2 texSize = ImVec2(gBuffer.width / 4, gBuffer.height / 4);
 	for (size_t i = 0; i < 3; i++)
 	{
-		ImGui::Image((ImTextureID)gBuffer.colorBuffer[i], texSize, ImVec2(0, 1), ImVec2(1, 0));
+		//Compact layout has no position buffer, show depth in its place
+		unsigned int texture = gBuffer.colorBuffer[i] != 0 ? gBuffer.colorBuffer[i] : gBuffer.depthBuffer;
+		ImGui::Image((ImTextureID)texture, texSize, ImVec2(0, 1), ImVec2(1, 0));
 	}
 	ImGui::End();
 
@@ -477,6 +183,49 @@ void drawUI() {
 
 }
 
+/// <summary>
+/// Rolling graph of GPU frame time, then each scope of the latest resolved frame with its average and its own graph
+/// </summary>
+void drawProfilerUI() {
+	//Right of the Settings window on first run
+	ImGui::SetNextWindowPos(ImVec2(420, 20), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(420, 360), ImGuiCond_FirstUseEver);
+	ImGui::Begin("GPU Profiler");
+	const ew::GpuFrameTiming* latest = gpuProfiler.getLatestFrame();
+	if (!gpuProfiler.isAvailable()) {
+		ImGui::Text("Timer queries are unavailable on this driver");
+	}
+	else if (latest != nullptr) {
+		static std::vector<float> history;
+		gpuProfiler.getFrameHistory(&history);
+		float average = 0.0f;
+		for (float milliseconds : history) {
+			average += milliseconds / history.size();
+		}
+		char overlay[32];
+		snprintf(overlay, sizeof(overlay), "%.2f ms average", average);
+		ImGui::PlotLines("##GPU Frame", history.data(), (int)history.size(), 0, overlay, 0.0f, FLT_MAX, ImVec2(-1, 80));
+		for (size_t i = 0; i < latest->scopes.size(); i++) {
+			const ew::GpuScopeTiming& scope = latest->scopes[i];
+			gpuProfiler.getScopeHistory(scope.name, &history);
+			average = 0.0f;
+			for (float milliseconds : history) {
+				average += milliseconds / history.size();
+			}
+			ImGui::PushID((int)i);
+			ImGui::Text("%*s%-*s %6.2f ms", scope.depth * 2, "", 18 - scope.depth * 2, scope.name, average);
+			ImGui::SameLine();
+			ImGui::PlotLines("##Scope", history.data(), (int)history.size(), 0, nullptr, 0.0f, FLT_MAX, ImVec2(-1, 16));
+			ImGui::PopID();
+		}
+		ImGui::Text("Dropped frames: %d", gpuProfiler.getNumDroppedFrames());
+		if (ImGui::Button("Save Chrome Trace")) {
+			gpuProfiler.writeChromeTrace("gpuTrace.json");
+		}
+	}
+	ImGui::End();
+}
+
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
 	glViewport(0, 0, width, height);
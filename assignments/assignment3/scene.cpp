@@ -0,0 +1,970 @@
+#include "scene.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+#include <ew/transform.h>
+#include <ew/instanceBuffer.h>
+#include <ew/lightBuffer.h>
+#include <ew/lightCulling.h>
+#include <ew/frustum.h>
+#include <ew/lod.h>
+#include <ew/geometryArena.h>
+#include <ew/instanceCulling.h>
+#include <ew/occlusion.h>
+#include <ew/procGen.h>
+
+int screenWidth = 1080;
+int screenHeight = 720;
+
+ew::Camera camera;
+ew::Transform monkeyTransform, planeTransform;
+
+//Monkey/plane grid, kept on the CPU with world space bounds so each pass can cull before drawing
+struct SceneInstances {
+	std::vector<glm::mat4> transforms;
+	ew::SphereBoundsSoA bounds;
+}monkeyGrid, planeGrid;
+
+//Visible transforms for one pass. The shadow and camera passes each get their own buffers
+//so the second upload doesn't touch data the first pass's draws still read
+struct PassInstances {
+	ew::InstanceBuffer monkeys, planes;
+	std::vector<unsigned int> visibleIndices;
+	std::vector<int> visibleLods;
+	std::vector<unsigned int> lodOffsets; //Start of each LOD's slice of visibleTransforms
+	std::vector<glm::mat4> visibleTransforms;
+	ew::InstanceBuffer allInstances; //Monkeys then planes, for the multi-draw path
+	std::vector<ew::DrawElementsIndirectCommand> drawCommands;
+	ew::GpuInstanceCuller gpuCuller;
+	ew::HiZBuffer hiZ; //This pass's depth from the previous frame, for GPU culling
+	ew::HiZPyramid occluders; //Software rasterized nearest monkeys, for the CPU paths
+	bool useOccluders = false;
+}shadowPassInstances, cameraPassInstances;
+
+//Copies of the scene meshes in one shared vertex/index buffer, so both mesh types and all their LODs
+//draw with a single glMultiDrawElementsIndirect per pass. Only used with instancing
+struct SceneArena {
+	ew::GeometryArena arena;
+	std::vector<int> monkeyMeshes;
+	std::vector<int> planeMeshes;
+	//Every monkey then every plane, for GPU culling, which picks visible instances and LODs itself
+	ew::InstanceBuffer allTransforms;
+	ew::CullScene cullScene;
+}sceneArena;
+
+//Without GPU culling each pass rasterizes its nearest monkeys into a small depth buffer on the CPU
+//and tests everything else against that. Deterministic, but only monkeys occlude
+const int MAX_SOFTWARE_OCCLUDERS = 32;
+const int SOFTWARE_OCCLUSION_SIZE = 256; //Stretched over the whole view whatever its aspect ratio
+struct SoftwareOcclusion {
+	std::vector<ew::MeshData> monkeyMeshes;
+	ew::DepthBuffer depthBuffer;
+	std::vector<std::pair<float, unsigned int>> nearest; //NDC depth, monkey index
+}softwareOcclusion;
+
+bool useInstancing = true;
+bool useMultiDrawIndirect = true;
+bool useGpuCulling = false;
+bool useFrustumCulling = true;
+//Hidden instances are tested against last frame's depth with GPU culling, and against software rasterized monkeys without
+bool useOcclusionCulling = false;
+//Streamed noise terrain under the monkey grid
+bool useTerrain = false;
+
+//LODs switch when their error would cover more than lodBias pixels. Shadow map texels are blurred by PCF
+//and rarely line up with screen pixels, so the shadow pass gets away with a much coarser bias
+bool useLods = true;
+float lodBias = 1.0f;
+float shadowLodBias = 4.0f;
+
+Material material;
+Framebuffer framebuffer, gBuffer;
+
+//Compact G-buffer: octahedral RG16 normals + RGBA8 albedo, world position rebuilt from a 32 bit float depth buffer.
+//12 bytes/pixel instead of 26 for the full layout
+bool compactGBuffer = false;
+
+//Static casters are cached in staticShadowMap and only redrawn where out of date. Dynamic casters are drawn
+//over a copy of it in shadowMap each frame. With no dynamic casters the lighting pass reads the cache directly
+ShadowMap shadowMap, staticShadowMap;
+ew::ShadowCache shadowCache;
+bool useShadowCache = true;
+
+//Orbits above the grid, a shadow caster that can't be cached
+bool useMovingMonkey = false;
+ew::Transform movingMonkeyTransform;
+
+bool reloadShaders = false;
+
+ew::GpuProfiler gpuProfiler;
+
+Light light;
+Shadow shadow;
+
+ew::ShadowCascadeSettings shadowCascadeSettings;
+ew::ShadowCascades shadowCascades;
+bool showCascades = false;
+int shownCascade = 0;
+
+int numPointLights = 256;
+ew::LightBuffer pointLights;
+
+const char* lightingModeNames[NUM_LIGHTING_MODES] = { "Full Screen", "Tiled (CPU)", "Tiled (Compute)", "Light Volumes" };
+int lightingMode = LIGHTING_TILED_COMPUTE;
+
+const int LIGHT_TILE_SIZE = 16; //Must match TILE_SIZE in lightCull.comp
+const int MAX_LIGHTS_PER_TILE = 512;
+ew::LightGrid lightGrid;
+ew::LightGridBuffer lightGridBuffer;
+
+//Lays out count lights on a square grid centered on the origin
+void createPointLights(int count) {
+	float scalar = 4.5;
+	int side = (int)ceilf(sqrtf((float)count));
+	for (int index = 0; index < count; index++)
+	{
+		int i = index / side - side / 2;
+		int j = index % side - side / 2;
+		ew::PointLight pointLight;
+		pointLight.position = glm::vec3(i * scalar + (0.5 * scalar), 0, j * scalar + (0.5 * scalar));
+		pointLight.color = glm::vec4(rand() % 2, rand() % 2, rand() % 2, 1);
+		pointLight.radius = 10;
+		pointLights.setLight(index, pointLight);
+	}
+	pointLights.setCount(count);
+}
+
+Framebuffer createFrameBuffer(unsigned int width, unsigned int height, int colorFormat, int depthFormat)
+{
+	framebuffer.width = width;
+	framebuffer.height = height;
+
+	//create Framebuffer Object
+	glCreateFramebuffers(1, &framebuffer.fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
+	//Create Color Buffer
+	glGenTextures(1, &framebuffer.colorBuffer[0]);
+	glBindTexture(GL_TEXTURE_2D, framebuffer.colorBuffer[0]);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, framebuffer.width, framebuffer.height);
+	//Attach color buffer to framebuffer
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, framebuffer.colorBuffer[0], 0);
+
+	glGenTextures(1, &framebuffer.depthBuffer);
+	glBindTexture(GL_TEXTURE_2D, framebuffer.depthBuffer);
+	//Create depth buffer. Must match the gBuffer depth format so the depth blit works
+	glTexStorage2D(GL_TEXTURE_2D, 1, depthFormat, framebuffer.width, framebuffer.height);
+	//Attach to framebuffer. Light volumes mark the pixels they cover in the stencil
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, framebuffer.depthBuffer, 0);
+
+	GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
+		printf("Framebuffer incomplete: %d", fboStatus);
+	}
+
+	return framebuffer;
+}
+
+ShadowMap createShadowMap(unsigned int resolution, int numLayers)
+{
+	ShadowMap shadowMap = {};
+	shadowMap.width = resolution;
+	shadowMap.height = resolution;
+
+	glCreateFramebuffers(1, &shadowMap.fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, shadowMap.fbo);
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &shadowMap.depthBuffer);
+	//16 bit depth values. Cascades are fitted tightly, so their depth ranges are short
+	glTextureStorage3D(shadowMap.depthBuffer, 1, GL_DEPTH_COMPONENT16, resolution, resolution, numLayers);
+
+	glTextureParameteri(shadowMap.depthBuffer, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(shadowMap.depthBuffer, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	//Pixels outside of frustum should have max distance (white)
+	glTextureParameteri(shadowMap.depthBuffer, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTextureParameteri(shadowMap.depthBuffer, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	float borderColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTextureParameterfv(shadowMap.depthBuffer, GL_TEXTURE_BORDER_COLOR, borderColor);
+
+	//Layered attachment, the geometry shader picks each triangle's layer
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMap.depthBuffer, 0);
+
+	//Views need fresh names from glGenTextures
+	glGenTextures(numLayers, shadowMap.layerViews);
+	for (int layer = 0; layer < numLayers; layer++) {
+		glTextureView(shadowMap.layerViews[layer], GL_TEXTURE_2D, shadowMap.depthBuffer, GL_DEPTH_COMPONENT16, 0, 1, layer, 1);
+	}
+
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+
+	GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
+		printf("Shadow map framebuffer incomplete: %d", fboStatus);
+	}
+
+	return shadowMap;
+}
+
+//Both depth buffers carry a stencil for light volumes, as the depth blit needs matching formats.
+//Compact positions come from depth, so it needs the extra precision
+int depthStencilFormat(bool compact)
+{
+	return compact ? GL_DEPTH32F_STENCIL8 : GL_DEPTH24_STENCIL8;
+}
+
+Framebuffer createGBuffer(unsigned int width, unsigned int height, bool compact) 
+{
+	Framebuffer framebuffer = {};
+
+	framebuffer.width = width;
+	framebuffer.height = height;
+
+	glCreateFramebuffers( 1, &framebuffer.fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
+
+	int formats[3] = {
+		GL_RGB32F, //world Pos
+		GL_RGB16F, //world norm
+		GL_RGB16F  //albedo
+	};
+	if (compact) {
+		formats[0] = 0; //rebuilt from depth instead
+		formats[1] = GL_RG16_SNORM; //octahedral world norm
+		formats[2] = GL_RGBA8;
+	}
+
+	//create 3 color textures
+	for (size_t i = 0; i < 3; i++) 
+	{
+		if (formats[i] == 0) {
+			continue;
+		}
+		glGenTextures( 1, &framebuffer.colorBuffer[i]);
+		glBindTexture(GL_TEXTURE_2D, framebuffer.colorBuffer[i]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, formats[i], width, height);
+
+		//prevent wrapping by clamping
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, framebuffer.colorBuffer[i], 0);
+	}
+	//tell gl what color attatchments we'll draw to
+	const GLenum drawBuffers[3] = {
+		compact ? (GLenum)GL_NONE : (GLenum)GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2
+	};
+	glDrawBuffers(3, drawBuffers);
+
+	glGenTextures(1, &framebuffer.depthBuffer);
+	glBindTexture(GL_TEXTURE_2D, framebuffer.depthBuffer);
+	//Create depth buffer
+	glTexStorage2D(GL_TEXTURE_2D, 1, depthStencilFormat(compact), framebuffer.width, framebuffer.height);
+	//Attach to framebuffer
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, framebuffer.depthBuffer, 0);
+
+	GLenum fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
+		printf("Framebuffer incomplete: %d", fboStatus);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+
+	return framebuffer;
+}
+
+void deleteFramebuffer(Framebuffer& fb)
+{
+	for (unsigned int& colorBuffer : fb.colorBuffer) {
+		if (colorBuffer != 0) {
+			glDeleteTextures(1, &colorBuffer);
+			colorBuffer = 0;
+		}
+	}
+	glDeleteTextures(1, &fb.depthBuffer);
+	glDeleteFramebuffers(1, &fb.fbo);
+	fb.depthBuffer = fb.fbo = 0;
+}
+
+//(Re)creates the gBuffer and post processing framebuffer for the current G-buffer layout
+void createRenderTargets(unsigned int width, unsigned int height)
+{
+	deleteFramebuffer(gBuffer);
+	deleteFramebuffer(framebuffer);
+	gBuffer = createGBuffer(width, height, compactGBuffer);
+	createFrameBuffer(width, height, 0, depthStencilFormat(compactGBuffer));//idk what color format is yet
+}
+
+void addSceneShaders(ew::ShaderBatch& batch) {
+	batch.add("assets/lit.vert", "assets/lit.frag");
+	batch.add("assets/blur.vert", "assets/blur.frag");
+	//Shadow casters render into every cascade at once
+	batch.add("assets/depthOnly.vert", "assets/shadowCascades.geom", "assets/depthOnly.frag");
+	batch.add("assets/depthOnlyInstanced.vert", "assets/shadowCascades.geom", "assets/depthOnly.frag");
+	batch.add("assets/geo.vert", "assets/geo.frag");
+	batch.add("assets/geoInstanced.vert", "assets/geo.frag");
+	batch.add("assets/deferredLit.vert", "assets/deferredLit.frag");
+	batch.add("assets/lightOrb.vert", "assets/lightOrb.frag");
+	batch.add("assets/lightVolume.vert", "assets/lightVolume.frag");
+	batch.add("assets/lightVolume.vert", "assets/depthOnly.frag");
+	batch.add("assets/lightCull.comp");
+	batch.add("assets/instanceCull.comp");
+	batch.add("assets/hiZ.comp");
+}
+
+//Builds the same 50x50 grid that the old loop drew one object at a time, with world space bounding spheres
+void createSceneInstances(const ew::Model& monkeyModel, const ew::Mesh& planeMesh) {
+	monkeyGrid = SceneInstances();
+	planeGrid = SceneInstances();
+	monkeyGrid.transforms.reserve(50 * 50);
+	planeGrid.transforms.reserve(50 * 50);
+	float scalar = 4.5;
+	for (int i = -25; i < 25; i++)
+	{
+		for (int j = -25; j < 25; j++)
+		{
+			ew::Transform temp = monkeyTransform;
+			glm::vec3 offset = glm::vec3(i * scalar, 0, j * scalar);
+			temp.position += offset;
+			monkeyGrid.transforms.push_back(temp.modelMatrix());
+			monkeyGrid.bounds.push_back(ew::transformBoundingSphere(monkeyModel.getBoundingSphere(), monkeyGrid.transforms.back()));
+			temp.position -= glm::vec3(0, 1, 0);
+			planeGrid.transforms.push_back(temp.modelMatrix());
+			planeGrid.bounds.push_back(ew::transformBoundingSphere(planeMesh.getBoundingSphere(), planeGrid.transforms.back()));
+		}
+	}
+}
+
+//Both grids for GPU culling: one mesh type per drawable, with a command per arena mesh and LOD
+void createCullScene(const ew::Model& monkeyModel, const ew::Mesh& planeMesh) {
+	ew::CullScene& scene = sceneArena.cullScene;
+	scene = ew::CullScene();
+	float monkeyErrors[ew::MAX_CULL_LODS] = {};
+	for (int lod = 0; lod < monkeyModel.getNumLods() && lod < ew::MAX_CULL_LODS; lod++) {
+		monkeyErrors[lod] = monkeyModel.getLodError(lod);
+	}
+	unsigned int monkeyType = scene.addMeshType(monkeyErrors, monkeyModel.getNumLods(), monkeyModel.getBoundingSphere().radius);
+	float planeError = 0.0f;
+	unsigned int planeType = scene.addMeshType(&planeError, 1, planeMesh.getBoundingSphere().radius);
+
+	std::vector<ew::DrawElementsIndirectCommand> commands;
+	for (int lod = 0; lod < scene.meshTypes[monkeyType].numLods; lod++) {
+		for (int handle : sceneArena.monkeyMeshes) {
+			sceneArena.arena.addDrawCommand(commands, handle, lod, 0, 0);
+			scene.addCommand(commands.back(), monkeyType, lod);
+		}
+	}
+	for (int handle : sceneArena.planeMeshes) {
+		sceneArena.arena.addDrawCommand(commands, handle, 0, 0, 0);
+		scene.addCommand(commands.back(), planeType, 0);
+	}
+
+	std::vector<glm::mat4> transforms;
+	for (int i = 0; i < monkeyGrid.bounds.size(); i++) {
+		scene.addInstance(monkeyType, { glm::vec3(monkeyGrid.bounds.x[i], monkeyGrid.bounds.y[i], monkeyGrid.bounds.z[i]), monkeyGrid.bounds.radius[i] });
+		transforms.push_back(monkeyGrid.transforms[i]);
+	}
+	for (int i = 0; i < planeGrid.bounds.size(); i++) {
+		scene.addInstance(planeType, { glm::vec3(planeGrid.bounds.x[i], planeGrid.bounds.y[i], planeGrid.bounds.z[i]), planeGrid.bounds.radius[i] });
+		transforms.push_back(planeGrid.transforms[i]);
+	}
+	sceneArena.allTransforms.load(transforms);
+	shadowPassInstances.gpuCuller.upload(scene);
+	cameraPassInstances.gpuCuller.upload(scene);
+}
+
+//Fills pass.visibleIndices with the instances inside the frustum (all of them when culling is off)
+//that pass.occluders doesn't hide. Returns the count
+int cullInstances(const SceneInstances& instances, const ew::Frustum& frustum, PassInstances& pass) {
+	int count = instances.bounds.size();
+	pass.visibleIndices.resize(count);
+	int numVisible = count;
+	if (useFrustumCulling) {
+		numVisible = ew::cullSpheres(frustum, instances.bounds, pass.visibleIndices.data());
+	}
+	else {
+		for (int i = 0; i < count; i++) {
+			pass.visibleIndices[i] = i;
+		}
+	}
+	if (!pass.useOccluders) {
+		return numVisible;
+	}
+	int numUnoccluded = 0;
+	for (int i = 0; i < numVisible; i++) {
+		unsigned int index = pass.visibleIndices[i];
+		glm::vec3 center = glm::vec3(instances.bounds.x[index], instances.bounds.y[index], instances.bounds.z[index]);
+		float radius = instances.bounds.radius[index];
+		if (!ew::isOccluded(pass.occluders, ew::AABB{ center - radius, center + radius })) {
+			pass.visibleIndices[numUnoccluded++] = index;
+		}
+	}
+	return numUnoccluded;
+}
+
+//Software rasterizes the MAX_SOFTWARE_OCCLUDERS nearest visible monkeys at full detail, so occluders are never
+//smaller than what's drawn, and builds pass.occluders from them
+void buildSoftwareOccluders(const ew::Frustum& frustum, const glm::mat4& viewProjection, PassInstances& pass) {
+	pass.useOccluders = false;
+	int numVisible = cullInstances(monkeyGrid, frustum, pass);
+	std::vector<std::pair<float, unsigned int>>& nearest = softwareOcclusion.nearest;
+	nearest.clear();
+	for (int i = 0; i < numVisible; i++) {
+		unsigned int index = pass.visibleIndices[i];
+		glm::vec4 clip = viewProjection * glm::vec4(monkeyGrid.bounds.x[index], monkeyGrid.bounds.y[index], monkeyGrid.bounds.z[index], 1.0f);
+		if (clip.w > 0.0f) {
+			nearest.push_back({ clip.z / clip.w, index });
+		}
+	}
+	int numOccluders = glm::min((int)nearest.size(), MAX_SOFTWARE_OCCLUDERS);
+	std::partial_sort(nearest.begin(), nearest.begin() + numOccluders, nearest.end());
+
+	ew::DepthBuffer& depthBuffer = softwareOcclusion.depthBuffer;
+	ew::clearDepthBuffer(&depthBuffer, SOFTWARE_OCCLUSION_SIZE, SOFTWARE_OCCLUSION_SIZE);
+	for (int i = 0; i < numOccluders; i++) {
+		glm::mat4 modelViewProjection = viewProjection * monkeyGrid.transforms[nearest[i].second];
+		for (const ew::MeshData& meshData : softwareOcclusion.monkeyMeshes) {
+			unsigned int firstIndex = meshData.lods.empty() ? 0 : meshData.lods[0].firstIndex;
+			unsigned int numIndices = meshData.lods.empty() ? meshData.indices.size() : meshData.lods[0].numIndices;
+			ew::rasterizeDepth(&depthBuffer, modelViewProjection, meshData.vertices.data(), meshData.indices.data() + firstIndex, numIndices);
+		}
+	}
+	ew::buildHiZ(depthBuffer.depth.data(), depthBuffer.width, depthBuffer.height, viewProjection, &pass.occluders);
+	pass.useOccluders = true;
+}
+
+//LOD of one instance from its world space bounds. Assumes uniform scale, recovered from how much the bounds grew
+template<typename Drawable>
+int selectInstanceLod(const Drawable& drawable, const SceneInstances& instances, unsigned int index, const ew::LodSelector& lodSelector) {
+	if (!useLods) {
+		return 0;
+	}
+	ew::BoundingSphere bounds;
+	bounds.center = glm::vec3(instances.bounds.x[index], instances.bounds.y[index], instances.bounds.z[index]);
+	bounds.radius = instances.bounds.radius[index];
+	float scale = bounds.radius / drawable.getBoundingSphere().radius;
+	return drawable.selectLod(ew::getMaxLodError(lodSelector, bounds) / scale);
+}
+
+//Appends the visible instances of one mesh type to pass.visibleTransforms, counting sorted by LOD so each LOD
+//is one contiguous slice. pass.lodOffsets[lod] ends up at the end of each slice. Returns where this mesh type starts
+template<typename Drawable>
+unsigned int gatherVisible(const Drawable& drawable, const SceneInstances& instances, const ew::Frustum& frustum, const ew::LodSelector& lodSelector,
+	PassInstances& pass) {
+	int numVisible = cullInstances(instances, frustum, pass);
+	unsigned int start = pass.visibleTransforms.size();
+	int numLods = drawable.getNumLods();
+	pass.visibleLods.resize(numVisible);
+	pass.lodOffsets.assign(numLods + 1, start);
+	for (int i = 0; i < numVisible; i++) {
+		pass.visibleLods[i] = selectInstanceLod(drawable, instances, pass.visibleIndices[i], lodSelector);
+		pass.lodOffsets[pass.visibleLods[i] + 1]++;
+	}
+	for (int lod = 0; lod < numLods; lod++) {
+		pass.lodOffsets[lod + 1] += pass.lodOffsets[lod] - start;
+	}
+	pass.visibleTransforms.resize(start + numVisible);
+	for (int i = 0; i < numVisible; i++) {
+		pass.visibleTransforms[pass.lodOffsets[pass.visibleLods[i]]++] = instances.transforms[pass.visibleIndices[i]];
+	}
+	return start;
+}
+
+//Draws the visible instances of one mesh type with the current shader
+template<typename Drawable>
+void drawVisible(Drawable& drawable, const SceneInstances& instances, const ew::Frustum& frustum, const ew::LodSelector& lodSelector,
+	PassInstances& pass, ew::InstanceBuffer& instanceBuffer, ew::Shader& shader) {
+	if (useInstancing) {
+		//Instanced shaders read _Models[_InstanceOffset + gl_InstanceID]
+		pass.visibleTransforms.clear();
+		unsigned int offset = gatherVisible(drawable, instances, frustum, lodSelector, pass);
+		if (!pass.visibleTransforms.empty()) {
+			instanceBuffer.load(pass.visibleTransforms);
+			instanceBuffer.bind(0);
+		}
+		for (int lod = 0; lod < drawable.getNumLods(); lod++) {
+			int count = pass.lodOffsets[lod] - offset;
+			if (count > 0) {
+				shader.setInt("_InstanceOffset", offset);
+				drawable.drawInstanced(count, ew::DrawMode::TRIANGLES, lod);
+			}
+			offset = pass.lodOffsets[lod];
+		}
+		return;
+	}
+	int numVisible = cullInstances(instances, frustum, pass);
+	for (int i = 0; i < numVisible; i++) {
+		shader.setMat4("_Model", instances.transforms[pass.visibleIndices[i]]);
+		drawable.draw(ew::DrawMode::TRIANGLES, selectInstanceLod(drawable, instances, pass.visibleIndices[i], lodSelector));
+	}
+}
+
+//Gathers one mesh type's visible instances and adds a draw command per LOD slice and arena mesh.
+//LODs are still picked with drawable, whose errors match the arena copies
+template<typename Drawable>
+void addIndirectDraws(const Drawable& drawable, const std::vector<int>& arenaMeshes, const SceneInstances& instances, const ew::Frustum& frustum,
+	const ew::LodSelector& lodSelector, PassInstances& pass) {
+	unsigned int offset = gatherVisible(drawable, instances, frustum, lodSelector, pass);
+	for (int lod = 0; lod < drawable.getNumLods(); lod++) {
+		unsigned int count = pass.lodOffsets[lod] - offset;
+		if (count > 0) {
+			for (int handle : arenaMeshes) {
+				sceneArena.arena.addDrawCommand(pass.drawCommands, handle, lod, count, offset);
+			}
+		}
+		offset = pass.lodOffsets[lod];
+	}
+}
+
+//Cascade uniforms shared by shadowCascades.geom and deferredLit.frag. Inactive ones are ignored
+void setShadowCascadeUniforms(const ew::Shader& shader) {
+	shader.setInt("_NumCascades", shadowCascades.numCascades);
+	for (int i = 0; i < shadowCascades.numCascades; i++) {
+		std::string index = "[" + std::to_string(i) + "]";
+		shader.setMat4("_CascadeViewProjections" + index, shadowCascades.viewProjections[i]);
+		shader.setFloat("_CascadeSplits" + index, shadowCascades.splitDepths[i]);
+		shader.setFloat("_CascadeTexelSizes" + index, shadowCascades.texelSizes[i]);
+		shader.setFloat("_CascadeDepthRanges" + index, shadowCascades.depthRanges[i]);
+	}
+}
+
+//The shadow map the lighting pass reads
+const ShadowMap& getLitShadowMap() {
+	return useMovingMonkey ? shadowMap : staticShadowMap;
+}
+
+bool useGpuOcclusion() {
+	return useInstancing && useMultiDrawIndirect && useGpuCulling && useOcclusionCulling;
+}
+
+void drawScene(ew::Model& monkeyModel, ew::Mesh& planeMesh, ew::Shader &shader, const ew::Shader& cullShader, const glm::mat4& viewProjection,
+	const ew::LodSelector& lodSelector, PassInstances& pass) {//Draws scene using current shader
+	ew::Frustum frustum = ew::extractFrustum(viewProjection);
+	if (useInstancing && useMultiDrawIndirect && useGpuCulling) {
+		//Visible instances, LODs and draw commands never leave the GPU. Occlusion reads the pyramid built after this pass last frame
+		pass.gpuCuller.cull(cullShader, useFrustumCulling ? &frustum : nullptr, useLods ? &lodSelector : nullptr,
+			useOcclusionCulling ? &pass.hiZ : nullptr);
+		shader.use();
+		sceneArena.allTransforms.bind(0);
+		pass.gpuCuller.bindInstanceIds(4);
+		shader.setInt("_UseInstanceIds", 1);
+		shader.setInt("_InstanceOffset", 0);
+		sceneArena.arena.drawIndirect(pass.gpuCuller.getCommandBuffer(), pass.gpuCuller.getNumCommands(), pass.gpuCuller.getNumInstances());
+		shader.setInt("_UseInstanceIds", 0);
+		return;
+	}
+	pass.useOccluders = false;
+	if (useOcclusionCulling) {
+		buildSoftwareOccluders(frustum, viewProjection, pass);
+	}
+	if (useInstancing && useMultiDrawIndirect) {
+		pass.visibleTransforms.clear();
+		pass.drawCommands.clear();
+		addIndirectDraws(monkeyModel, sceneArena.monkeyMeshes, monkeyGrid, frustum, lodSelector, pass);
+		addIndirectDraws(planeMesh, sceneArena.planeMeshes, planeGrid, frustum, lodSelector, pass);
+		if (!pass.visibleTransforms.empty()) {
+			pass.allInstances.load(pass.visibleTransforms);
+			pass.allInstances.bind(0);
+		}
+		//Each command's baseInstance reaches the shader as vBaseInstance
+		shader.setInt("_InstanceOffset", 0);
+		sceneArena.arena.draw(pass.drawCommands);
+		return;
+	}
+	drawVisible(monkeyModel, monkeyGrid, frustum, lodSelector, pass, pass.monkeys, shader);
+	drawVisible(planeMesh, planeGrid, frustum, lodSelector, pass, pass.planes, shader);
+}
+
+//Tiles generate on the scene's thread pool. The far plane is 100, so a 3 tile radius covers everything visible
+static ew::TerrainSettings createTerrainSettings() {
+	ew::NoiseSettings terrainNoise;
+	ew::TerrainSettings terrainSettings;
+	terrainSettings.loadRadius = 3;
+	terrainSettings.height = [terrainNoise](float x, float z) { return ew::sampleNoise(terrainNoise, x, z) - 20.0f; };
+	return terrainSettings;
+}
+
+/// <summary>
+/// Loads the scene while shaderBatch compiles, creates render targets at screenWidth x screenHeight, then waits for the programs
+/// </summary>
+Scene::Scene(ew::ShaderBatch& shaderBatch)
+	//Scene geometry uses 16 byte quantized vertices, the shadow and geometry passes are bound by vertex fetch
+	: shaderBatch(shaderBatch), monkeyModel("assets/Suzanne.obj", true, ew::VertexFormat::PACKED),
+	//Textures decode in the background and show a placeholder until they're uploaded
+	textureLoader(threadPool), terrain(createTerrainSettings(), threadPool)
+{
+	rockTexture = textureLoader.load("assets/Rock037_2K-PNG/Rock037_2K-PNG_Color.png");
+	ew::MeshData planeMeshData = ew::createPlane(10, 10, 5);
+	planeMesh = ew::Mesh(planeMeshData, ew::VertexFormat::PACKED);
+	sceneArena.arena.create(1 << 16, 1 << 18);
+	softwareOcclusion.monkeyMeshes = ew::loadMeshData("assets/Suzanne.obj");
+	for (const ew::MeshData& meshData : softwareOcclusion.monkeyMeshes) {
+		sceneArena.monkeyMeshes.push_back(sceneArena.arena.add(meshData));
+	}
+	sceneArena.planeMeshes.push_back(sceneArena.arena.add(planeMeshData));
+
+	planeTransform.position.y += -1;
+	//planeTransform.scale *= 100;
+
+	pointLights.create(MAX_POINT_LIGHTS);
+	createPointLights(numPointLights);
+	createSceneInstances(monkeyModel, planeMesh);
+	createCullScene(monkeyModel, planeMesh);
+	sphereMesh = ew::Mesh(ew::createSphere(1.0f, 8));
+	//Light volumes need a rounder sphere so the faceted mesh hugs the light radius
+	const int lightVolumeSubdivisions = 16;
+	lightVolumeMesh = ew::Mesh(ew::createSphere(1.0f, lightVolumeSubdivisions));
+	//Scales the mesh so its flat faces sit outside the true sphere instead of cutting into it
+	lightVolumeScale = 1.0f / (cosf(glm::pi<float>() / lightVolumeSubdivisions) * cosf(glm::pi<float>() / (2 * lightVolumeSubdivisions)));
+
+	createRenderTargets(screenWidth, screenHeight);
+	shadowMap = createShadowMap(shadowCascadeSettings.resolution, ew::MAX_SHADOW_CASCADES);
+	staticShadowMap = createShadowMap(shadowCascadeSettings.resolution, ew::MAX_SHADOW_CASCADES);
+	glCreateVertexArrays(1, &dummyVAO);
+
+	shaderBatch.wait();
+	shaderBatch.printStats();
+	for (int i = 0; i < NUM_SCENE_SHADERS; i++) {
+		shaders.push_back(shaderBatch.get(i));
+	}
+
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST); //Depth testing
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/// <summary>
+/// Per frame work before rendering. Terrain streams around the camera, so move it first
+/// </summary>
+/// <param name="time">Seconds since start, drives the orbiting monkey</param>
+void Scene::update(float time) {
+	ew::resetDrawStats();
+	//Upload at most one 2K RGBA texture per frame
+	textureLoader.update(2048 * 2048 * 4);
+
+	//Clicks during a reload are dropped. Clearing the batch would wait for the programs still compiling
+	if (reloadShaders && !reloadingShaders) {
+		shaderBatch.clear();
+		addSceneShaders(shaderBatch);
+		shaderBatch.submit();
+		reloadingShaders = true;
+	}
+	reloadShaders = false;
+	//The old programs keep drawing until every new one is done. Those that failed to compile stay on the old version
+	if (reloadingShaders && shaderBatch.poll()) {
+		reloadingShaders = false;
+		for (int i = 0; i < NUM_SCENE_SHADERS; i++) {
+			const ew::Shader& reloaded = shaderBatch.get(i, shaders[i]);
+			if (reloaded.getId() != shaders[i].getId()) {
+				glDeleteProgram(shaders[i].getId());
+				shaders[i] = reloaded;
+			}
+		}
+		shaderBatch.printStats();
+	}
+
+	//rotate monkey
+	//monkeyTransform.rotation = glm::rotate(monkeyTransform.rotation, deltaTime, glm::vec3(0.0, 1.0, 0.0));
+	movingMonkeyTransform.position = glm::vec3(cosf(time * 0.5f) * 6.0f, 2.0f, sinf(time * 0.5f) * 6.0f);
+	movingMonkeyTransform.rotation = glm::angleAxis(-time * 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+	if (useTerrain) {
+		terrain.update(camera.position);
+		//Tiles streaming in or out change static casters under them
+		for (const ew::AABB& bounds : terrain.getChangedBounds()) {
+			shadowCache.invalidate(bounds);
+		}
+	}
+}
+
+/// <summary>
+/// Shadows, G-buffer, light culling, lighting, light orbs, then blurs the lit image into outputFramebuffer.
+/// Each pass is a gpuProfiler scope, the caller begins and ends the frame
+/// </summary>
+void Scene::render(unsigned int outputFramebuffer) {
+	ew::Shader& blurShader = shaders[BLUR_SHADER];
+	ew::Shader& depthOnlyShader = shaders[DEPTH_ONLY_SHADER];
+	ew::Shader& depthOnlyInstancedShader = shaders[DEPTH_ONLY_INSTANCED_SHADER];
+	ew::Shader& geoShader = shaders[GEO_SHADER];
+	ew::Shader& geoInstancedShader = shaders[GEO_INSTANCED_SHADER];
+	ew::Shader& defferedShader = shaders[DEFERRED_SHADER];
+	ew::Shader& lightOrbShader = shaders[LIGHT_ORB_SHADER];
+	ew::Shader& lightVolumeShader = shaders[LIGHT_VOLUME_SHADER];
+	ew::Shader& lightVolumeMarkShader = shaders[LIGHT_VOLUME_MARK_SHADER];
+	ew::Shader& lightCullShader = shaders[LIGHT_CULL_SHADER];
+	ew::Shader& instanceCullShader = shaders[INSTANCE_CULL_SHADER];
+	ew::Shader& hiZShader = shaders[HI_Z_SHADER];
+
+	ew::fitShadowCascades(camera, light.direction, shadowCascadeSettings, &shadowCascades);
+	//Encloses every cascade, casters are culled once for all of them
+	glm::mat4 lightViewProjection = shadowCascades.cullViewProjection;
+
+	//ShadowMap Pass
+
+	if (!useShadowCache) {
+		shadowCache.invalidateAll();
+	}
+	glm::ivec4 dirtyRects[ew::MAX_SHADOW_CASCADES];
+	unsigned int dirtyCascades = shadowCache.update(shadowCascades, dirtyRects);
+	gpuProfiler.beginScope("Shadows");
+	glCullFace(GL_FRONT);
+	//Cascades are only as deep as their slice of the view, casters in front of them are flattened onto the near plane
+	glEnable(GL_DEPTH_CLAMP);
+	//LOD distances follow the viewer, not the light. Cached cascades keep the LODs they were drawn with until they're redrawn
+	ew::LodSelector shadowLodSelector = ew::createLodSelector(camera, screenHeight, 1.0f, shadowLodBias);
+	if (dirtyCascades != 0) {
+		gpuProfiler.beginScope("Static Casters");
+		glBindFramebuffer(GL_FRAMEBUFFER, staticShadowMap.fbo);
+		glViewport(0, 0, staticShadowMap.width, staticShadowMap.height);
+		//The geometry shader sends each cascade to its own viewport index, so each gets its own scissor
+		glEnable(GL_SCISSOR_TEST);
+		float clearDepth = 1.0f;
+		for (int i = 0; i < shadowCascades.numCascades; i++) {
+			if (dirtyCascades & (1u << i)) {
+				const glm::ivec4& rect = dirtyRects[i];
+				glScissorIndexed(i, rect.x, rect.y, rect.z, rect.w);
+				glClearTexSubImage(staticShadowMap.depthBuffer, 0, rect.x, rect.y, i, rect.z, rect.w, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
+			}
+		}
+
+		ew::Shader& depthShader = useInstancing ? depthOnlyInstancedShader : depthOnlyShader;
+		depthShader.use();
+		//Render scene from light's point of view. The geometry shader projects into each cascade
+		depthShader.setMat4("_ViewProjection", glm::mat4(1.0f));
+		depthShader.setInt("_CascadeMask", dirtyCascades);
+		setShadowCascadeUniforms(depthShader);
+		drawScene(monkeyModel, planeMesh, depthShader, instanceCullShader, lightViewProjection, shadowLodSelector, shadowPassInstances);
+		if (useTerrain) {
+			ew::Frustum lightFrustum = ew::extractFrustum(lightViewProjection);
+			depthOnlyShader.use();
+			depthOnlyShader.setMat4("_ViewProjection", glm::mat4(1.0f));
+			depthOnlyShader.setMat4("_Model", glm::mat4(1.0f));
+			depthOnlyShader.setInt("_CascadeMask", dirtyCascades);
+			setShadowCascadeUniforms(depthOnlyShader);
+			terrain.draw(&lightFrustum, &shadowLodSelector);
+		}
+		glDisable(GL_SCISSOR_TEST);
+		gpuProfiler.endScope();
+	}
+	if (useMovingMonkey) {
+		gpuProfiler.beginScope("Moving Casters");
+		glCopyImageSubData(staticShadowMap.depthBuffer, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, shadowMap.depthBuffer, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+			shadowMap.width, shadowMap.height, shadowCascades.numCascades);
+		glBindFramebuffer(GL_FRAMEBUFFER, shadowMap.fbo);
+		glViewport(0, 0, shadowMap.width, shadowMap.height);
+		depthOnlyShader.use();
+		depthOnlyShader.setMat4("_ViewProjection", glm::mat4(1.0f));
+		depthOnlyShader.setMat4("_Model", movingMonkeyTransform.modelMatrix());
+		depthOnlyShader.setInt("_CascadeMask", (1 << ew::MAX_SHADOW_CASCADES) - 1);
+		setShadowCascadeUniforms(depthOnlyShader);
+		monkeyModel.draw();
+		gpuProfiler.endScope();
+	}
+	glDisable(GL_DEPTH_CLAMP);
+	gpuProfiler.endScope();
+	//No single cascade covers every caster, so GPU occlusion culling only applies to the camera pass.
+	//The shadow pass's hiZ stays empty and culling skips it
+
+
+	//geo pass
+	gpuProfiler.beginScope("Geometry");
+
+	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer.fbo);
+	glViewport( 0, 0, gBuffer.width, gBuffer.height);
+	glClearColor( 0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glCullFace(GL_BACK);
+
+	glBindTextureUnit(1, textureLoader.getTexture(rockTexture));
+	glBindTextureUnit(0, framebuffer.fbo);
+
+	ew::Shader& sceneShader = useInstancing ? geoInstancedShader : geoShader;
+	sceneShader.use();
+
+	sceneShader.setInt("_MainTex", 1);
+	sceneShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
+	sceneShader.setInt("_CompactGBuffer", compactGBuffer);
+	ew::LodSelector lodSelector = ew::createLodSelector(camera, screenHeight, 1.0f, lodBias);
+	drawScene(monkeyModel, planeMesh, sceneShader, instanceCullShader, camera.projectionMatrix() * camera.viewMatrix(), lodSelector, cameraPassInstances);
+	if (useTerrain || useMovingMonkey) {
+		geoShader.use();
+		geoShader.setInt("_MainTex", 1);
+		geoShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
+		geoShader.setInt("_CompactGBuffer", compactGBuffer);
+		if (useTerrain) {
+			ew::Frustum frustum = ew::extractFrustum(camera.projectionMatrix() * camera.viewMatrix());
+			geoShader.setMat4("_Model", glm::mat4(1.0f));
+			terrain.draw(&frustum, &lodSelector);
+		}
+		if (useMovingMonkey) {
+			geoShader.setMat4("_Model", movingMonkeyTransform.modelMatrix());
+			monkeyModel.draw();
+		}
+	}
+	//Culls next frame's geometry pass
+	if (useGpuOcclusion()) {
+		gpuProfiler.beginScope("Hi-Z");
+		cameraPassInstances.hiZ.build(hiZShader, gBuffer.depthBuffer, gBuffer.width, gBuffer.height, camera.projectionMatrix() * camera.viewMatrix());
+		gpuProfiler.endScope();
+	}
+	gpuProfiler.endScope();
+
+	//LIGHT CULLING
+	gpuProfiler.beginScope("Light Culling");
+	//Only copies lights that changed since last frame
+	pointLights.upload();
+	pointLights.bind(1);
+
+	int tilesX = (gBuffer.width + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+	int tilesY = (gBuffer.height + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+	if (lightingMode == LIGHTING_TILED_CPU) {
+		ew::cullLightsTiled(pointLights.getLights(), pointLights.getCount(), camera, gBuffer.width, gBuffer.height, LIGHT_TILE_SIZE, MAX_LIGHTS_PER_TILE, &lightGrid);
+		lightGridBuffer.upload(lightGrid);
+	}
+	else if (lightingMode == LIGHTING_TILED_COMPUTE) {
+		lightGridBuffer.resize(tilesX, tilesY, MAX_LIGHTS_PER_TILE);
+		lightGridBuffer.bind(2, 3);
+		lightCullShader.use();
+		lightCullShader.setInt("_NumPointLights", pointLights.getCount());
+		lightCullShader.setInt("_MaxLightsPerTile", MAX_LIGHTS_PER_TILE);
+		lightCullShader.setMat4("_View", camera.viewMatrix());
+		lightCullShader.setMat4("_InverseProjection", glm::inverse(camera.projectionMatrix()));
+		lightCullShader.setVec2("_ScreenSize", gBuffer.width, gBuffer.height);
+		glBindTextureUnit(0, gBuffer.depthBuffer);
+		glDispatchCompute(tilesX, tilesY, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+	gpuProfiler.endScope();
+	
+	//LIGHTING PASS
+	gpuProfiler.beginScope("Lighting");
+	//if using post processing, we draw to our offscreen framebuffer
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
+	glViewport(0, 0, framebuffer.width, framebuffer.height);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	defferedShader.use();
+
+	//Bind g-buffer textures
+	glBindTextureUnit(0, gBuffer.colorBuffer[0]);
+	glBindTextureUnit(1, gBuffer.colorBuffer[1]);
+	glBindTextureUnit(2, gBuffer.colorBuffer[2]);
+	glBindTextureUnit(3, getLitShadowMap().depthBuffer); //For shadow mapping, one layer per cascade
+	glBindTextureUnit(4, gBuffer.depthBuffer); //Compact G-buffer rebuilds positions from depth
+	glm::mat4 inverseViewProjection = glm::inverse(camera.projectionMatrix() * camera.viewMatrix());
+	defferedShader.setInt("_CompactGBuffer", compactGBuffer);
+	defferedShader.setMat4("_InverseViewProjection", inverseViewProjection);
+
+	//Light volumes add point lights in their own pass, so the full screen pass only does the directional light
+	defferedShader.setInt("_NumPointLights", lightingMode == LIGHTING_VOLUMES ? 0 : pointLights.getCount());
+	lightGridBuffer.bind(2, 3);
+	defferedShader.setInt("_UseTiledLights", lightingMode == LIGHTING_TILED_CPU || lightingMode == LIGHTING_TILED_COMPUTE);
+	defferedShader.setInt("_TileSize", LIGHT_TILE_SIZE);
+	defferedShader.setInt("_TilesX", tilesX);
+	defferedShader.setInt("_MaxLightsPerTile", MAX_LIGHTS_PER_TILE);
+
+	defferedShader.setFloat("_Material.Ka", material.Ka);
+	defferedShader.setFloat("_Material.Kd", material.Kd);
+	defferedShader.setFloat("_Material.Ks", material.Ks);
+	defferedShader.setFloat("_Material.Shininess", material.Shininess);
+	defferedShader.setVec3("_EyePos", camera.position);
+	defferedShader.setVec3("_LightDirection", light.direction);
+	defferedShader.setFloat("_minBias", shadow.minBias);
+	defferedShader.setFloat("_maxBias", shadow.maxBias);
+	defferedShader.setInt("_ShadowMap", 3);
+	defferedShader.setMat4("_View", camera.viewMatrix());
+	defferedShader.setInt("_ShowCascades", showCascades);
+	setShadowCascadeUniforms(defferedShader);
+
+	glBindVertexArray(dummyVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+
+	//LightOrb stuff?
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer.fbo); //Read from gBuffer 
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer.fbo); //Write to current fbo
+	glBlitFramebuffer(
+		0, 0, screenWidth, screenHeight, 0, 0, screenWidth, screenHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST
+	);
+
+	if (lightingMode == LIGHTING_VOLUMES) {
+		gpuProfiler.beginScope("Light Volumes");
+		glm::mat4 viewProjection = camera.projectionMatrix() * camera.viewMatrix();
+		//Stencil mark: counts the volumes each pixel's surface is inside. Back faces behind the surface increment
+		//and front faces behind it decrement, so volumes entirely in front of or behind the surface cancel out.
+		//Needs no front faces, so it still works with the camera inside a volume.
+		//Depth clamp keeps back faces past the far plane in both passes
+		glEnable(GL_STENCIL_TEST);
+		glStencilFunc(GL_ALWAYS, 0, 0xFF);
+		glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+		glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthMask(GL_FALSE);
+		glDisable(GL_CULL_FACE);
+		glEnable(GL_DEPTH_CLAMP);
+
+		lightVolumeMarkShader.use();
+		lightVolumeMarkShader.setMat4("_ViewProjection", viewProjection);
+		lightVolumeMarkShader.setFloat("_VolumeScale", lightVolumeScale);
+		lightVolumeMesh.drawInstanced(pointLights.getCount());
+
+		glEnable(GL_CULL_FACE);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+		//Additive pass over marked pixels only. Back faces behind the surface further limit each light to the pixels it can reach
+		glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+		glDepthFunc(GL_GEQUAL);
+		glCullFace(GL_FRONT);
+
+		lightVolumeShader.use();
+		lightVolumeShader.setMat4("_ViewProjection", viewProjection);
+		lightVolumeShader.setFloat("_VolumeScale", lightVolumeScale);
+		lightVolumeShader.setFloat("_Material.Ka", material.Ka);
+		lightVolumeShader.setFloat("_Material.Kd", material.Kd);
+		lightVolumeShader.setFloat("_Material.Ks", material.Ks);
+		lightVolumeShader.setFloat("_Material.Shininess", material.Shininess);
+		lightVolumeShader.setVec3("_EyePos", camera.position);
+		lightVolumeShader.setInt("_CompactGBuffer", compactGBuffer);
+		lightVolumeShader.setMat4("_InverseViewProjection", inverseViewProjection);
+		lightVolumeMesh.drawInstanced(pointLights.getCount());
+
+		glCullFace(GL_BACK);
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+		glDisable(GL_STENCIL_TEST);
+		glDisable(GL_DEPTH_CLAMP);
+		gpuProfiler.endScope();
+	}
+	gpuProfiler.endScope();
+
+	//Draw all light orbs
+	gpuProfiler.beginScope("Light Orbs");
+	lightOrbShader.use();
+	lightOrbShader.setMat4("_ViewProjection", camera.projectionMatrix() * camera.viewMatrix());
+	lightOrbShader.setFloat("_OrbRadius", 0.2f); //Whatever radius you want
+	sphereMesh.drawInstanced(pointLights.getCount());
+	gpuProfiler.endScope();
+
+	gpuProfiler.beginScope("Post");
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	blurShader.use();
+
+	glBindTextureUnit(0, framebuffer.colorBuffer[0]);
+	glBindVertexArray(dummyVAO);
+
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+
+	blurShader.setInt("_MainTex", 0);
+	gpuProfiler.endScope();
+}
@@ -0,0 +1,140 @@
+/*
+*	The assignment3 scene: a monkey grid lit by deferred point lights and cascaded shadows.
+*	Shared by the assignment3 window and the headless sceneRunner
+*/
+
+#pragma once
+#include <ew/external/glad.h>
+#include <ew/shader.h>
+#include <ew/model.h>
+#include <ew/mesh.h>
+#include <ew/camera.h>
+#include <ew/threadPool.h>
+#include <ew/asyncTexture.h>
+#include <ew/terrain.h>
+#include <ew/shadowCascades.h>
+#include <ew/shadowCache.h>
+#include <ew/gpuProfiler.h>
+
+//Size of the render targets, set before creating the Scene
+extern int screenWidth;
+extern int screenHeight;
+
+extern ew::Camera camera;
+
+extern bool useInstancing;
+extern bool useMultiDrawIndirect;
+extern bool useGpuCulling;
+extern bool useFrustumCulling;
+extern bool useOcclusionCulling;
+extern bool useTerrain;
+extern bool useLods;
+extern float lodBias;
+extern float shadowLodBias;
+
+struct Material {
+	float Ka = 1.0;
+	float Kd = 0.5;
+	float Ks = 0.5;
+	float Shininess = 128;
+};
+extern Material material;
+
+struct Framebuffer {
+	unsigned int fbo;
+	unsigned int colorBuffer[8];
+	unsigned int depthBuffer;
+	unsigned int width;
+	unsigned int height;
+};
+extern Framebuffer framebuffer, gBuffer;
+extern bool compactGBuffer;
+
+//Depth texture array with a layer per cascade, all rendered in one layered pass
+struct ShadowMap {
+	unsigned int fbo;
+	unsigned int depthBuffer;
+	unsigned int layerViews[ew::MAX_SHADOW_CASCADES]; //2D views of each layer, for ImGui
+	unsigned int width;
+	unsigned int height;
+};
+extern ew::ShadowCache shadowCache;
+extern bool useShadowCache;
+extern bool useMovingMonkey;
+
+//Every program the scene uses, in the order addSceneShaders adds them to a batch
+enum SceneShader {
+	LIT_SHADER, BLUR_SHADER, DEPTH_ONLY_SHADER, DEPTH_ONLY_INSTANCED_SHADER, GEO_SHADER, GEO_INSTANCED_SHADER, DEFERRED_SHADER,
+	LIGHT_ORB_SHADER, LIGHT_VOLUME_SHADER, LIGHT_VOLUME_MARK_SHADER, LIGHT_CULL_SHADER, INSTANCE_CULL_SHADER, HI_Z_SHADER, NUM_SCENE_SHADERS
+};
+extern bool reloadShaders; //Set by the UI, recompiles every scene shader while the old ones keep drawing
+
+//Times each pass on the GPU. Does nothing on drivers without timer queries
+extern ew::GpuProfiler gpuProfiler;
+
+struct Light {
+	glm::vec3 direction = glm::vec3(0,-1,0);
+	glm::vec3 color;
+};
+extern Light light;
+
+//In shadow texels, scaled by each cascade's texel size
+struct Shadow {
+	float minBias = 1.0f;
+	float maxBias = 4.0f;
+};
+extern Shadow shadow;
+
+extern ew::ShadowCascadeSettings shadowCascadeSettings;
+extern ew::ShadowCascades shadowCascades; //Refitted to the camera every frame
+extern bool showCascades;
+extern int shownCascade;
+
+//Capacity of the light buffer. Shaders read the active count from _NumPointLights
+const int MAX_POINT_LIGHTS = 4096;
+extern int numPointLights;
+
+//How point lights are assigned to pixels in the lighting pass
+enum LightingMode {
+	LIGHTING_FULLSCREEN = 0, //Every pixel loops over every light
+	LIGHTING_TILED_CPU, //Per-tile light lists built by ew::cullLightsTiled
+	LIGHTING_TILED_COMPUTE, //Per-tile light lists built by lightCull.comp using G-buffer depth bounds
+	LIGHTING_VOLUMES, //Each light rasterizes its bounding sphere and shades only the pixels it covers
+	NUM_LIGHTING_MODES
+};
+extern const char* lightingModeNames[NUM_LIGHTING_MODES];
+extern int lightingMode;
+
+void createPointLights(int count);
+void createRenderTargets(unsigned int width, unsigned int height);
+const ShadowMap& getLitShadowMap();
+void addSceneShaders(ew::ShaderBatch& batch);
+
+//Meshes, textures and programs the passes draw with. Rendering settings are the globals above
+class Scene {
+public:
+	//shaderBatch must hold addSceneShaders' programs, already submitted. Assets load while they compile
+	Scene(ew::ShaderBatch& shaderBatch);
+	Scene(const Scene&) = delete;
+	Scene& operator=(const Scene&) = delete;
+	//Streams in textures and terrain around the camera, swaps in reloaded shaders and moves the orbiting monkey
+	void update(float time);
+	//Draws every pass for the current camera, the last one into outputFramebuffer (0 for the window)
+	void render(unsigned int outputFramebuffer);
+	const ew::Terrain& getTerrain() const { return terrain; }
+	const ew::ShaderBatch& getShaderBatch() const { return shaderBatch; }
+private:
+	ew::ShaderBatch& shaderBatch;
+	bool reloadingShaders = false;
+	std::vector<ew::Shader> shaders; //In SceneShader order
+	ew::Model monkeyModel;
+	ew::ThreadPool threadPool;
+	ew::AsyncTextureLoader textureLoader;
+	ew::Terrain terrain;
+	int rockTexture;
+	ew::Mesh planeMesh;
+	ew::Mesh sphereMesh;
+	ew::Mesh lightVolumeMesh;
+	float lightVolumeScale;
+	unsigned int dummyVAO;
+};
@@ -0,0 +1,213 @@
+/*
+*	Background texture loading
+*/
+
+#include "asyncTexture.h"
+#include <stdio.h>
+#include <string.h>
+#include "external/glad.h"
+#include "external/stb_image.h"
+
+namespace ew {
+	static int getInternalFormat(int numComponents) {
+		switch (numComponents) {
+		default:
+			return GL_RGBA8;
+		case 2:
+			return GL_RG8;
+		case 1:
+			return GL_R8;
+		}
+	}
+
+	static int getPixelFormat(int numComponents) {
+		switch (numComponents) {
+		default:
+			return GL_RGBA;
+		case 2:
+			return GL_RG;
+		case 1:
+			return GL_RED;
+		}
+	}
+
+	AsyncTextureLoader::AsyncTextureLoader(ThreadPool& threadPool, int numStagingBuffers)
+		: m_threadPool(threadPool), m_stagingBuffers(numStagingBuffers < 1 ? 1 : numStagingBuffers)
+	{
+		//Mid grey so untextured surfaces still shade sensibly
+		const unsigned char grey[4] = { 128, 128, 128, 255 };
+		glCreateTextures(GL_TEXTURE_2D, 1, &m_placeholder);
+		glTextureStorage2D(m_placeholder, 1, GL_RGBA8, 1, 1);
+		glTextureSubImage2D(m_placeholder, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+	}
+
+	/// <summary>
+	/// Waits for in flight decodes, since they write back into this loader.
+	/// Uploaded textures belong to the caller and are not deleted.
+	/// </summary>
+	AsyncTextureLoader::~AsyncTextureLoader()
+	{
+		m_threadPool.waitIdle();
+		for (DecodedImage& image : m_decoded)
+		{
+			stbi_image_free(image.pixels);
+		}
+		for (StagingBuffer& staging : m_stagingBuffers)
+		{
+			if (staging.fence != nullptr) {
+				glDeleteSync((GLsync)staging.fence);
+			}
+			glDeleteBuffers(1, &staging.pbo);
+		}
+		glDeleteTextures(1, &m_placeholder);
+	}
+
+	int AsyncTextureLoader::load(const char* filePath) {
+		return load(filePath, GL_REPEAT, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR, true);
+	}
+
+	/// <summary>
+	/// Queues filePath for decoding on the thread pool
+	/// </summary>
+	/// <returns>Handle for getTexture()</returns>
+	int AsyncTextureLoader::load(const char* filePath, int wrapMode, int magFilter, int minFilter, bool mipmap) {
+		TextureRequest request;
+		request.filePath = filePath;
+		request.wrapMode = wrapMode;
+		request.magFilter = magFilter;
+		request.minFilter = minFilter;
+		request.mipmap = mipmap;
+		m_requests.push_back(request);
+		int handle = (int)m_requests.size() - 1;
+		m_numPending++;
+
+		std::string path = filePath;
+		m_threadPool.submit([this, handle, path]() {
+			DecodedImage image;
+			image.handle = handle;
+			image.pixels = nullptr;
+			int numComponents = 0;
+			if (stbi_info(path.c_str(), &image.width, &image.height, &numComponents)) {
+				//RGB is expanded to RGBA, drivers convert 3 channel uploads on the CPU anyway
+				int desiredComponents = numComponents == 3 ? 4 : numComponents;
+				image.pixels = stbi_load(path.c_str(), &image.width, &image.height, &numComponents, desiredComponents);
+				image.numComponents = desiredComponents;
+			}
+			std::lock_guard<std::mutex> lock(m_decodedMutex);
+			m_decoded.push_back(image);
+		});
+		return handle;
+	}
+
+	int AsyncTextureLoader::update(size_t maxUploadBytes)
+	{
+		std::vector<DecodedImage> decoded;
+		{
+			std::lock_guard<std::mutex> lock(m_decodedMutex);
+			decoded.swap(m_decoded);
+		}
+		size_t uploadedBytes = 0;
+		size_t i = 0;
+		for (; i < decoded.size(); i++)
+		{
+			if (maxUploadBytes > 0 && i > 0 && uploadedBytes >= maxUploadBytes) {
+				break;
+			}
+			const DecodedImage& image = decoded[i];
+			if (image.pixels == nullptr) {
+				printf("Failed to load image %s\n", m_requests[image.handle].filePath.c_str());
+			}
+			else {
+				upload(image);
+				uploadedBytes += (size_t)image.width * image.height * image.numComponents;
+				stbi_image_free(image.pixels);
+			}
+			m_numPending--;
+		}
+		//Anything over budget goes back to the front of the queue for next time
+		if (i < decoded.size()) {
+			std::lock_guard<std::mutex> lock(m_decodedMutex);
+			m_decoded.insert(m_decoded.begin(), decoded.begin() + i, decoded.end());
+		}
+		return (int)i;
+	}
+
+	void AsyncTextureLoader::finishAll()
+	{
+		while (m_numPending > 0) {
+			m_threadPool.waitIdle();
+			update();
+		}
+	}
+
+	unsigned int AsyncTextureLoader::getTexture(int handle) const
+	{
+		if (handle < 0 || handle >= (int)m_requests.size() || m_requests[handle].texture == 0) {
+			return m_placeholder;
+		}
+		return m_requests[handle].texture;
+	}
+
+	bool AsyncTextureLoader::isReady(int handle) const
+	{
+		return handle >= 0 && handle < (int)m_requests.size() && m_requests[handle].texture != 0;
+	}
+
+	/// <summary>
+	/// Copies pixels into the next staging buffer in the ring and uploads from it into immutable storage.
+	/// The buffer is only reused once the fence from its last upload has passed, so the copy never waits on the GPU
+	/// unless the ring wraps around faster than uploads complete.
+	/// </summary>
+	void AsyncTextureLoader::upload(const DecodedImage& image)
+	{
+		TextureRequest& request = m_requests[image.handle];
+		StagingBuffer& staging = m_stagingBuffers[m_nextStagingBuffer];
+		m_nextStagingBuffer = (m_nextStagingBuffer + 1) % (int)m_stagingBuffers.size();
+
+		if (staging.fence != nullptr) {
+			glClientWaitSync((GLsync)staging.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync((GLsync)staging.fence);
+			staging.fence = nullptr;
+		}
+		size_t size = (size_t)image.width * image.height * image.numComponents;
+		if (staging.size < size) {
+			glDeleteBuffers(1, &staging.pbo);
+			glCreateBuffers(1, &staging.pbo);
+			glNamedBufferStorage(staging.pbo, size, NULL, GL_MAP_WRITE_BIT);
+			staging.size = size;
+		}
+		void* mapped = glMapNamedBufferRange(staging.pbo, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		memcpy(mapped, image.pixels, size);
+		glUnmapNamedBuffer(staging.pbo);
+
+		int numLevels = 1;
+		if (request.mipmap) {
+			for (int dimension = image.width > image.height ? image.width : image.height; dimension > 1; dimension /= 2) {
+				numLevels++;
+			}
+		}
+		unsigned int texture;
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+		glTextureStorage2D(texture, numLevels, getInternalFormat(image.numComponents), image.width, image.height);
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.pbo);
+		//Rows of 1 and 2 channel images aren't 4 byte aligned in general
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTextureSubImage2D(texture, 0, 0, 0, image.width, image.height, getPixelFormat(image.numComponents), GL_UNSIGNED_BYTE, (const void*)0);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		staging.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_S, request.wrapMode);
+		glTextureParameteri(texture, GL_TEXTURE_WRAP_T, request.wrapMode);
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, request.minFilter);
+		glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, request.magFilter);
+		//Black border by default
+		float borderColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		glTextureParameterfv(texture, GL_TEXTURE_BORDER_COLOR, borderColor);
+		if (request.mipmap) {
+			glGenerateTextureMipmap(texture);
+		}
+		request.texture = texture;
+	}
+}
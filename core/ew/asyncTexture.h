@@ -0,0 +1,62 @@
+/*
+*	Background texture loading
+*/
+
+#pragma once
+#include <mutex>
+#include <string>
+#include <vector>
+#include "threadPool.h"
+
+namespace ew {
+	//Decodes images on a ThreadPool and uploads them on the GL thread through a ring of pixel buffer objects.
+	//load() returns a handle immediately; getTexture() resolves it to a 1x1 placeholder until the real texture is uploaded.
+	class AsyncTextureLoader {
+	public:
+		AsyncTextureLoader(ThreadPool& threadPool, int numStagingBuffers = 3);
+		~AsyncTextureLoader();
+		AsyncTextureLoader(const AsyncTextureLoader&) = delete;
+		AsyncTextureLoader& operator=(const AsyncTextureLoader&) = delete;
+		int load(const char* filePath);
+		int load(const char* filePath, int wrapMode, int magFilter, int minFilter, bool mipmap);
+		//Uploads decoded images, stopping once maxUploadBytes is reached (0 = no limit). At least one image per call. Returns how many were uploaded.
+		int update(size_t maxUploadBytes = 0);
+		//Blocks until every queued texture has been decoded and uploaded
+		void finishAll();
+		//Resolve every time you bind, the handle's texture changes once it's ready
+		unsigned int getTexture(int handle)const;
+		bool isReady(int handle)const;
+		inline int getNumPending()const { return m_numPending; }
+	private:
+		struct TextureRequest {
+			std::string filePath;
+			int wrapMode;
+			int magFilter;
+			int minFilter;
+			bool mipmap;
+			unsigned int texture = 0;
+		};
+		//Written by worker threads, consumed by update()
+		struct DecodedImage {
+			int handle;
+			unsigned char* pixels; //Null if decoding failed
+			int width;
+			int height;
+			int numComponents;
+		};
+		struct StagingBuffer {
+			unsigned int pbo = 0;
+			size_t size = 0;
+			void* fence = nullptr; //GLsync of the last upload read from this buffer
+		};
+		void upload(const DecodedImage& image);
+		ThreadPool& m_threadPool;
+		std::vector<TextureRequest> m_requests;
+		std::vector<DecodedImage> m_decoded;
+		std::mutex m_decodedMutex;
+		std::vector<StagingBuffer> m_stagingBuffers;
+		int m_nextStagingBuffer = 0;
+		unsigned int m_placeholder = 0;
+		int m_numPending = 0;
+	};
+}
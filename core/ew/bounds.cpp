@@ -0,0 +1,93 @@
+/*
+*	Bounding volumes
+*/
+
+#include "bounds.h"
+#include "mesh.h"
+#include <math.h>
+
+namespace ew {
+	AABB computeAABB(const Vertex* vertices, int count)
+	{
+		AABB aabb;
+		if (count <= 0) {
+			return aabb;
+		}
+		aabb.min = aabb.max = vertices[0].pos;
+		for (int i = 1; i < count; i++)
+		{
+			aabb.min = glm::min(aabb.min, vertices[i].pos);
+			aabb.max = glm::max(aabb.max, vertices[i].pos);
+		}
+		return aabb;
+	}
+
+	/// <summary>
+	/// Sphere centered on the AABB center, with radius reaching the farthest vertex.
+	/// Not minimal, but tight for the roughly symmetric meshes we use and only two passes over the data.
+	/// </summary>
+	BoundingSphere computeBoundingSphere(const Vertex* vertices, int count)
+	{
+		BoundingSphere sphere;
+		sphere.center = computeAABB(vertices, count).center();
+		float maxDistanceSquared = 0.0f;
+		for (int i = 0; i < count; i++)
+		{
+			glm::vec3 d = vertices[i].pos - sphere.center;
+			maxDistanceSquared = glm::max(maxDistanceSquared, glm::dot(d, d));
+		}
+		sphere.radius = sqrtf(maxDistanceSquared);
+		return sphere;
+	}
+
+	AABB combineAABB(const AABB& a, const AABB& b)
+	{
+		AABB aabb;
+		aabb.min = glm::min(a.min, b.min);
+		aabb.max = glm::max(a.max, b.max);
+		return aabb;
+	}
+
+	BoundingSphere combineBoundingSphere(const BoundingSphere& a, const BoundingSphere& b)
+	{
+		glm::vec3 toB = b.center - a.center;
+		float distance = glm::length(toB);
+		//One already contains the other
+		if (distance + b.radius <= a.radius) {
+			return a;
+		}
+		if (distance + a.radius <= b.radius) {
+			return b;
+		}
+		BoundingSphere sphere;
+		sphere.radius = (distance + a.radius + b.radius) * 0.5f;
+		sphere.center = a.center + toB * ((sphere.radius - a.radius) / distance);
+		return sphere;
+	}
+
+	/// <summary>
+	/// Transforms the center and projects the extents onto each world axis (Arvo's method)
+	/// </summary>
+	AABB transformAABB(const AABB& aabb, const glm::mat4& m)
+	{
+		glm::vec3 center = glm::vec3(m * glm::vec4(aabb.center(), 1.0f));
+		glm::vec3 extents = aabb.extents();
+		glm::vec3 worldExtents = glm::abs(glm::vec3(m[0])) * extents.x
+			+ glm::abs(glm::vec3(m[1])) * extents.y
+			+ glm::abs(glm::vec3(m[2])) * extents.z;
+		AABB result;
+		result.min = center - worldExtents;
+		result.max = center + worldExtents;
+		return result;
+	}
+
+	BoundingSphere transformBoundingSphere(const BoundingSphere& sphere, const glm::mat4& m)
+	{
+		BoundingSphere result;
+		result.center = glm::vec3(m * glm::vec4(sphere.center, 1.0f));
+		float maxScaleSquared = glm::max(glm::dot(glm::vec3(m[0]), glm::vec3(m[0])),
+			glm::max(glm::dot(glm::vec3(m[1]), glm::vec3(m[1])), glm::dot(glm::vec3(m[2]), glm::vec3(m[2]))));
+		result.radius = sphere.radius * sqrtf(maxScaleSquared);
+		return result;
+	}
+}
@@ -0,0 +1,31 @@
+/*
+*	Bounding volumes
+*/
+
+#pragma once
+#include <glm/glm.hpp>
+
+namespace ew {
+	struct Vertex;
+
+	struct AABB {
+		glm::vec3 min = glm::vec3(0);
+		glm::vec3 max = glm::vec3(0);
+		inline glm::vec3 center()const { return (min + max) * 0.5f; }
+		inline glm::vec3 extents()const { return (max - min) * 0.5f; }
+	};
+
+	struct BoundingSphere {
+		glm::vec3 center = glm::vec3(0);
+		float radius = 0.0f;
+	};
+
+	AABB computeAABB(const Vertex* vertices, int count);
+	BoundingSphere computeBoundingSphere(const Vertex* vertices, int count);
+	AABB combineAABB(const AABB& a, const AABB& b);
+	BoundingSphere combineBoundingSphere(const BoundingSphere& a, const BoundingSphere& b);
+	//Smallest AABB containing the transformed box
+	AABB transformAABB(const AABB& aabb, const glm::mat4& m);
+	//Conservative: radius is scaled by the largest axis scale
+	BoundingSphere transformBoundingSphere(const BoundingSphere& sphere, const glm::mat4& m);
+}
@@ -0,0 +1,126 @@
+/*
+*	View frustum extraction and culling
+*/
+
+#include "frustum.h"
+#include <math.h>
+
+namespace ew {
+	/// <summary>
+	/// Gribb/Hartmann plane extraction: each plane is the last row of the matrix plus or minus another row
+	/// </summary>
+	/// <param name="viewProjection">Maps world space to clip space</param>
+	Frustum extractFrustum(const glm::mat4& viewProjection)
+	{
+		//glm is column major, so row i is m[0][i], m[1][i]...
+		glm::vec4 rows[4];
+		for (int i = 0; i < 4; i++)
+		{
+			rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		}
+		Frustum frustum;
+		frustum.planes[0] = rows[3] + rows[0]; //Left
+		frustum.planes[1] = rows[3] - rows[0]; //Right
+		frustum.planes[2] = rows[3] + rows[1]; //Bottom
+		frustum.planes[3] = rows[3] - rows[1]; //Top
+		frustum.planes[4] = rows[3] + rows[2]; //Near
+		frustum.planes[5] = rows[3] - rows[2]; //Far
+		for (glm::vec4& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return frustum;
+	}
+
+	bool frustumIntersectsSphere(const Frustum& frustum, const glm::vec3& center, float radius)
+	{
+		for (const glm::vec4& plane : frustum.planes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool frustumIntersectsAABB(const Frustum& frustum, const AABB& aabb)
+	{
+		for (const glm::vec4& plane : frustum.planes)
+		{
+			//Corner furthest along the plane normal
+			glm::vec3 corner = glm::vec3(
+				plane.x >= 0.0f ? aabb.max.x : aabb.min.x,
+				plane.y >= 0.0f ? aabb.max.y : aabb.min.y,
+				plane.z >= 0.0f ? aabb.max.z : aabb.min.z);
+			if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void SphereBoundsSoA::push_back(const BoundingSphere& sphere)
+	{
+		x.push_back(sphere.center.x);
+		y.push_back(sphere.center.y);
+		z.push_back(sphere.center.z);
+		radius.push_back(sphere.radius);
+	}
+
+	void SphereBoundsSoA::clear()
+	{
+		x.clear();
+		y.clear();
+		z.clear();
+		radius.clear();
+	}
+
+	/// <summary>
+	/// Tests spheres in fixed size blocks. The per block loop is branch free with plane constants hoisted,
+	/// so compilers turn it into SIMD; indices are only compacted afterwards.
+	/// </summary>
+	int cullSpheres(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, int count, unsigned int* visibleIndices)
+	{
+		const int BLOCK_SIZE = 64;
+		float px[6], py[6], pz[6], pw[6];
+		for (int p = 0; p < 6; p++)
+		{
+			px[p] = frustum.planes[p].x;
+			py[p] = frustum.planes[p].y;
+			pz[p] = frustum.planes[p].z;
+			pw[p] = frustum.planes[p].w;
+		}
+
+		int numVisible = 0;
+		unsigned char inside[BLOCK_SIZE];
+		for (int start = 0; start < count; start += BLOCK_SIZE)
+		{
+			int blockCount = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+			const float* bx = x + start;
+			const float* by = y + start;
+			const float* bz = z + start;
+			const float* br = radius + start;
+			for (int i = 0; i < blockCount; i++)
+			{
+				bool visible = true;
+				for (int p = 0; p < 6; p++)
+				{
+					float distance = px[p] * bx[i] + py[p] * by[i] + pz[p] * bz[i] + pw[p];
+					visible &= distance >= -br[i];
+				}
+				inside[i] = visible;
+			}
+			for (int i = 0; i < blockCount; i++)
+			{
+				visibleIndices[numVisible] = start + i;
+				numVisible += inside[i];
+			}
+		}
+		return numVisible;
+	}
+
+	int cullSpheres(const Frustum& frustum, const SphereBoundsSoA& bounds, unsigned int* visibleIndices)
+	{
+		return cullSpheres(frustum, bounds.x.data(), bounds.y.data(), bounds.z.data(), bounds.radius.data(), bounds.size(), visibleIndices);
+	}
+}
@@ -0,0 +1,34 @@
+/*
+*	View frustum extraction and culling
+*/
+
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "bounds.h"
+
+namespace ew {
+	//World space planes with normalized, inward facing normals: dot(plane.xyz, p) + plane.w >= 0 inside.
+	//Order: left, right, bottom, top, near, far
+	struct Frustum {
+		glm::vec4 planes[6];
+	};
+
+	//Works for any view projection, e.g. Camera::projectionMatrix() * viewMatrix() or an orthographic shadow camera
+	Frustum extractFrustum(const glm::mat4& viewProjection);
+	bool frustumIntersectsSphere(const Frustum& frustum, const glm::vec3& center, float radius);
+	bool frustumIntersectsAABB(const Frustum& frustum, const AABB& aabb);
+
+	//Bounding spheres stored as separate arrays so cullSpheres can process several at once
+	struct SphereBoundsSoA {
+		std::vector<float> x, y, z, radius;
+		void push_back(const BoundingSphere& sphere);
+		void clear();
+		inline int size()const { return (int)radius.size(); }
+	};
+
+	//Writes the indices of spheres touching the frustum to visibleIndices (room for count needed) and returns how many.
+	//Conservative: spheres near a frustum corner may be kept.
+	int cullSpheres(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, int count, unsigned int* visibleIndices);
+	int cullSpheres(const Frustum& frustum, const SphereBoundsSoA& bounds, unsigned int* visibleIndices);
+}
@@ -0,0 +1,286 @@
+/*
+*	Shared vertex/index buffers for many meshes, drawn with multi-draw indirect
+*/
+
+#include "geometryArena.h"
+#include "external/glad.h"
+#include <stdio.h>
+
+namespace ew {
+	RangeAllocator::RangeAllocator(unsigned int capacity)
+	{
+		reset(capacity);
+	}
+	void RangeAllocator::reset(unsigned int capacity)
+	{
+		m_capacity = capacity;
+		m_used = 0;
+		m_freeBlocks.clear();
+		m_allocations.clear();
+		if (capacity > 0) {
+			m_freeBlocks[0] = capacity;
+		}
+	}
+	/// <summary>
+	/// First fit. The lowest free block that fits is split and its front is returned,
+	/// which keeps long lived allocations packed towards the start of the buffer.
+	/// </summary>
+	/// <param name="size">Number of elements, must be greater than 0</param>
+	unsigned int RangeAllocator::allocate(unsigned int size)
+	{
+		if (size == 0) {
+			return INVALID_OFFSET;
+		}
+		for (auto it = m_freeBlocks.begin(); it != m_freeBlocks.end(); ++it)
+		{
+			if (it->second < size) {
+				continue;
+			}
+			unsigned int offset = it->first;
+			unsigned int remaining = it->second - size;
+			m_freeBlocks.erase(it);
+			if (remaining > 0) {
+				m_freeBlocks[offset + size] = remaining;
+			}
+			m_allocations[offset] = size;
+			m_used += size;
+			return offset;
+		}
+		return INVALID_OFFSET;
+	}
+	/// <summary>
+	/// Returns a range to the free list, merging it with the free blocks directly before and after it.
+	/// </summary>
+	bool RangeAllocator::free(unsigned int offset)
+	{
+		auto allocation = m_allocations.find(offset);
+		if (allocation == m_allocations.end()) {
+			return false;
+		}
+		unsigned int size = allocation->second;
+		m_allocations.erase(allocation);
+		m_used -= size;
+
+		auto next = m_freeBlocks.lower_bound(offset);
+		if (next != m_freeBlocks.end() && next->first == offset + size) {
+			size += next->second;
+			next = m_freeBlocks.erase(next);
+		}
+		if (next != m_freeBlocks.begin()) {
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset) {
+				previous->second += size;
+				return true;
+			}
+		}
+		m_freeBlocks[offset] = size;
+		return true;
+	}
+	unsigned int RangeAllocator::getLargestFreeBlock() const
+	{
+		unsigned int largest = 0;
+		for (const auto& block : m_freeBlocks) {
+			largest = block.second > largest ? block.second : largest;
+		}
+		return largest;
+	}
+
+	int ArenaMesh::selectLod(float maxError) const
+	{
+		for (int i = (int)lods.size() - 1; i > 0; i--)
+		{
+			if (lods[i].error <= maxError) {
+				return i;
+			}
+		}
+		return 0;
+	}
+
+	//Larger than any instance count, so the base instance attribute reads one element per draw
+	static const unsigned int BASE_INSTANCE_DIVISOR = 0x7FFFFFFF;
+
+	GeometryArena::GeometryArena(unsigned int maxVertices, unsigned int maxIndices)
+	{
+		create(maxVertices, maxIndices);
+	}
+	/// <summary>
+	/// Allocates the shared buffers once, at full size. Both are immutable storage, meshes are copied in with glNamedBufferSubData.
+	/// </summary>
+	void GeometryArena::create(unsigned int maxVertices, unsigned int maxIndices)
+	{
+		m_vertexAllocator.reset(maxVertices);
+		m_indexAllocator.reset(maxIndices);
+		m_meshes.clear();
+		m_freeHandles.clear();
+
+		glCreateBuffers(1, &m_vbo);
+		glNamedBufferStorage(m_vbo, sizeof(Vertex) * maxVertices, nullptr, GL_DYNAMIC_STORAGE_BIT);
+		glCreateBuffers(1, &m_ebo);
+		glNamedBufferStorage(m_ebo, sizeof(unsigned int) * maxIndices, nullptr, GL_DYNAMIC_STORAGE_BIT);
+		glCreateBuffers(1, &m_indirectBuffer);
+
+		glCreateVertexArrays(1, &m_vao);
+		glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, sizeof(Vertex));
+		glVertexArrayElementBuffer(m_vao, m_ebo);
+		//Position attribute
+		glVertexArrayAttribFormat(m_vao, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, pos));
+		//Normal attribute
+		glVertexArrayAttribFormat(m_vao, 1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, normal));
+		//UV attribute
+		glVertexArrayAttribFormat(m_vao, 2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, uv));
+		for (unsigned int attribute = 0; attribute < 3; attribute++) {
+			glVertexArrayAttribBinding(m_vao, attribute, 0);
+			glEnableVertexArrayAttrib(m_vao, attribute);
+		}
+		//Base instance attribute, from its own buffer in binding 1
+		glVertexArrayAttribIFormat(m_vao, BASE_INSTANCE_ATTRIBUTE, 1, GL_UNSIGNED_INT, 0);
+		glVertexArrayAttribBinding(m_vao, BASE_INSTANCE_ATTRIBUTE, 1);
+		glVertexArrayBindingDivisor(m_vao, 1, BASE_INSTANCE_DIVISOR);
+		glEnableVertexArrayAttrib(m_vao, BASE_INSTANCE_ATTRIBUTE);
+		reserveBaseInstances(1024);
+	}
+	int GeometryArena::add(const MeshData& meshData)
+	{
+		return add(meshData.vertices.data(), meshData.vertices.size(), meshData.indices.data(), meshData.indices.size(),
+			meshData.lods.data(), meshData.lods.size());
+	}
+	/// <summary>
+	/// Copies a mesh into free ranges of the shared buffers. Indices are uploaded as they are, mesh relative.
+	/// </summary>
+	/// <returns>Handle for getMesh, addDrawCommand and remove, or -1 if the mesh is empty or the arena is full</returns>
+	int GeometryArena::add(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices, const MeshLod* lods, int numLods)
+	{
+		//Empty ranges can't be allocated, so would otherwise look like a full arena
+		if (numVertices <= 0 || numIndices <= 0) {
+			printf("Can't add an empty mesh of %d vertices and %d indices to the geometry arena\n", numVertices, numIndices);
+			return -1;
+		}
+		unsigned int baseVertex = m_vertexAllocator.allocate(numVertices);
+		unsigned int firstIndex = m_indexAllocator.allocate(numIndices);
+		if (baseVertex == RangeAllocator::INVALID_OFFSET || firstIndex == RangeAllocator::INVALID_OFFSET) {
+			printf("Geometry arena full, can't add a mesh of %d vertices and %d indices\n", numVertices, numIndices);
+			m_vertexAllocator.free(baseVertex);
+			m_indexAllocator.free(firstIndex);
+			return -1;
+		}
+		glNamedBufferSubData(m_vbo, sizeof(Vertex) * baseVertex, sizeof(Vertex) * numVertices, vertices);
+		glNamedBufferSubData(m_ebo, sizeof(unsigned int) * firstIndex, sizeof(unsigned int) * numIndices, indices);
+
+		ArenaMesh mesh;
+		mesh.baseVertex = baseVertex;
+		mesh.numVertices = numVertices;
+		mesh.firstIndex = firstIndex;
+		mesh.numIndices = numIndices;
+		mesh.aabb = computeAABB(vertices, numVertices);
+		mesh.boundingSphere = computeBoundingSphere(vertices, numVertices);
+		if (numLods == 0) {
+			mesh.lods.push_back(MeshLod{ firstIndex, (unsigned int)numIndices, 0.0f });
+		}
+		for (int i = 0; i < numLods; i++) {
+			mesh.lods.push_back(MeshLod{ firstIndex + lods[i].firstIndex, lods[i].numIndices, lods[i].error });
+		}
+
+		if (m_freeHandles.empty()) {
+			m_meshes.push_back(mesh);
+			return (int)m_meshes.size() - 1;
+		}
+		int handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+		m_meshes[handle] = mesh;
+		return handle;
+	}
+	/// <summary>
+	/// Frees a mesh's ranges for reuse. Draws already submitted still read the old data, the GL orders later uploads after them.
+	/// </summary>
+	void GeometryArena::remove(int handle)
+	{
+		ArenaMesh& mesh = m_meshes[handle];
+		if (mesh.lods.empty()) {
+			return;
+		}
+		m_vertexAllocator.free(mesh.baseVertex);
+		m_indexAllocator.free(mesh.firstIndex);
+		mesh = ArenaMesh();
+		m_freeHandles.push_back(handle);
+	}
+	void GeometryArena::addDrawCommand(std::vector<DrawElementsIndirectCommand>& commands, int handle, int lod, unsigned int instanceCount, unsigned int baseInstance) const
+	{
+		const ArenaMesh& mesh = m_meshes[handle];
+		const MeshLod& range = mesh.lods[glm::clamp(lod, 0, (int)mesh.lods.size() - 1)];
+		commands.push_back(DrawElementsIndirectCommand{ range.numIndices, instanceCount, range.firstIndex, (int)mesh.baseVertex, baseInstance });
+	}
+	/// <summary>
+	/// Grows the 0, 1, 2... buffer that turns each command's baseInstance into a vertex attribute.
+	/// GL 4.5 shaders can't read baseInstance directly, instanced attributes are offset by it.
+	/// </summary>
+	void GeometryArena::reserveBaseInstances(unsigned int count)
+	{
+		if (count <= m_baseInstanceCapacity) {
+			return;
+		}
+		count = glm::max(count, m_baseInstanceCapacity * 2);
+		std::vector<unsigned int> values(count);
+		for (unsigned int i = 0; i < count; i++) {
+			values[i] = i;
+		}
+		glDeleteBuffers(1, &m_baseInstanceBuffer);
+		glCreateBuffers(1, &m_baseInstanceBuffer);
+		glNamedBufferStorage(m_baseInstanceBuffer, sizeof(unsigned int) * count, values.data(), 0);
+		glVertexArrayVertexBuffer(m_vao, 1, m_baseInstanceBuffer, 0, sizeof(unsigned int));
+		m_baseInstanceCapacity = count;
+	}
+	void GeometryArena::draw(const std::vector<DrawElementsIndirectCommand>& commands)
+	{
+		draw(commands.data(), commands.size());
+	}
+	/// <summary>
+	/// Uploads the commands to the indirect buffer and submits them in one call.
+	/// Instance data (e.g. an ew::InstanceBuffer) must be bound by the caller.
+	/// </summary>
+	void GeometryArena::draw(const DrawElementsIndirectCommand* commands, int numCommands)
+	{
+		if (numCommands == 0) {
+			return;
+		}
+		unsigned int instances = 0;
+		unsigned int triangles = 0;
+		unsigned int baseInstanceEnd = 0;
+		for (int i = 0; i < numCommands; i++) {
+			instances += commands[i].instanceCount;
+			triangles += commands[i].count / 3 * commands[i].instanceCount;
+			baseInstanceEnd = glm::max(baseInstanceEnd, commands[i].baseInstance + 1);
+		}
+		reserveBaseInstances(baseInstanceEnd);
+		if ((unsigned int)numCommands > m_indirectCapacity) {
+			glNamedBufferData(m_indirectBuffer, sizeof(DrawElementsIndirectCommand) * numCommands, commands, GL_DYNAMIC_DRAW);
+			m_indirectCapacity = numCommands;
+		}
+		else {
+			glNamedBufferSubData(m_indirectBuffer, 0, sizeof(DrawElementsIndirectCommand) * numCommands, commands);
+		}
+		multiDraw(m_indirectBuffer, numCommands);
+		recordDrawCall(instances, triangles);
+	}
+	/// <summary>
+	/// Instance and triangle counts only exist on the GPU, so draw stats count the call alone.
+	/// </summary>
+	void GeometryArena::drawIndirect(unsigned int indirectBuffer, int numCommands, unsigned int maxInstances)
+	{
+		if (numCommands == 0) {
+			return;
+		}
+		reserveBaseInstances(maxInstances);
+		multiDraw(indirectBuffer, numCommands);
+		recordDrawCall(0, 0);
+	}
+	void GeometryArena::multiDraw(unsigned int indirectBuffer, int numCommands)
+	{
+		glBindVertexArray(m_vao);
+		//Full float vertices, no dequantization
+		glVertexAttrib3f(POSITION_SCALE_ATTRIBUTE, 1.0f, 1.0f, 1.0f);
+		glVertexAttrib3f(POSITION_OFFSET_ATTRIBUTE, 0.0f, 0.0f, 0.0f);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, numCommands, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+}
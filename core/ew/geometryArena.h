@@ -0,0 +1,96 @@
+/*
+*	Shared vertex/index buffers for many meshes, drawn with multi-draw indirect
+*/
+
+#pragma once
+#include <map>
+#include <vector>
+#include "mesh.h"
+
+namespace ew {
+	//Free-list suballocator over a range of [0, capacity) elements. Doesn't touch GL, the arena uses one per buffer.
+	//First fit over free blocks sorted by offset, neighbouring free blocks merge when a range is freed.
+	class RangeAllocator {
+	public:
+		static const unsigned int INVALID_OFFSET = 0xFFFFFFFF;
+		RangeAllocator() {};
+		RangeAllocator(unsigned int capacity);
+		//Forgets every allocation
+		void reset(unsigned int capacity);
+		//Returns INVALID_OFFSET if no free block is large enough
+		unsigned int allocate(unsigned int size);
+		//offset must come from allocate(). Returns false for ranges that aren't allocated
+		bool free(unsigned int offset);
+		inline unsigned int getCapacity()const { return m_capacity; }
+		inline unsigned int getUsed()const { return m_used; }
+		inline int getNumFreeBlocks()const { return (int)m_freeBlocks.size(); }
+		unsigned int getLargestFreeBlock()const;
+	private:
+		std::map<unsigned int, unsigned int> m_freeBlocks; //Offset -> size
+		std::map<unsigned int, unsigned int> m_allocations; //Offset -> size
+		unsigned int m_capacity = 0;
+		unsigned int m_used = 0;
+	};
+
+	//Matches the layout glMultiDrawElementsIndirect reads
+	struct DrawElementsIndirectCommand {
+		unsigned int count;
+		unsigned int instanceCount;
+		unsigned int firstIndex;
+		int baseVertex;
+		unsigned int baseInstance;
+	};
+
+	//Where a mesh lives in the arena. Indices stay mesh relative and are offset by baseVertex when drawn
+	struct ArenaMesh {
+		unsigned int baseVertex;
+		unsigned int numVertices;
+		unsigned int firstIndex; //Every LOD's indices
+		unsigned int numIndices;
+		std::vector<MeshLod> lods; //firstIndex relative to the arena's index buffer
+		AABB aabb;
+		BoundingSphere boundingSphere;
+		inline int getNumLods()const { return (int)lods.size(); }
+		inline const BoundingSphere& getBoundingSphere()const { return boundingSphere; }
+		int selectLod(float maxError)const;
+	};
+
+	//All meshes share one VAO, one vertex buffer and one 32 bit index buffer, so any list of them
+	//draws with a single glMultiDrawElementsIndirect. Meshes can be added and removed at any time, e.g. while streaming.
+	//Vertices are stored FULL: PACKED dequantizes per mesh, which a single draw can't vary.
+	//Shaders index instances as _Models[vBaseInstance + gl_InstanceID], reading BASE_INSTANCE_ATTRIBUTE.
+	class GeometryArena {
+	public:
+		GeometryArena() {};
+		GeometryArena(unsigned int maxVertices, unsigned int maxIndices);
+		void create(unsigned int maxVertices, unsigned int maxIndices);
+		//Returns a handle, or -1 if the mesh has no vertices or indices or either buffer has no block large enough
+		int add(const MeshData& meshData);
+		int add(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices, const MeshLod* lods = nullptr, int numLods = 0);
+		void remove(int handle);
+		inline const ArenaMesh& getMesh(int handle)const { return m_meshes[handle]; }
+		//Appends a command drawing instanceCount instances of a mesh LOD, reading instances from baseInstance on
+		void addDrawCommand(std::vector<DrawElementsIndirectCommand>& commands, int handle, int lod, unsigned int instanceCount, unsigned int baseInstance)const;
+		//One glMultiDrawElementsIndirect for every command
+		void draw(const std::vector<DrawElementsIndirectCommand>& commands);
+		void draw(const DrawElementsIndirectCommand* commands, int numCommands);
+		//Draws commands already in a GPU buffer, e.g. written by GpuInstanceCuller. Base instances must be below maxInstances
+		void drawIndirect(unsigned int indirectBuffer, int numCommands, unsigned int maxInstances);
+		inline const RangeAllocator& getVertexAllocator()const { return m_vertexAllocator; }
+		inline const RangeAllocator& getIndexAllocator()const { return m_indexAllocator; }
+	private:
+		void reserveBaseInstances(unsigned int count);
+		void multiDraw(unsigned int indirectBuffer, int numCommands);
+		RangeAllocator m_vertexAllocator;
+		RangeAllocator m_indexAllocator;
+		std::vector<ArenaMesh> m_meshes;
+		std::vector<int> m_freeHandles;
+		unsigned int m_vao = 0;
+		unsigned int m_vbo = 0;
+		unsigned int m_ebo = 0;
+		unsigned int m_indirectBuffer = 0;
+		unsigned int m_indirectCapacity = 0; //Commands
+		unsigned int m_baseInstanceBuffer = 0; //0, 1, 2... read with a divisor so each draw sees its baseInstance
+		unsigned int m_baseInstanceCapacity = 0;
+	};
+}
@@ -0,0 +1,246 @@
+/*
+*	GPU pass timings from GL_TIMESTAMP queries, read back a few frames late so the CPU never waits on them
+*/
+
+#include "gpuProfiler.h"
+#include <stdio.h>
+#include <string.h>
+#include "external/glad.h"
+
+namespace ew {
+	bool GpuProfiler::create()
+	{
+		if (m_available) {
+			return true;
+		}
+		//Some software drivers expose the query functions but report a 0 bit counter
+		int counterBits = 0;
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counterBits);
+		if (counterBits <= 0) {
+			printf("GPU timer queries are unavailable, GPU profiling is off\n");
+			return false;
+		}
+		for (FrameQueries& frame : m_frames)
+		{
+			frame.queries.resize(MAX_GPU_SCOPES * 2 + 2);
+			glCreateQueries(GL_TIMESTAMP, (int)frame.queries.size(), frame.queries.data());
+			frame.scopes.reserve(MAX_GPU_SCOPES);
+		}
+		m_available = true;
+		return true;
+	}
+
+	/// <summary>
+	/// Reads back every frame whose queries have finished, then starts recording into the oldest slot.
+	/// A slot still unfinished after GPU_PROFILER_FRAMES frames is dropped rather than waited on.
+	/// </summary>
+	void GpuProfiler::beginFrame()
+	{
+		if (!m_available) {
+			return;
+		}
+		if (m_recording) {
+			endFrame();
+		}
+		resolveFrames();
+		FrameQueries& frame = m_frames[m_frameIndex % GPU_PROFILER_FRAMES];
+		if (frame.pending) {
+			m_numDroppedFrames++;
+		}
+		frame.pending = false;
+		frame.scopes.clear();
+		frame.frame = m_frameIndex;
+		frame.numQueries = 0;
+		glQueryCounter(frame.queries[frame.numQueries++], GL_TIMESTAMP);
+		m_openScopes.clear();
+		m_recording = true;
+	}
+
+	void GpuProfiler::endFrame()
+	{
+		if (!m_recording) {
+			return;
+		}
+		while (!m_openScopes.empty()) {
+			endScope();
+		}
+		FrameQueries& frame = m_frames[m_frameIndex % GPU_PROFILER_FRAMES];
+		frame.endQuery = frame.numQueries++;
+		glQueryCounter(frame.queries[frame.endQuery], GL_TIMESTAMP);
+		frame.pending = true;
+		m_recording = false;
+		m_frameIndex++;
+	}
+
+	void GpuProfiler::beginScope(const char* name)
+	{
+		if (!m_recording) {
+			return;
+		}
+		FrameQueries& frame = m_frames[m_frameIndex % GPU_PROFILER_FRAMES];
+		if ((int)frame.scopes.size() >= MAX_GPU_SCOPES) {
+			m_openScopes.push_back(-1);
+			return;
+		}
+		RecordedScope scope;
+		scope.name = name;
+		scope.depth = (int)m_openScopes.size();
+		scope.parent = m_openScopes.empty() ? -1 : m_openScopes.back();
+		scope.beginQuery = frame.numQueries++;
+		scope.endQuery = -1;
+		glQueryCounter(frame.queries[scope.beginQuery], GL_TIMESTAMP);
+		m_openScopes.push_back((int)frame.scopes.size());
+		frame.scopes.push_back(scope);
+	}
+
+	void GpuProfiler::endScope()
+	{
+		if (!m_recording || m_openScopes.empty()) {
+			return;
+		}
+		int index = m_openScopes.back();
+		m_openScopes.pop_back();
+		if (index < 0) {
+			return;
+		}
+		FrameQueries& frame = m_frames[m_frameIndex % GPU_PROFILER_FRAMES];
+		RecordedScope& scope = frame.scopes[index];
+		scope.endQuery = frame.numQueries++;
+		glQueryCounter(frame.queries[scope.endQuery], GL_TIMESTAMP);
+	}
+
+	/// <summary>
+	/// Oldest first. Timestamps finish in order, so once a frame's last query is available all of its queries are,
+	/// and reading them doesn't wait. The first frame still in flight ends the search.
+	/// </summary>
+	void GpuProfiler::resolveFrames()
+	{
+		uint64_t first = m_frameIndex > GPU_PROFILER_FRAMES ? m_frameIndex - GPU_PROFILER_FRAMES : 0;
+		for (uint64_t frameIndex = first; frameIndex < m_frameIndex; frameIndex++)
+		{
+			FrameQueries& frame = m_frames[frameIndex % GPU_PROFILER_FRAMES];
+			if (!frame.pending || frame.frame != frameIndex) {
+				continue;
+			}
+			int available = 0;
+			glGetQueryObjectiv(frame.queries[frame.endQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) {
+				break;
+			}
+			uint64_t timestamps[MAX_GPU_SCOPES * 2 + 2];
+			for (int i = 0; i < frame.numQueries; i++)
+			{
+				glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+			}
+			GpuFrameTiming timing;
+			timing.frame = frame.frame;
+			timing.begin = timestamps[0];
+			timing.end = timestamps[frame.endQuery];
+			timing.scopes.reserve(frame.scopes.size());
+			for (const RecordedScope& scope : frame.scopes)
+			{
+				GpuScopeTiming scopeTiming;
+				scopeTiming.name = scope.name;
+				scopeTiming.depth = scope.depth;
+				scopeTiming.parent = scope.parent;
+				scopeTiming.begin = timestamps[scope.beginQuery];
+				scopeTiming.end = timestamps[scope.endQuery];
+				timing.scopes.push_back(scopeTiming);
+			}
+			m_history.push_back(timing);
+			if ((int)m_history.size() > GPU_PROFILER_HISTORY) {
+				m_history.pop_front();
+			}
+			frame.pending = false;
+		}
+	}
+
+	const GpuFrameTiming* GpuProfiler::getLatestFrame() const
+	{
+		return m_history.empty() ? nullptr : &m_history.back();
+	}
+
+	void GpuProfiler::getFrameHistory(std::vector<float>* milliseconds) const
+	{
+		milliseconds->clear();
+		for (const GpuFrameTiming& frame : m_history)
+		{
+			milliseconds->push_back((float)frame.getMilliseconds());
+		}
+	}
+
+	void GpuProfiler::getScopeHistory(const char* name, std::vector<float>* milliseconds) const
+	{
+		milliseconds->clear();
+		for (const GpuFrameTiming& frame : m_history)
+		{
+			double total = 0.0;
+			for (const GpuScopeTiming& scope : frame.scopes)
+			{
+				if (strcmp(scope.name, name) == 0) {
+					total += scope.getMilliseconds();
+				}
+			}
+			milliseconds->push_back((float)total);
+		}
+	}
+
+	void writeJsonString(FILE* file, const char* string)
+	{
+		fputc('"', file);
+		for (const char* c = string; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\') {
+				fputc('\\', file);
+				fputc(*c, file);
+			}
+			else if ((unsigned char)*c < 0x20) {
+				fprintf(file, "\\u%04x", *c);
+			}
+			else {
+				fputc(*c, file);
+			}
+		}
+		fputc('"', file);
+	}
+
+	//Times are in microseconds from origin
+	static void writeTraceEvent(FILE* file, const char* name, uint64_t begin, uint64_t end, uint64_t origin, uint64_t frame, bool first)
+	{
+		fprintf(file, first ? "\n{\"name\":" : ",\n{\"name\":");
+		writeJsonString(file, name);
+		fprintf(file, ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu}}",
+			(begin - origin) / 1000.0, (end - begin) / 1000.0, (unsigned long long)frame);
+	}
+
+	/// <summary>
+	/// Frames and scopes nest by time on one track, which is how trace viewers draw hierarchy.
+	/// Times start from the oldest frame in the history.
+	/// </summary>
+	bool GpuProfiler::writeChromeTrace(const std::string& path) const
+	{
+		FILE* file = fopen(path.c_str(), "w");
+		if (file == NULL) {
+			printf("Failed to write trace %s\n", path.c_str());
+			return false;
+		}
+		uint64_t origin = m_history.empty() ? 0 : m_history.front().begin;
+		fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+		bool first = true;
+		for (const GpuFrameTiming& frame : m_history)
+		{
+			writeTraceEvent(file, "Frame", frame.begin, frame.end, origin, frame.frame, first);
+			first = false;
+			for (const GpuScopeTiming& scope : frame.scopes)
+			{
+				writeTraceEvent(file, scope.name, scope.begin, scope.end, origin, frame.frame, false);
+			}
+		}
+		fprintf(file, "\n]}\n");
+		if (fclose(file) != 0) {
+			printf("Failed to write trace %s\n", path.c_str());
+			return false;
+		}
+		return true;
+	}
+}
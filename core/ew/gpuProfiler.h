@@ -0,0 +1,87 @@
+/*
+*	GPU pass timings from GL_TIMESTAMP queries, read back a few frames late so the CPU never waits on them
+*/
+
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace ew {
+	const int GPU_PROFILER_FRAMES = 4; //Frames of queries in flight. Results are read back this many frames late
+	const int MAX_GPU_SCOPES = 64; //Per frame, further scopes are ignored
+	const int GPU_PROFILER_HISTORY = 240; //Resolved frames kept for graphs and traces
+
+	struct GpuScopeTiming {
+		const char* name;
+		int depth; //0 for scopes directly in the frame
+		int parent; //Index into the frame's scopes, -1 at depth 0
+		uint64_t begin; //GPU timestamps in nanoseconds
+		uint64_t end;
+		inline double getMilliseconds()const { return (end - begin) / 1e6; }
+	};
+
+	struct GpuFrameTiming {
+		uint64_t frame; //Counts beginFrame calls
+		uint64_t begin; //From beginFrame to endFrame, including any time the GPU sat idle
+		uint64_t end;
+		std::vector<GpuScopeTiming> scopes; //In the order they began, parents before children
+		inline double getMilliseconds()const { return (end - begin) / 1e6; }
+	};
+
+	//Times named, nested scopes of GPU work. Every call does nothing if the driver has no timer queries
+	//(GL_QUERY_COUNTER_BITS of 0), so profiling can stay in the code on any driver.
+	class GpuProfiler {
+	public:
+		GpuProfiler() = default;
+		GpuProfiler(const GpuProfiler&) = delete;
+		GpuProfiler& operator=(const GpuProfiler&) = delete;
+		//Needs a current context. Returns false if timer queries are unavailable
+		bool create();
+		inline bool isAvailable()const { return m_available; }
+		void beginFrame();
+		void endFrame();
+		//name must outlive the profiler, e.g. a string literal
+		void beginScope(const char* name);
+		void endScope();
+		//Most recent resolved frame, or null before the first one resolves
+		const GpuFrameTiming* getLatestFrame()const;
+		inline const std::deque<GpuFrameTiming>& getHistory()const { return m_history; }
+		//Milliseconds per resolved frame, oldest first. Scopes sharing a name add up, frames without one give 0
+		void getFrameHistory(std::vector<float>* milliseconds)const;
+		void getScopeHistory(const char* name, std::vector<float>* milliseconds)const;
+		//Frames whose queries were still unfinished when their slot came around again
+		inline int getNumDroppedFrames()const { return m_numDroppedFrames; }
+		//Every frame in the history as complete events ("ph": "X"), for chrome://tracing or Perfetto
+		bool writeChromeTrace(const std::string& path)const;
+	private:
+		struct RecordedScope {
+			const char* name;
+			int depth;
+			int parent;
+			int beginQuery;
+			int endQuery;
+		};
+		struct FrameQueries {
+			std::vector<unsigned int> queries; //Frame begin, a begin and end per scope, frame end
+			std::vector<RecordedScope> scopes;
+			int numQueries = 0;
+			int endQuery = 0;
+			uint64_t frame = 0;
+			bool pending = false; //Recorded and not read back yet
+		};
+		void resolveFrames();
+		FrameQueries m_frames[GPU_PROFILER_FRAMES];
+		std::deque<GpuFrameTiming> m_history;
+		std::vector<int> m_openScopes; //Indices into the current frame's scopes, -1 for ignored ones
+		uint64_t m_frameIndex = 0;
+		int m_numDroppedFrames = 0;
+		bool m_available = false;
+		bool m_recording = false;
+	};
+
+	//Writes string as a quoted JSON string, escaping quotes, backslashes and control characters
+	void writeJsonString(FILE* file, const char* string);
+}
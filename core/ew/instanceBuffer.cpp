@@ -0,0 +1,42 @@
+/*
+*	Per-instance transforms for instanced drawing
+*/
+
+#include "instanceBuffer.h"
+#include "external/glad.h"
+
+namespace ew {
+	InstanceBuffer::InstanceBuffer(const std::vector<glm::mat4>& transforms)
+	{
+		load(transforms);
+	}
+	void InstanceBuffer::load(const std::vector<glm::mat4>& transforms)
+	{
+		load(transforms.data(), (int)transforms.size());
+	}
+	/// <summary>
+	/// Uploads instance transforms. The buffer only reallocates when it needs to grow,
+	/// so it is cheap to reload every frame with a varying number of instances.
+	/// </summary>
+	/// <param name="transforms">Model matrices, one per instance</param>
+	/// <param name="count">Number of instances</param>
+	void InstanceBuffer::load(const glm::mat4* transforms, int count)
+	{
+		if (!m_initialized) {
+			glCreateBuffers(1, &m_ssbo);
+			m_initialized = true;
+		}
+		if (count > m_capacity) {
+			glNamedBufferData(m_ssbo, sizeof(glm::mat4) * count, transforms, GL_DYNAMIC_DRAW);
+			m_capacity = count;
+		}
+		else if (count > 0) {
+			glNamedBufferSubData(m_ssbo, 0, sizeof(glm::mat4) * count, transforms);
+		}
+		m_count = count;
+	}
+	void InstanceBuffer::bind(unsigned int bindingIndex) const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingIndex, m_ssbo);
+	}
+}
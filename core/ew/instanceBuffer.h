@@ -0,0 +1,26 @@
+/*
+*	Per-instance transforms for instanced drawing
+*/
+
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace ew {
+	//Model matrices stored in a shader storage buffer.
+	//Instanced shaders read them as _Models[gl_InstanceID] from the bound binding index.
+	class InstanceBuffer {
+	public:
+		InstanceBuffer() {};
+		InstanceBuffer(const std::vector<glm::mat4>& transforms);
+		void load(const std::vector<glm::mat4>& transforms);
+		void load(const glm::mat4* transforms, int count);
+		void bind(unsigned int bindingIndex = 0)const;
+		inline int getCount()const { return m_count; }
+	private:
+		bool m_initialized = false;
+		unsigned int m_ssbo = 0;
+		int m_count = 0;
+		int m_capacity = 0;
+	};
+}
@@ -0,0 +1,223 @@
+/*
+*	GPU driven instance culling and indirect draw command generation
+*/
+
+#include "instanceCulling.h"
+#include "external/glad.h"
+#include <stdio.h>
+
+namespace ew {
+	unsigned int CullScene::addMeshType(const float* lodErrors, int numLods, float radius)
+	{
+		CullMeshType meshType = {};
+		meshType.numLods = glm::clamp(numLods, 1, MAX_CULL_LODS);
+		for (int i = 0; i < MAX_CULL_LODS; i++) {
+			meshType.lodErrors[i] = i < numLods ? lodErrors[i] : 0.0f;
+		}
+		meshType.radius = radius;
+		meshTypes.push_back(meshType);
+		return (unsigned int)meshTypes.size() - 1;
+	}
+	void CullScene::addInstance(unsigned int meshType, const BoundingSphere& worldBounds)
+	{
+		CullInstance instance = {};
+		instance.sphere = glm::vec4(worldBounds.center, worldBounds.radius);
+		instance.meshType = meshType;
+		instances.push_back(instance);
+	}
+	void CullScene::addCommand(const DrawElementsIndirectCommand& command, unsigned int meshType, int lod)
+	{
+		commands.push_back(command);
+		commandBins.push_back(meshType * MAX_CULL_LODS + lod);
+	}
+
+	/// <summary>
+	/// Same math, in the same order, as cullSpheres and getMaxLodError. instanceCull.comp mirrors this line for line
+	/// and marks it precise, so results only differ if the GPU's division or square root aren't correctly rounded.
+	/// </summary>
+	unsigned int classifyInstance(const CullScene& scene, int instance, const Frustum* frustum, const LodSelector* lodSelector, const HiZPyramid* occlusion)
+	{
+		const CullInstance& cullInstance = scene.instances[instance];
+		glm::vec3 center = glm::vec3(cullInstance.sphere);
+		float radius = cullInstance.sphere.w;
+		if (frustum != nullptr) {
+			for (int p = 0; p < 6; p++)
+			{
+				const glm::vec4& plane = frustum->planes[p];
+				float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+				if (!(distance >= -radius)) {
+					return CULLED_BIN;
+				}
+			}
+		}
+		if (occlusion != nullptr && isOccluded(*occlusion, AABB{ center - radius, center + radius })) {
+			return CULLED_BIN;
+		}
+		const CullMeshType& meshType = scene.meshTypes[cullInstance.meshType];
+		int lod = 0;
+		if (lodSelector != nullptr) {
+			BoundingSphere bounds = { center, radius };
+			float scale = radius / meshType.radius;
+			float maxError = getMaxLodError(*lodSelector, bounds) / scale;
+			for (int i = meshType.numLods - 1; i > 0; i--)
+			{
+				if (meshType.lodErrors[i] <= maxError) {
+					lod = i;
+					break;
+				}
+			}
+		}
+		return cullInstance.meshType * MAX_CULL_LODS + lod;
+	}
+
+	/// <summary>
+	/// Counting sort of the visible instances by bin. Stable, so ids within a bin stay in instance order like the GPU's
+	/// per workgroup compaction.
+	/// </summary>
+	void cullInstances(const CullScene& scene, const Frustum* frustum, const LodSelector* lodSelector, CullResult* result, const HiZPyramid* occlusion)
+	{
+		int numInstances = scene.instances.size();
+		int numBins = scene.getNumBins();
+		std::vector<unsigned int> bins(numInstances);
+		std::vector<unsigned int> binOffsets(numBins + 1, 0);
+		for (int i = 0; i < numInstances; i++)
+		{
+			bins[i] = classifyInstance(scene, i, frustum, lodSelector, occlusion);
+			if (bins[i] != CULLED_BIN) {
+				binOffsets[bins[i] + 1]++;
+			}
+		}
+		std::vector<unsigned int> binCounts(binOffsets.begin() + 1, binOffsets.end());
+		for (int bin = 0; bin < numBins; bin++) {
+			binOffsets[bin + 1] += binOffsets[bin];
+		}
+		result->numVisible = binOffsets[numBins];
+		result->commands = scene.commands;
+		for (size_t c = 0; c < result->commands.size(); c++)
+		{
+			unsigned int bin = scene.commandBins[c];
+			result->commands[c].instanceCount = binCounts[bin];
+			result->commands[c].baseInstance = binOffsets[bin];
+		}
+		result->instanceIds.resize(result->numVisible);
+		for (int i = 0; i < numInstances; i++)
+		{
+			if (bins[i] != CULLED_BIN) {
+				result->instanceIds[binOffsets[bins[i]]++] = i;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Uploads the scene and sizes the scratch buffers the three culling stages share.
+	/// </summary>
+	void GpuInstanceCuller::upload(const CullScene& scene)
+	{
+		if (!m_initialized) {
+			glCreateBuffers(1, &m_instanceBuffer);
+			glCreateBuffers(1, &m_meshTypeBuffer);
+			glCreateBuffers(1, &m_commandBinBuffer);
+			glCreateBuffers(1, &m_commandBuffer);
+			glCreateBuffers(1, &m_instanceIdBuffer);
+			glCreateBuffers(1, &m_instanceBinBuffer);
+			glCreateBuffers(1, &m_groupCountBuffer);
+			m_initialized = true;
+		}
+		m_numInstances = scene.instances.size();
+		m_numCommands = scene.commands.size();
+		m_numBins = scene.getNumBins();
+		if (m_numBins > CULL_GROUP_SIZE) {
+			printf("Instance culling supports at most %d bins, got %d\n", CULL_GROUP_SIZE, m_numBins);
+			m_numBins = m_numInstances = m_numCommands = 0;
+			return;
+		}
+		int numGroups = (m_numInstances + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+		//Size 0 buffers can't be bound, everything gets at least one element
+		glNamedBufferData(m_instanceBuffer, sizeof(CullInstance) * glm::max(m_numInstances, 1), NULL, GL_STATIC_DRAW);
+		glNamedBufferSubData(m_instanceBuffer, 0, sizeof(CullInstance) * m_numInstances, scene.instances.data());
+		glNamedBufferData(m_meshTypeBuffer, sizeof(CullMeshType) * glm::max((int)scene.meshTypes.size(), 1), NULL, GL_STATIC_DRAW);
+		glNamedBufferSubData(m_meshTypeBuffer, 0, sizeof(CullMeshType) * scene.meshTypes.size(), scene.meshTypes.data());
+		glNamedBufferData(m_commandBinBuffer, sizeof(unsigned int) * glm::max(m_numCommands, 1), NULL, GL_STATIC_DRAW);
+		glNamedBufferSubData(m_commandBinBuffer, 0, sizeof(unsigned int) * m_numCommands, scene.commandBins.data());
+		glNamedBufferData(m_commandBuffer, sizeof(DrawElementsIndirectCommand) * glm::max(m_numCommands, 1), NULL, GL_DYNAMIC_DRAW);
+		glNamedBufferSubData(m_commandBuffer, 0, sizeof(DrawElementsIndirectCommand) * m_numCommands, scene.commands.data());
+		glNamedBufferData(m_instanceIdBuffer, sizeof(unsigned int) * glm::max(m_numInstances, 1), NULL, GL_DYNAMIC_DRAW);
+		glNamedBufferData(m_instanceBinBuffer, sizeof(unsigned int) * glm::max(m_numInstances, 1), NULL, GL_DYNAMIC_DRAW);
+		//Per workgroup and bin counts, then the total visible count
+		glNamedBufferData(m_groupCountBuffer, sizeof(unsigned int) * (numGroups * m_numBins + 1), NULL, GL_DYNAMIC_DRAW);
+	}
+	/// <summary>
+	/// Stage 0 classifies instances and counts each workgroup's instances per bin,
+	/// stage 1 (one workgroup) turns the counts into offsets and fills in the commands,
+	/// stage 2 writes each visible instance's id at its bin offset plus its rank within the workgroup.
+	/// Nothing depends on atomic ordering, so the output is deterministic.
+	/// </summary>
+	/// <param name="frustum">Null draws everything</param>
+	/// <param name="lodSelector">Null always draws LOD 0</param>
+	/// <param name="occlusion">Null or an unbuilt HiZBuffer skips occlusion culling</param>
+	void GpuInstanceCuller::cull(const Shader& cullShader, const Frustum* frustum, const LodSelector* lodSelector, const HiZBuffer* occlusion)
+	{
+		if (m_numInstances == 0) {
+			return;
+		}
+		int numGroups = (m_numInstances + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+		cullShader.use();
+		cullShader.setInt("_NumInstances", m_numInstances);
+		cullShader.setInt("_NumCommands", m_numCommands);
+		cullShader.setInt("_NumBins", m_numBins);
+		cullShader.setInt("_NumGroups", numGroups);
+		cullShader.setInt("_UseFrustum", frustum != nullptr);
+		if (frustum != nullptr) {
+			for (int p = 0; p < 6; p++) {
+				cullShader.setVec4("_FrustumPlanes[" + std::to_string(p) + "]", frustum->planes[p]);
+			}
+		}
+		cullShader.setInt("_UseLods", lodSelector != nullptr);
+		if (lodSelector != nullptr) {
+			cullShader.setVec3("_CameraPosition", lodSelector->cameraPosition);
+			cullShader.setFloat("_PixelsPerUnit", lodSelector->pixelsPerUnit);
+			cullShader.setInt("_Orthographic", lodSelector->orthographic);
+			cullShader.setFloat("_MaxPixelError", lodSelector->maxPixelError);
+		}
+		bool useOcclusion = occlusion != nullptr && occlusion->isValid();
+		cullShader.setInt("_UseOcclusion", useOcclusion);
+		if (useOcclusion) {
+			cullShader.setMat4("_HiZViewProjection", occlusion->getViewProjection());
+			occlusion->bind(7);
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_instanceBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_meshTypeBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_commandBinBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_commandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_instanceIdBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, m_instanceBinBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, m_groupCountBuffer);
+
+		cullShader.setInt("_Stage", 0);
+		glDispatchCompute(numGroups, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		cullShader.setInt("_Stage", 1);
+		glDispatchCompute(1, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		cullShader.setInt("_Stage", 2);
+		glDispatchCompute(numGroups, 1, 1);
+		//Draws read the commands as indirect arguments and the ids from vertex shaders
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+	}
+	void GpuInstanceCuller::bindInstanceIds(unsigned int bindingIndex) const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingIndex, m_instanceIdBuffer);
+	}
+	void GpuInstanceCuller::download(CullResult* result) const
+	{
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		result->commands.resize(m_numCommands);
+		glGetNamedBufferSubData(m_commandBuffer, 0, sizeof(DrawElementsIndirectCommand) * m_numCommands, result->commands.data());
+		int numGroups = (m_numInstances + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+		unsigned int numVisible = 0;
+		glGetNamedBufferSubData(m_groupCountBuffer, sizeof(unsigned int) * numGroups * m_numBins, sizeof(unsigned int), &numVisible);
+		result->numVisible = numVisible;
+		result->instanceIds.resize(result->numVisible);
+		glGetNamedBufferSubData(m_instanceIdBuffer, 0, sizeof(unsigned int) * result->numVisible, result->instanceIds.data());
+	}
+}
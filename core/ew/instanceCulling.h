@@ -0,0 +1,97 @@
+/*
+*	GPU driven instance culling and indirect draw command generation
+*/
+
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "frustum.h"
+#include "lod.h"
+#include "geometryArena.h"
+#include "shader.h"
+#include "occlusion.h"
+
+namespace ew {
+	//Instances per workgroup in instanceCull.comp. Also the most bins (mesh types * MAX_CULL_LODS) one scene can have
+	const int CULL_GROUP_SIZE = 256;
+	const int MAX_CULL_LODS = 4;
+	//Instance bin for instances outside the frustum
+	const unsigned int CULLED_BIN = 0xFFFFFFFF;
+
+	//Mirrors the GLSL structs under std430 rules
+	struct CullInstance {
+		glm::vec4 sphere; //World space center and radius
+		unsigned int meshType;
+		unsigned int padding[3];
+	};
+	static_assert(sizeof(CullInstance) == 32, "CullInstance must match the 32 byte std430 array stride");
+
+	struct CullMeshType {
+		float lodErrors[MAX_CULL_LODS]; //Object space, see Model::getLodError
+		float radius; //Object space bounding sphere radius, instance scale is recovered from it
+		int numLods;
+		unsigned int padding[2];
+	};
+	static_assert(sizeof(CullMeshType) == 32, "CullMeshType must match the 32 byte std430 array stride");
+
+	//Everything culling reads that doesn't change per view.
+	//Instances are grouped into bins of meshType * MAX_CULL_LODS + lod. Every command belongs to one bin and draws
+	//all of its instances, so a mesh type made of several meshes (e.g. a Model) has one command per mesh and LOD.
+	struct CullScene {
+		std::vector<CullInstance> instances;
+		std::vector<CullMeshType> meshTypes;
+		std::vector<DrawElementsIndirectCommand> commands; //instanceCount and baseInstance are filled in by culling
+		std::vector<unsigned int> commandBins;
+		//lodErrors from finest to coarsest, at most MAX_CULL_LODS are used. Returns the mesh type
+		unsigned int addMeshType(const float* lodErrors, int numLods, float radius);
+		void addInstance(unsigned int meshType, const BoundingSphere& worldBounds);
+		void addCommand(const DrawElementsIndirectCommand& command, unsigned int meshType, int lod);
+		inline int getNumBins()const { return (int)meshTypes.size() * MAX_CULL_LODS; }
+	};
+
+	//Commands with their instance counts and offsets, and the visible instance indices they read:
+	//command c draws instanceIds[baseInstance, baseInstance + instanceCount).
+	//Ids are sorted by bin, then by instance index, so GPU and CPU results are identical.
+	struct CullResult {
+		std::vector<DrawElementsIndirectCommand> commands;
+		std::vector<unsigned int> instanceIds;
+		int numVisible = 0;
+	};
+
+	//Bin of one instance, CULLED_BIN if it's outside the frustum or occluded. No frustum or occlusion skips that test,
+	//no lodSelector always picks LOD 0. Occlusion tests the box around each instance's sphere
+	unsigned int classifyInstance(const CullScene& scene, int instance, const Frustum* frustum, const LodSelector* lodSelector,
+		const HiZPyramid* occlusion = nullptr);
+	//CPU reference of instanceCull.comp
+	void cullInstances(const CullScene& scene, const Frustum* frustum, const LodSelector* lodSelector, CullResult* result,
+		const HiZPyramid* occlusion = nullptr);
+
+	//Runs instanceCull.comp over a CullScene. The commands it writes can be drawn straight from the GPU with GeometryArena::drawIndirect
+	class GpuInstanceCuller {
+	public:
+		//Call again whenever the scene changes. At most CULL_GROUP_SIZE bins
+		void upload(const CullScene& scene);
+		//Three dispatches with shader storage barriers between them. Overwrites shader storage bindings 0-6 and texture unit 7.
+		//occlusion is usually last frame's depth, tested with the view projection it was rendered with
+		void cull(const Shader& cullShader, const Frustum* frustum, const LodSelector* lodSelector, const HiZBuffer* occlusion = nullptr);
+		//Shaders read _Models[_InstanceIds[vBaseInstance + gl_InstanceID]]
+		void bindInstanceIds(unsigned int bindingIndex)const;
+		//Waits for the GPU, for validation against cullInstances
+		void download(CullResult* result)const;
+		inline unsigned int getCommandBuffer()const { return m_commandBuffer; }
+		inline int getNumCommands()const { return m_numCommands; }
+		inline int getNumInstances()const { return m_numInstances; }
+	private:
+		bool m_initialized = false;
+		unsigned int m_instanceBuffer = 0;
+		unsigned int m_meshTypeBuffer = 0;
+		unsigned int m_commandBinBuffer = 0;
+		unsigned int m_commandBuffer = 0;
+		unsigned int m_instanceIdBuffer = 0;
+		unsigned int m_instanceBinBuffer = 0;
+		unsigned int m_groupCountBuffer = 0;
+		int m_numInstances = 0;
+		int m_numCommands = 0;
+		int m_numBins = 0;
+	};
+}
@@ -0,0 +1,113 @@
+/*
+*	Point light storage for shaders
+*/
+
+#include "lightBuffer.h"
+#include "external/glad.h"
+#include <algorithm>
+#include <string.h>
+#include <stdio.h>
+
+namespace ew {
+	LightBuffer::LightBuffer(int capacity)
+	{
+		create(capacity);
+	}
+	/// <summary>
+	/// Allocates immutable storage for LIGHT_BUFFER_REGIONS copies of capacity lights and maps it once for the lifetime of the buffer.
+	/// </summary>
+	/// <param name="capacity">Maximum number of lights</param>
+	void LightBuffer::create(int capacity)
+	{
+		m_capacity = capacity;
+		m_count = 0;
+		m_lights.assign(capacity, PointLight{ glm::vec3(0), 0.0f, glm::vec4(0) });
+		int alignment = 0;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		alignment = std::max(alignment, 1);
+		m_regionSize = (sizeof(PointLight) * capacity + alignment - 1) / alignment * alignment;
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &m_ssbo);
+		glNamedBufferStorage(m_ssbo, m_regionSize * LIGHT_BUFFER_REGIONS, nullptr, flags);
+		m_mapped = (PointLight*)glMapNamedBufferRange(m_ssbo, 0, m_regionSize * LIGHT_BUFFER_REGIONS, flags);
+		if (m_mapped == nullptr) {
+			printf("Failed to map light buffer");
+		}
+		for (int region = 0; region < LIGHT_BUFFER_REGIONS; region++) {
+			if (m_mapped != nullptr) {
+				memcpy((char*)m_mapped + m_regionSize * region, m_lights.data(), sizeof(PointLight) * capacity);
+			}
+			m_fences[region] = nullptr;
+			m_dirtyBegin[region] = m_dirtyEnd[region] = 0;
+		}
+		m_region = 0;
+		m_changed = false;
+	}
+	void LightBuffer::setLight(int index, const PointLight& light)
+	{
+		if (index < 0 || index >= m_capacity) {
+			printf("Light index %d out of range, capacity is %d\n", index, m_capacity);
+			return;
+		}
+		m_lights[index] = light;
+		markDirty(index, index + 1);
+	}
+	/// <summary>
+	/// Sets how many lights are active. Clamped to capacity.
+	/// </summary>
+	void LightBuffer::setCount(int count)
+	{
+		m_count = std::min(std::max(count, 0), m_capacity);
+	}
+	//Every region missed the edit, each catches up when upload() next writes it
+	void LightBuffer::markDirty(int begin, int end)
+	{
+		m_changed = true;
+		for (int region = 0; region < LIGHT_BUFFER_REGIONS; region++) {
+			if (m_dirtyBegin[region] == m_dirtyEnd[region]) {
+				m_dirtyBegin[region] = begin;
+				m_dirtyEnd[region] = end;
+				continue;
+			}
+			m_dirtyBegin[region] = std::min(m_dirtyBegin[region], begin);
+			m_dirtyEnd[region] = std::max(m_dirtyEnd[region], end);
+		}
+	}
+	/// <summary>
+	/// Does nothing if no lights changed. Otherwise fences off the region in use, so it can be reused once draws
+	/// submitted so far are done with it, and copies the lights that changed since the next region was last written
+	/// into it with a single memcpy. That region was last read LIGHT_BUFFER_REGIONS - 1 uploads ago, so its fence
+	/// has normally signaled and the CPU doesn't wait. Bind after uploading.
+	/// </summary>
+	void LightBuffer::upload()
+	{
+		if (!m_changed || m_mapped == nullptr) {
+			return;
+		}
+		m_changed = false;
+		if (m_fences[m_region] != nullptr) {
+			glDeleteSync((GLsync)m_fences[m_region]);
+		}
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_region = (m_region + 1) % LIGHT_BUFFER_REGIONS;
+		GLsync fence = (GLsync)m_fences[m_region];
+		if (fence != nullptr) {
+			GLenum waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			while (waitResult == GL_TIMEOUT_EXPIRED) {
+				waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			}
+			glDeleteSync(fence);
+			m_fences[m_region] = nullptr;
+		}
+		int begin = m_dirtyBegin[m_region];
+		int end = m_dirtyEnd[m_region];
+		PointLight* region = (PointLight*)((char*)m_mapped + m_regionSize * m_region);
+		memcpy(region + begin, m_lights.data() + begin, sizeof(PointLight) * (end - begin));
+		m_dirtyBegin[m_region] = m_dirtyEnd[m_region] = 0;
+	}
+	//Binds the region the last upload() wrote
+	void LightBuffer::bind(unsigned int bindingIndex) const
+	{
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, bindingIndex, m_ssbo, m_regionSize * m_region, sizeof(PointLight) * m_capacity);
+	}
+}
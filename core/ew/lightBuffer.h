@@ -0,0 +1,55 @@
+/*
+*	Point light storage for shaders
+*/
+
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace ew {
+	//Mirrors the GLSL struct under std430 (and std140) rules:
+	//vec3 position and float radius share one 16 byte slot, color starts the next one.
+	struct PointLight {
+		glm::vec3 position;
+		float radius;
+		glm::vec4 color;
+	};
+	static_assert(sizeof(PointLight) == 32, "PointLight must match the 32 byte std430 array stride");
+	static_assert(offsetof(PointLight, position) == 0, "PointLight.position must be at offset 0");
+	static_assert(offsetof(PointLight, radius) == 12, "PointLight.radius must pack into position's vec4 slot");
+	static_assert(offsetof(PointLight, color) == 16, "PointLight.color must be 16 byte aligned");
+
+	//Copies of the lights in the buffer. upload() writes the oldest one, so the CPU doesn't wait on draws still reading the others
+	const int LIGHT_BUFFER_REGIONS = 3;
+
+	//Point lights kept in a persistently mapped shader storage buffer.
+	//Edits go to a CPU copy and only the dirty range is copied to the GPU on upload().
+	class LightBuffer {
+	public:
+		LightBuffer() {};
+		LightBuffer(int capacity);
+		void create(int capacity);
+		void setLight(int index, const PointLight& light);
+		inline const PointLight& getLight(int index)const { return m_lights[index]; }
+		inline const PointLight* getLights()const { return m_lights.data(); }
+		void setCount(int count);
+		inline int getCount()const { return m_count; }
+		inline int getCapacity()const { return m_capacity; }
+		void upload();
+		void bind(unsigned int bindingIndex)const;
+	private:
+		void markDirty(int begin, int end);
+		std::vector<PointLight> m_lights; //CPU copy, always authoritative
+		PointLight* m_mapped = nullptr; //Persistent, coherent mapping of the whole buffer
+		unsigned int m_ssbo = 0;
+		size_t m_regionSize = 0; //Bytes between regions, padded to the storage buffer offset alignment
+		int m_region = 0; //The one bind() binds
+		void* m_fences[LIGHT_BUFFER_REGIONS] = {}; //GLsync after the last commands that read each region
+		int m_dirtyBegin[LIGHT_BUFFER_REGIONS] = {}; //Per region dirty range [begin, end) in lights
+		int m_dirtyEnd[LIGHT_BUFFER_REGIONS] = {};
+		bool m_changed = false; //Lights changed since the last upload()
+		int m_capacity = 0;
+		int m_count = 0;
+	};
+}
@@ -0,0 +1,199 @@
+/*
+*	Screen-space tiled light culling
+*/
+
+#include "lightCulling.h"
+#include "external/glad.h"
+#include <algorithm>
+
+namespace ew {
+	static glm::vec3 unproject(const glm::mat4& inverseProjection, float x, float y, float z) {
+		glm::vec4 p = inverseProjection * glm::vec4(x, y, z, 1.0f);
+		return glm::vec3(p) / p.w;
+	}
+
+	/// <summary>
+	/// Builds a view space plane through three NDC points, flipped so the inside point is on the positive side.
+	/// </summary>
+	static glm::vec4 planeFromNDC(const glm::mat4& inverseProjection, glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 inside) {
+		glm::vec3 p0 = unproject(inverseProjection, a.x, a.y, a.z);
+		glm::vec3 p1 = unproject(inverseProjection, b.x, b.y, b.z);
+		glm::vec3 p2 = unproject(inverseProjection, c.x, c.y, c.z);
+		glm::vec3 n = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+		float d = -glm::dot(n, p0);
+		glm::vec3 q = unproject(inverseProjection, inside.x, inside.y, inside.z);
+		if (glm::dot(n, q) + d < 0.0f) {
+			n = -n;
+			d = -d;
+		}
+		return glm::vec4(n, d);
+	}
+
+	//Side planes only depend on one NDC coordinate, so a column (or row) of tiles shares them exactly
+	static glm::vec4 columnPlane(const glm::mat4& inverseProjection, float x, float insideX) {
+		return planeFromNDC(inverseProjection, glm::vec3(x, -1, -1), glm::vec3(x, 1, -1), glm::vec3(x, -1, 1), glm::vec3(insideX, 0, 0));
+	}
+	static glm::vec4 rowPlane(const glm::mat4& inverseProjection, float y, float insideY) {
+		return planeFromNDC(inverseProjection, glm::vec3(-1, y, -1), glm::vec3(1, y, -1), glm::vec3(-1, y, 1), glm::vec3(0, insideY, 0));
+	}
+	static glm::vec4 depthPlane(const glm::mat4& inverseProjection, float z) {
+		return planeFromNDC(inverseProjection, glm::vec3(-1, -1, z), glm::vec3(1, -1, z), glm::vec3(-1, 1, z), glm::vec3(0, 0, 0));
+	}
+	static void tileNDC(int pixelStart, int tileSize, int screenSize, float* ndcMin, float* ndcMax) {
+		int pixelEnd = std::min(pixelStart + tileSize, screenSize);
+		*ndcMin = 2.0f * pixelStart / screenSize - 1.0f;
+		*ndcMax = 2.0f * pixelEnd / screenSize - 1.0f;
+	}
+
+	/// <summary>
+	/// Computes the view space frustum of a single screen tile
+	/// </summary>
+	/// <param name="inverseProjection">Inverse of the camera projection matrix</param>
+	/// <param name="tileX">Tile column, from the left</param>
+	/// <param name="tileY">Tile row, from the bottom</param>
+	TileFrustum computeTileFrustum(const glm::mat4& inverseProjection, int screenWidth, int screenHeight, int tileSize, int tileX, int tileY)
+	{
+		float x0, x1, y0, y1;
+		tileNDC(tileX * tileSize, tileSize, screenWidth, &x0, &x1);
+		tileNDC(tileY * tileSize, tileSize, screenHeight, &y0, &y1);
+		float xc = (x0 + x1) * 0.5f;
+		float yc = (y0 + y1) * 0.5f;
+		TileFrustum frustum;
+		frustum.planes[0] = columnPlane(inverseProjection, x0, xc);
+		frustum.planes[1] = columnPlane(inverseProjection, x1, xc);
+		frustum.planes[2] = rowPlane(inverseProjection, y0, yc);
+		frustum.planes[3] = rowPlane(inverseProjection, y1, yc);
+		frustum.planes[4] = depthPlane(inverseProjection, -1.0f);
+		frustum.planes[5] = depthPlane(inverseProjection, 1.0f);
+		return frustum;
+	}
+
+	static inline bool sphereInsidePlane(const glm::vec4& plane, const glm::vec3& center, float radius) {
+		return glm::dot(glm::vec3(plane), center) + plane.w >= -radius;
+	}
+
+	/// <summary>
+	/// Conservative sphere vs tile frustum test. May report spheres near tile corners that don't actually touch the tile.
+	/// </summary>
+	bool sphereIntersectsTile(const TileFrustum& frustum, const glm::vec3& viewCenter, float radius)
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			if (!sphereInsidePlane(frustum.planes[i], viewCenter, radius)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// CPU reference for tiled light assignment. Lights are first bucketed per tile column, then each
+	/// column's lights are tested against the row planes, so the cost is far below tiles * lights.
+	/// Produces exactly the lists a per-tile sphereIntersectsTile test would.
+	/// </summary>
+	/// <param name="lights">World space point lights</param>
+	/// <param name="tileSize">Tile width and height in pixels</param>
+	/// <param name="maxLightsPerTile">Lights beyond this count are dropped from a tile</param>
+	/// <param name="grid">Grid to fill. Resized as needed</param>
+	void cullLightsTiled(const PointLight* lights, int numLights, const Camera& camera, int screenWidth, int screenHeight, int tileSize, int maxLightsPerTile, LightGrid* grid)
+	{
+		grid->tileSize = tileSize;
+		grid->tilesX = (screenWidth + tileSize - 1) / tileSize;
+		grid->tilesY = (screenHeight + tileSize - 1) / tileSize;
+		grid->maxLightsPerTile = maxLightsPerTile;
+		grid->lightCounts.assign(grid->tilesX * grid->tilesY, 0);
+		grid->lightIndices.resize(grid->tilesX * grid->tilesY * maxLightsPerTile);
+
+		glm::mat4 view = camera.viewMatrix();
+		glm::mat4 inverseProjection = glm::inverse(camera.projectionMatrix());
+		glm::vec4 nearPlane = depthPlane(inverseProjection, -1.0f);
+		glm::vec4 farPlane = depthPlane(inverseProjection, 1.0f);
+
+		//Lights in view space, rejected early against near/far
+		std::vector<glm::vec4> viewLights;
+		std::vector<unsigned int> viewLightIndices;
+		viewLights.reserve(numLights);
+		viewLightIndices.reserve(numLights);
+		for (int i = 0; i < numLights; i++)
+		{
+			glm::vec3 center = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+			if (sphereInsidePlane(nearPlane, center, lights[i].radius) && sphereInsidePlane(farPlane, center, lights[i].radius)) {
+				viewLights.push_back(glm::vec4(center, lights[i].radius));
+				viewLightIndices.push_back(i);
+			}
+		}
+
+		std::vector<glm::vec4> rowPlanes(grid->tilesY * 2);
+		for (int y = 0; y < grid->tilesY; y++)
+		{
+			float y0, y1;
+			tileNDC(y * tileSize, tileSize, screenHeight, &y0, &y1);
+			rowPlanes[y * 2] = rowPlane(inverseProjection, y0, (y0 + y1) * 0.5f);
+			rowPlanes[y * 2 + 1] = rowPlane(inverseProjection, y1, (y0 + y1) * 0.5f);
+		}
+
+		std::vector<unsigned int> columnLights;
+		columnLights.reserve(viewLights.size());
+		for (int x = 0; x < grid->tilesX; x++)
+		{
+			float x0, x1;
+			tileNDC(x * tileSize, tileSize, screenWidth, &x0, &x1);
+			glm::vec4 left = columnPlane(inverseProjection, x0, (x0 + x1) * 0.5f);
+			glm::vec4 right = columnPlane(inverseProjection, x1, (x0 + x1) * 0.5f);
+			columnLights.clear();
+			for (size_t i = 0; i < viewLights.size(); i++)
+			{
+				glm::vec3 center = glm::vec3(viewLights[i]);
+				if (sphereInsidePlane(left, center, viewLights[i].w) && sphereInsidePlane(right, center, viewLights[i].w)) {
+					columnLights.push_back((unsigned int)i);
+				}
+			}
+			for (int y = 0; y < grid->tilesY; y++)
+			{
+				int tile = y * grid->tilesX + x;
+				unsigned int* tileIndices = &grid->lightIndices[tile * maxLightsPerTile];
+				unsigned int count = 0;
+				for (size_t i = 0; i < columnLights.size() && count < (unsigned int)maxLightsPerTile; i++)
+				{
+					const glm::vec4& light = viewLights[columnLights[i]];
+					glm::vec3 center = glm::vec3(light);
+					if (sphereInsidePlane(rowPlanes[y * 2], center, light.w) && sphereInsidePlane(rowPlanes[y * 2 + 1], center, light.w)) {
+						tileIndices[count++] = viewLightIndices[columnLights[i]];
+					}
+				}
+				grid->lightCounts[tile] = count;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Allocates storage for tilesX * tilesY tiles. Only reallocates when the size changes.
+	/// </summary>
+	void LightGridBuffer::resize(int tilesX, int tilesY, int maxLightsPerTile)
+	{
+		if (!m_initialized) {
+			glCreateBuffers(1, &m_countsBuffer);
+			glCreateBuffers(1, &m_indicesBuffer);
+			m_initialized = true;
+		}
+		int numTiles = tilesX * tilesY;
+		if (numTiles == m_numTiles && maxLightsPerTile == m_maxLightsPerTile) {
+			return;
+		}
+		m_numTiles = numTiles;
+		m_maxLightsPerTile = maxLightsPerTile;
+		glNamedBufferData(m_countsBuffer, sizeof(unsigned int) * numTiles, NULL, GL_DYNAMIC_DRAW);
+		glNamedBufferData(m_indicesBuffer, sizeof(unsigned int) * numTiles * maxLightsPerTile, NULL, GL_DYNAMIC_DRAW);
+	}
+	void LightGridBuffer::upload(const LightGrid& grid)
+	{
+		resize(grid.tilesX, grid.tilesY, grid.maxLightsPerTile);
+		glNamedBufferSubData(m_countsBuffer, 0, sizeof(unsigned int) * grid.lightCounts.size(), grid.lightCounts.data());
+		glNamedBufferSubData(m_indicesBuffer, 0, sizeof(unsigned int) * grid.lightIndices.size(), grid.lightIndices.data());
+	}
+	void LightGridBuffer::bind(unsigned int countsBinding, unsigned int indicesBinding) const
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, countsBinding, m_countsBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, indicesBinding, m_indicesBuffer);
+	}
+}
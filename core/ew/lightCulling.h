@@ -0,0 +1,47 @@
+/*
+*	Screen-space tiled light culling
+*/
+
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "camera.h"
+#include "lightBuffer.h"
+
+namespace ew {
+	//View space planes bounding one screen tile. Normals face inward: dot(plane.xyz, p) + plane.w >= 0 inside.
+	//Order: left, right, bottom, top, near, far
+	struct TileFrustum {
+		glm::vec4 planes[6];
+	};
+
+	//Per-tile light index lists, laid out the same way the compute shader writes them.
+	//Tile (x, y) counts from the bottom left like gl_FragCoord and owns
+	//lightIndices[tile * maxLightsPerTile, tile * maxLightsPerTile + lightCounts[tile])
+	struct LightGrid {
+		int tileSize = 16;
+		int tilesX = 0;
+		int tilesY = 0;
+		int maxLightsPerTile = 0;
+		std::vector<unsigned int> lightCounts;
+		std::vector<unsigned int> lightIndices;
+	};
+
+	TileFrustum computeTileFrustum(const glm::mat4& inverseProjection, int screenWidth, int screenHeight, int tileSize, int tileX, int tileY);
+	bool sphereIntersectsTile(const TileFrustum& frustum, const glm::vec3& viewCenter, float radius);
+	void cullLightsTiled(const PointLight* lights, int numLights, const Camera& camera, int screenWidth, int screenHeight, int tileSize, int maxLightsPerTile, LightGrid* grid);
+
+	//GPU copy of a LightGrid. Filled either from the CPU with upload() or directly by a compute shader.
+	class LightGridBuffer {
+	public:
+		void resize(int tilesX, int tilesY, int maxLightsPerTile);
+		void upload(const LightGrid& grid);
+		void bind(unsigned int countsBinding, unsigned int indicesBinding)const;
+	private:
+		bool m_initialized = false;
+		unsigned int m_countsBuffer = 0;
+		unsigned int m_indicesBuffer = 0;
+		int m_numTiles = 0;
+		int m_maxLightsPerTile = 0;
+	};
+}
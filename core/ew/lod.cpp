@@ -0,0 +1,41 @@
+/*
+*	Screen space error driven LOD selection
+*/
+
+#include "lod.h"
+#include <math.h>
+
+namespace ew {
+	LodSelector createLodSelector(const Camera& camera, float screenHeight, float maxPixelError, float lodBias)
+	{
+		LodSelector selector;
+		selector.cameraPosition = camera.position;
+		selector.orthographic = camera.orthographic;
+		if (camera.orthographic) {
+			selector.pixelsPerUnit = screenHeight / camera.orthoHeight;
+		}
+		else {
+			selector.pixelsPerUnit = screenHeight / (2.0f * tanf(glm::radians(camera.fov) * 0.5f));
+		}
+		selector.maxPixelError = maxPixelError * lodBias;
+		return selector;
+	}
+
+	/// <summary>
+	/// Measured at the sphere's closest point to the camera, so everything inside the bounds projects to this size or less.
+	/// Bounds containing the camera get an effectively infinite size, which keeps them at full detail.
+	/// </summary>
+	float getProjectedSize(const LodSelector& selector, const BoundingSphere& worldBounds)
+	{
+		if (selector.orthographic) {
+			return selector.pixelsPerUnit;
+		}
+		float distance = glm::length(worldBounds.center - selector.cameraPosition) - worldBounds.radius;
+		return selector.pixelsPerUnit / glm::max(distance, 1e-6f);
+	}
+
+	float getMaxLodError(const LodSelector& selector, const BoundingSphere& worldBounds)
+	{
+		return selector.maxPixelError / getProjectedSize(selector, worldBounds);
+	}
+}
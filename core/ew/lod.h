@@ -0,0 +1,26 @@
+/*
+*	Screen space error driven LOD selection
+*/
+
+#pragma once
+#include <glm/glm.hpp>
+#include "camera.h"
+#include "bounds.h"
+
+namespace ew {
+	//Per-view constants for picking LODs. Build once per pass with createLodSelector
+	struct LodSelector {
+		glm::vec3 cameraPosition;
+		float pixelsPerUnit; //Perspective: screen pixels covered by one world unit at distance 1. Orthographic: at any distance
+		bool orthographic;
+		float maxPixelError; //Already scaled by the LOD bias
+	};
+
+	//lodBias scales the pixel error budget. Larger values switch to coarser LODs closer to the camera
+	LodSelector createLodSelector(const Camera& camera, float screenHeight, float maxPixelError = 1.0f, float lodBias = 1.0f);
+	//Screen space size in pixels of one world unit at the near side of worldBounds
+	float getProjectedSize(const LodSelector& selector, const BoundingSphere& worldBounds);
+	//Largest world space simplification error that projects to at most the pixel budget at worldBounds.
+	//Divide by the object's scale before comparing with Mesh/Model LOD errors.
+	float getMaxLodError(const LodSelector& selector, const BoundingSphere& worldBounds);
+}
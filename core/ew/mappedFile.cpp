@@ -0,0 +1,95 @@
+/*
+*	Read-only memory mapped files
+*/
+
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ew {
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	/// <summary>
+	/// Maps filePath into memory. Empty files fail to open since they can't be mapped.
+	/// </summary>
+	/// <returns>True on success</returns>
+	bool MappedFile::open(const std::string& filePath)
+	{
+		close();
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL) {
+			CloseHandle(file);
+			return false;
+		}
+		m_data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (m_data == nullptr) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		m_file = file;
+		m_mapping = mapping;
+		m_size = (size_t)size.QuadPart;
+#else
+		int fd = ::open(filePath.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return false;
+		}
+		struct stat fileStat;
+		if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+			::close(fd);
+			return false;
+		}
+		void* data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			::close(fd);
+			return false;
+		}
+		m_fd = fd;
+		m_data = data;
+		m_size = (size_t)fileStat.st_size;
+#endif
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (m_data == nullptr) {
+			return;
+		}
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+		CloseHandle((HANDLE)m_mapping);
+		CloseHandle((HANDLE)m_file);
+		m_file = m_mapping = nullptr;
+#else
+		munmap(m_data, m_size);
+		::close(m_fd);
+		m_fd = -1;
+#endif
+		m_data = nullptr;
+		m_size = 0;
+	}
+}
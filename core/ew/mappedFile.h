@@ -0,0 +1,32 @@
+/*
+*	Read-only memory mapped files
+*/
+
+#pragma once
+#include <stddef.h>
+#include <string>
+
+namespace ew {
+	//Maps a whole file into memory read-only. Unmapped on close() or destruction.
+	class MappedFile {
+	public:
+		MappedFile() {};
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		bool open(const std::string& filePath);
+		void close();
+		inline bool isOpen()const { return m_data != nullptr; }
+		inline const unsigned char* getData()const { return (const unsigned char*)m_data; }
+		inline size_t getSize()const { return m_size; }
+	private:
+		void* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#else
+		int m_fd = -1;
+#endif
+	};
+}
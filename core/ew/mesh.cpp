@@ -6,36 +6,102 @@
 */
 
 #include "mesh.h"
+#include "packing.h"
+#include "meshOptimizer.h"
 #include "external/glad.h"
 
 namespace ew {
-	Mesh::Mesh(const MeshData& meshData)
+	static DrawStats s_drawStats;
+
+	const DrawStats& getDrawStats()
 	{
-		load(meshData);
+		return s_drawStats;
 	}
-	void Mesh::load(const MeshData& meshData)
+	void resetDrawStats()
 	{
-		if (!m_initialized) {
-			glGenVertexArrays(1, &m_vao);
-			glBindVertexArray(m_vao);
+		s_drawStats = DrawStats();
+	}
+	void recordDrawCall(unsigned int instances, unsigned int triangles)
+	{
+		s_drawStats.drawCalls++;
+		s_drawStats.instances += instances;
+		s_drawStats.triangles += triangles;
+	}
 
-			glGenBuffers(1, &m_vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	static float safeInverse(float v) {
+		return v > 0.0f ? 1.0f / v : 0.0f;
+	}
 
-			glGenBuffers(1, &m_ebo);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-			//Position attribute
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
-			glEnableVertexAttribArray(0);
+	/// <summary>
+	/// Quantizes a vertex. Position is stored relative to bounds, which must contain it
+	/// </summary>
+	PackedVertex packVertex(const Vertex& vertex, const AABB& bounds)
+	{
+		glm::vec3 size = bounds.max - bounds.min;
+		glm::vec3 relative = vertex.pos - bounds.min;
+		PackedVertex packed;
+		packed.pos[0] = packUnorm16(relative.x * safeInverse(size.x));
+		packed.pos[1] = packUnorm16(relative.y * safeInverse(size.y));
+		packed.pos[2] = packUnorm16(relative.z * safeInverse(size.z));
+		packed.padding = 0;
+		packed.normal = packSnorm3x10(vertex.normal);
+		packed.uv[0] = packHalf(vertex.uv.x);
+		packed.uv[1] = packHalf(vertex.uv.y);
+		return packed;
+	}
+	/// <summary>
+	/// CPU mirror of what the vertex shader sees for a PACKED mesh
+	/// </summary>
+	Vertex unpackVertex(const PackedVertex& vertex, const AABB& bounds)
+	{
+		glm::vec3 normalized = glm::vec3(unpackUnorm16(vertex.pos[0]), unpackUnorm16(vertex.pos[1]), unpackUnorm16(vertex.pos[2]));
+		Vertex unpacked;
+		unpacked.pos = bounds.min + normalized * (bounds.max - bounds.min);
+		unpacked.normal = unpackSnorm3x10(vertex.normal);
+		unpacked.uv = glm::vec2(unpackHalf(vertex.uv[0]), unpackHalf(vertex.uv[1]));
+		return unpacked;
+	}
 
-			//Normal attribute
-			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, normal));
-			glEnableVertexAttribArray(1);
+	int getIndexSize(int numVertices)
+	{
+		if (numVertices <= 0xFF) {
+			return 1;
+		}
+		if (numVertices <= 0xFFFF) {
+			return 2;
+		}
+		return 4;
+	}
 
-			//UV attribute
-			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)(offsetof(Vertex, uv)));
-			glEnableVertexAttribArray(2);
+	static GLenum getIndexType(int indexSize)
+	{
+		return indexSize == 1 ? GL_UNSIGNED_BYTE : indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	}
 
+	//Truncation maps STRIP_RESTART_INDEX to the restart index of the narrower type, 0xFF or 0xFFFF
+	template<typename T>
+	static void uploadIndices(const unsigned int* indices, int numIndices)
+	{
+		std::vector<T> narrowed(indices, indices + numIndices);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(T) * numIndices, narrowed.data(), GL_STATIC_DRAW);
+	}
+
+	Mesh::Mesh(const MeshData& meshData, VertexFormat vertexFormat, IndexLayout indexLayout)
+	{
+		load(meshData, vertexFormat, indexLayout);
+	}
+	void Mesh::load(const MeshData& meshData, VertexFormat vertexFormat, IndexLayout indexLayout)
+	{
+		load(meshData.vertices.data(), meshData.vertices.size(), meshData.indices.data(), meshData.indices.size(), vertexFormat, indexLayout,
+			meshData.lods.data(), meshData.lods.size());
+	}
+	void Mesh::load(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices, VertexFormat vertexFormat, IndexLayout indexLayout,
+		const MeshLod* lods, int numLods)
+	{
+		if (!m_initialized) {
+			glGenVertexArrays(1, &m_vao);
+			glGenBuffers(1, &m_vbo);
+			glGenBuffers(1, &m_ebo);
 			m_initialized = true;
 		}
 
@@ -43,28 +109,166 @@ namespace ew {
 		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
 
-		if (meshData.vertices.size() > 0) {
-			glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * meshData.vertices.size(), meshData.vertices.data(), GL_STATIC_DRAW);
+		m_numVertices = numVertices;
+		m_aabb = computeAABB(vertices, m_numVertices);
+		m_boundingSphere = computeBoundingSphere(vertices, m_numVertices);
+		m_vertexFormat = vertexFormat;
+
+		//Attribute formats are reset on every load, since a reload may switch vertex format
+		if (vertexFormat == VertexFormat::PACKED) {
+			std::vector<PackedVertex> packedVertices(numVertices);
+			for (int i = 0; i < numVertices; i++) {
+				packedVertices[i] = packVertex(vertices[i], m_aabb);
+			}
+			if (numVertices > 0) {
+				glBufferData(GL_ARRAY_BUFFER, sizeof(PackedVertex) * numVertices, packedVertices.data(), GL_STATIC_DRAW);
+			}
+			m_positionScale = m_aabb.max - m_aabb.min;
+			m_positionOffset = m_aabb.min;
+			//Position attribute, [0,1] within the AABB
+			glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (const void*)offsetof(PackedVertex, pos));
+			//Normal attribute
+			glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (const void*)offsetof(PackedVertex, normal));
+			//UV attribute
+			glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (const void*)offsetof(PackedVertex, uv));
+		}
+		else {
+			if (numVertices > 0) {
+				glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * numVertices, vertices, GL_STATIC_DRAW);
+			}
+			m_positionScale = glm::vec3(1.0f);
+			m_positionOffset = glm::vec3(0.0f);
+			//Position attribute
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
+			//Normal attribute
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, normal));
+			//UV attribute
+			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)(offsetof(Vertex, uv)));
+		}
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+
+		MeshLod wholeMesh = { 0, (unsigned int)numIndices, 0.0f };
+		if (numLods == 0) {
+			lods = &wholeMesh;
+			numLods = 1;
+		}
+		m_lods.resize(numLods);
+		std::vector<unsigned int> strips;
+		for (int i = 0; i < numLods; i++)
+		{
+			LodRange& range = m_lods[i];
+			range.numTriangles = lods[i].numIndices / 3;
+			range.error = lods[i].error;
+			//Each LOD is stripped separately and appended, so its range moves
+			if (indexLayout == IndexLayout::TRIANGLE_STRIP) {
+				std::vector<unsigned int> lodStrips = generateTriangleStrips(indices + lods[i].firstIndex, lods[i].numIndices, numVertices);
+				range.firstIndex = strips.size();
+				range.numIndices = lodStrips.size();
+				strips.insert(strips.end(), lodStrips.begin(), lodStrips.end());
+			}
+			else {
+				range.firstIndex = lods[i].firstIndex;
+				range.numIndices = lods[i].numIndices;
+			}
 		}
-		if (meshData.indices.size() > 0) {
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * meshData.indices.size(), meshData.indices.data(), GL_STATIC_DRAW);
+		if (indexLayout == IndexLayout::TRIANGLE_STRIP) {
+			indices = strips.data();
+			numIndices = strips.size();
+		}
+		m_numIndices = numIndices;
+		m_indexLayout = indexLayout;
+		m_indexSize = ew::getIndexSize(numVertices);
+		if (numIndices > 0) {
+			if (m_indexSize == 1) {
+				uploadIndices<uint8_t>(indices, numIndices);
+			}
+			else if (m_indexSize == 2) {
+				uploadIndices<uint16_t>(indices, numIndices);
+			}
+			else {
+				glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * numIndices, indices, GL_STATIC_DRAW);
+			}
 		}
-		m_numVertices = meshData.vertices.size();
-		m_numIndices = meshData.indices.size();
 
 		glBindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
-	void Mesh::draw(ew::DrawMode drawMode) const
+	/// <summary>
+	/// Binds the VAO and sets the position dequantization constants and base instance.
+	/// Generic attribute values are context state, not VAO state, so this runs before every draw.
+	/// </summary>
+	void Mesh::bindForDraw() const
 	{
 		glBindVertexArray(m_vao);
+		glVertexAttrib3f(POSITION_SCALE_ATTRIBUTE, m_positionScale.x, m_positionScale.y, m_positionScale.z);
+		glVertexAttrib3f(POSITION_OFFSET_ATTRIBUTE, m_positionOffset.x, m_positionOffset.y, m_positionOffset.z);
+		glVertexAttribI1ui(BASE_INSTANCE_ATTRIBUTE, 0);
+	}
+	/// <summary>
+	/// Picks the coarsest LOD within the error budget. Pair with getMaxLodError to choose by screen space error.
+	/// </summary>
+	int Mesh::selectLod(float maxError) const
+	{
+		for (int i = (int)m_lods.size() - 1; i > 0; i--)
+		{
+			if (m_lods[i].error <= maxError) {
+				return i;
+			}
+		}
+		return 0;
+	}
+	const Mesh::LodRange& Mesh::getLodRange(int lod) const
+	{
+		return m_lods[glm::clamp(lod, 0, (int)m_lods.size() - 1)];
+	}
+	void Mesh::draw(ew::DrawMode drawMode, int lod) const
+	{
+		bindForDraw();
 		if (drawMode == DrawMode::TRIANGLES) {
-			glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, NULL);
+			const LodRange& range = getLodRange(lod);
+			const void* offset = (const void*)((size_t)range.firstIndex * m_indexSize);
+			if (m_indexLayout == IndexLayout::TRIANGLE_STRIP) {
+				glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+				glDrawElements(GL_TRIANGLE_STRIP, range.numIndices, getIndexType(m_indexSize), offset);
+				glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+			}
+			else {
+				glDrawElements(GL_TRIANGLES, range.numIndices, getIndexType(m_indexSize), offset);
+			}
+			recordDrawCall(1, range.numTriangles);
 		}
 		else {
 			glDrawArrays(GL_POINTS, 0, m_numVertices);
+			recordDrawCall(1, 0);
 		}
 		
 	}
+	/// <summary>
+	/// Draws instanceCount copies of this mesh in a single draw call.
+	/// Per-instance data (e.g. an ew::InstanceBuffer) must be bound by the caller.
+	/// </summary>
+	void Mesh::drawInstanced(int instanceCount, ew::DrawMode drawMode, int lod) const
+	{
+		bindForDraw();
+		if (drawMode == DrawMode::TRIANGLES) {
+			const LodRange& range = getLodRange(lod);
+			const void* offset = (const void*)((size_t)range.firstIndex * m_indexSize);
+			if (m_indexLayout == IndexLayout::TRIANGLE_STRIP) {
+				glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+				glDrawElementsInstanced(GL_TRIANGLE_STRIP, range.numIndices, getIndexType(m_indexSize), offset, instanceCount);
+				glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+			}
+			else {
+				glDrawElementsInstanced(GL_TRIANGLES, range.numIndices, getIndexType(m_indexSize), offset, instanceCount);
+			}
+			recordDrawCall(instanceCount, range.numTriangles * instanceCount);
+		}
+		else {
+			glDrawArraysInstanced(GL_POINTS, 0, m_numVertices, instanceCount);
+			recordDrawCall(instanceCount, 0);
+		}
+	}
 }
\ No newline at end of file
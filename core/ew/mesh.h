@@ -5,6 +5,8 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <vector>
+#include <stdint.h>
+#include "bounds.h"
 
 namespace ew {
 	struct Vertex {
@@ -13,30 +15,122 @@ namespace ew {
 		glm::vec2 uv;
 	};
 
+	//A level of detail: a range of MeshData::indices drawn with the same vertices
+	struct MeshLod {
+		unsigned int firstIndex;
+		unsigned int numIndices;
+		float error; //Object space distance the simplified surface may be from the full mesh
+	};
+
 	struct MeshData {
 		std::vector<Vertex> vertices;
 		std::vector<unsigned int> indices;
+		//Finest to coarsest, see generateLods. Empty means a single LOD of all indices
+		std::vector<MeshLod> lods;
+	};
+
+	//Layout of a Mesh's vertex buffer on the GPU.
+	//PACKED is 16 bytes instead of 32: positions are 16 bit unorm relative to the mesh AABB,
+	//normals 10:10:10:2 snorm and uvs half floats.
+	enum class VertexFormat {
+		FULL = 0,
+		PACKED = 1
 	};
 
+	struct PackedVertex {
+		uint16_t pos[3]; //0 = aabb.min, 65535 = aabb.max
+		uint16_t padding;
+		uint32_t normal; //GL_INT_2_10_10_10_REV
+		uint16_t uv[2]; //Half floats
+	};
+
+	//Vertex shaders reconstruct position as vPos * scale + offset, reading these generic attributes.
+	//Mesh sets them before every draw, to identity for FULL meshes.
+	const unsigned int POSITION_SCALE_ATTRIBUTE = 7;
+	const unsigned int POSITION_OFFSET_ATTRIBUTE = 8;
+	//First instance of a multi-draw indirect command (see GeometryArena), as an unsigned int.
+	//Instanced shaders add it to gl_InstanceID, Mesh sets it to 0.
+	const unsigned int BASE_INSTANCE_ATTRIBUTE = 9;
+
+	PackedVertex packVertex(const Vertex& vertex, const AABB& bounds);
+	Vertex unpackVertex(const PackedVertex& vertex, const AABB& bounds);
+
+	//How a Mesh stores its index buffer. TRIANGLE_STRIP converts the triangle list with
+	//generateTriangleStrips on upload and draws with primitive restart.
+	enum class IndexLayout {
+		TRIANGLE_LIST = 0,
+		TRIANGLE_STRIP = 1
+	};
+
+	//Smallest index size in bytes (1, 2 or 4) for a mesh of numVertices.
+	//The largest value of each size is kept free as the primitive restart index.
+	int getIndexSize(int numVertices);
+
 	enum class DrawMode {
 		TRIANGLES = 0,
 		POINTS = 1
 	};
 
+	//CPU-side counters of submitted draws. Reset once per frame with resetDrawStats()
+	struct DrawStats {
+		unsigned int drawCalls = 0;
+		unsigned int instances = 0;
+		unsigned int triangles = 0;
+	};
+	const DrawStats& getDrawStats();
+	void resetDrawStats();
+	void recordDrawCall(unsigned int instances, unsigned int triangles);
+
 	class Mesh {
 	public:
 		Mesh() {};
-		Mesh(const MeshData& meshData);
-		void load(const MeshData& meshData);
-		void draw(DrawMode drawMode = DrawMode::TRIANGLES)const;
+		Mesh(const MeshData& meshData, VertexFormat vertexFormat = VertexFormat::FULL, IndexLayout indexLayout = IndexLayout::TRIANGLE_LIST);
+		void load(const MeshData& meshData, VertexFormat vertexFormat = VertexFormat::FULL, IndexLayout indexLayout = IndexLayout::TRIANGLE_LIST);
+		//Uploads straight from caller memory, e.g. a mapped mesh cache, without building a MeshData.
+		//Indices are always a triangle list here, narrowed to getIndexSize(numVertices) bytes on upload.
+		//lods index into indices like MeshData::lods; none means a single LOD of all indices.
+		void load(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices,
+			VertexFormat vertexFormat = VertexFormat::FULL, IndexLayout indexLayout = IndexLayout::TRIANGLE_LIST,
+			const MeshLod* lods = nullptr, int numLods = 0);
+		void draw(DrawMode drawMode = DrawMode::TRIANGLES, int lod = 0)const;
+		void drawInstanced(int instanceCount, DrawMode drawMode = DrawMode::TRIANGLES, int lod = 0)const;
 		inline int getNumVertices()const { return m_numVertices; }
+		//Indices in the GPU buffer for every LOD, including restart indices for strips
 		inline int getNumIndices()const { return m_numIndices; }
+		inline int getNumTriangles(int lod = 0)const { return m_lods[lod].numTriangles; }
+		inline int getNumLods()const { return (int)m_lods.size(); }
+		inline float getLodError(int lod)const { return m_lods[lod].error; }
+		//Coarsest LOD whose error is at most maxError, in object space units
+		int selectLod(float maxError)const;
+		inline int getIndexSize()const { return m_indexSize; }
+		inline IndexLayout getIndexLayout()const { return m_indexLayout; }
+		inline VertexFormat getVertexFormat()const { return m_vertexFormat; }
+		//Object space bounds, computed in load()
+		inline const AABB& getAABB()const { return m_aabb; }
+		inline const BoundingSphere& getBoundingSphere()const { return m_boundingSphere; }
 	private:
+		//A LOD's range of the GPU index buffer, which differs from MeshLod once converted to strips
+		struct LodRange {
+			unsigned int firstIndex;
+			unsigned int numIndices;
+			unsigned int numTriangles;
+			float error;
+		};
+		void bindForDraw()const;
+		const LodRange& getLodRange(int lod)const;
 		bool m_initialized = false;
 		unsigned int m_vao = 0;
 		unsigned int m_vbo = 0;
 		unsigned int m_ebo = 0;
 		unsigned int m_numVertices = 0;
 		unsigned int m_numIndices = 0;
+		std::vector<LodRange> m_lods = std::vector<LodRange>(1, LodRange{ 0, 0, 0, 0.0f });
+		int m_indexSize = 4;
+		IndexLayout m_indexLayout = IndexLayout::TRIANGLE_LIST;
+		VertexFormat m_vertexFormat = VertexFormat::FULL;
+		glm::vec3 m_positionScale = glm::vec3(1.0f);
+		glm::vec3 m_positionOffset = glm::vec3(0.0f);
+		AABB m_aabb;
+		BoundingSphere m_boundingSphere;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+/*
+*	Binary mesh cache, so models skip the importer after the first load
+*/
+
+#include "meshCache.h"
+#include <stdio.h>
+
+namespace ew {
+	uint64_t hashBytes(const void* data, size_t size, uint64_t hash)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	uint64_t hashFile(const std::string& filePath)
+	{
+		MappedFile file;
+		if (!file.open(filePath)) {
+			return 0;
+		}
+		return hashBytes(file.getData(), file.getSize());
+	}
+
+	/// <summary>
+	/// Writes meshes to cachePath in the MeshCache layout. Vertex and index arrays are 4 byte aligned
+	/// so they can be read in place once the file is mapped.
+	/// </summary>
+	/// <returns>True on success</returns>
+	bool writeMeshCache(const std::string& cachePath, uint64_t sourceHash, const std::vector<MeshData>& meshes)
+	{
+		MeshCacheHeader header;
+		header.magic = MESH_CACHE_MAGIC;
+		header.version = MESH_CACHE_VERSION;
+		header.sourceHash = sourceHash;
+		header.vertexSize = sizeof(Vertex);
+		header.numMeshes = (uint32_t)meshes.size();
+
+		std::vector<MeshCacheEntry> entries(meshes.size());
+		uint64_t offset = sizeof(MeshCacheHeader) + sizeof(MeshCacheEntry) * meshes.size();
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			entries[i].numVertices = (uint32_t)meshes[i].vertices.size();
+			entries[i].numIndices = (uint32_t)meshes[i].indices.size();
+			entries[i].numLods = (uint32_t)meshes[i].lods.size();
+			entries[i].padding = 0;
+			entries[i].vertexOffset = offset;
+			offset += sizeof(Vertex) * entries[i].numVertices;
+			entries[i].indexOffset = offset;
+			offset += sizeof(unsigned int) * entries[i].numIndices;
+			entries[i].lodOffset = offset;
+			offset += sizeof(MeshLod) * entries[i].numLods;
+		}
+
+		FILE* file = fopen(cachePath.c_str(), "wb");
+		if (file == NULL) {
+			printf("Failed to write mesh cache %s\n", cachePath.c_str());
+			return false;
+		}
+		bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+		if (!entries.empty()) {
+			success &= fwrite(entries.data(), sizeof(MeshCacheEntry), entries.size(), file) == entries.size();
+		}
+		for (const MeshData& mesh : meshes)
+		{
+			success &= fwrite(mesh.vertices.data(), sizeof(Vertex), mesh.vertices.size(), file) == mesh.vertices.size();
+			success &= fwrite(mesh.indices.data(), sizeof(unsigned int), mesh.indices.size(), file) == mesh.indices.size();
+			success &= fwrite(mesh.lods.data(), sizeof(MeshLod), mesh.lods.size(), file) == mesh.lods.size();
+		}
+		success &= fclose(file) == 0;
+		if (!success) {
+			printf("Failed to write mesh cache %s\n", cachePath.c_str());
+			remove(cachePath.c_str());
+		}
+		return success;
+	}
+
+	bool MeshCache::open(const std::string& cachePath, uint64_t expectedSourceHash)
+	{
+		close();
+		if (!m_file.open(cachePath)) {
+			return false;
+		}
+		size_t size = m_file.getSize();
+		const unsigned char* data = m_file.getData();
+		const MeshCacheHeader* header = (const MeshCacheHeader*)data;
+		bool valid = size >= sizeof(MeshCacheHeader)
+			&& header->magic == MESH_CACHE_MAGIC
+			&& header->version == MESH_CACHE_VERSION
+			&& header->sourceHash == expectedSourceHash
+			&& header->vertexSize == sizeof(Vertex)
+			&& header->numMeshes <= (size - sizeof(MeshCacheHeader)) / sizeof(MeshCacheEntry);
+		const MeshCacheEntry* entries = (const MeshCacheEntry*)(data + sizeof(MeshCacheHeader));
+		//Every array has to lie inside the file
+		for (uint32_t i = 0; valid && i < header->numMeshes; i++)
+		{
+			const MeshCacheEntry& entry = entries[i];
+			valid = entry.vertexOffset % 4 == 0 && entry.indexOffset % 4 == 0
+				&& entry.vertexOffset <= size && entry.numVertices <= (size - entry.vertexOffset) / sizeof(Vertex)
+				&& entry.indexOffset <= size && entry.numIndices <= (size - entry.indexOffset) / sizeof(unsigned int)
+				&& entry.lodOffset % 4 == 0 && entry.lodOffset <= size && entry.numLods <= (size - entry.lodOffset) / sizeof(MeshLod);
+			//And every LOD inside the index array
+			const MeshLod* lods = (const MeshLod*)(data + entry.lodOffset);
+			for (uint32_t j = 0; valid && j < entry.numLods; j++)
+			{
+				valid = lods[j].firstIndex <= entry.numIndices && lods[j].numIndices <= entry.numIndices - lods[j].firstIndex;
+			}
+		}
+		if (!valid) {
+			m_file.close();
+			return false;
+		}
+		m_entries = entries;
+		m_numMeshes = (int)header->numMeshes;
+		return true;
+	}
+
+	void MeshCache::close()
+	{
+		m_file.close();
+		m_entries = nullptr;
+		m_numMeshes = 0;
+	}
+
+	MeshView MeshCache::getMesh(int index) const
+	{
+		const MeshCacheEntry& entry = m_entries[index];
+		const unsigned char* data = m_file.getData();
+		MeshView view;
+		view.vertices = (const Vertex*)(data + entry.vertexOffset);
+		view.numVertices = (int)entry.numVertices;
+		view.indices = (const unsigned int*)(data + entry.indexOffset);
+		view.numIndices = (int)entry.numIndices;
+		view.lods = (const MeshLod*)(data + entry.lodOffset);
+		view.numLods = (int)entry.numLods;
+		return view;
+	}
+}
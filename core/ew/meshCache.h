@@ -0,0 +1,64 @@
+/*
+*	Binary mesh cache, so models skip the importer after the first load
+*/
+
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "mesh.h"
+#include "mappedFile.h"
+
+namespace ew {
+	//File layout: MeshCacheHeader, numMeshes MeshCacheEntry, then raw Vertex, index and MeshLod arrays at the entry offsets.
+	//Bump MESH_CACHE_VERSION whenever the layout or what gets baked into it changes.
+	const uint32_t MESH_CACHE_MAGIC = 0x434D5745; //"EWMC"
+	const uint32_t MESH_CACHE_VERSION = 3; //2: meshes are run through optimizeMesh before baking. 3: LOD chains
+
+	struct MeshCacheHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t sourceHash; //hashFile() of the file the meshes were imported from
+		uint32_t vertexSize; //sizeof(Vertex) when written
+		uint32_t numMeshes;
+	};
+
+	struct MeshCacheEntry {
+		uint64_t vertexOffset; //Bytes from the start of the file
+		uint64_t indexOffset;
+		uint64_t lodOffset;
+		uint32_t numVertices;
+		uint32_t numIndices; //Every LOD's indices
+		uint32_t numLods;
+		uint32_t padding;
+	};
+
+	//Points into the mapped cache file. Valid while the MeshCache is open.
+	struct MeshView {
+		const Vertex* vertices;
+		int numVertices;
+		const unsigned int* indices;
+		int numIndices;
+		const MeshLod* lods;
+		int numLods;
+	};
+
+	//64 bit FNV-1a of the file contents. Returns 0 if the file can't be read.
+	uint64_t hashFile(const std::string& filePath);
+	uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull);
+
+	bool writeMeshCache(const std::string& cachePath, uint64_t sourceHash, const std::vector<MeshData>& meshes);
+
+	class MeshCache {
+	public:
+		//Fails if the file is missing, truncated, from another version, or was built from a different source
+		bool open(const std::string& cachePath, uint64_t expectedSourceHash);
+		void close();
+		inline int getNumMeshes()const { return m_numMeshes; }
+		MeshView getMesh(int index)const;
+	private:
+		MappedFile m_file;
+		const MeshCacheEntry* m_entries = nullptr;
+		int m_numMeshes = 0;
+	};
+}
@@ -0,0 +1,380 @@
+/*
+*	Index and vertex reordering for GPU cache efficiency
+*/
+
+#include "meshOptimizer.h"
+#include <math.h>
+#include <algorithm>
+
+namespace ew {
+	VertexCacheStats analyzeVertexCache(const unsigned int* indices, int numIndices, int numVertices, int cacheSize)
+	{
+		//Timestamp of when each vertex entered the FIFO. In the cache while (time - timestamp) < cacheSize
+		std::vector<int> cacheTimestamps(numVertices, -cacheSize - 1);
+		int time = 0;
+		int numTransformed = 0;
+		for (int i = 0; i < numIndices; i++)
+		{
+			unsigned int v = indices[i];
+			if (time - cacheTimestamps[v] > cacheSize - 1) {
+				cacheTimestamps[v] = time++;
+				numTransformed++;
+			}
+		}
+		VertexCacheStats stats;
+		stats.acmr = numIndices > 0 ? (float)numTransformed / (numIndices / 3) : 0.0f;
+		stats.atvr = numVertices > 0 ? (float)numTransformed / numVertices : 0.0f;
+		return stats;
+	}
+
+	//Triangles adjacent to each vertex v are adjacency[offsets[v]] up to adjacency[offsets[v + 1]]
+	static void buildTriangleAdjacency(const unsigned int* indices, int numTriangles, int numVertices, std::vector<int>& offsets, std::vector<int>& adjacency)
+	{
+		offsets.assign(numVertices + 1, 0);
+		for (int i = 0; i < numTriangles * 3; i++)
+		{
+			offsets[indices[i] + 1]++;
+		}
+		for (int v = 0; v < numVertices; v++)
+		{
+			offsets[v + 1] += offsets[v];
+		}
+		adjacency.resize(numTriangles * 3);
+		std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+		for (int t = 0; t < numTriangles; t++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				adjacency[fill[indices[t * 3 + k]]++] = t;
+			}
+		}
+	}
+
+	//Forsyth's scoring, with the constants from his original write up
+	const int FORSYTH_CACHE_SIZE = 32;
+	const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+	const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+	const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+	const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+	static float forsythVertexScore(int cachePosition, int remainingTriangles) {
+		if (remainingTriangles == 0) {
+			return -1.0f;
+		}
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			//The 3 most recent vertices belong to the triangle just drawn; using them again is good but not best
+			if (cachePosition < 3) {
+				score = FORSYTH_LAST_TRIANGLE_SCORE;
+			}
+			else {
+				float scale = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+				score = powf(1.0f - (cachePosition - 3) * scale, FORSYTH_CACHE_DECAY_POWER);
+			}
+		}
+		//Favor vertices with few triangles left so they don't get stranded
+		score += FORSYTH_VALENCE_BOOST_SCALE * powf((float)remainingTriangles, -FORSYTH_VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	/// <summary>
+	/// Greedily emits the triangle whose vertices score highest in a simulated LRU cache.
+	/// Only triangles touching cached vertices are rescored each step, so it runs in roughly linear time.
+	/// </summary>
+	void optimizeVertexCache(unsigned int* indices, int numIndices, int numVertices)
+	{
+		int numTriangles = numIndices / 3;
+		if (numTriangles == 0) {
+			return;
+		}
+		std::vector<int> adjacencyOffsets;
+		std::vector<int> adjacency;
+		buildTriangleAdjacency(indices, numTriangles, numVertices, adjacencyOffsets, adjacency);
+
+		std::vector<int> remainingTriangles(numVertices);
+		std::vector<int> cachePositions(numVertices, -1);
+		std::vector<float> vertexScores(numVertices);
+		for (int v = 0; v < numVertices; v++)
+		{
+			remainingTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+			vertexScores[v] = forsythVertexScore(-1, remainingTriangles[v]);
+		}
+		std::vector<float> triangleScores(numTriangles);
+		std::vector<bool> emitted(numTriangles, false);
+		for (int t = 0; t < numTriangles; t++)
+		{
+			triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+		}
+
+		std::vector<unsigned int> output;
+		output.reserve(numTriangles * 3);
+		//Holds up to cache size + the 3 newest entries before they're trimmed
+		std::vector<int> cache;
+		cache.reserve(FORSYTH_CACHE_SIZE + 3);
+		std::vector<int> newCache;
+		newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+		int bestTriangle = 0;
+		for (int t = 1; t < numTriangles; t++)
+		{
+			if (triangleScores[t] > triangleScores[bestTriangle]) {
+				bestTriangle = t;
+			}
+		}
+		int nextUnemitted = 0;
+		for (int emittedCount = 0; emittedCount < numTriangles; emittedCount++)
+		{
+			const unsigned int* triangle = &indices[bestTriangle * 3];
+			emitted[bestTriangle] = true;
+			output.insert(output.end(), triangle, triangle + 3);
+
+			//Move the triangle's vertices to the front of the cache
+			newCache.clear();
+			for (int k = 0; k < 3; k++)
+			{
+				int v = triangle[k];
+				newCache.push_back(v);
+				remainingTriangles[v]--;
+				//Drop this triangle from the vertex's adjacency so it isn't rescored
+				int* begin = &adjacency[adjacencyOffsets[v]];
+				int* end = begin + remainingTriangles[v] + 1;
+				*std::find(begin, end, bestTriangle) = *(end - 1);
+			}
+			for (int v : cache)
+			{
+				if (v != (int)triangle[0] && v != (int)triangle[1] && v != (int)triangle[2]) {
+					newCache.push_back(v);
+				}
+			}
+			for (size_t i = FORSYTH_CACHE_SIZE; i < newCache.size(); i++)
+			{
+				cachePositions[newCache[i]] = -1;
+				vertexScores[newCache[i]] = forsythVertexScore(-1, remainingTriangles[newCache[i]]);
+			}
+			if (newCache.size() > FORSYTH_CACHE_SIZE) {
+				newCache.resize(FORSYTH_CACHE_SIZE);
+			}
+			cache.swap(newCache);
+
+			//Rescore cached vertices and the triangles around them, tracking the best
+			for (int i = 0; i < (int)cache.size(); i++)
+			{
+				cachePositions[cache[i]] = i;
+				vertexScores[cache[i]] = forsythVertexScore(i, remainingTriangles[cache[i]]);
+			}
+			bestTriangle = -1;
+			float bestScore = -1.0f;
+			for (int v : cache)
+			{
+				for (int a = adjacencyOffsets[v]; a < adjacencyOffsets[v] + remainingTriangles[v]; a++)
+				{
+					int t = adjacency[a];
+					float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+					triangleScores[t] = score;
+					if (score > bestScore) {
+						bestScore = score;
+						bestTriangle = t;
+					}
+				}
+			}
+			//Nothing connected to the cache is left, start over somewhere else
+			if (bestTriangle < 0) {
+				while (nextUnemitted < numTriangles && emitted[nextUnemitted]) {
+					nextUnemitted++;
+				}
+				bestTriangle = nextUnemitted;
+			}
+		}
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	/// <summary>
+	/// Splits the triangle order into clusters wherever a triangle misses the cache on all 3 vertices.
+	/// The cache is cold there anyway, so clusters can be reordered without losing hits. Clusters are then
+	/// sorted by how far they face away from the mesh center, a view independent guess of which surfaces occlude others.
+	/// </summary>
+	void optimizeOverdraw(unsigned int* indices, int numIndices, const Vertex* vertices, int numVertices, int cacheSize)
+	{
+		int numTriangles = numIndices / 3;
+		if (numTriangles == 0) {
+			return;
+		}
+		std::vector<int> clusterStarts;
+		std::vector<int> cacheTimestamps(numVertices, -cacheSize - 1);
+		int time = 0;
+		for (int t = 0; t < numTriangles; t++)
+		{
+			int misses = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = indices[t * 3 + k];
+				if (time - cacheTimestamps[v] > cacheSize - 1) {
+					cacheTimestamps[v] = time++;
+					misses++;
+				}
+			}
+			if (t == 0 || misses == 3) {
+				clusterStarts.push_back(t);
+			}
+		}
+		clusterStarts.push_back(numTriangles);
+		int numClusters = (int)clusterStarts.size() - 1;
+
+		glm::vec3 meshCenter = glm::vec3(0);
+		float meshArea = 0.0f;
+		std::vector<glm::vec3> clusterCenters(numClusters);
+		std::vector<glm::vec3> clusterNormals(numClusters);
+		for (int c = 0; c < numClusters; c++)
+		{
+			glm::vec3 center = glm::vec3(0);
+			glm::vec3 normal = glm::vec3(0);
+			float area = 0.0f;
+			for (int t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+			{
+				glm::vec3 p0 = vertices[indices[t * 3]].pos;
+				glm::vec3 p1 = vertices[indices[t * 3 + 1]].pos;
+				glm::vec3 p2 = vertices[indices[t * 3 + 2]].pos;
+				glm::vec3 areaNormal = glm::cross(p1 - p0, p2 - p0);
+				float triangleArea = glm::length(areaNormal);
+				center += (p0 + p1 + p2) * (triangleArea / 3.0f);
+				normal += areaNormal;
+				area += triangleArea;
+			}
+			meshCenter += center;
+			meshArea += area;
+			clusterCenters[c] = area > 0.0f ? center / area : vertices[indices[clusterStarts[c] * 3]].pos;
+			float normalLength = glm::length(normal);
+			clusterNormals[c] = normalLength > 0.0f ? normal / normalLength : glm::vec3(0);
+		}
+		if (meshArea > 0.0f) {
+			meshCenter /= meshArea;
+		}
+
+		std::vector<float> sortKeys(numClusters);
+		std::vector<int> order(numClusters);
+		for (int c = 0; c < numClusters; c++)
+		{
+			sortKeys[c] = glm::dot(clusterCenters[c] - meshCenter, clusterNormals[c]);
+			order[c] = c;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<unsigned int> output;
+		output.reserve(numTriangles * 3);
+		for (int c : order)
+		{
+			output.insert(output.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+		}
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	void optimizeVertexFetch(MeshData& meshData, std::vector<unsigned int>* remap)
+	{
+		std::vector<unsigned int> newIndices(meshData.vertices.size(), UNUSED_VERTEX);
+		std::vector<Vertex> vertices;
+		vertices.reserve(meshData.vertices.size());
+		for (unsigned int& index : meshData.indices)
+		{
+			if (newIndices[index] == UNUSED_VERTEX) {
+				newIndices[index] = (unsigned int)vertices.size();
+				vertices.push_back(meshData.vertices[index]);
+			}
+			index = newIndices[index];
+		}
+		meshData.vertices.swap(vertices);
+		if (remap != nullptr) {
+			remap->swap(newIndices);
+		}
+	}
+
+	MeshOptimizationStats optimizeMesh(MeshData& meshData, std::vector<unsigned int>* remap)
+	{
+		MeshOptimizationStats stats;
+		int numIndices = (int)meshData.indices.size();
+		stats.before = analyzeVertexCache(meshData.indices.data(), numIndices, (int)meshData.vertices.size());
+		optimizeVertexCache(meshData.indices.data(), numIndices, (int)meshData.vertices.size());
+		optimizeOverdraw(meshData.indices.data(), numIndices, meshData.vertices.data(), (int)meshData.vertices.size());
+		optimizeVertexFetch(meshData, remap);
+		stats.after = analyzeVertexCache(meshData.indices.data(), numIndices, (int)meshData.vertices.size());
+		return stats;
+	}
+
+	//Finds an unused triangle with the directed edge a->b, in its own winding order. Returns -1 if there is none
+	static int findTriangleWithEdge(const unsigned int* indices, const std::vector<int>& adjacencyOffsets, const std::vector<int>& adjacency,
+		const std::vector<bool>& used, unsigned int a, unsigned int b, unsigned int& third)
+	{
+		for (int i = adjacencyOffsets[a]; i < adjacencyOffsets[a + 1]; i++)
+		{
+			int t = adjacency[i];
+			if (used[t]) {
+				continue;
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				if (indices[t * 3 + k] == a && indices[t * 3 + (k + 1) % 3] == b) {
+					third = indices[t * 3 + (k + 2) % 3];
+					return t;
+				}
+			}
+		}
+		return -1;
+	}
+
+	/// <summary>
+	/// Greedily walks edge-adjacent triangles into strips, starting each strip at the first unused
+	/// triangle so the cache-friendly order of the list is roughly kept. A strip alternates winding
+	/// every triangle, so it only continues into a neighbour whose winding matches at that position.
+	/// </summary>
+	std::vector<unsigned int> generateTriangleStrips(const unsigned int* indices, int numIndices, int numVertices)
+	{
+		int numTriangles = numIndices / 3;
+		std::vector<int> adjacencyOffsets;
+		std::vector<int> adjacency;
+		buildTriangleAdjacency(indices, numTriangles, numVertices, adjacencyOffsets, adjacency);
+
+		std::vector<bool> used(numTriangles, false);
+		std::vector<unsigned int> strips;
+		strips.reserve(numIndices);
+		for (int start = 0; start < numTriangles; start++)
+		{
+			if (used[start]) {
+				continue;
+			}
+			used[start] = true;
+			//Rotate the first triangle so the strip can continue over its last edge, if any rotation allows it.
+			//The second triangle of a strip is wound (v2, v1, v3), so it needs the edge v2->v1.
+			const unsigned int* triangle = indices + start * 3;
+			int rotation = 0;
+			for (int r = 0; r < 3; r++)
+			{
+				unsigned int third;
+				if (findTriangleWithEdge(indices, adjacencyOffsets, adjacency, used, triangle[(r + 2) % 3], triangle[(r + 1) % 3], third) >= 0) {
+					rotation = r;
+					break;
+				}
+			}
+			if (!strips.empty()) {
+				strips.push_back(STRIP_RESTART_INDEX);
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				strips.push_back(triangle[(rotation + k) % 3]);
+			}
+			//Triangle n of a strip is (s[n], s[n+1], s[n+2]) when n is even and (s[n+1], s[n], s[n+2]) when odd
+			for (int n = 1;; n++)
+			{
+				unsigned int x = strips[strips.size() - 2];
+				unsigned int y = strips[strips.size() - 1];
+				unsigned int third;
+				int t = n % 2 == 0 ? findTriangleWithEdge(indices, adjacencyOffsets, adjacency, used, x, y, third)
+					: findTriangleWithEdge(indices, adjacencyOffsets, adjacency, used, y, x, third);
+				if (t < 0) {
+					break;
+				}
+				used[t] = true;
+				strips.push_back(third);
+			}
+		}
+		return strips;
+	}
+}
@@ -0,0 +1,41 @@
+/*
+*	Index and vertex reordering for GPU cache efficiency
+*/
+
+#pragma once
+#include <vector>
+#include "mesh.h"
+
+namespace ew {
+	struct VertexCacheStats {
+		float acmr; //Average cache miss ratio: transformed vertices per triangle. 0.5 is ideal for regular grids, 3 is worst
+		float atvr; //Average transform to vertex ratio: transformed vertices per unique vertex. 1 is ideal
+	};
+
+	//Simulates a FIFO post-transform cache of cacheSize entries
+	VertexCacheStats analyzeVertexCache(const unsigned int* indices, int numIndices, int numVertices, int cacheSize = 16);
+
+	//Reorders triangles for post-transform cache hits (Forsyth's linear-speed algorithm)
+	void optimizeVertexCache(unsigned int* indices, int numIndices, int numVertices);
+	//Reorders clusters of an already cache-optimized index buffer so outward facing clusters draw first.
+	//Clusters split where the cache simulation restarts, so the cache efficiency is kept.
+	void optimizeOverdraw(unsigned int* indices, int numIndices, const Vertex* vertices, int numVertices, int cacheSize = 16);
+	//remap entry of a vertex optimizeVertexFetch dropped
+	const unsigned int UNUSED_VERTEX = 0xFFFFFFFF;
+	//Reorders vertices into first use order and remaps the indices. Unreferenced vertices are dropped.
+	//remap, if given, gets the new index of every old vertex
+	void optimizeVertexFetch(MeshData& meshData, std::vector<unsigned int>* remap = nullptr);
+
+	struct MeshOptimizationStats {
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+	//Runs all three passes in order. remap is passed to optimizeVertexFetch
+	MeshOptimizationStats optimizeMesh(MeshData& meshData, std::vector<unsigned int>* remap = nullptr);
+
+	//Separates strips in generateTriangleStrips output. Truncates to the fixed restart index of 8 and 16 bit indices too
+	const unsigned int STRIP_RESTART_INDEX = 0xFFFFFFFF;
+	//Converts a triangle list to triangle strips joined by STRIP_RESTART_INDEX, keeping each triangle's winding.
+	//Draw with GL_PRIMITIVE_RESTART_FIXED_INDEX enabled.
+	std::vector<unsigned int> generateTriangleStrips(const unsigned int* indices, int numIndices, int numVertices);
+}
@@ -0,0 +1,435 @@
+/*
+*	Quadric error mesh simplification and LOD chain generation
+*/
+
+#include "meshSimplifier.h"
+#include "meshOptimizer.h"
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <tuple>
+#include <unordered_set>
+
+namespace ew {
+	//Sum of squared distances to a set of planes, as the symmetric 4x4 matrix Q in error(p) = p^T Q p with p = (x, y, z, 1)
+	struct Quadric {
+		double a2 = 0, ab = 0, ac = 0, ad = 0;
+		double b2 = 0, bc = 0, bd = 0;
+		double c2 = 0, cd = 0;
+		double d2 = 0;
+	};
+
+	static void addPlane(Quadric& q, double a, double b, double c, double d)
+	{
+		q.a2 += a * a; q.ab += a * b; q.ac += a * c; q.ad += a * d;
+		q.b2 += b * b; q.bc += b * c; q.bd += b * d;
+		q.c2 += c * c; q.cd += c * d;
+		q.d2 += d * d;
+	}
+
+	static Quadric addQuadrics(const Quadric& q, const Quadric& r)
+	{
+		Quadric sum;
+		sum.a2 = q.a2 + r.a2; sum.ab = q.ab + r.ab; sum.ac = q.ac + r.ac; sum.ad = q.ad + r.ad;
+		sum.b2 = q.b2 + r.b2; sum.bc = q.bc + r.bc; sum.bd = q.bd + r.bd;
+		sum.c2 = q.c2 + r.c2; sum.cd = q.cd + r.cd;
+		sum.d2 = q.d2 + r.d2;
+		return sum;
+	}
+
+	static double evaluateQuadric(const Quadric& q, const glm::vec3& p)
+	{
+		double x = p.x, y = p.y, z = p.z;
+		double error = q.a2 * x * x + q.b2 * y * y + q.c2 * z * z + q.d2
+			+ 2.0 * (q.ab * x * y + q.ac * x * z + q.bc * y * z + q.ad * x + q.bd * y + q.cd * z);
+		//Rounding can push a zero error slightly negative
+		return error > 0.0 ? error : 0.0;
+	}
+
+	const double EDGE_LENGTH_WEIGHT = 1e-4;
+
+	struct Collapse {
+		double cost;
+		unsigned int from;
+		unsigned int to;
+		//std::priority_queue pops the largest element, so compare in reverse to get the cheapest collapse first
+		bool operator<(const Collapse& other)const { return cost > other.cost; }
+	};
+
+	static glm::vec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		return glm::cross(b - a, c - a);
+	}
+
+	static float pointTriangleDistanceSquared(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+	/// <summary>
+	/// Distance from every original vertex to the triangles now around the vertex it was collapsed onto.
+	/// The true closest triangle may be elsewhere, so this bounds the distance to the simplified surface from above.
+	/// Quadric costs are sums over many planes and overestimate that distance several times over.
+	/// </summary>
+	static float measureCollapseError(const Vertex* vertices, int numVertices, const std::vector<unsigned int>& triangles,
+		const std::vector<bool>& removed, std::vector<std::vector<int>>& vertexTriangles, std::vector<unsigned int>& collapsedTo)
+	{
+		for (std::vector<int>& adjacent : vertexTriangles)
+		{
+			adjacent.erase(std::remove_if(adjacent.begin(), adjacent.end(), [&](int t) { return removed[t]; }), adjacent.end());
+		}
+		float maxDistanceSquared = 0.0f;
+		for (unsigned int v = 0; v < (unsigned int)numVertices; v++)
+		{
+			//Follow the collapse chain, compressing it as we go
+			unsigned int target = v;
+			while (collapsedTo[target] != target) {
+				target = collapsedTo[target];
+			}
+			collapsedTo[v] = target;
+			if (target == v) {
+				continue;
+			}
+			//Collapses onto busy vertices can leave v under a triangle one ring further out, so search two rings
+			const glm::vec3& p = vertices[v].pos;
+			float closest = FLT_MAX;
+			for (int t : vertexTriangles[target])
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					for (int neighbour : vertexTriangles[triangles[t * 3 + k]])
+					{
+						closest = std::min(closest, pointTriangleDistanceSquared(p, vertices[triangles[neighbour * 3]].pos,
+							vertices[triangles[neighbour * 3 + 1]].pos, vertices[triangles[neighbour * 3 + 2]].pos));
+					}
+				}
+			}
+			//A vertex left without triangles has nothing to be measured against
+			if (closest < FLT_MAX) {
+				maxDistanceSquared = std::max(maxDistanceSquared, closest);
+			}
+		}
+		return sqrtf(maxDistanceSquared);
+	}
+
+	/// <summary>
+	/// Half-edge collapses ordered by quadric error. Seam vertices share a position with other vertices,
+	/// so topology, locking and quadrics are tracked per welded position while triangles keep their own vertex indices.
+	/// Collapse costs are re-evaluated lazily: quadrics only grow, so a popped collapse whose cost went up is pushed back.
+	/// </summary>
+	std::vector<unsigned int> simplifyIndices(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices,
+		int targetIndexCount, float* error)
+	{
+		int numTriangles = numIndices / 3;
+		std::vector<unsigned int> triangles(indices, indices + numTriangles * 3);
+		if (error) {
+			*error = 0.0f;
+		}
+		if (numTriangles * 3 <= targetIndexCount) {
+			return triangles;
+		}
+
+		//Weld vertices by position. Adding 0 turns -0 into 0
+		std::map<std::tuple<float, float, float>, unsigned int> positionMap;
+		std::vector<unsigned int> positionIds(numVertices);
+		for (int v = 0; v < numVertices; v++)
+		{
+			const glm::vec3& p = vertices[v].pos;
+			auto inserted = positionMap.emplace(std::make_tuple(p.x + 0.0f, p.y + 0.0f, p.z + 0.0f), (unsigned int)positionMap.size());
+			positionIds[v] = inserted.first->second;
+		}
+		int numPositions = (int)positionMap.size();
+
+		//Seams have more than one referenced vertex at a position, borders have an edge without a twin.
+		//Collapsing either would tear the mesh or smear attributes, so both stay put.
+		std::vector<int> positionVertex(numPositions, -1);
+		std::vector<bool> locked(numPositions, false);
+		std::unordered_set<uint64_t> directedEdges;
+		for (int i = 0; i < numTriangles * 3; i++)
+		{
+			unsigned int v = triangles[i];
+			unsigned int p = positionIds[v];
+			if (positionVertex[p] < 0) {
+				positionVertex[p] = v;
+			}
+			else if (positionVertex[p] != (int)v) {
+				locked[p] = true;
+			}
+			unsigned int next = positionIds[triangles[i - i % 3 + (i + 1) % 3]];
+			directedEdges.insert(((uint64_t)p << 32) | next);
+		}
+		for (int i = 0; i < numTriangles * 3; i++)
+		{
+			unsigned int p = positionIds[triangles[i]];
+			unsigned int next = positionIds[triangles[i - i % 3 + (i + 1) % 3]];
+			if (directedEdges.count(((uint64_t)next << 32) | p) == 0) {
+				locked[p] = locked[next] = true;
+			}
+		}
+
+		std::vector<Quadric> quadrics(numPositions);
+		std::vector<std::vector<int>> vertexTriangles(numVertices);
+		for (int t = 0; t < numTriangles; t++)
+		{
+			const unsigned int* triangle = &triangles[t * 3];
+			glm::vec3 normal = triangleNormal(vertices[triangle[0]].pos, vertices[triangle[1]].pos, vertices[triangle[2]].pos);
+			float length = glm::length(normal);
+			if (length > 0.0f) {
+				normal /= length;
+				float d = -glm::dot(normal, vertices[triangle[0]].pos);
+				for (int k = 0; k < 3; k++)
+				{
+					addPlane(quadrics[positionIds[triangle[k]]], normal.x, normal.y, normal.z, d);
+				}
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				vertexTriangles[triangle[k]].push_back(t);
+			}
+		}
+
+		//Flat regions all cost 0. A small edge length term breaks those ties toward short edges,
+		//which keeps collapses spread out instead of piling every neighbour onto one vertex
+		auto collapseCost = [&](unsigned int from, unsigned int to) {
+			glm::vec3 edge = vertices[to].pos - vertices[from].pos;
+			return evaluateQuadric(addQuadrics(quadrics[positionIds[from]], quadrics[positionIds[to]]), vertices[to].pos)
+				+ EDGE_LENGTH_WEIGHT * glm::dot(edge, edge);
+		};
+		std::priority_queue<Collapse> queue;
+		auto pushCollapse = [&](unsigned int from, unsigned int to) {
+			unsigned int fromPosition = positionIds[from];
+			unsigned int toPosition = positionIds[to];
+			if (locked[fromPosition] || fromPosition == toPosition) {
+				return;
+			}
+			Collapse collapse;
+			collapse.cost = collapseCost(from, to);
+			collapse.from = from;
+			collapse.to = to;
+			queue.push(collapse);
+		};
+		for (int i = 0; i < numTriangles * 3; i++)
+		{
+			unsigned int v = triangles[i];
+			unsigned int next = triangles[i - i % 3 + (i + 1) % 3];
+			pushCollapse(v, next);
+			pushCollapse(next, v);
+		}
+
+		std::vector<bool> removed(numTriangles, false);
+		//Vertex each vertex was collapsed onto, itself while it's still in the mesh
+		std::vector<unsigned int> collapsedTo(numVertices);
+		for (int v = 0; v < numVertices; v++)
+		{
+			collapsedTo[v] = v;
+		}
+		int numLiveTriangles = numTriangles;
+		while (numLiveTriangles * 3 > targetIndexCount && !queue.empty())
+		{
+			Collapse collapse = queue.top();
+			queue.pop();
+			if (collapsedTo[collapse.from] != collapse.from || collapsedTo[collapse.to] != collapse.to) {
+				continue;
+			}
+			unsigned int fromPosition = positionIds[collapse.from];
+			unsigned int toPosition = positionIds[collapse.to];
+			double cost = collapseCost(collapse.from, collapse.to);
+			if (cost > collapse.cost * 1.0001 + 1e-12) {
+				collapse.cost = cost;
+				queue.push(collapse);
+				continue;
+			}
+
+			//The edge must still exist, and no remaining triangle around from may flip or become a sliver
+			const glm::vec3& toPos = vertices[collapse.to].pos;
+			bool adjacent = false;
+			bool flips = false;
+			for (int t : vertexTriangles[collapse.from])
+			{
+				if (removed[t]) {
+					continue;
+				}
+				const unsigned int* triangle = &triangles[t * 3];
+				glm::vec3 before[3];
+				glm::vec3 after[3];
+				bool degenerates = false;
+				for (int k = 0; k < 3; k++)
+				{
+					before[k] = vertices[triangle[k]].pos;
+					after[k] = triangle[k] == collapse.from ? toPos : before[k];
+					degenerates |= positionIds[triangle[k]] == toPosition;
+				}
+				if (degenerates) {
+					adjacent = true;
+					continue;
+				}
+				glm::vec3 normalBefore = triangleNormal(before[0], before[1], before[2]);
+				glm::vec3 normalAfter = triangleNormal(after[0], after[1], after[2]);
+				if (glm::dot(normalBefore, normalAfter) <= 0.0f) {
+					flips = true;
+					break;
+				}
+			}
+			if (!adjacent || flips) {
+				continue;
+			}
+
+			for (int t : vertexTriangles[collapse.from])
+			{
+				if (removed[t]) {
+					continue;
+				}
+				unsigned int* triangle = &triangles[t * 3];
+				for (int k = 0; k < 3; k++)
+				{
+					if (triangle[k] == collapse.from) {
+						triangle[k] = collapse.to;
+					}
+				}
+				if (positionIds[triangle[0]] == positionIds[triangle[1]] || positionIds[triangle[1]] == positionIds[triangle[2]]
+					|| positionIds[triangle[2]] == positionIds[triangle[0]]) {
+					removed[t] = true;
+					numLiveTriangles--;
+				}
+				else {
+					vertexTriangles[collapse.to].push_back(t);
+				}
+			}
+			collapsedTo[collapse.from] = collapse.to;
+			std::vector<int>().swap(vertexTriangles[collapse.from]);
+			quadrics[toPosition] = addQuadrics(quadrics[toPosition], quadrics[fromPosition]);
+
+			//Drop removed triangles so busy vertices don't keep rescanning them,
+			//then queue collapses along to's edges, some of which are new
+			std::vector<int>& toTriangles = vertexTriangles[collapse.to];
+			toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(), [&](int t) { return removed[t]; }), toTriangles.end());
+			for (int t : toTriangles)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int v = triangles[t * 3 + k];
+					if (v != collapse.to) {
+						pushCollapse(v, collapse.to);
+						pushCollapse(collapse.to, v);
+					}
+				}
+			}
+		}
+
+		std::vector<unsigned int> simplified;
+		simplified.reserve(numLiveTriangles * 3);
+		for (int t = 0; t < numTriangles; t++)
+		{
+			if (!removed[t]) {
+				simplified.insert(simplified.end(), &triangles[t * 3], &triangles[t * 3 + 3]);
+			}
+		}
+		if (error) {
+			*error = measureCollapseError(vertices, numVertices, triangles, removed, vertexTriangles, collapsedTo);
+		}
+		return simplified;
+	}
+
+	/// <summary>
+	/// Every level is simplified from the full mesh rather than the previous level,
+	/// so each error is measured against the original surface.
+	/// </summary>
+	void generateLods(MeshData& meshData, int maxLods, float reduction)
+	{
+		//Regenerating drops any LODs already appended
+		if (!meshData.lods.empty()) {
+			meshData.indices.resize(meshData.lods[0].numIndices);
+		}
+		int numBaseIndices = (int)meshData.indices.size();
+		meshData.lods.clear();
+		MeshLod base;
+		base.firstIndex = 0;
+		base.numIndices = numBaseIndices;
+		base.error = 0.0f;
+		meshData.lods.push_back(base);
+
+		for (int i = 1; i < maxLods; i++)
+		{
+			const MeshLod& previous = meshData.lods.back();
+			int targetIndexCount = (int)(previous.numIndices * reduction) / 3 * 3;
+			float error;
+			std::vector<unsigned int> indices = simplifyIndices(meshData.vertices.data(), meshData.vertices.size(),
+				meshData.indices.data(), numBaseIndices, targetIndexCount, &error);
+			//Locked seams and borders stall simplification, a level that barely shrank isn't worth drawing
+			if (indices.empty() || indices.size() > previous.numIndices * 0.8f) {
+				break;
+			}
+			optimizeVertexCache(indices.data(), indices.size(), meshData.vertices.size());
+			MeshLod lod;
+			lod.firstIndex = meshData.indices.size();
+			lod.numIndices = indices.size();
+			lod.error = std::max(error, previous.error);
+			meshData.indices.insert(meshData.indices.end(), indices.begin(), indices.end());
+			meshData.lods.push_back(lod);
+		}
+	}
+
+	static float pointTriangleDistanceSquared(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		//Closest point by Voronoi region, from Ericson's Real-Time Collision Detection
+		glm::vec3 ab = b - a;
+		glm::vec3 ac = c - a;
+		glm::vec3 ap = p - a;
+		float d1 = glm::dot(ab, ap);
+		float d2 = glm::dot(ac, ap);
+		if (d1 <= 0.0f && d2 <= 0.0f) {
+			return glm::dot(ap, ap);
+		}
+		glm::vec3 bp = p - b;
+		float d3 = glm::dot(ab, bp);
+		float d4 = glm::dot(ac, bp);
+		if (d3 >= 0.0f && d4 <= d3) {
+			return glm::dot(bp, bp);
+		}
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+			glm::vec3 q = a + ab * (d1 / (d1 - d3));
+			return glm::dot(p - q, p - q);
+		}
+		glm::vec3 cp = p - c;
+		float d5 = glm::dot(ab, cp);
+		float d6 = glm::dot(ac, cp);
+		if (d6 >= 0.0f && d5 <= d6) {
+			return glm::dot(cp, cp);
+		}
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+			glm::vec3 q = a + ac * (d2 / (d2 - d6));
+			return glm::dot(p - q, p - q);
+		}
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+			glm::vec3 q = b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+			return glm::dot(p - q, p - q);
+		}
+		float denominator = 1.0f / (va + vb + vc);
+		glm::vec3 q = a + ab * (vb * denominator) + ac * (vc * denominator);
+		return glm::dot(p - q, p - q);
+	}
+
+	float measureSimplificationError(const Vertex* vertices, const unsigned int* indices, int numIndices,
+		const unsigned int* simplifiedIndices, int numSimplifiedIndices)
+	{
+		float maxDistanceSquared = 0.0f;
+		std::unordered_set<unsigned int> measured;
+		for (int i = 0; i < numIndices; i++)
+		{
+			if (!measured.insert(indices[i]).second) {
+				continue;
+			}
+			const glm::vec3& p = vertices[indices[i]].pos;
+			float closest = FLT_MAX;
+			for (int t = 0; t + 2 < numSimplifiedIndices && closest > maxDistanceSquared; t += 3)
+			{
+				closest = std::min(closest, pointTriangleDistanceSquared(p, vertices[simplifiedIndices[t]].pos,
+					vertices[simplifiedIndices[t + 1]].pos, vertices[simplifiedIndices[t + 2]].pos));
+			}
+			maxDistanceSquared = std::max(maxDistanceSquared, closest);
+		}
+		return sqrtf(maxDistanceSquared);
+	}
+}
@@ -0,0 +1,26 @@
+/*
+*	Quadric error mesh simplification and LOD chain generation
+*/
+
+#pragma once
+#include <vector>
+#include "mesh.h"
+
+namespace ew {
+	//Collapses edges in order of quadric error (Garland & Heckbert) until at most targetIndexCount indices remain
+	//or no valid collapse is left. Vertices are only collapsed onto their neighbours, never moved,
+	//so the result indexes the same vertex array. Vertices on UV/normal seams and open borders are locked.
+	//error receives an upper bound on the distance from removed vertices to the simplified surface, in object space units.
+	std::vector<unsigned int> simplifyIndices(const Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices,
+		int targetIndexCount, float* error = nullptr);
+
+	//Appends up to maxLods - 1 simplified index ranges to meshData.indices and describes all of them in meshData.lods.
+	//Each level targets reduction times the previous level's triangles; generation stops early once simplification stalls.
+	//Run optimizeMesh first, every LOD shares its vertex order.
+	void generateLods(MeshData& meshData, int maxLods = 4, float reduction = 0.5f);
+
+	//Largest distance from a vertex of the original triangles to the simplified surface.
+	//Brute force over every vertex/triangle pair, meant for tests and tools.
+	float measureSimplificationError(const Vertex* vertices, const unsigned int* indices, int numIndices,
+		const unsigned int* simplifiedIndices, int numSimplifiedIndices);
+}
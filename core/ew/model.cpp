@@ -3,6 +3,10 @@
 */
 
 #include "model.h"
+#include "meshCache.h"
+#include "meshOptimizer.h"
+#include "meshSimplifier.h"
+#include <stdio.h>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 
@@ -10,25 +14,138 @@
 #include <glm/glm.hpp>
 
 namespace ew {
-	ew::Mesh processAiMesh(aiMesh* aiMesh);
+	ew::MeshData processAiMesh(aiMesh* aiMesh);
 
-	Model::Model(const std::string& filePath)
+	//Imports with Assimp, then optimizes and builds LODs. Returns false if the file can't be imported
+	static bool importMeshData(const std::string& filePath, std::vector<ew::MeshData>& meshData)
 	{
 		Assimp::Importer importer;
 		const aiScene* aiScene = importer.ReadFile(filePath, aiProcess_Triangulate);
+		if (aiScene == NULL) {
+			printf("Failed to load model %s: %s\n", filePath.c_str(), importer.GetErrorString());
+			return false;
+		}
+		meshData.resize(aiScene->mNumMeshes);
 		for (size_t i = 0; i < aiScene->mNumMeshes; i++)
 		{
 			aiMesh* aiMesh = aiScene->mMeshes[i];
-			m_meshes.push_back(processAiMesh(aiMesh));
+			meshData[i] = processAiMesh(aiMesh);
+			//Baked into the cache too, so cached loads get the optimized order for free
+			optimizeMesh(meshData[i]);
+			generateLods(meshData[i]);
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// CPU copies of a model's meshes, through the same cache as Model. For uploads Model doesn't do itself, e.g. into a GeometryArena.
+	/// </summary>
+	std::vector<MeshData> loadMeshData(const std::string& filePath, bool useCache)
+	{
+		std::string cachePath = filePath + ".ewmesh";
+		uint64_t sourceHash = useCache ? hashFile(filePath) : 0;
+		std::vector<MeshData> meshData;
+		MeshCache cache;
+		if (sourceHash != 0 && cache.open(cachePath, sourceHash)) {
+			meshData.resize(cache.getNumMeshes());
+			for (int i = 0; i < cache.getNumMeshes(); i++)
+			{
+				MeshView view = cache.getMesh(i);
+				meshData[i].vertices.assign(view.vertices, view.vertices + view.numVertices);
+				meshData[i].indices.assign(view.indices, view.indices + view.numIndices);
+				meshData[i].lods.assign(view.lods, view.lods + view.numLods);
+			}
+		}
+		else if (importMeshData(filePath, meshData) && sourceHash != 0) {
+			writeMeshCache(cachePath, sourceHash, meshData);
 		}
+		return meshData;
 	}
 
-	void Model::draw()
+	Model::Model(const std::string& filePath, bool useCache, VertexFormat vertexFormat)
 	{
+		std::string cachePath = filePath + ".ewmesh";
+		uint64_t sourceHash = useCache ? hashFile(filePath) : 0;
+		MeshCache cache;
+		//Cached meshes upload straight from the mapped file
+		if (sourceHash != 0 && cache.open(cachePath, sourceHash)) {
+			m_meshes.resize(cache.getNumMeshes());
+			for (int i = 0; i < cache.getNumMeshes(); i++)
+			{
+				MeshView view = cache.getMesh(i);
+				m_meshes[i].load(view.vertices, view.numVertices, view.indices, view.numIndices, vertexFormat, IndexLayout::TRIANGLE_LIST, view.lods, view.numLods);
+			}
+		}
+		else {
+			std::vector<ew::MeshData> meshData;
+			if (!importMeshData(filePath, meshData)) {
+				return;
+			}
+			m_meshes.reserve(meshData.size());
+			for (size_t i = 0; i < meshData.size(); i++)
+			{
+				m_meshes.push_back(ew::Mesh(meshData[i], vertexFormat));
+			}
+			if (sourceHash != 0) {
+				writeMeshCache(cachePath, sourceHash, meshData);
+			}
+		}
 		for (size_t i = 0; i < m_meshes.size(); i++)
 		{
-			m_meshes[i].draw();
+			const ew::Mesh& mesh = m_meshes[i];
+			m_aabb = i == 0 ? mesh.getAABB() : combineAABB(m_aabb, mesh.getAABB());
+			m_boundingSphere = i == 0 ? mesh.getBoundingSphere() : combineBoundingSphere(m_boundingSphere, mesh.getBoundingSphere());
+		}
+	}
+
+	void Model::draw(DrawMode drawMode, int lod)
+	{
+		for (size_t i = 0; i < m_meshes.size(); i++)
+		{
+			m_meshes[i].draw(drawMode, lod);
+		}
+	}
+
+	void Model::drawInstanced(int instanceCount, DrawMode drawMode, int lod)
+	{
+		for (size_t i = 0; i < m_meshes.size(); i++)
+		{
+			m_meshes[i].drawInstanced(instanceCount, drawMode, lod);
+		}
+	}
+
+	/// <summary>
+	/// LOD levels every mesh has. Meshes simplify at different rates, so a model LOD's error is its worst mesh's
+	/// </summary>
+	int Model::getNumLods() const
+	{
+		int numLods = m_meshes.empty() ? 1 : m_meshes[0].getNumLods();
+		for (size_t i = 1; i < m_meshes.size(); i++)
+		{
+			numLods = glm::min(numLods, m_meshes[i].getNumLods());
+		}
+		return numLods;
+	}
+
+	float Model::getLodError(int lod) const
+	{
+		float error = 0.0f;
+		for (size_t i = 0; i < m_meshes.size(); i++)
+		{
+			error = glm::max(error, m_meshes[i].getLodError(lod));
+		}
+		return error;
+	}
+
+	int Model::selectLod(float maxError) const
+	{
+		for (int i = getNumLods() - 1; i > 0; i--)
+		{
+			if (getLodError(i) <= maxError) {
+				return i;
+			}
 		}
+		return 0;
 	}
 
 	glm::vec3 convertAIVec3(const aiVector3D& v) {
@@ -36,8 +153,11 @@ namespace ew {
 	}
 
 	//Utility functions local to this file
-	ew::Mesh processAiMesh(aiMesh* aiMesh) {
+	ew::MeshData processAiMesh(aiMesh* aiMesh) {
 		ew::MeshData meshData;
+		meshData.vertices.reserve(aiMesh->mNumVertices);
+		//Triangulated, so every face has 3 indices
+		meshData.indices.reserve(aiMesh->mNumFaces * 3);
 		for (size_t i = 0; i < aiMesh->mNumVertices; i++)
 		{
 			ew::Vertex vertex;
@@ -58,7 +178,7 @@ namespace ew {
 				meshData.indices.push_back(aiMesh->mFaces[i].mIndices[j]);
 			}
 		}
-		return ew::Mesh(meshData);
+		return meshData;
 	}
 
 }
@@ -10,9 +10,26 @@
 namespace ew {
 	class Model {
 	public:
-		Model(const std::string& filePath);
-		void draw();
+		//Loads from filePath + ".ewmesh" when that cache matches the source file, otherwise imports with Assimp and writes the cache.
+		//Imported meshes are optimized and get a LOD chain before upload.
+		//The cache always stores full float vertices, vertexFormat only selects the GPU layout
+		Model(const std::string& filePath, bool useCache = true, VertexFormat vertexFormat = VertexFormat::FULL);
+		void draw(DrawMode drawMode = DrawMode::TRIANGLES, int lod = 0);
+		void drawInstanced(int instanceCount, DrawMode drawMode = DrawMode::TRIANGLES, int lod = 0);
+		//LODs are generated on import and stored in the mesh cache, see generateLods
+		int getNumLods()const;
+		float getLodError(int lod)const;
+		//Coarsest LOD whose error is at most maxError, in object space units
+		int selectLod(float maxError)const;
+		//Object space bounds enclosing every mesh
+		inline const AABB& getAABB()const { return m_aabb; }
+		inline const BoundingSphere& getBoundingSphere()const { return m_boundingSphere; }
 	private:
 		std::vector<ew::Mesh> m_meshes;
+		AABB m_aabb;
+		BoundingSphere m_boundingSphere;
 	};
+
+	//Optimized meshes with LODs as Model would load them, using and writing the same cache
+	std::vector<MeshData> loadMeshData(const std::string& filePath, bool useCache = true);
 }
\ No newline at end of file
@@ -0,0 +1,236 @@
+/*
+*	Hierarchical-Z occlusion culling, on the GPU and with a software rasterized CPU fallback
+*/
+
+#include "occlusion.h"
+#include "external/glad.h"
+#include <math.h>
+
+namespace ew {
+	int getHiZLevels(int width, int height)
+	{
+		int levels = 1;
+		while (width > 1 || height > 1) {
+			width = glm::max(width / 2, 1);
+			height = glm::max(height / 2, 1);
+			levels++;
+		}
+		return levels;
+	}
+
+	/// <summary>
+	/// Same level sizes as a GL mip chain: each level is half the previous one, rounded down.
+	/// </summary>
+	void buildHiZ(const float* depth, int width, int height, const glm::mat4& viewProjection, HiZPyramid* pyramid)
+	{
+		int numLevels = getHiZLevels(width, height);
+		pyramid->viewProjection = viewProjection;
+		pyramid->levels.resize(numLevels);
+		pyramid->sizes.resize(numLevels);
+		pyramid->levels[0].assign(depth, depth + width * height);
+		pyramid->sizes[0] = glm::ivec2(width, height);
+		for (int level = 1; level < numLevels; level++)
+		{
+			glm::ivec2 sourceSize = pyramid->sizes[level - 1];
+			glm::ivec2 size = glm::max(sourceSize / 2, glm::ivec2(1));
+			const std::vector<float>& source = pyramid->levels[level - 1];
+			std::vector<float>& destination = pyramid->levels[level];
+			destination.resize(size.x * size.y);
+			pyramid->sizes[level] = size;
+			for (int y = 0; y < size.y; y++)
+			{
+				int lastY = y == size.y - 1 ? sourceSize.y - 1 : y * 2 + 1;
+				for (int x = 0; x < size.x; x++)
+				{
+					int lastX = x == size.x - 1 ? sourceSize.x - 1 : x * 2 + 1;
+					float farthest = 0.0f;
+					for (int sy = y * 2; sy <= lastY; sy++) {
+						for (int sx = x * 2; sx <= lastX; sx++) {
+							farthest = glm::max(farthest, source[sy * sourceSize.x + sx]);
+						}
+					}
+					destination[y * size.x + x] = farthest;
+				}
+			}
+		}
+	}
+
+	//Grouped like glm's mat4 * vec4, and written out the same way in the shaders
+	static glm::vec4 projectPoint(const glm::mat4& m, const glm::vec3& p)
+	{
+		return (m[0] * p.x + m[1] * p.y) + (m[2] * p.z + m[3]);
+	}
+
+	/// <summary>
+	/// Projects the box corners to a screen rectangle and its nearest depth, then reads the level where the rectangle
+	/// spans at most 2x2 texels. Those 4 texels cover it, so the box is hidden if it's behind all of them.
+	/// </summary>
+	bool isOccluded(const HiZPyramid& pyramid, const AABB& worldBounds)
+	{
+		if (pyramid.levels.empty()) {
+			return false;
+		}
+		glm::ivec2 size = pyramid.sizes[0];
+		glm::vec2 rectMin = glm::vec2(1e30f);
+		glm::vec2 rectMax = glm::vec2(-1e30f);
+		float nearestDepth = 1.0f;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 p = glm::vec3(corner & 1 ? worldBounds.max.x : worldBounds.min.x,
+				corner & 2 ? worldBounds.max.y : worldBounds.min.y,
+				corner & 4 ? worldBounds.max.z : worldBounds.min.z);
+			glm::vec4 clip = projectPoint(pyramid.viewProjection, p);
+			if (!(clip.w > 1e-6f)) {
+				return false;
+			}
+			glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			glm::vec2 screen = (glm::vec2(ndc) * 0.5f + 0.5f) * glm::vec2(size);
+			rectMin = glm::min(rectMin, screen);
+			rectMax = glm::max(rectMax, screen);
+			nearestDepth = glm::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+		}
+		if (!(nearestDepth > 0.0f) || rectMax.x < 0.0f || rectMax.y < 0.0f || rectMin.x >= size.x || rectMin.y >= size.y) {
+			return false;
+		}
+		int x0 = (int)floorf(glm::clamp(rectMin.x, 0.0f, size.x - 1.0f));
+		int y0 = (int)floorf(glm::clamp(rectMin.y, 0.0f, size.y - 1.0f));
+		int x1 = (int)floorf(glm::clamp(rectMax.x, 0.0f, size.x - 1.0f));
+		int y1 = (int)floorf(glm::clamp(rectMax.y, 0.0f, size.y - 1.0f));
+		int level = 0;
+		while (level < pyramid.getNumLevels() - 1 && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+			level++;
+		}
+		glm::ivec2 levelSize = pyramid.sizes[level];
+		const std::vector<float>& depth = pyramid.levels[level];
+		//Clamped texels on odd sized levels hold the folded in leftovers
+		int lx0 = glm::min(x0 >> level, levelSize.x - 1);
+		int ly0 = glm::min(y0 >> level, levelSize.y - 1);
+		int lx1 = glm::min(x1 >> level, levelSize.x - 1);
+		int ly1 = glm::min(y1 >> level, levelSize.y - 1);
+		float farthest = glm::max(glm::max(depth[ly0 * levelSize.x + lx0], depth[ly0 * levelSize.x + lx1]),
+			glm::max(depth[ly1 * levelSize.x + lx0], depth[ly1 * levelSize.x + lx1]));
+		return nearestDepth > farthest;
+	}
+
+	void clearDepthBuffer(DepthBuffer* buffer, int width, int height)
+	{
+		buffer->width = width;
+		buffer->height = height;
+		buffer->depth.assign(width * height, 1.0f);
+	}
+
+	static float edgeFunction(const glm::vec3& a, const glm::vec3& b, float x, float y)
+	{
+		return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+	}
+
+	/// <summary>
+	/// Half-space rasterizer. Depth is interpolated linearly in screen space, which is exact for NDC depth.
+	/// </summary>
+	void rasterizeDepth(DepthBuffer* buffer, const glm::mat4& modelViewProjection, const Vertex* vertices, const unsigned int* indices, int numIndices)
+	{
+		glm::vec2 size = glm::vec2(buffer->width, buffer->height);
+		for (int i = 0; i + 2 < numIndices; i += 3)
+		{
+			glm::vec3 screen[3];
+			bool clipped = false;
+			for (int k = 0; k < 3; k++)
+			{
+				glm::vec4 clip = projectPoint(modelViewProjection, vertices[indices[i + k]].pos);
+				if (!(clip.w > 1e-6f) || clip.z < -clip.w) {
+					clipped = true;
+					break;
+				}
+				glm::vec3 ndc = glm::vec3(clip) / clip.w;
+				screen[k] = glm::vec3((glm::vec2(ndc) * 0.5f + 0.5f) * size, ndc.z * 0.5f + 0.5f);
+			}
+			if (clipped) {
+				continue;
+			}
+			float area = edgeFunction(screen[0], screen[1], screen[2].x, screen[2].y);
+			if (area == 0.0f) {
+				continue;
+			}
+			float sign = area < 0.0f ? -1.0f : 1.0f;
+			glm::vec2 triangleMin = glm::min(glm::min(glm::vec2(screen[0]), glm::vec2(screen[1])), glm::vec2(screen[2]));
+			glm::vec2 triangleMax = glm::max(glm::max(glm::vec2(screen[0]), glm::vec2(screen[1])), glm::vec2(screen[2]));
+			if (triangleMax.x < 0.0f || triangleMax.y < 0.0f || triangleMin.x > size.x || triangleMin.y > size.y) {
+				continue;
+			}
+			//Pixels whose centers can fall inside
+			int x0 = (int)glm::max(floorf(triangleMin.x - 0.5f), 0.0f);
+			int y0 = (int)glm::max(floorf(triangleMin.y - 0.5f), 0.0f);
+			int x1 = (int)glm::min(ceilf(triangleMax.x - 0.5f), size.x - 1.0f);
+			int y1 = (int)glm::min(ceilf(triangleMax.y - 0.5f), size.y - 1.0f);
+			for (int y = y0; y <= y1; y++)
+			{
+				float py = y + 0.5f;
+				for (int x = x0; x <= x1; x++)
+				{
+					float px = x + 0.5f;
+					float w0 = edgeFunction(screen[1], screen[2], px, py) * sign;
+					float w1 = edgeFunction(screen[2], screen[0], px, py) * sign;
+					float w2 = edgeFunction(screen[0], screen[1], px, py) * sign;
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+						continue;
+					}
+					float depth = (w0 * screen[0].z + w1 * screen[1].z + w2 * screen[2].z) / (area * sign);
+					float& stored = buffer->depth[y * buffer->width + x];
+					stored = glm::min(stored, depth);
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Level 0 copies the depth texture, then each level is reduced from the one before it.
+	/// Textures bound to unit 0 and image units 0 and 1 are replaced.
+	/// </summary>
+	void HiZBuffer::build(const Shader& hiZShader, unsigned int depthTexture, int width, int height, const glm::mat4& viewProjection)
+	{
+		if (m_texture == 0 || width != m_width || height != m_height) {
+			glDeleteTextures(1, &m_texture);
+			m_width = width;
+			m_height = height;
+			m_numLevels = getHiZLevels(width, height);
+			glCreateTextures(GL_TEXTURE_2D, 1, &m_texture);
+			glTextureStorage2D(m_texture, m_numLevels, GL_R32F, width, height);
+			glTextureParameteri(m_texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+			glTextureParameteri(m_texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		}
+		m_viewProjection = viewProjection;
+		hiZShader.use();
+		glBindTextureUnit(0, depthTexture);
+		for (int level = 0; level < m_numLevels; level++)
+		{
+			int levelWidth = glm::max(width >> level, 1);
+			int levelHeight = glm::max(height >> level, 1);
+			if (level > 0) {
+				glBindImageTexture(0, m_texture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			}
+			glBindImageTexture(1, m_texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			hiZShader.setInt("_Level", level);
+			glDispatchCompute((levelWidth + 7) / 8, (levelHeight + 7) / 8, 1);
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		}
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+	void HiZBuffer::bind(unsigned int textureUnit) const
+	{
+		glBindTextureUnit(textureUnit, m_texture);
+	}
+	void HiZBuffer::download(HiZPyramid* pyramid) const
+	{
+		glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+		pyramid->viewProjection = m_viewProjection;
+		pyramid->levels.resize(m_numLevels);
+		pyramid->sizes.resize(m_numLevels);
+		for (int level = 0; level < m_numLevels; level++)
+		{
+			glm::ivec2 size = glm::ivec2(glm::max(m_width >> level, 1), glm::max(m_height >> level, 1));
+			pyramid->sizes[level] = size;
+			pyramid->levels[level].resize(size.x * size.y);
+			glGetTextureImage(m_texture, level, GL_RED, GL_FLOAT, sizeof(float) * size.x * size.y, pyramid->levels[level].data());
+		}
+	}
+}
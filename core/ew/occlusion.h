@@ -0,0 +1,62 @@
+/*
+*	Hierarchical-Z occlusion culling, on the GPU and with a software rasterized CPU fallback
+*/
+
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "bounds.h"
+#include "mesh.h"
+#include "shader.h"
+
+namespace ew {
+	//Farthest depth mip chain in GL window depth, [0, 1] with 1 at the far plane.
+	//Level 0 is the depth buffer. Each texel of the next level holds the farthest of the 2x2 texels below it,
+	//and on odd sized levels the last row/column also folds in the leftover texels, so coarser levels never miss any.
+	struct HiZPyramid {
+		std::vector<std::vector<float>> levels;
+		std::vector<glm::ivec2> sizes;
+		glm::mat4 viewProjection = glm::mat4(1.0f); //What the depth was rendered with
+		inline int getNumLevels()const { return (int)levels.size(); }
+	};
+
+	int getHiZLevels(int width, int height);
+	void buildHiZ(const float* depth, int width, int height, const glm::mat4& viewProjection, HiZPyramid* pyramid);
+	//True if every point of worldBounds is farther than the depth covering its screen rectangle.
+	//Conservative: bounds crossing the near plane or leaving the screen are never occluded.
+	//hiZ.comp and instanceCull.comp mirror this exactly, so the GPU agrees given the same pyramid.
+	bool isOccluded(const HiZPyramid& pyramid, const AABB& worldBounds);
+
+	//CPU depth buffer in GL window depth, for rasterizing occluders in software
+	struct DepthBuffer {
+		int width = 0;
+		int height = 0;
+		std::vector<float> depth;
+	};
+	void clearDepthBuffer(DepthBuffer* buffer, int width, int height);
+	//Depth only rasterization at pixel centers, no face culling. Triangles crossing the near plane are skipped rather than clipped,
+	//which only loses occlusion. Deterministic, for testing and as a fallback without GPU culling
+	void rasterizeDepth(DepthBuffer* buffer, const glm::mat4& modelViewProjection, const Vertex* vertices, const unsigned int* indices, int numIndices);
+
+	//GPU Hi-Z pyramid as an R32F texture with a full mip chain, built from a depth texture by hiZ.comp
+	class HiZBuffer {
+	public:
+		//Reallocates when the size changes
+		void build(const Shader& hiZShader, unsigned int depthTexture, int width, int height, const glm::mat4& viewProjection);
+		void bind(unsigned int textureUnit)const;
+		//Waits for the GPU, for validation against buildHiZ
+		void download(HiZPyramid* pyramid)const;
+		inline bool isValid()const { return m_texture != 0; }
+		inline unsigned int getTexture()const { return m_texture; }
+		inline int getWidth()const { return m_width; }
+		inline int getHeight()const { return m_height; }
+		inline int getNumLevels()const { return m_numLevels; }
+		inline const glm::mat4& getViewProjection()const { return m_viewProjection; }
+	private:
+		unsigned int m_texture = 0;
+		int m_width = 0;
+		int m_height = 0;
+		int m_numLevels = 0;
+		glm::mat4 m_viewProjection = glm::mat4(1.0f);
+	};
+}
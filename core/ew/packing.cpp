@@ -0,0 +1,120 @@
+/*
+*	Compact encodings for G-buffer and vertex data. Mirrors assets/gbuffer.glsl
+*/
+
+#include "packing.h"
+#include <math.h>
+#include <string.h>
+
+namespace ew {
+	static glm::vec2 signNotZero(const glm::vec2& v) {
+		return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	/// <summary>
+	/// Projects a unit vector onto the octahedron |x|+|y|+|z|=1 and unfolds the lower half over the corners
+	/// </summary>
+	/// <param name="n">Normalized vector</param>
+	/// <returns>Encoded vector in [-1,1]^2</returns>
+	glm::vec2 octEncode(const glm::vec3& n) {
+		glm::vec3 p = n / (fabsf(n.x) + fabsf(n.y) + fabsf(n.z));
+		if (p.z >= 0.0f) {
+			return glm::vec2(p.x, p.y);
+		}
+		return (glm::vec2(1.0f) - glm::abs(glm::vec2(p.y, p.x))) * signNotZero(glm::vec2(p.x, p.y));
+	}
+
+	/// <summary>
+	/// Inverse of octEncode
+	/// </summary>
+	/// <param name="e">Encoded vector in [-1,1]^2</param>
+	/// <returns>Normalized vector</returns>
+	glm::vec3 octDecode(const glm::vec2& e) {
+		glm::vec3 n = glm::vec3(e.x, e.y, 1.0f - fabsf(e.x) - fabsf(e.y));
+		if (n.z < 0.0f) {
+			glm::vec2 xy = (glm::vec2(1.0f) - glm::abs(glm::vec2(n.y, n.x))) * signNotZero(glm::vec2(n.x, n.y));
+			n.x = xy.x;
+			n.y = xy.y;
+		}
+		return glm::normalize(n);
+	}
+
+	float quantizeSnorm(float v, int bits) {
+		float scale = (float)((1 << (bits - 1)) - 1);
+		float q = roundf(glm::clamp(v, -1.0f, 1.0f) * scale);
+		return glm::max(q / scale, -1.0f);
+	}
+
+	uint16_t packUnorm16(float v) {
+		return (uint16_t)roundf(glm::clamp(v, 0.0f, 1.0f) * 65535.0f);
+	}
+
+	float unpackUnorm16(uint16_t v) {
+		return v / 65535.0f;
+	}
+
+	static uint32_t packSnorm10(float v) {
+		int q = (int)roundf(glm::clamp(v, -1.0f, 1.0f) * 511.0f);
+		return (uint32_t)q & 0x3FF;
+	}
+
+	static float unpackSnorm10(uint32_t v) {
+		//Sign extend the low 10 bits
+		int q = (int)(v << 22) >> 22;
+		return glm::max(q / 511.0f, -1.0f);
+	}
+
+	/// <summary>
+	/// Packs a vector in [-1,1]^3 into 10 bit signed normalized components, matching a normalized
+	/// GL_INT_2_10_10_10_REV attribute
+	/// </summary>
+	uint32_t packSnorm3x10(const glm::vec3& v) {
+		return packSnorm10(v.x) | (packSnorm10(v.y) << 10) | (packSnorm10(v.z) << 20);
+	}
+
+	glm::vec3 unpackSnorm3x10(uint32_t v) {
+		return glm::vec3(unpackSnorm10(v), unpackSnorm10(v >> 10), unpackSnorm10(v >> 20));
+	}
+
+	/// <summary>
+	/// Converts a float to an IEEE 754 half float (GL_HALF_FLOAT). Rounds to nearest even,
+	/// overflows to infinity and produces subnormals for tiny values.
+	/// </summary>
+	uint16_t packHalf(float v) {
+		uint32_t bits;
+		memcpy(&bits, &v, sizeof(bits));
+		uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+		uint32_t magnitude = bits & 0x7FFFFFFF;
+		//Inf and NaN
+		if (magnitude >= 0x7F800000) {
+			return sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0);
+		}
+		//Too large for a half
+		if (magnitude >= 0x477FF000) {
+			return sign | 0x7C00;
+		}
+		//Below the smallest normal half, 2^-14. Subnormal halves are multiples of 2^-24
+		if (magnitude < 0x38800000) {
+			return sign | (uint16_t)lrintf(fabsf(v) * 16777216.0f);
+		}
+		//Rebias the exponent from 127 to 15 and round the mantissa from 23 to 10 bits.
+		//A mantissa carry correctly bumps the exponent.
+		uint32_t h = magnitude - 0x38000000;
+		h = (h + 0x0FFF + ((h >> 13) & 1)) >> 13;
+		return sign | (uint16_t)h;
+	}
+
+	float unpackHalf(uint16_t v) {
+		uint32_t sign = (uint32_t)(v & 0x8000) << 16;
+		uint32_t exponent = (v >> 10) & 0x1F;
+		uint32_t mantissa = v & 0x3FF;
+		if (exponent == 0) {
+			float f = mantissa / 16777216.0f;
+			return sign ? -f : f;
+		}
+		uint32_t bits = exponent == 31 ? sign | 0x7F800000 | (mantissa << 13) : sign | ((exponent + 112) << 23) | (mantissa << 13);
+		float f;
+		memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+}
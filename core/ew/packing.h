@@ -0,0 +1,26 @@
+/*
+*	Compact encodings for G-buffer and vertex data. Mirrors assets/gbuffer.glsl
+*/
+
+#pragma once
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+namespace ew {
+	//Octahedral normal encoding. Unit vector -> [-1,1]^2
+	glm::vec2 octEncode(const glm::vec3& n);
+	glm::vec3 octDecode(const glm::vec2& e);
+
+	//Round trips v in [-1,1] through a signed normalized integer with the given bit count, like an RG8/RG16_SNORM texel
+	float quantizeSnorm(float v, int bits);
+
+	//Vertex attribute encodings used by ew::VertexFormat::PACKED
+	uint16_t packUnorm16(float v);
+	float unpackUnorm16(uint16_t v);
+	//GL_INT_2_10_10_10_REV layout: x in the low bits, w = 0
+	uint32_t packSnorm3x10(const glm::vec3& v);
+	glm::vec3 unpackSnorm3x10(uint32_t v);
+	//IEEE half float, round to nearest even
+	uint16_t packHalf(float v);
+	float unpackHalf(uint16_t v);
+}
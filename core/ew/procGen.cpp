@@ -4,6 +4,8 @@
 
 #include "procGen.h"
 #include <stdlib.h>
+#include <math.h>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
@@ -60,108 +62,172 @@ namespace ew {
 		createCubeFace(vec3{ +0.0f,+0.0f,-1.0f }, size, &mesh); //Back
 		return mesh;
 	}
-	MeshData createPlane(float width, float height, int subdivisions)
+	//Vertices per parallel batch. Smaller meshes aren't worth the hand off to other threads
+	static const int PROC_GEN_BATCH_VERTICES = 16384;
+
+	/// <summary>
+	/// Calls fn(row) for every row in [0, numRows), split across threadPool if there's enough work
+	/// </summary>
+	template<typename Fn>
+	static void forEachRow(int numRows, int verticesPerRow, ThreadPool* threadPool, Fn fn) {
+		int rowsPerBatch = PROC_GEN_BATCH_VERTICES / (verticesPerRow > 0 ? verticesPerRow : 1);
+		rowsPerBatch = rowsPerBatch < 1 ? 1 : rowsPerBatch;
+		if (threadPool == nullptr || numRows <= rowsPerBatch) {
+			for (int row = 0; row < numRows; row++)
+			{
+				fn(row);
+			}
+			return;
+		}
+		threadPool->parallelFor(numRows, rowsPerBatch, [&](int begin, int end) {
+			for (int row = begin; row < end; row++)
+			{
+				fn(row);
+			}
+		});
+	}
+
+	int getPlaneVertexCount(int subdivisions) {
+		return (subdivisions + 1) * (subdivisions + 1);
+	}
+	int getPlaneIndexCount(int subdivisions) {
+		return subdivisions * subdivisions * 6;
+	}
+	MeshData createPlane(float width, float height, int subdivisions, ThreadPool* threadPool)
 	{
-		//VERTICES
 		MeshData mesh;
+		mesh.vertices.resize(getPlaneVertexCount(subdivisions));
+		mesh.indices.resize(getPlaneIndexCount(subdivisions));
+		createPlane(width, height, subdivisions, mesh.vertices.data(), mesh.indices.data(), threadPool);
+		return mesh;
+	}
+	/// <summary>
+	/// Each row writes its own vertices and the quads below it, so rows are independent
+	/// </summary>
+	void createPlane(float width, float height, int subdivisions, Vertex* vertices, unsigned int* indices, ThreadPool* threadPool)
+	{
 		int columns = subdivisions + 1;
-		for (size_t row = 0; row <= subdivisions; row++)
-		{
-			for (size_t col = 0; col <= subdivisions; col++)
+		forEachRow(subdivisions + 1, columns, threadPool, [&](int row) {
+			//VERTICES
+			Vertex* v = vertices + row * columns;
+			for (int col = 0; col <= subdivisions; col++, v++)
 			{
-				Vertex v;                                                                                                                                                                                                                                                                                                                                                                                                    
-				v.uv.x = ((float)col / subdivisions);
-				v.uv.y = ((float)row / subdivisions);
-				v.pos.x = -width/2 + width * v.uv.x;
-				v.pos.y = 0;
-				v.pos.z = height/2 -height * v.uv.y;
-				v.normal = vec3(0, 1, 0);
-				mesh.vertices.push_back(v);
+				v->uv.x = ((float)col / subdivisions);
+				v->uv.y = ((float)row / subdivisions);
+				v->pos.x = -width/2 + width * v->uv.x;
+				v->pos.y = 0;
+				v->pos.z = height/2 -height * v->uv.y;
+				v->normal = vec3(0, 1, 0);
 			}
-		}
-		//INDICES
-		for (size_t row = 0; row < subdivisions; row++)
-		{
-			for (size_t col = 0; col < subdivisions; col++)
+			//INDICES
+			if (row == subdivisions) {
+				return;
+			}
+			unsigned int* index = indices + (size_t)row * subdivisions * 6;
+			for (int col = 0; col < subdivisions; col++)
 			{
-				int start = row * columns + col;
-				mesh.indices.push_back(start);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns + 1);
-				mesh.indices.push_back(start + columns + 1);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start);
+				unsigned int start = row * columns + col;
+				*index++ = start;
+				*index++ = start + 1;
+				*index++ = start + columns + 1;
+				*index++ = start + columns + 1;
+				*index++ = start + columns;
+				*index++ = start;
 			}
-		}
-		return mesh;
+		});
+	}
+
+	int getSphereVertexCount(int subdivisions) {
+		return (subdivisions + 1) * (subdivisions + 1);
 	}
-	MeshData createSphere(float radius, int subdivisions)
+	int getSphereIndexCount(int subdivisions) {
+		int sideRows = subdivisions > 2 ? subdivisions - 2 : 0;
+		return subdivisions * 3 * 2 + sideRows * subdivisions * 6;
+	}
+	MeshData createSphere(float radius, int subdivisions, ThreadPool* threadPool)
 	{
 		MeshData mesh;
-		//VERTICES
+		mesh.vertices.resize(getSphereVertexCount(subdivisions));
+		mesh.indices.resize(getSphereIndexCount(subdivisions));
+		createSphere(radius, subdivisions, mesh.vertices.data(), mesh.indices.data(), threadPool);
+		return mesh;
+	}
+	/// <summary>
+	/// Rings share one table of sin/cos per column, and each ring only evaluates its own angle once.
+	/// Both give the same values as calling sinf/cosf per vertex
+	/// </summary>
+	void createSphere(float radius, int subdivisions, Vertex* vertices, unsigned int* indices, ThreadPool* threadPool)
+	{
 		float thetaStep = glm::two_pi<float>() / subdivisions;
 		float phiStep = glm::pi<float>() / subdivisions;
-		for (size_t row = 0; row <= subdivisions; row++)
+		unsigned int columns = subdivisions + 1;
+		std::vector<float> cosTheta(columns);
+		std::vector<float> sinTheta(columns);
+		for (unsigned int col = 0; col < columns; col++)
 		{
+			float theta = thetaStep * col;
+			cosTheta[col] = cosf(theta);
+			sinTheta[col] = sinf(theta);
+		}
+		//Top cap, then rows of quads for the sides, then the bottom cap
+		unsigned int* topCap = indices;
+		unsigned int* sides = topCap + subdivisions * 3;
+		unsigned int* bottomCap = sides + (getSphereIndexCount(subdivisions) - subdivisions * 3 * 2);
+		forEachRow(subdivisions + 1, columns, threadPool, [&](int row) {
+			//VERTICES
 			float phi = row * phiStep;
-			for (size_t col = 0; col <= subdivisions; col++)
+			float sinPhi = sinf(phi);
+			float cosPhi = cosf(phi);
+			Vertex* v = vertices + row * columns;
+			for (unsigned int col = 0; col < columns; col++, v++)
 			{
-				float theta = thetaStep * col;
-				Vertex v;
-				v.normal.x = cosf(theta) * sinf(phi);
-				v.normal.y = cosf(phi);
-				v.normal.z = sinf(theta) * sinf(phi);
-				v.pos = v.normal * radius;
-				v.uv.x = (float)col / subdivisions;
-				v.uv.y = 1.0 - ((float)row / subdivisions);
-				mesh.vertices.push_back(v);
+				v->normal.x = cosTheta[col] * sinPhi;
+				v->normal.y = cosPhi;
+				v->normal.z = sinTheta[col] * sinPhi;
+				v->pos = v->normal * radius;
+				v->uv.x = (float)col / subdivisions;
+				v->uv.y = 1.0 - ((float)row / subdivisions);
 			}
-		}
-		
-		//INDICES
-		unsigned int columns = subdivisions + 1;
-		unsigned int sideStart = columns;
-		unsigned int poleStart = 0;
-		//Top cap
-		for (size_t i = 0; i < subdivisions; i++)
-		{
-			mesh.indices.push_back(sideStart + i);
-			mesh.indices.push_back(poleStart + i);
-			mesh.indices.push_back(sideStart +i+1);
-		}
-		//Rows of quads for sides
-		for (size_t row = 1; row < subdivisions - 1; row++)
-		{
-			for (size_t col = 0; col < subdivisions; col++)
+			//INDICES
+			if (row < 1 || row >= subdivisions - 1) {
+				return;
+			}
+			unsigned int* index = sides + (size_t)(row - 1) * subdivisions * 6;
+			for (int col = 0; col < subdivisions; col++)
 			{
 				unsigned int start = row * columns + col;
-				mesh.indices.push_back(start);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns + 1);
+				*index++ = start;
+				*index++ = start + 1;
+				*index++ = start + columns;
+				*index++ = start + columns;
+				*index++ = start + 1;
+				*index++ = start + columns + 1;
 			}
+		});
+		unsigned int sideStart = columns;
+		unsigned int poleStart = 0;
+		for (int i = 0; i < subdivisions; i++)
+		{
+			*topCap++ = sideStart + i;
+			*topCap++ = poleStart + i;
+			*topCap++ = sideStart + i + 1;
 		}
-		//Bottom cap
 		poleStart = (columns * columns) - columns;
 		sideStart = poleStart - columns;
-		for (size_t i = 0; i < subdivisions; i++)
+		for (int i = 0; i < subdivisions; i++)
 		{
-			mesh.indices.push_back(sideStart + i);
-			mesh.indices.push_back(sideStart + i + 1);
-			mesh.indices.push_back(poleStart + i);
+			*bottomCap++ = sideStart + i;
+			*bottomCap++ = sideStart + i + 1;
+			*bottomCap++ = poleStart + i;
 		}
-		return mesh;
 	}
-	void createCylinderRing(MeshData* meshData, float radius, int subdivisions, float y, bool sideFacing) {
-		float thetaStep = two_pi<float>() / subdivisions;
-		for (size_t i = 0; i <= subdivisions; i++)
+
+	static void createCylinderRing(Vertex* vertices, const float* cosTheta, const float* sinTheta, float radius, int subdivisions, float y, bool sideFacing) {
+		for (int i = 0; i <= subdivisions; i++)
 		{
-			float theta = i * thetaStep;
-			float cosA = cosf(theta);
-			float sinA = sinf(theta);
-			Vertex v;
+			float cosA = cosTheta[i];
+			float sinA = sinTheta[i];
+			Vertex& v = vertices[i];
 			v.pos = vec3(cosA * radius, y, sinA * radius);
 			if (sideFacing) {
 				v.normal = vec3(cosA, 0, sinA);
@@ -171,70 +237,89 @@ namespace ew {
 				v.normal = vec3(0, sign(y), 0);
 				v.uv = vec2(cosA * 0.5f + 0.5f, sinA * 0.5f + 0.5f);
 			}
-
-			meshData->vertices.push_back(v);
 		}
 	}
+	int getCylinderVertexCount(int subdivisions) {
+		return (subdivisions + 1) * 4 + 2;
+	}
+	int getCylinderIndexCount(int subdivisions) {
+		return (subdivisions + 1) * 12;
+	}
 	MeshData createCylinder(float radius, float height, int subdivisions)
 	{
 		MeshData mesh;
-
+		mesh.vertices.resize(getCylinderVertexCount(subdivisions));
+		mesh.indices.resize(getCylinderIndexCount(subdivisions));
+		createCylinder(radius, height, subdivisions, mesh.vertices.data(), mesh.indices.data());
+		return mesh;
+	}
+	/// <summary>
+	/// Only four rings, so unlike the plane and sphere this isn't worth splitting across threads
+	/// </summary>
+	void createCylinder(float radius, float height, int subdivisions, Vertex* vertices, unsigned int* indices)
+	{
+		int columns = subdivisions + 1;
 		//VERTICES
 		{
 			const float topY = height * 0.5;
 			const float bottomY = -topY;
+			//All four rings share the same angles
+			float thetaStep = two_pi<float>() / subdivisions;
+			std::vector<float> cosTheta(columns);
+			std::vector<float> sinTheta(columns);
+			for (int i = 0; i < columns; i++)
+			{
+				float theta = i * thetaStep;
+				cosTheta[i] = cosf(theta);
+				sinTheta[i] = sinf(theta);
+			}
 
-			Vertex topVertex;
-			topVertex.pos = vec3(0, topY, 0);
-			topVertex.normal = vec3(0, 1, 0);
-			topVertex.uv = vec2(0.5f);
-			mesh.vertices.push_back(topVertex);
+			Vertex* topVertex = vertices;
+			topVertex->pos = vec3(0, topY, 0);
+			topVertex->normal = vec3(0, 1, 0);
+			topVertex->uv = vec2(0.5f);
 
-			createCylinderRing(&mesh, radius, subdivisions, topY, false);
-			createCylinderRing(&mesh, radius, subdivisions, topY, true);
-			createCylinderRing(&mesh, radius, subdivisions, bottomY, true);
-			createCylinderRing(&mesh, radius, subdivisions, bottomY, false);
+			createCylinderRing(vertices + 1, cosTheta.data(), sinTheta.data(), radius, subdivisions, topY, false);
+			createCylinderRing(vertices + 1 + columns, cosTheta.data(), sinTheta.data(), radius, subdivisions, topY, true);
+			createCylinderRing(vertices + 1 + columns * 2, cosTheta.data(), sinTheta.data(), radius, subdivisions, bottomY, true);
+			createCylinderRing(vertices + 1 + columns * 3, cosTheta.data(), sinTheta.data(), radius, subdivisions, bottomY, false);
 
-			Vertex bottomVertex;
-			bottomVertex.pos = vec3(0, bottomY, 0);
-			bottomVertex.normal = vec3(0, -1, 0);
-			bottomVertex.uv = vec2(0.5f);
-			mesh.vertices.push_back(bottomVertex);
+			Vertex* bottomVertex = vertices + 1 + columns * 4;
+			bottomVertex->pos = vec3(0, bottomY, 0);
+			bottomVertex->normal = vec3(0, -1, 0);
+			bottomVertex->uv = vec2(0.5f);
 		}
-		
 
 		//INDICES
 		{
-			int columns = subdivisions + 1;
 			//Top cap
-			for (size_t i = 0; i < columns; i++)
+			for (int i = 0; i < columns; i++)
 			{
-				mesh.indices.push_back(0);
-				mesh.indices.push_back(i + 1);
-				mesh.indices.push_back(i);
+				*indices++ = 0;
+				*indices++ = i + 1;
+				*indices++ = i;
 			}
 			int sideStart = columns;
 			//Sides
-			for (size_t i = 0; i < columns; i++)
+			for (int i = 0; i < columns; i++)
 			{
 				unsigned int start = sideStart + i;
-				mesh.indices.push_back(start);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start + columns);
-				mesh.indices.push_back(start + 1);
-				mesh.indices.push_back(start + columns + 1);
+				*indices++ = start;
+				*indices++ = start + 1;
+				*indices++ = start + columns;
+				*indices++ = start + columns;
+				*indices++ = start + 1;
+				*indices++ = start + columns + 1;
 			}
 			//Bottom cap
-			unsigned int bottomIndex = mesh.vertices.size() - 1;
+			unsigned int bottomIndex = getCylinderVertexCount(subdivisions) - 1;
 			sideStart = bottomIndex - columns;
-			for (size_t i = 0; i < columns; i++)
+			for (int i = 0; i < columns; i++)
 			{
-				mesh.indices.push_back(bottomIndex);
-				mesh.indices.push_back(sideStart + i);
-				mesh.indices.push_back(sideStart + i + 1);
+				*indices++ = bottomIndex;
+				*indices++ = sideStart + i;
+				*indices++ = sideStart + i + 1;
 			}
 		}
-		return mesh;
 	}
 }
\ No newline at end of file
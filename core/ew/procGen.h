@@ -4,10 +4,24 @@
 
 #pragma once
 #include "mesh.h"
+#include "threadPool.h"
 
 namespace ew {
 	MeshData createCube(float size);
-	MeshData createPlane(float width, float height, int subdivisions);
-	MeshData createSphere(float radius, int subdivisions);
+	//Rows are generated in parallel when given a threadPool
+	MeshData createPlane(float width, float height, int subdivisions, ThreadPool* threadPool = nullptr);
+	MeshData createSphere(float radius, int subdivisions, ThreadPool* threadPool = nullptr);
 	MeshData createCylinder(float radius, float height, int subdivisions);
+
+	//Exact buffer sizes for the versions below, which write into caller allocated buffers instead of a MeshData,
+	//e.g. straight into a mapped buffer or a reused scratch allocation
+	int getPlaneVertexCount(int subdivisions);
+	int getPlaneIndexCount(int subdivisions);
+	int getSphereVertexCount(int subdivisions);
+	int getSphereIndexCount(int subdivisions);
+	int getCylinderVertexCount(int subdivisions);
+	int getCylinderIndexCount(int subdivisions);
+	void createPlane(float width, float height, int subdivisions, Vertex* vertices, unsigned int* indices, ThreadPool* threadPool = nullptr);
+	void createSphere(float radius, int subdivisions, Vertex* vertices, unsigned int* indices, ThreadPool* threadPool = nullptr);
+	void createCylinder(float radius, float height, int subdivisions, Vertex* vertices, unsigned int* indices);
 }
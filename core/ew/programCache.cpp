@@ -0,0 +1,138 @@
+/*
+*	On-disk cache of linked shader program binaries, so programs skip the GLSL compiler after the first run
+*/
+
+#include "programCache.h"
+#include <stdio.h>
+#include <vector>
+#include "external/glad.h"
+#include "meshCache.h"
+#include "mappedFile.h"
+
+namespace ew {
+	static bool s_programCacheEnabled = true;
+
+	uint64_t hashDriver()
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+		for (GLenum name : names)
+		{
+			const char* value = (const char*)glGetString(name);
+			if (value != nullptr) {
+				std::string string = value;
+				//Include the terminator so "ab" + "c" and "a" + "bc" differ
+				hash = hashBytes(string.c_str(), string.size() + 1, hash);
+			}
+		}
+		return hash;
+	}
+
+	uint64_t hashProgramSources(const std::vector<std::string>& sources)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (const std::string& source : sources)
+		{
+			uint64_t size = source.size();
+			hash = hashBytes(&size, sizeof(size), hash);
+			hash = hashBytes(source.data(), source.size(), hash);
+		}
+		return hash;
+	}
+
+	std::string getProgramCachePath(const std::vector<std::string>& stagePaths)
+	{
+		uint64_t hash = hashProgramSources(stagePaths);
+		char name[32];
+		snprintf(name, sizeof(name), ".%08x.ewprog", (unsigned int)(hash ^ (hash >> 32)));
+		return stagePaths.empty() ? std::string() : stagePaths[0] + name;
+	}
+
+	/// <summary>
+	/// The driver may still refuse a binary whose header matches, e.g. after an update that kept its version string,
+	/// so the link status decides. Rejected programs are deleted and the caller compiles from source.
+	/// </summary>
+	unsigned int loadProgramBinary(const std::string& cachePath, uint64_t sourceHash)
+	{
+		if (!s_programCacheEnabled) {
+			return 0;
+		}
+		MappedFile file;
+		if (!file.open(cachePath)) {
+			return 0;
+		}
+		const ProgramCacheHeader* header = (const ProgramCacheHeader*)file.getData();
+		bool valid = file.getSize() >= sizeof(ProgramCacheHeader)
+			&& header->magic == PROGRAM_CACHE_MAGIC
+			&& header->version == PROGRAM_CACHE_VERSION
+			&& header->sourceHash == sourceHash
+			&& header->driverHash == hashDriver()
+			&& header->binarySize <= file.getSize() - sizeof(ProgramCacheHeader);
+		if (!valid) {
+			return 0;
+		}
+		unsigned int program = glCreateProgram();
+		glProgramBinary(program, header->binaryFormat, file.getData() + sizeof(ProgramCacheHeader), header->binarySize);
+		int success;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success) {
+			//Drivers may also raise an error for a binary they reject (GL_INVALID_ENUM for an unknown format).
+			//The caller compiles from source instead, so it must not see that error
+			glGetError();
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	bool saveProgramBinary(const std::string& cachePath, uint64_t sourceHash, unsigned int program)
+	{
+		if (!s_programCacheEnabled) {
+			return false;
+		}
+		int numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		int linked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		int binaryLength = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		if (numFormats == 0 || !linked || binaryLength <= 0) {
+			return false;
+		}
+		std::vector<unsigned char> binary(binaryLength);
+		GLenum binaryFormat = 0;
+		glGetProgramBinary(program, binaryLength, &binaryLength, &binaryFormat, binary.data());
+
+		ProgramCacheHeader header;
+		header.magic = PROGRAM_CACHE_MAGIC;
+		header.version = PROGRAM_CACHE_VERSION;
+		header.sourceHash = sourceHash;
+		header.driverHash = hashDriver();
+		header.binaryFormat = binaryFormat;
+		header.binarySize = (uint32_t)binaryLength;
+
+		FILE* file = fopen(cachePath.c_str(), "wb");
+		if (file == NULL) {
+			printf("Failed to write program cache %s\n", cachePath.c_str());
+			return false;
+		}
+		bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+		success &= fwrite(binary.data(), 1, binaryLength, file) == (size_t)binaryLength;
+		success &= fclose(file) == 0;
+		if (!success) {
+			printf("Failed to write program cache %s\n", cachePath.c_str());
+			remove(cachePath.c_str());
+		}
+		return success;
+	}
+
+	void setProgramCacheEnabled(bool enabled)
+	{
+		s_programCacheEnabled = enabled;
+	}
+
+	bool isProgramCacheEnabled()
+	{
+		return s_programCacheEnabled;
+	}
+}
@@ -0,0 +1,39 @@
+/*
+*	On-disk cache of linked shader program binaries, so programs skip the GLSL compiler after the first run
+*/
+
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ew {
+	//File layout: ProgramCacheHeader, then binarySize bytes from glGetProgramBinary.
+	//Bump PROGRAM_CACHE_VERSION whenever the layout changes
+	const uint32_t PROGRAM_CACHE_MAGIC = 0x50435745; //"EWCP"
+	const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+	struct ProgramCacheHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t sourceHash; //hashProgramSources() of the preprocessed stage sources
+		uint64_t driverHash; //hashDriver() when written. Binaries only load on the driver that made them
+		uint32_t binaryFormat;
+		uint32_t binarySize;
+	};
+
+	//GL vendor, renderer, version and GLSL version strings. Needs a current context
+	uint64_t hashDriver();
+	uint64_t hashProgramSources(const std::vector<std::string>& sources);
+	//Next to the first stage, named after every stage's path: "assets/geo.vert.1a2b3c4d.ewprog"
+	std::string getProgramCachePath(const std::vector<std::string>& stagePaths);
+
+	//Returns a linked program, or 0 if the cache is missing, stale, from another driver, or the driver rejects it
+	unsigned int loadProgramBinary(const std::string& cachePath, uint64_t sourceHash);
+	//Does nothing for programs that failed to link or drivers without binary formats
+	bool saveProgramBinary(const std::string& cachePath, uint64_t sourceHash, unsigned int program);
+
+	//On by default. Off, every program compiles from source and nothing is written
+	void setProgramCacheEnabled(bool enabled);
+	bool isProgramCacheEnabled();
+}
@@ -5,48 +5,136 @@
 #include "shader.h"
 #include <fstream>
 #include <sstream>
+#include <string.h>
+#include <thread>
 #include "external/glad.h"
+#include "programCache.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+//GL_KHR_parallel_shader_compile is an extension, not core GL, so glad doesn't define it. The ARB version shares its values
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 namespace ew {
-	/// <summary>
-	/// Loads shader source code from a file.
-	/// </summary>
-	/// <param name="filePath"></param>
-	/// <returns></returns>
-	std::string loadShaderSourceFromFile(const std::string& filePath) {
+	//Guards against include cycles
+	static const int MAX_INCLUDE_DEPTH = 16;
+
+	static std::string loadShaderSourceFromFile(const std::string& filePath, int depth) {
 		std::ifstream fstream(filePath);
 		if (!fstream.is_open()) {
 			printf("Failed to load file %s", filePath.c_str());
 			return {};
 		}
+		//Includes are resolved relative to the including file
+		size_t slash = filePath.find_last_of("/\\");
+		std::string directory = slash == std::string::npos ? "" : filePath.substr(0, slash + 1);
+
 		std::stringstream buffer;
-		buffer << fstream.rdbuf();
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(fstream, line)) {
+			lineNumber++;
+			size_t directive = line.find_first_not_of(" \t");
+			if (directive != std::string::npos && line.compare(directive, 8, "#include") == 0) {
+				size_t open = line.find('"', directive);
+				size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+				if (close == std::string::npos) {
+					printf("Malformed #include in %s line %d\n", filePath.c_str(), lineNumber);
+					continue;
+				}
+				if (depth >= MAX_INCLUDE_DEPTH) {
+					printf("#include nested too deeply in %s\n", filePath.c_str());
+					continue;
+				}
+				buffer << loadShaderSourceFromFile(directory + line.substr(open + 1, close - open - 1), depth + 1) << "\n";
+				//Keep compiler error line numbers pointing into this file
+				buffer << "#line " << lineNumber + 1 << "\n";
+				continue;
+			}
+			buffer << line << "\n";
+		}
 		return buffer.str();
 	}
 
 	/// <summary>
-	/// Creates and compiles a shader object of a given type
+	/// Loads shader source code from a file.
+	/// Lines of the form #include "file" are replaced with that file's contents, relative to this file's directory.
+	/// </summary>
+	/// <param name="filePath"></param>
+	/// <returns></returns>
+	std::string loadShaderSourceFromFile(const std::string& filePath) {
+		return loadShaderSourceFromFile(filePath, 0);
+	}
+
+	/// <summary>
+	/// Creates a shader object of a given type and starts compiling it, without waiting for the result
 	/// </summary>
 	/// <param name="shaderType">Expects GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, etc.</param>
 	/// <param name="sourceCode">GLSL source code for the shader stage</param>
 	/// <returns></returns>
-	static unsigned int createShader(GLenum shaderType, const char* sourceCode) {
+	static unsigned int submitShader(GLenum shaderType, const char* sourceCode) {
 		//Create a new vertex shader object
 		unsigned int shader = glCreateShader(shaderType);
 		//Supply the shader object with source code
 		glShaderSource(shader, 1, &sourceCode, NULL);
 		//Compile the shader object
 		glCompileShader(shader);
+		return shader;
+	}
+	/// <summary>
+	/// Waits for a shader to compile and prints its errors
+	/// </summary>
+	/// <param name="shader">Shader object from submitShader</param>
+	/// <param name="name">Printed with errors, may be null</param>
+	/// <returns>Whether the shader compiled</returns>
+	static bool checkShaderCompiled(unsigned int shader, const char* name) {
 		int success;
 		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
 		if (!success) {
 			//512 is an arbitrary length, but should be plenty of characters for our error message.
 			char infoLog[512];
 			glGetShaderInfoLog(shader, 512, NULL, infoLog);
-			printf("Failed to compile shader: %s", infoLog);
+			if (name != nullptr) {
+				printf("Failed to compile shader %s: %s", name, infoLog);
+			}
+			else {
+				printf("Failed to compile shader: %s", infoLog);
+			}
 		}
+		return success;
+	}
+	/// <summary>
+	/// Waits for a program to link and prints its errors
+	/// </summary>
+	/// <param name="program">Program after glLinkProgram</param>
+	/// <param name="name">Printed with errors, may be null</param>
+	/// <returns>Whether the program linked</returns>
+	static bool checkProgramLinked(unsigned int program, const char* name) {
+		int success;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success) {
+			char infoLog[512];
+			glGetProgramInfoLog(program, 512, NULL, infoLog);
+			if (name != nullptr) {
+				printf("Failed to link shader program %s: %s", name, infoLog);
+			}
+			else {
+				printf("Failed to link shader program: %s", infoLog);
+			}
+		}
+		return success;
+	}
+	/// <summary>
+	/// Creates and compiles a shader object of a given type
+	/// </summary>
+	/// <param name="shaderType">Expects GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, etc.</param>
+	/// <param name="sourceCode">GLSL source code for the shader stage</param>
+	/// <returns></returns>
+	static unsigned int createShader(GLenum shaderType, const char* sourceCode) {
+		unsigned int shader = submitShader(shaderType, sourceCode);
+		checkShaderCompiled(shader, nullptr);
 		return shader;
 	}
 
@@ -57,28 +145,111 @@ namespace ew {
 	/// <param name="fragmentShaderSource">GLSL source code for the fragment shader</param>
 	/// <returns></returns>
 	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource) {
+		return createShaderProgram(vertexShaderSource, nullptr, fragmentShaderSource);
+	}
+	/// <summary>
+	/// Creates a shader program with vertex, geometry and fragment shaders
+	/// </summary>
+	/// <param name="vertexShaderSource">GLSL source code for the vertex shader</param>
+	/// <param name="geometryShaderSource">GLSL source code for the geometry shader, or null to skip the stage</param>
+	/// <param name="fragmentShaderSource">GLSL source code for the fragment shader</param>
+	/// <returns></returns>
+	unsigned int createShaderProgram(const char* vertexShaderSource, const char* geometryShaderSource, const char* fragmentShaderSource) {
 		unsigned int vertexShader = createShader(GL_VERTEX_SHADER, vertexShaderSource);
+		unsigned int geometryShader = geometryShaderSource != nullptr ? createShader(GL_GEOMETRY_SHADER, geometryShaderSource) : 0;
 		unsigned int fragmentShader = createShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
 
 		unsigned int shaderProgram = glCreateProgram();
 		//Attach each stage
 		glAttachShader(shaderProgram, vertexShader);
+		if (geometryShader != 0) {
+			glAttachShader(shaderProgram, geometryShader);
+		}
 		glAttachShader(shaderProgram, fragmentShader);
+		//Lets saveProgramBinary read the result back
+		glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 		//Link all the stages together
 		glLinkProgram(shaderProgram);
-		int success;
-		glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-		if (!success) {
-			char infoLog[512];
-			glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-			printf("Failed to link shader program: %s", infoLog);
-		}
+		checkProgramLinked(shaderProgram, nullptr);
 		//The linked program now contains our compiled code, so we can delete these intermediate objects
 		glDeleteShader(vertexShader);
+		if (geometryShader != 0) {
+			glDeleteShader(geometryShader);
+		}
 		glDeleteShader(fragmentShader);
 		return shaderProgram;
 	}
 	/// <summary>
+	/// Creates a shader program with a single compute stage
+	/// </summary>
+	/// <param name="computeShaderSource">GLSL source code for the compute shader</param>
+	/// <returns></returns>
+	unsigned int createComputeProgram(const char* computeShaderSource) {
+		unsigned int computeShader = createShader(GL_COMPUTE_SHADER, computeShaderSource);
+		unsigned int shaderProgram = glCreateProgram();
+		glAttachShader(shaderProgram, computeShader);
+		glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(shaderProgram);
+		checkProgramLinked(shaderProgram, nullptr);
+		glDeleteShader(computeShader);
+		return shaderProgram;
+	}
+	static int s_parallelShaderCompile = -1; //Unknown until the first check
+
+	bool hasParallelShaderCompile()
+	{
+		if (s_parallelShaderCompile < 0) {
+			s_parallelShaderCompile = 0;
+			int numExtensions = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+			for (int i = 0; i < numExtensions; i++)
+			{
+				const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+				if (strcmp(extension, "GL_KHR_parallel_shader_compile") == 0 || strcmp(extension, "GL_ARB_parallel_shader_compile") == 0) {
+					s_parallelShaderCompile = 1;
+				}
+			}
+		}
+		return s_parallelShaderCompile == 1;
+	}
+
+	typedef void (GLAD_API_PTR* MaxShaderCompilerThreadsProc)(GLuint count);
+
+	bool setShaderCompilerThreads(GLProcLoader getProcAddress, unsigned int maxThreads)
+	{
+		if (!hasParallelShaderCompile()) {
+			return false;
+		}
+		MaxShaderCompilerThreadsProc maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)getProcAddress("glMaxShaderCompilerThreadsKHR");
+		if (maxShaderCompilerThreads == nullptr) {
+			maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)getProcAddress("glMaxShaderCompilerThreadsARB");
+		}
+		if (maxShaderCompilerThreads == nullptr) {
+			return false;
+		}
+		maxShaderCompilerThreads(maxThreads);
+		return true;
+	}
+	/// <summary>
+	/// Loads a program from its binary cache, or calls compile and caches what it links.
+	/// Any change to a stage's preprocessed source, includes included, or to the driver falls back to compiling.
+	/// </summary>
+	/// <param name="stagePaths">Every stage's file, which names the cache file</param>
+	/// <param name="sources">Every stage's preprocessed source, which keys the cache</param>
+	template<typename Compile>
+	static unsigned int createCachedProgram(const std::vector<std::string>& stagePaths, const std::vector<std::string>& sources, Compile compile)
+	{
+		std::string cachePath = getProgramCachePath(stagePaths);
+		uint64_t sourceHash = hashProgramSources(sources);
+		unsigned int program = loadProgramBinary(cachePath, sourceHash);
+		if (program != 0) {
+			return program;
+		}
+		program = compile();
+		saveProgramBinary(cachePath, sourceHash, program);
+		return program;
+	}
+	/// <summary>
 	/// Creates a shader instance with vertex + fragment stages
 	/// </summary>
 	/// <param name="vertexShader">File path to vertex shader</param>
@@ -87,7 +258,98 @@ namespace ew {
 	{
 		std::string vertexShaderSource = ew::loadShaderSourceFromFile(vertexShader.c_str());
 		std::string fragmentShaderSource = ew::loadShaderSourceFromFile(fragmentShader.c_str());
-		m_id = ew::createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+		m_id = createCachedProgram({ vertexShader, fragmentShader }, { vertexShaderSource, fragmentShaderSource }, [&]() {
+			return ew::createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
+		});
+		cacheUniformLocations();
+	}
+	/// <summary>
+	/// Creates a shader instance with vertex + geometry + fragment stages
+	/// </summary>
+	/// <param name="vertexShader">File path to vertex shader</param>
+	/// <param name="geometryShader">File path to geometry shader</param>
+	/// <param name="fragmentShader">File path to fragment shader</param>
+	Shader::Shader(const std::string& vertexShader, const std::string& geometryShader, const std::string& fragmentShader)
+	{
+		std::string vertexShaderSource = ew::loadShaderSourceFromFile(vertexShader.c_str());
+		std::string geometryShaderSource = ew::loadShaderSourceFromFile(geometryShader.c_str());
+		std::string fragmentShaderSource = ew::loadShaderSourceFromFile(fragmentShader.c_str());
+		m_id = createCachedProgram({ vertexShader, geometryShader, fragmentShader }, { vertexShaderSource, geometryShaderSource, fragmentShaderSource }, [&]() {
+			return ew::createShaderProgram(vertexShaderSource.c_str(), geometryShaderSource.c_str(), fragmentShaderSource.c_str());
+		});
+		cacheUniformLocations();
+	}
+	/// <summary>
+	/// Creates a compute shader instance. Dispatch with glDispatchCompute after use()
+	/// </summary>
+	/// <param name="computeShader">File path to compute shader</param>
+	Shader::Shader(const std::string& computeShader)
+	{
+		std::string computeShaderSource = ew::loadShaderSourceFromFile(computeShader.c_str());
+		m_id = createCachedProgram({ computeShader }, { computeShaderSource }, [&]() {
+			return ew::createComputeProgram(computeShaderSource.c_str());
+		});
+		cacheUniformLocations();
+	}
+	Shader::Shader(unsigned int program)
+		: m_id(program)
+	{
+		if (program != 0) {
+			cacheUniformLocations();
+		}
+	}
+	/// <summary>
+	/// Reflects every active uniform of the linked program into a name -> location map.
+	/// Arrays are registered per element ("arr[3]") as well as by their base name.
+	/// </summary>
+	void Shader::cacheUniformLocations()
+	{
+		m_uniformLocations.clear();
+		int numUniforms = 0;
+		glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &numUniforms);
+		int maxNameLength = 0;
+		glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+		std::string name(maxNameLength, '\0');
+		for (int i = 0; i < numUniforms; i++)
+		{
+			int nameLength = 0;
+			int arraySize = 0;
+			GLenum type;
+			glGetActiveUniform(m_id, i, maxNameLength, &nameLength, &arraySize, &type, &name[0]);
+			std::string uniformName = name.substr(0, nameLength);
+			int location = glGetUniformLocation(m_id, uniformName.c_str());
+			//Uniform block members have no location
+			if (location < 0) {
+				continue;
+			}
+			m_uniformLocations[uniformName] = location;
+			//Arrays are reported once as "name[0]"
+			size_t bracket = uniformName.size() > 3 ? uniformName.size() - 3 : std::string::npos;
+			if (bracket != std::string::npos && uniformName.compare(bracket, 3, "[0]") == 0) {
+				std::string baseName = uniformName.substr(0, bracket);
+				m_uniformLocations[baseName] = location;
+				for (int j = 1; j < arraySize; j++)
+				{
+					std::string elementName = baseName + "[" + std::to_string(j) + "]";
+					m_uniformLocations[elementName] = glGetUniformLocation(m_id, elementName.c_str());
+				}
+			}
+		}
+	}
+	int Shader::findUniformLocation(const std::string& name) const
+	{
+		auto it = m_uniformLocations.find(name);
+		return it != m_uniformLocations.end() ? it->second : -1;
+	}
+	/// <summary>
+	/// Returns a cached uniform location. Location -1 (not active) is silently ignored by the setters, same as GL.
+	/// </summary>
+	/// <param name="name">Uniform name, e.g. "_Material.Ka" or "_PointLights[3].color"</param>
+	UniformLocation Shader::getUniformLocation(const std::string& name) const
+	{
+		UniformLocation location;
+		location.value = findUniformLocation(name);
+		return location;
 	}
 	void Shader::use()const
 	{
@@ -95,15 +357,15 @@ namespace ew {
 	}
 	void Shader::setInt(const std::string& name, int v) const
 	{
-		glUniform1i(glGetUniformLocation(m_id, name.c_str()), v);
+		glUniform1i(findUniformLocation(name), v);
 	}
 	void Shader::setFloat(const std::string& name, float v) const
 	{
-		glUniform1f(glGetUniformLocation(m_id, name.c_str()), v);
+		glUniform1f(findUniformLocation(name), v);
 	}
 	void Shader::setVec2(const std::string& name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(m_id, name.c_str()), x, y);
+		glUniform2f(findUniformLocation(name), x, y);
 	}
 	void Shader::setVec2(const std::string& name, const glm::vec2& v) const
 	{
@@ -111,7 +373,7 @@ namespace ew {
 	}
 	void Shader::setVec3(const std::string& name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(m_id, name.c_str()), x, y, z);
+		glUniform3f(findUniformLocation(name), x, y, z);
 	}
 	void Shader::setVec3(const std::string& name, const glm::vec3& v) const
 	{
@@ -119,7 +381,7 @@ namespace ew {
 	}
 	void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
 	{
-		glUniform4f(glGetUniformLocation(m_id, name.c_str()), x, y, z, w);
+		glUniform4f(findUniformLocation(name), x, y, z, w);
 	}
 	void Shader::setVec4(const std::string& name, const glm::vec4& v) const
 	{
@@ -127,7 +389,247 @@ namespace ew {
 	}
 	void Shader::setMat4(const std::string& name, const glm::mat4& m) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(m));
+		glUniformMatrix4fv(findUniformLocation(name), 1, GL_FALSE, glm::value_ptr(m));
+	}
+	void Shader::setInt(UniformLocation location, int v) const
+	{
+		glUniform1i(location.value, v);
+	}
+	void Shader::setFloat(UniformLocation location, float v) const
+	{
+		glUniform1f(location.value, v);
+	}
+	void Shader::setVec2(UniformLocation location, const glm::vec2& v) const
+	{
+		glUniform2f(location.value, v.x, v.y);
+	}
+	void Shader::setVec3(UniformLocation location, const glm::vec3& v) const
+	{
+		glUniform3f(location.value, v.x, v.y, v.z);
+	}
+	void Shader::setVec4(UniformLocation location, const glm::vec4& v) const
+	{
+		glUniform4f(location.value, v.x, v.y, v.z, v.w);
+	}
+	void Shader::setMat4(UniformLocation location, const glm::mat4& m) const
+	{
+		glUniformMatrix4fv(location.value, 1, GL_FALSE, glm::value_ptr(m));
 	}
-}
 
+	static double millisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+	//1 stage is compute, 2 are vertex + fragment, 3 are vertex + geometry + fragment
+	static GLenum getStageType(size_t numStages, size_t stage)
+	{
+		if (numStages == 1) {
+			return GL_COMPUTE_SHADER;
+		}
+		if (stage == 0) {
+			return GL_VERTEX_SHADER;
+		}
+		return stage == numStages - 1 ? GL_FRAGMENT_SHADER : GL_GEOMETRY_SHADER;
+	}
+	int ShaderBatch::addProgram(const std::vector<std::string>& stagePaths)
+	{
+		PendingProgram pending;
+		pending.stagePaths = stagePaths;
+		m_programs.push_back(pending);
+		m_shaders.push_back(Shader(0u));
+		ShaderCompileStats stats;
+		stats.name = stagePaths[0];
+		for (size_t i = 1; i < stagePaths.size(); i++)
+		{
+			stats.name += " + " + stagePaths[i].substr(stagePaths[i].find_last_of("/\\") + 1);
+		}
+		m_stats.push_back(stats);
+		return (int)m_programs.size() - 1;
+	}
+	int ShaderBatch::add(const std::string& vertexShader, const std::string& fragmentShader)
+	{
+		return addProgram({ vertexShader, fragmentShader });
+	}
+	int ShaderBatch::add(const std::string& vertexShader, const std::string& geometryShader, const std::string& fragmentShader)
+	{
+		return addProgram({ vertexShader, geometryShader, fragmentShader });
+	}
+	int ShaderBatch::add(const std::string& computeShader)
+	{
+		return addProgram({ computeShader });
+	}
+	/// <summary>
+	/// Cached programs load first. Then every remaining stage is handed to the compiler before any program links,
+	/// and nothing here asks for a status, since that would wait for the compiler.
+	/// Programs added after an earlier submit() are submitted, the rest are left alone.
+	/// </summary>
+	void ShaderBatch::submit()
+	{
+		std::vector<int> compiling;
+		for (int i = 0; i < (int)m_programs.size(); i++)
+		{
+			PendingProgram& pending = m_programs[i];
+			if (pending.submitted) {
+				continue;
+			}
+			pending.submitted = true;
+			pending.submitTime = std::chrono::steady_clock::now();
+			for (const std::string& path : pending.stagePaths)
+			{
+				pending.sources.push_back(loadShaderSourceFromFile(path));
+			}
+			pending.sourceHash = hashProgramSources(pending.sources);
+			auto start = std::chrono::steady_clock::now();
+			pending.program = loadProgramBinary(getProgramCachePath(pending.stagePaths), pending.sourceHash);
+			if (pending.program != 0) {
+				m_shaders[i] = Shader(pending.program);
+				m_stats[i].fromCache = true;
+				m_stats[i].linked = true;
+				m_stats[i].linkTime = millisecondsSince(start);
+				m_stats[i].blockedTime = m_stats[i].linkTime;
+				pending.sources.clear();
+				pending.compiled = true;
+				pending.done = true;
+				continue;
+			}
+			compiling.push_back(i);
+		}
+		for (int i : compiling)
+		{
+			PendingProgram& pending = m_programs[i];
+			auto start = std::chrono::steady_clock::now();
+			for (size_t stage = 0; stage < pending.sources.size(); stage++)
+			{
+				pending.shaders.push_back(submitShader(getStageType(pending.sources.size(), stage), pending.sources[stage].c_str()));
+			}
+			m_stats[i].blockedTime += millisecondsSince(start);
+		}
+		//Linking doesn't have to wait for compiles either, the driver queues it behind them
+		for (int i : compiling)
+		{
+			PendingProgram& pending = m_programs[i];
+			auto start = std::chrono::steady_clock::now();
+			pending.program = glCreateProgram();
+			for (unsigned int shader : pending.shaders)
+			{
+				glAttachShader(pending.program, shader);
+			}
+			glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			glLinkProgram(pending.program);
+			m_stats[i].blockedTime += millisecondsSince(start);
+			m_numPending++;
+		}
+	}
+	/// <summary>
+	/// With GL_KHR_parallel_shader_compile, GL_COMPLETION_STATUS_KHR says whether a status query would wait,
+	/// so only finished programs are collected. Without it every query waits, so everything is collected now.
+	/// Times are taken when a program is found finished, so they're only as fine as the polling.
+	/// </summary>
+	bool ShaderBatch::poll()
+	{
+		bool parallel = hasParallelShaderCompile();
+		for (int i = 0; i < (int)m_programs.size(); i++)
+		{
+			PendingProgram& pending = m_programs[i];
+			if (!pending.submitted || pending.done) {
+				continue;
+			}
+			if (!pending.compiled) {
+				bool compiled = true;
+				for (size_t stage = 0; parallel && stage < pending.shaders.size(); stage++)
+				{
+					int complete = 0;
+					glGetShaderiv(pending.shaders[stage], GL_COMPLETION_STATUS_KHR, &complete);
+					compiled &= complete != 0;
+				}
+				if (!compiled) {
+					continue;
+				}
+				finishCompile(i);
+			}
+			if (parallel) {
+				int complete = 0;
+				glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &complete);
+				if (!complete) {
+					continue;
+				}
+			}
+			finishLink(i);
+		}
+		return isDone();
+	}
+	void ShaderBatch::finishCompile(int index)
+	{
+		PendingProgram& pending = m_programs[index];
+		auto start = std::chrono::steady_clock::now();
+		for (size_t stage = 0; stage < pending.shaders.size(); stage++)
+		{
+			checkShaderCompiled(pending.shaders[stage], pending.stagePaths[stage].c_str());
+		}
+		m_stats[index].blockedTime += millisecondsSince(start);
+		m_stats[index].compileTime = millisecondsSince(pending.submitTime);
+		pending.compiled = true;
+	}
+	/// <summary>
+	/// Caches the linked program and makes it available to get(), or deletes it if it failed to link
+	/// </summary>
+	void ShaderBatch::finishLink(int index)
+	{
+		PendingProgram& pending = m_programs[index];
+		ShaderCompileStats& stats = m_stats[index];
+		auto start = std::chrono::steady_clock::now();
+		stats.linked = checkProgramLinked(pending.program, stats.name.c_str());
+		stats.linkTime = millisecondsSince(pending.submitTime) - stats.compileTime;
+		for (unsigned int shader : pending.shaders)
+		{
+			glDeleteShader(shader);
+		}
+		pending.shaders.clear();
+		if (stats.linked) {
+			saveProgramBinary(getProgramCachePath(pending.stagePaths), pending.sourceHash, pending.program);
+			m_shaders[index] = Shader(pending.program);
+		}
+		else {
+			glDeleteProgram(pending.program);
+			pending.program = 0;
+		}
+		stats.blockedTime += millisecondsSince(start);
+		pending.sources.clear();
+		pending.done = true;
+		m_numPending--;
+	}
+	void ShaderBatch::wait()
+	{
+		while (!poll()) {
+			std::this_thread::yield();
+		}
+	}
+	bool ShaderBatch::isReady(int index) const
+	{
+		return m_programs[index].done && m_programs[index].program != 0;
+	}
+	const Shader& ShaderBatch::get(int index, const Shader& fallback) const
+	{
+		return isReady(index) ? m_shaders[index] : fallback;
+	}
+	const Shader& ShaderBatch::get(int index) const
+	{
+		return m_shaders[index];
+	}
+	void ShaderBatch::printStats() const
+	{
+		printf("%-60s %11s %11s %11s\n", "program", "compile ms", "link ms", "blocked ms");
+		for (const ShaderCompileStats& stats : m_stats)
+		{
+			const char* note = stats.fromCache ? " (cached)" : (stats.linked ? "" : " (failed)");
+			printf("%-60s %11.2f %11.2f %11.2f%s\n", stats.name.c_str(), stats.compileTime, stats.linkTime, stats.blockedTime, note);
+		}
+	}
+	void ShaderBatch::clear()
+	{
+		wait();
+		m_programs.clear();
+		m_shaders.clear();
+		m_stats.clear();
+	}
+}
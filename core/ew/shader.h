@@ -3,16 +3,42 @@
 */
 
 #pragma once
+#include <stdint.h>
+#include <chrono>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <glm/glm.hpp>
 
 namespace ew {
 	std::string loadShaderSourceFromFile(const std::string& filePath);
 	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource);
+	//geometryShaderSource may be null
+	unsigned int createShaderProgram(const char* vertexShaderSource, const char* geometryShaderSource, const char* fragmentShaderSource);
+	unsigned int createComputeProgram(const char* computeShaderSource);
+
+	//Looks up a GL function by name, e.g. glfwGetProcAddress
+	typedef void (*GLProc)();
+	typedef GLProc(*GLProcLoader)(const char* name);
+	//Whether the driver has GL_KHR_parallel_shader_compile (or the ARB version), which lets ShaderBatch poll without waiting
+	bool hasParallelShaderCompile();
+	//Lets the driver use up to maxThreads background compiler threads, 0 compiles on the calling thread.
+	//Drivers pick their own default, so this is optional. Returns false without the extension
+	bool setShaderCompilerThreads(GLProcLoader getProcAddress, unsigned int maxThreads);
+
+	//Pre-resolved uniform location. Look it up once with Shader::getUniformLocation and keep it around
+	//so hot loops don't pay for string hashing or driver lookups.
+	struct UniformLocation {
+		int value = -1;
+	};
+
 	class Shader {
 	public:
 		Shader(const std::string& vertexShader, const std::string& fragmentShader);
+		Shader(const std::string& vertexShader, const std::string& geometryShader, const std::string& fragmentShader);
+		explicit Shader(const std::string& computeShader);
 		void use()const;
+		UniformLocation getUniformLocation(const std::string& name) const;
 		void setInt(const std::string& name, int v) const;
 		void setFloat(const std::string& name, float v) const;
 		void setVec2(const std::string& name, float x, float y) const;
@@ -22,7 +48,82 @@ namespace ew {
 		void setVec4(const std::string& name, float x, float y, float z, float w) const;
 		void setVec4(const std::string& name, const glm::vec4& v) const;
 		void setMat4(const std::string& name, const glm::mat4& m) const;
+		void setInt(UniformLocation location, int v) const;
+		void setFloat(UniformLocation location, float v) const;
+		void setVec2(UniformLocation location, const glm::vec2& v) const;
+		void setVec3(UniformLocation location, const glm::vec3& v) const;
+		void setVec4(UniformLocation location, const glm::vec4& v) const;
+		void setMat4(UniformLocation location, const glm::mat4& m) const;
+		//Program handle. Copies share it, so only delete it once no copy is in use
+		unsigned int getId() const { return m_id; }
 	private:
+		friend class ShaderBatch;
+		//Wraps a linked program. 0 makes an empty shader
+		explicit Shader(unsigned int program);
+		void cacheUniformLocations();
+		int findUniformLocation(const std::string& name) const;
 		unsigned int m_id; //Shader program handle
+		std::unordered_map<std::string, int> m_uniformLocations; //Active uniform name -> location, filled at link time
+	};
+
+	//Times of one program in a ShaderBatch, in milliseconds
+	struct ShaderCompileStats {
+		std::string name; //Stage files joined with " + "
+		bool fromCache = false; //Loaded from the program cache instead of compiled
+		bool linked = false;
+		double compileTime = 0.0; //From submit until every stage finished compiling
+		double linkTime = 0.0; //From then until the program finished linking
+		double blockedTime = 0.0; //Spent waiting inside GL calls for this program on the calling thread
+	};
+
+	//Compiles many programs at once. Every stage is handed to the driver before any status is checked, so drivers
+	//with GL_KHR_parallel_shader_compile work on all of them in the background and poll() never waits for them.
+	//Programs found in the program cache are ready as soon as submit() returns
+	class ShaderBatch {
+	public:
+		ShaderBatch() = default;
+		ShaderBatch(const ShaderBatch&) = delete;
+		ShaderBatch& operator=(const ShaderBatch&) = delete;
+		//Each returns the program's index, in the order added
+		int add(const std::string& vertexShader, const std::string& fragmentShader);
+		int add(const std::string& vertexShader, const std::string& geometryShader, const std::string& fragmentShader);
+		int add(const std::string& computeShader);
+		//Loads every stage's source and starts compiling everything that isn't cached
+		void submit();
+		//Collects programs that finished. Without the extension this waits for all of them.
+		//Returns true once every program is done
+		bool poll();
+		void wait();
+		bool isDone() const { return m_numPending == 0; }
+		int getNumPending() const { return m_numPending; }
+		//Linked and usable. Programs that fail to link never become ready
+		bool isReady(int index) const;
+		//The program once it's ready, fallback until then, e.g. a cheaper shader with the same inputs
+		const Shader& get(int index, const Shader& fallback) const;
+		//Only valid once isReady(index)
+		const Shader& get(int index) const;
+		const std::vector<ShaderCompileStats>& getStats() const { return m_stats; }
+		void printStats() const;
+		//Forgets every program, waiting for unfinished ones first. Shaders already taken with get stay valid
+		void clear();
+	private:
+		struct PendingProgram {
+			std::vector<std::string> stagePaths;
+			std::vector<std::string> sources;
+			std::vector<unsigned int> shaders; //Stage objects until the program links
+			uint64_t sourceHash = 0;
+			unsigned int program = 0;
+			std::chrono::steady_clock::time_point submitTime;
+			bool submitted = false;
+			bool compiled = false;
+			bool done = false;
+		};
+		int addProgram(const std::vector<std::string>& stagePaths);
+		void finishCompile(int index);
+		void finishLink(int index);
+		std::vector<PendingProgram> m_programs;
+		std::vector<Shader> m_shaders; //Empty until each program is ready
+		std::vector<ShaderCompileStats> m_stats;
+		int m_numPending = 0; //Submitted and not done
 	};
-}
\ No newline at end of file
+}
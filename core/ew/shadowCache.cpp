@@ -0,0 +1,110 @@
+/*
+*	Tracks which parts of a cached static shadow map are out of date
+*/
+
+#include "shadowCache.h"
+#include <math.h>
+
+namespace ew {
+	static const glm::ivec4 NO_DIRTY_TEXELS = glm::ivec4(0);
+
+	static bool isEmpty(const glm::ivec4& rect) {
+		return rect.z <= rect.x || rect.w <= rect.y;
+	}
+
+	/// <summary>
+	/// A cascade whose view projection differs in any way from the one it was drawn with is redrawn in full.
+	/// Cascades snap to whole texels, so with a still camera and light their matrices match exactly.
+	/// </summary>
+	unsigned int ShadowCache::update(const ShadowCascades& cascades, glm::ivec4* dirtyRects)
+	{
+		if (cascades.resolution != m_resolution) {
+			invalidateAll();
+			m_resolution = cascades.resolution;
+		}
+		unsigned int mask = 0;
+		m_stats.redrawn = m_stats.partial = m_stats.skipped = 0;
+		for (int i = 0; i < cascades.numCascades; i++)
+		{
+			glm::ivec4 dirty = m_dirty[i];
+			bool full = !m_valid[i] || cascades.viewProjections[i] != m_viewProjections[i];
+			if (full) {
+				dirty = glm::ivec4(0, 0, m_resolution, m_resolution);
+				m_viewProjections[i] = cascades.viewProjections[i];
+				m_valid[i] = true;
+			}
+			m_dirty[i] = NO_DIRTY_TEXELS;
+			if (isEmpty(dirty)) {
+				m_stats.skipped++;
+				continue;
+			}
+			if (full) {
+				m_stats.redrawn++;
+			}
+			else {
+				m_stats.partial++;
+			}
+			mask |= 1u << i;
+			dirtyRects[i] = glm::ivec4(dirty.x, dirty.y, dirty.z - dirty.x, dirty.w - dirty.y);
+		}
+		//Cascades turned off hold nothing worth keeping
+		for (int i = cascades.numCascades; i < MAX_SHADOW_CASCADES; i++)
+		{
+			m_valid[i] = false;
+		}
+		m_stats.totalRedrawn += m_stats.redrawn;
+		m_stats.totalPartial += m_stats.partial;
+		m_stats.totalSkipped += m_stats.skipped;
+		return mask;
+	}
+
+	/// <summary>
+	/// Only x and y are tested. Cascades are drawn with depth clamping, so changes anywhere toward the light can cast into them.
+	/// The region grows by a texel each way to cover rasterization rounding.
+	/// </summary>
+	void ShadowCache::invalidate(const AABB& worldBounds)
+	{
+		for (int i = 0; i < MAX_SHADOW_CASCADES; i++)
+		{
+			if (!m_valid[i]) {
+				continue;
+			}
+			glm::vec2 clipMin = glm::vec2(1e30f);
+			glm::vec2 clipMax = glm::vec2(-1e30f);
+			for (int corner = 0; corner < 8; corner++)
+			{
+				glm::vec3 p = glm::vec3(corner & 1 ? worldBounds.max.x : worldBounds.min.x,
+					corner & 2 ? worldBounds.max.y : worldBounds.min.y,
+					corner & 4 ? worldBounds.max.z : worldBounds.min.z);
+				//Orthographic, w is 1
+				glm::vec2 clip = glm::vec2(m_viewProjections[i] * glm::vec4(p, 1.0f));
+				clipMin = glm::min(clipMin, clip);
+				clipMax = glm::max(clipMax, clip);
+			}
+			glm::vec2 texelMin = (clipMin * 0.5f + 0.5f) * (float)m_resolution;
+			glm::vec2 texelMax = (clipMax * 0.5f + 0.5f) * (float)m_resolution;
+			glm::ivec4 region = glm::ivec4(
+				glm::max((int)floorf(texelMin.x) - 1, 0), glm::max((int)floorf(texelMin.y) - 1, 0),
+				glm::min((int)ceilf(texelMax.x) + 1, m_resolution), glm::min((int)ceilf(texelMax.y) + 1, m_resolution));
+			if (isEmpty(region)) {
+				continue;
+			}
+			glm::ivec4& dirty = m_dirty[i];
+			if (isEmpty(dirty)) {
+				dirty = region;
+			}
+			else {
+				dirty = glm::ivec4(glm::min(dirty.x, region.x), glm::min(dirty.y, region.y), glm::max(dirty.z, region.z), glm::max(dirty.w, region.w));
+			}
+		}
+	}
+
+	void ShadowCache::invalidateAll()
+	{
+		for (int i = 0; i < MAX_SHADOW_CASCADES; i++)
+		{
+			m_valid[i] = false;
+			m_dirty[i] = NO_DIRTY_TEXELS;
+		}
+	}
+}
@@ -0,0 +1,41 @@
+/*
+*	Tracks which parts of a cached static shadow map are out of date
+*/
+
+#pragma once
+#include <glm/glm.hpp>
+#include "shadowCascades.h"
+#include "bounds.h"
+
+namespace ew {
+	struct ShadowCacheStats {
+		//Cascades in the last update: fully redrawn, redrawn within a dirty region, and reused as they were
+		int redrawn = 0;
+		int partial = 0;
+		int skipped = 0;
+		unsigned long long totalRedrawn = 0;
+		unsigned long long totalPartial = 0;
+		unsigned long long totalSkipped = 0;
+	};
+
+	//Static casters only need redrawing into a cascade when its projection changes (the light turned, the camera
+	//moved the cascade by a texel, cascade settings changed), and then only where static geometry changed otherwise.
+	//Dynamic casters are drawn over a copy of the cached map each frame
+	class ShadowCache {
+	public:
+		//Returns a bitmask of the cascades that must be redrawn this frame. dirtyRects[cascade] is the texel
+		//rectangle (x, y, width, height) to clear and redraw, ready for glScissorIndexed.
+		//Those cascades count as up to date afterwards
+		unsigned int update(const ShadowCascades& cascades, glm::ivec4* dirtyRects);
+		//Static casters changed within worldBounds. Cascades it touches redraw that region on the next update
+		void invalidate(const AABB& worldBounds);
+		void invalidateAll();
+		inline const ShadowCacheStats& getStats()const { return m_stats; }
+	private:
+		int m_resolution = 0;
+		glm::mat4 m_viewProjections[MAX_SHADOW_CASCADES];
+		bool m_valid[MAX_SHADOW_CASCADES] = {};
+		glm::ivec4 m_dirty[MAX_SHADOW_CASCADES] = {}; //Min x, min y, max x, max y in texels. Empty when max <= min
+		ShadowCacheStats m_stats;
+	};
+}
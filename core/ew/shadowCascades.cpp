@@ -0,0 +1,95 @@
+/*
+*	Cascaded shadow maps fitted to slices of the view frustum
+*/
+
+#include "shadowCascades.h"
+#include <math.h>
+
+namespace ew {
+	/// <summary>
+	/// Practical split scheme: a lambda weighted blend of logarithmic and uniform splits.
+	/// The last split is always farPlane.
+	/// </summary>
+	void computeCascadeSplits(float nearPlane, float farPlane, int numCascades, float lambda, float* splitDepths)
+	{
+		for (int i = 1; i <= numCascades; i++)
+		{
+			float t = (float)i / numCascades;
+			float logSplit = nearPlane * powf(farPlane / nearPlane, t);
+			float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+			splitDepths[i - 1] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+		}
+		splitDepths[numCascades - 1] = farPlane;
+	}
+
+	/// <summary>
+	/// Each cascade is a square box around the bounding sphere of its frustum slice, so its size doesn't change
+	/// as the camera turns. Light space is centered on the world origin and boxes are snapped to whole texels
+	/// within it, so as the camera moves every shadow texel keeps covering the same patch of the world.
+	/// </summary>
+	void fitShadowCascades(const Camera& camera, const glm::vec3& lightDirection, const ShadowCascadeSettings& settings, ShadowCascades* cascades)
+	{
+		glm::vec3 direction = glm::length(lightDirection) > 1e-6f ? glm::normalize(lightDirection) : glm::vec3(0, -1, 0);
+		glm::vec3 up = glm::vec3(0, 1, 0);
+		//If light is aligned with up vector, choose a new one
+		if (glm::abs(glm::dot(direction, up)) >= 1.0f - glm::epsilon<float>()) {
+			up = glm::vec3(0, 0, 1);
+		}
+		glm::mat4 lightView = glm::lookAt(glm::vec3(0), direction, up);
+		glm::mat4 inverseView = glm::inverse(camera.viewMatrix());
+
+		int numCascades = glm::clamp(settings.numCascades, 1, MAX_SHADOW_CASCADES);
+		float farPlane = glm::max(glm::min(camera.farPlane, settings.shadowDistance), camera.nearPlane * 2.0f);
+		cascades->numCascades = numCascades;
+		cascades->resolution = settings.resolution;
+		computeCascadeSplits(camera.nearPlane, farPlane, numCascades, settings.splitLambda, cascades->splitDepths);
+
+		float tanHalfFov = tanf(glm::radians(camera.fov) * 0.5f);
+		glm::vec3 boundsMin = glm::vec3(1e30f);
+		glm::vec3 boundsMax = glm::vec3(-1e30f);
+		float sliceNear = camera.nearPlane;
+		for (int i = 0; i < numCascades; i++)
+		{
+			glm::vec3 corners[8];
+			glm::vec3 center = glm::vec3(0);
+			for (int corner = 0; corner < 8; corner++)
+			{
+				float depth = corner & 4 ? cascades->splitDepths[i] : sliceNear;
+				float halfHeight = camera.orthographic ? camera.orthoHeight * 0.5f : depth * tanHalfFov;
+				float halfWidth = halfHeight * camera.aspectRatio;
+				glm::vec4 viewPosition = glm::vec4(corner & 1 ? halfWidth : -halfWidth, corner & 2 ? halfHeight : -halfHeight, -depth, 1.0f);
+				corners[corner] = glm::vec3(inverseView * viewPosition);
+				center += corners[corner] / 8.0f;
+			}
+			float radius = 0.0f;
+			for (int corner = 0; corner < 8; corner++)
+			{
+				radius = glm::max(radius, glm::length(corners[corner] - center));
+			}
+			//Rounding hides float noise in the radius, which would otherwise change the texel size every frame
+			radius = ceilf(radius * 16.0f) / 16.0f;
+			//Leaves room for the box to sit up to a texel off center once snapped
+			float halfSize = radius * settings.resolution / (settings.resolution - 2.0f);
+			float texelSize = 2.0f * halfSize / settings.resolution;
+
+			glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+			lightCenter.x = floorf(lightCenter.x / texelSize) * texelSize;
+			lightCenter.y = floorf(lightCenter.y / texelSize) * texelSize;
+			//The light looks down -z. Depth snaps too, more coarsely and with the range padded to match,
+			//so a cascade's matrix stays the same until the camera moves it and cached shadows (ew::ShadowCache) stay valid
+			float depthStep = texelSize * 16.0f;
+			float depth = roundf(-lightCenter.z / depthStep) * depthStep;
+			glm::vec3 boxMin = glm::vec3(lightCenter.x - halfSize, lightCenter.y - halfSize, depth - radius - depthStep);
+			glm::vec3 boxMax = glm::vec3(lightCenter.x + halfSize, lightCenter.y + halfSize, depth + radius + depthStep);
+			glm::mat4 projection = glm::ortho(boxMin.x, boxMax.x, boxMin.y, boxMax.y, boxMin.z, boxMax.z);
+			cascades->viewProjections[i] = projection * lightView;
+			cascades->texelSizes[i] = texelSize;
+			cascades->depthRanges[i] = boxMax.z - boxMin.z;
+			boundsMin = glm::min(boundsMin, boxMin);
+			boundsMax = glm::max(boundsMax, boxMax);
+			sliceNear = cascades->splitDepths[i];
+		}
+		glm::mat4 cullProjection = glm::ortho(boundsMin.x, boundsMax.x, boundsMin.y, boundsMax.y, boundsMin.z - settings.casterDistance, boundsMax.z);
+		cascades->cullViewProjection = cullProjection * lightView;
+	}
+}
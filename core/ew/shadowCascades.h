@@ -0,0 +1,40 @@
+/*
+*	Cascaded shadow maps fitted to slices of the view frustum
+*/
+
+#pragma once
+#include <glm/glm.hpp>
+#include "camera.h"
+
+namespace ew {
+	//Must match MAX_CASCADES in the shadow geometry shader and lighting shader
+	const int MAX_SHADOW_CASCADES = 4;
+
+	struct ShadowCascadeSettings {
+		int numCascades = 4;
+		float shadowDistance = 100.0f; //Shadows end here or at the camera's far plane, whichever is nearer
+		//Blend between uniform (0) and logarithmic (1) splits. Logarithmic keeps shadow texels per screen pixel constant,
+		//but spends most of the first cascade right in front of the near plane
+		float splitLambda = 0.75f;
+		int resolution = 2048; //Texels per cascade side
+		float casterDistance = 50.0f; //How far toward the light casters outside every cascade are still kept by culling
+	};
+
+	struct ShadowCascades {
+		int numCascades = 0;
+		int resolution = 0; //Texels per cascade side
+		float splitDepths[MAX_SHADOW_CASCADES]; //View depth where each cascade ends
+		glm::mat4 viewProjections[MAX_SHADOW_CASCADES];
+		float texelSizes[MAX_SHADOW_CASCADES]; //World units per shadow texel
+		float depthRanges[MAX_SHADOW_CASCADES]; //World units from each cascade's near plane to its far plane
+		//Light space box around every cascade, extended casterDistance toward the light, to cull casters once for all cascades
+		glm::mat4 cullViewProjection;
+	};
+
+	//Far view depth of each of numCascades slices of [nearPlane, farPlane]
+	void computeCascadeSplits(float nearPlane, float farPlane, int numCascades, float lambda, float* splitDepths);
+	//Orthographic projections along lightDirection around each slice of camera's frustum. Boxes only move in whole texels
+	//and keep their size as the camera turns, so shadow edges don't shimmer. Render with depth clamping:
+	//each box is only as deep as its slice, casters in front of it are flattened onto its near plane
+	void fitShadowCascades(const Camera& camera, const glm::vec3& lightDirection, const ShadowCascadeSettings& settings, ShadowCascades* cascades);
+}
@@ -0,0 +1,448 @@
+/*
+*	Chunked heightfield terrain, streamed around the camera
+*/
+
+#include "terrain.h"
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <iterator>
+#include "external/glad.h"
+#include "external/stb_image.h"
+
+namespace ew {
+	//Lattice value in [-1, 1]
+	static float hashLattice(int x, int z, unsigned int seed) {
+		unsigned int h = seed * 0x9E3779B9u ^ (unsigned int)x * 0x85EBCA6Bu ^ (unsigned int)z * 0xC2B2AE35u;
+		h ^= h >> 16;
+		h *= 0x7FEB352Du;
+		h ^= h >> 15;
+		h *= 0x846CA68Bu;
+		h ^= h >> 16;
+		return (h >> 8) / 8388607.5f - 1.0f;
+	}
+	static float valueNoise(float x, float z, unsigned int seed) {
+		float floorX = floorf(x);
+		float floorZ = floorf(z);
+		int ix = (int)floorX;
+		int iz = (int)floorZ;
+		float tx = x - floorX;
+		float tz = z - floorZ;
+		tx = tx * tx * (3.0f - 2.0f * tx);
+		tz = tz * tz * (3.0f - 2.0f * tz);
+		float a = glm::mix(hashLattice(ix, iz, seed), hashLattice(ix + 1, iz, seed), tx);
+		float b = glm::mix(hashLattice(ix, iz + 1, seed), hashLattice(ix + 1, iz + 1, seed), tx);
+		return glm::mix(a, b, tz);
+	}
+	float sampleNoise(const NoiseSettings& settings, float x, float z)
+	{
+		float height = 0.0f;
+		float frequency = settings.frequency;
+		float amplitude = settings.amplitude;
+		for (int octave = 0; octave < settings.octaves; octave++)
+		{
+			height += amplitude * valueNoise(x * frequency, z * frequency, settings.seed + octave);
+			frequency *= settings.lacunarity;
+			amplitude *= settings.gain;
+		}
+		return height;
+	}
+	HeightFunction createNoiseHeightFunction(const NoiseSettings& settings)
+	{
+		return [settings](float x, float z) { return sampleNoise(settings, x, z); };
+	}
+
+	bool loadHeightImage(const char* filePath, HeightImage* image)
+	{
+		int numComponents;
+		unsigned short* texels = stbi_load_16(filePath, &image->width, &image->height, &numComponents, 1);
+		if (texels == NULL) {
+			printf("Failed to load heightmap %s\n", filePath);
+			return false;
+		}
+		image->texels.assign(texels, texels + image->width * image->height);
+		stbi_image_free(texels);
+		return true;
+	}
+	HeightFunction createImageHeightFunction(std::shared_ptr<const HeightImage> image, float metersPerTexel, float heightScale)
+	{
+		return [image, metersPerTexel, heightScale](float x, float z) {
+			float u = glm::clamp(x / metersPerTexel, 0.0f, image->width - 1.0f);
+			float v = glm::clamp(z / metersPerTexel, 0.0f, image->height - 1.0f);
+			int x0 = glm::min((int)u, image->width - 2 < 0 ? 0 : image->width - 2);
+			int y0 = glm::min((int)v, image->height - 2 < 0 ? 0 : image->height - 2);
+			int x1 = glm::min(x0 + 1, image->width - 1);
+			int y1 = glm::min(y0 + 1, image->height - 1);
+			const unsigned short* texels = image->texels.data();
+			float a = glm::mix((float)texels[y0 * image->width + x0], (float)texels[y0 * image->width + x1], u - x0);
+			float b = glm::mix((float)texels[y1 * image->width + x0], (float)texels[y1 * image->width + x1], u - x0);
+			return glm::mix(a, b, v - y0) * (heightScale / 65535.0f);
+		};
+	}
+
+	int getTerrainTileVertexCount(int tileQuads)
+	{
+		return (tileQuads + 1) * (tileQuads + 1) + tileQuads * 4;
+	}
+
+	//Grid coordinates of the k-th vertex around the tile's edge: along z = 0, x = max, z = max, then x = 0.
+	//Walking this way, skirt quads built as (p0, p1, skirt0) face outwards
+	static glm::ivec2 getEdgeVertex(int tileQuads, int k) {
+		int side = k / tileQuads;
+		int t = k % tileQuads;
+		switch (side) {
+		case 0:
+			return glm::ivec2(t, 0);
+		case 1:
+			return glm::ivec2(tileQuads, t);
+		case 2:
+			return glm::ivec2(tileQuads - t, tileQuads);
+		default:
+			return glm::ivec2(0, tileQuads - t);
+		}
+	}
+
+	/// <summary>
+	/// Heights and normals only depend on world position, so shared edges match between neighbouring tiles.
+	/// Each LOD's error is measured against the triangles it actually draws, with the same diagonal as the full grid.
+	/// </summary>
+	void generateTerrainTile(const TerrainSettings& settings, glm::ivec2 coord, TerrainTileData* tile)
+	{
+		int quads = settings.tileQuads;
+		int columns = quads + 1;
+		float spacing = settings.tileSize / quads;
+		glm::vec2 origin = glm::vec2(coord) * settings.tileSize;
+		tile->coord = coord;
+		tile->vertices.resize(getTerrainTileVertexCount(quads));
+		std::vector<float> heights(columns * columns);
+		float minHeight = 1e30f;
+		float maxHeight = -1e30f;
+		for (int j = 0; j < columns; j++)
+		{
+			for (int i = 0; i < columns; i++)
+			{
+				//From global grid indices, so both tiles on a shared edge compute exactly the same positions
+				float x = (coord.x * quads + i) * spacing;
+				float z = (coord.y * quads + j) * spacing;
+				float height = settings.height(x, z);
+				heights[j * columns + i] = height;
+				minHeight = glm::min(minHeight, height);
+				maxHeight = glm::max(maxHeight, height);
+				//Central differences, sampled past the tile edge so neighbours agree
+				float dx = settings.height(x + spacing, z) - settings.height(x - spacing, z);
+				float dz = settings.height(x, z + spacing) - settings.height(x, z - spacing);
+				Vertex& v = tile->vertices[j * columns + i];
+				v.pos = glm::vec3(x, height, z);
+				v.normal = glm::normalize(glm::vec3(-dx, 2.0f * spacing, -dz));
+				v.uv = glm::vec2(x, z) / settings.tileSize;
+			}
+		}
+
+		for (int lod = 0; lod < MAX_TERRAIN_LODS; lod++)
+		{
+			tile->lodErrors[lod] = 0.0f;
+			int step = 1 << lod;
+			if (lod == 0 || lod >= settings.numLods || step > quads) {
+				continue;
+			}
+			float error = 0.0f;
+			for (int j = 0; j < quads; j++)
+			{
+				for (int i = 0; i < quads; i++)
+				{
+					int i0 = i / step * step;
+					int j0 = j / step * step;
+					float u = (float)(i - i0) / step;
+					float v = (float)(j - j0) / step;
+					float h00 = heights[j0 * columns + i0];
+					float h10 = heights[j0 * columns + i0 + step];
+					float h01 = heights[(j0 + step) * columns + i0];
+					float h11 = heights[(j0 + step) * columns + i0 + step];
+					//Split along the (i0, j0) - (i0 + step, j0 + step) diagonal
+					float interpolated = v >= u ? (1.0f - v) * h00 + (v - u) * h01 + u * h11
+						: (1.0f - u) * h00 + v * h11 + (u - v) * h10;
+					error = glm::max(error, fabsf(heights[j * columns + i] - interpolated));
+				}
+			}
+			tile->lodErrors[lod] = glm::max(error, tile->lodErrors[lod - 1]);
+		}
+
+		float skirtDepth = settings.skirtDepth + tile->lodErrors[glm::clamp(settings.numLods, 1, MAX_TERRAIN_LODS) - 1];
+		for (int k = 0; k < quads * 4; k++)
+		{
+			glm::ivec2 edge = getEdgeVertex(quads, k);
+			Vertex& skirt = tile->vertices[columns * columns + k];
+			skirt = tile->vertices[edge.y * columns + edge.x];
+			skirt.pos.y -= skirtDepth;
+		}
+		tile->bounds.min = glm::vec3(origin.x, minHeight - skirtDepth, origin.y);
+		tile->bounds.max = glm::vec3(origin.x + settings.tileSize, maxHeight, origin.y + settings.tileSize);
+	}
+
+	void generateTerrainIndices(int tileQuads, int numLods, std::vector<unsigned short>* indices, std::vector<unsigned int>* lodOffsets)
+	{
+		int columns = tileQuads + 1;
+		unsigned short skirtStart = columns * columns;
+		indices->clear();
+		lodOffsets->clear();
+		for (int lod = 0; lod < numLods; lod++)
+		{
+			lodOffsets->push_back(indices->size());
+			int step = 1 << lod;
+			//Grid, counter clockwise seen from above
+			for (int j = 0; j < tileQuads; j += step)
+			{
+				for (int i = 0; i < tileQuads; i += step)
+				{
+					unsigned short start = j * columns + i;
+					unsigned short right = start + step;
+					unsigned short up = start + step * columns;
+					unsigned short upRight = up + step;
+					indices->insert(indices->end(), { start, up, upRight, start, upRight, right });
+				}
+			}
+			//Skirt
+			int edgeVertices = tileQuads * 4;
+			for (int k = 0; k < edgeVertices; k += step)
+			{
+				int next = (k + step) % edgeVertices;
+				glm::ivec2 a = getEdgeVertex(tileQuads, k);
+				glm::ivec2 b = getEdgeVertex(tileQuads, next);
+				unsigned short top0 = a.y * columns + a.x;
+				unsigned short top1 = b.y * columns + b.x;
+				unsigned short bottom0 = skirtStart + k;
+				unsigned short bottom1 = skirtStart + next;
+				indices->insert(indices->end(), { top0, top1, bottom0, top1, bottom1, bottom0 });
+			}
+		}
+		lodOffsets->push_back(indices->size());
+	}
+
+	/// <summary>
+	/// Allocates every slot up front and shares one 16 bit index buffer between them.
+	/// numLods is clamped so the coarsest LOD still has one quad per tile.
+	/// </summary>
+	Terrain::Terrain(const TerrainSettings& settings, ThreadPool& threadPool)
+		: m_settings(settings), m_threadPool(threadPool)
+	{
+		m_settings.tileQuads = glm::clamp(m_settings.tileQuads, 1, 128);
+		int maxLods = 1;
+		while (maxLods < MAX_TERRAIN_LODS && m_settings.tileQuads % (1 << maxLods) == 0) {
+			maxLods++;
+		}
+		m_settings.numLods = glm::clamp(m_settings.numLods, 1, maxLods);
+		m_settings.maxPendingTiles = glm::max(m_settings.maxPendingTiles, 1);
+		m_verticesPerTile = getTerrainTileVertexCount(m_settings.tileQuads);
+
+		int diameter = m_settings.loadRadius * 2 + 1;
+		m_slots.resize(diameter * diameter);
+		for (int slot = (int)m_slots.size() - 1; slot >= 0; slot--)
+		{
+			m_freeSlots.push_back(slot);
+		}
+		for (int z = -m_settings.loadRadius; z <= m_settings.loadRadius; z++)
+		{
+			for (int x = -m_settings.loadRadius; x <= m_settings.loadRadius; x++)
+			{
+				m_loadOrder.push_back(glm::ivec2(x, z));
+			}
+		}
+		std::stable_sort(m_loadOrder.begin(), m_loadOrder.end(), [](glm::ivec2 a, glm::ivec2 b) {
+			return a.x * a.x + a.y * a.y < b.x * b.x + b.y * b.y;
+		});
+
+		std::vector<unsigned short> indices;
+		generateTerrainIndices(m_settings.tileQuads, m_settings.numLods, &indices, &m_lodOffsets);
+		glCreateBuffers(1, &m_vbo);
+		glNamedBufferStorage(m_vbo, sizeof(Vertex) * m_verticesPerTile * m_slots.size(), nullptr, GL_DYNAMIC_STORAGE_BIT);
+		glCreateBuffers(1, &m_ebo);
+		glNamedBufferStorage(m_ebo, sizeof(unsigned short) * indices.size(), indices.data(), 0);
+		glCreateBuffers(1, &m_indirectBuffer);
+
+		glCreateVertexArrays(1, &m_vao);
+		glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, sizeof(Vertex));
+		glVertexArrayElementBuffer(m_vao, m_ebo);
+		//Position attribute
+		glVertexArrayAttribFormat(m_vao, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, pos));
+		//Normal attribute
+		glVertexArrayAttribFormat(m_vao, 1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, normal));
+		//UV attribute
+		glVertexArrayAttribFormat(m_vao, 2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, uv));
+		for (unsigned int attribute = 0; attribute < 3; attribute++) {
+			glVertexArrayAttribBinding(m_vao, attribute, 0);
+			glEnableVertexArrayAttrib(m_vao, attribute);
+		}
+	}
+
+	/// <summary>
+	/// Waits for in flight tiles, since they write back into this terrain.
+	/// </summary>
+	Terrain::~Terrain()
+	{
+		m_threadPool.waitIdle();
+		glDeleteVertexArrays(1, &m_vao);
+		glDeleteBuffers(1, &m_vbo);
+		glDeleteBuffers(1, &m_ebo);
+		glDeleteBuffers(1, &m_indirectBuffer);
+	}
+
+	unsigned long long Terrain::tileKey(glm::ivec2 coord)
+	{
+		return ((unsigned long long)(unsigned int)coord.x << 32) | (unsigned int)coord.y;
+	}
+
+	void Terrain::freeSlot(int slot)
+	{
+		TileSlot& tileSlot = m_slots[slot];
+		if (tileSlot.state == SlotState::RESIDENT) {
+			m_numResident--;
+			m_changedBounds.push_back(tileSlot.bounds);
+		}
+		m_tileSlots.erase(tileKey(tileSlot.coord));
+		tileSlot.state = SlotState::FREE;
+		tileSlot.ticket++;
+		m_freeSlots.push_back(slot);
+	}
+
+	/// <summary>
+	/// Out of range tiles are freed first, so their slots can be reused by tiles coming into range in the same update.
+	/// Tiles still generating when they leave range are freed too, their results are dropped when they arrive.
+	/// </summary>
+	void Terrain::update(const glm::vec3& cameraPosition)
+	{
+		glm::ivec2 center = glm::ivec2(glm::floor(glm::vec2(cameraPosition.x, cameraPosition.z) / m_settings.tileSize));
+		m_changedBounds.clear();
+		for (int slot = 0; slot < (int)m_slots.size(); slot++)
+		{
+			glm::ivec2 offset = glm::abs(m_slots[slot].coord - center);
+			if (m_slots[slot].state != SlotState::FREE && glm::max(offset.x, offset.y) > m_settings.loadRadius) {
+				freeSlot(slot);
+			}
+		}
+
+		std::vector<GeneratedTile> generated;
+		{
+			std::lock_guard<std::mutex> lock(m_generatedMutex);
+			generated.swap(m_generated);
+		}
+		int numUploads = 0;
+		size_t i = 0;
+		for (; i < generated.size(); i++)
+		{
+			GeneratedTile& tile = generated[i];
+			TileSlot& tileSlot = m_slots[tile.slot];
+			if (tileSlot.ticket == tile.ticket) {
+				if (numUploads >= m_settings.maxUploadsPerUpdate) {
+					break;
+				}
+				glNamedBufferSubData(m_vbo, sizeof(Vertex) * m_verticesPerTile * tile.slot, sizeof(Vertex) * m_verticesPerTile, tile.data->vertices.data());
+				tileSlot.state = SlotState::RESIDENT;
+				tileSlot.bounds = tile.data->bounds;
+				m_changedBounds.push_back(tileSlot.bounds);
+				std::copy(tile.data->lodErrors, tile.data->lodErrors + MAX_TERRAIN_LODS, tileSlot.lodErrors);
+				m_numResident++;
+				numUploads++;
+			}
+			m_numPending--;
+		}
+		//Anything over budget goes back to the front of the queue for next time
+		if (i < generated.size()) {
+			std::lock_guard<std::mutex> lock(m_generatedMutex);
+			m_generated.insert(m_generated.begin(), std::make_move_iterator(generated.begin() + i), std::make_move_iterator(generated.end()));
+		}
+
+		for (const glm::ivec2& offset : m_loadOrder)
+		{
+			if (m_numPending >= m_settings.maxPendingTiles || m_freeSlots.empty()) {
+				break;
+			}
+			glm::ivec2 coord = center + offset;
+			if (m_tileSlots.count(tileKey(coord)) > 0) {
+				continue;
+			}
+			int slot = m_freeSlots.back();
+			m_freeSlots.pop_back();
+			TileSlot& tileSlot = m_slots[slot];
+			tileSlot.state = SlotState::LOADING;
+			tileSlot.coord = coord;
+			m_tileSlots[tileKey(coord)] = slot;
+			m_numPending++;
+			unsigned int ticket = tileSlot.ticket;
+			m_threadPool.submit([this, slot, ticket, coord]() {
+				GeneratedTile tile;
+				tile.slot = slot;
+				tile.ticket = ticket;
+				tile.data.reset(new TerrainTileData());
+				generateTerrainTile(m_settings, coord, tile.data.get());
+				std::lock_guard<std::mutex> lock(m_generatedMutex);
+				m_generated.push_back(std::move(tile));
+			});
+		}
+	}
+
+	void Terrain::finishLoading(const glm::vec3& cameraPosition)
+	{
+		update(cameraPosition);
+		while (m_numPending > 0) {
+			m_threadPool.waitIdle();
+			update(cameraPosition);
+		}
+	}
+
+	/// <summary>
+	/// Picks the coarsest LOD whose error stays within the pixel budget at the tile's near side,
+	/// then submits every visible tile in one call.
+	/// </summary>
+	int Terrain::draw(const Frustum* frustum, const LodSelector* lodSelector)
+	{
+		m_commands.clear();
+		unsigned int triangles = 0;
+		for (int slot = 0; slot < (int)m_slots.size(); slot++)
+		{
+			const TileSlot& tileSlot = m_slots[slot];
+			if (tileSlot.state != SlotState::RESIDENT || (frustum != nullptr && !frustumIntersectsAABB(*frustum, tileSlot.bounds))) {
+				continue;
+			}
+			int lod = 0;
+			if (lodSelector != nullptr) {
+				BoundingSphere bounds = { tileSlot.bounds.center(), glm::length(tileSlot.bounds.extents()) };
+				float maxError = getMaxLodError(*lodSelector, bounds);
+				for (int i = m_settings.numLods - 1; i > 0; i--)
+				{
+					if (tileSlot.lodErrors[i] <= maxError) {
+						lod = i;
+						break;
+					}
+				}
+			}
+			unsigned int count = m_lodOffsets[lod + 1] - m_lodOffsets[lod];
+			m_commands.push_back(DrawElementsIndirectCommand{ count, 1, m_lodOffsets[lod], slot * m_verticesPerTile, 0 });
+			triangles += count / 3;
+		}
+		if (m_commands.empty()) {
+			return 0;
+		}
+		if (m_commands.size() > m_indirectCapacity) {
+			glNamedBufferData(m_indirectBuffer, sizeof(DrawElementsIndirectCommand) * m_commands.size(), m_commands.data(), GL_DYNAMIC_DRAW);
+			m_indirectCapacity = m_commands.size();
+		}
+		else {
+			glNamedBufferSubData(m_indirectBuffer, 0, sizeof(DrawElementsIndirectCommand) * m_commands.size(), m_commands.data());
+		}
+		glBindVertexArray(m_vao);
+		//Full float vertices, no dequantization
+		glVertexAttrib3f(POSITION_SCALE_ATTRIBUTE, 1.0f, 1.0f, 1.0f);
+		glVertexAttrib3f(POSITION_OFFSET_ATTRIBUTE, 0.0f, 0.0f, 0.0f);
+		glVertexAttribI1ui(BASE_INSTANCE_ATTRIBUTE, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, m_commands.size(), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		recordDrawCall(m_commands.size(), triangles);
+		return (int)m_commands.size();
+	}
+
+	size_t Terrain::getGpuBytes() const
+	{
+		return sizeof(Vertex) * m_verticesPerTile * m_slots.size() + sizeof(unsigned short) * m_lodOffsets.back();
+	}
+}
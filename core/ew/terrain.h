@@ -0,0 +1,138 @@
+/*
+*	Chunked heightfield terrain, streamed around the camera
+*/
+
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "mesh.h"
+#include "frustum.h"
+#include "lod.h"
+#include "geometryArena.h"
+#include "threadPool.h"
+
+namespace ew {
+	//World space height at x, z. Called from worker threads, so it must be safe to call concurrently
+	typedef std::function<float(float x, float z)> HeightFunction;
+
+	//Fractal value noise
+	struct NoiseSettings {
+		unsigned int seed = 0;
+		int octaves = 5;
+		float frequency = 0.01f; //Of the first octave, in cycles per world unit
+		float amplitude = 8.0f; //Of the first octave
+		float lacunarity = 2.0f; //Frequency multiplier per octave
+		float gain = 0.5f; //Amplitude multiplier per octave
+	};
+	float sampleNoise(const NoiseSettings& settings, float x, float z);
+	HeightFunction createNoiseHeightFunction(const NoiseSettings& settings);
+
+	//16 bit grayscale heightmap, e.g. a PNG exported from a terrain tool. 8 bit images are widened
+	struct HeightImage {
+		int width = 0;
+		int height = 0;
+		std::vector<unsigned short> texels;
+	};
+	bool loadHeightImage(const char* filePath, HeightImage* image);
+	//Bilinearly filtered. The image covers [0, width * metersPerTexel) on x and z and is clamped outside that.
+	//A texel of 65535 is heightScale high
+	HeightFunction createImageHeightFunction(std::shared_ptr<const HeightImage> image, float metersPerTexel, float heightScale);
+
+	const int MAX_TERRAIN_LODS = 6;
+
+	struct TerrainSettings {
+		int tileQuads = 64; //Quads per tile side. A power of two, at most 128 so tiles fit 16 bit indices
+		float tileSize = 32.0f; //World units per tile side
+		int loadRadius = 6; //Tiles kept resident in each direction around the camera's tile
+		int numLods = 4; //LOD n uses every 2^n-th vertex of the tile
+		//Skirts hang this far below each tile's edges, plus the tile's own coarsest LOD error,
+		//hiding cracks where neighbouring tiles use different LODs
+		float skirtDepth = 1.0f;
+		int maxPendingTiles = 8; //Tiles generating at once, which bounds CPU memory
+		int maxUploadsPerUpdate = 4;
+		HeightFunction height;
+	};
+
+	//One tile's vertices in world space: the (tileQuads + 1)^2 grid, then a skirt vertex under each edge vertex
+	struct TerrainTileData {
+		glm::ivec2 coord;
+		std::vector<Vertex> vertices;
+		AABB bounds;
+		float lodErrors[MAX_TERRAIN_LODS]; //Largest height difference between each LOD and the full grid
+	};
+	int getTerrainTileVertexCount(int tileQuads);
+	//Deterministic, safe to call from any thread
+	void generateTerrainTile(const TerrainSettings& settings, glm::ivec2 coord, TerrainTileData* tile);
+	//Indices every tile shares, grid then skirt for each LOD. LOD n is [lodOffsets[n], lodOffsets[n + 1])
+	void generateTerrainIndices(int tileQuads, int numLods, std::vector<unsigned short>* indices, std::vector<unsigned int>* lodOffsets);
+
+	//Keeps the tiles within loadRadius of the camera resident, generating them on a ThreadPool.
+	//Tiles live in fixed slots of one vertex buffer sized for (2 * loadRadius + 1)^2 tiles, so GPU memory
+	//doesn't depend on the size of the world, and all visible tiles draw with one glMultiDrawElementsIndirect.
+	//Vertices are in world space: draw with an identity _Model
+	class Terrain {
+	public:
+		Terrain(const TerrainSettings& settings, ThreadPool& threadPool);
+		~Terrain();
+		Terrain(const Terrain&) = delete;
+		Terrain& operator=(const Terrain&) = delete;
+		//Frees tiles that are out of range, uploads finished ones and queues missing ones, nearest first
+		void update(const glm::vec3& cameraPosition);
+		//Blocks until every tile around cameraPosition is resident
+		void finishLoading(const glm::vec3& cameraPosition);
+		//Null frustum or lodSelector draws every resident tile at full detail. Returns how many tiles were drawn
+		int draw(const Frustum* frustum, const LodSelector* lodSelector);
+		inline const TerrainSettings& getSettings()const { return m_settings; }
+		inline int getNumSlots()const { return (int)m_slots.size(); }
+		inline int getNumResidentTiles()const { return m_numResident; }
+		inline int getNumPendingTiles()const { return m_numPending; }
+		//Bounds of the tiles the last update() made resident or freed, for caches of anything drawn from the terrain
+		inline const std::vector<AABB>& getChangedBounds()const { return m_changedBounds; }
+		//Vertex and index buffers, allocated once
+		size_t getGpuBytes()const;
+	private:
+		enum class SlotState {
+			FREE,
+			LOADING,
+			RESIDENT
+		};
+		struct TileSlot {
+			SlotState state = SlotState::FREE;
+			glm::ivec2 coord;
+			AABB bounds;
+			float lodErrors[MAX_TERRAIN_LODS];
+			unsigned int ticket = 0; //Bumped when the slot is freed, so results for an evicted tile are dropped
+		};
+		//Written by worker threads, consumed by update()
+		struct GeneratedTile {
+			int slot;
+			unsigned int ticket;
+			std::unique_ptr<TerrainTileData> data;
+		};
+		static unsigned long long tileKey(glm::ivec2 coord);
+		void freeSlot(int slot);
+		TerrainSettings m_settings;
+		ThreadPool& m_threadPool;
+		std::vector<TileSlot> m_slots;
+		std::vector<int> m_freeSlots;
+		std::unordered_map<unsigned long long, int> m_tileSlots; //Tile coord -> slot, for loading and resident tiles
+		std::vector<glm::ivec2> m_loadOrder; //Offsets within loadRadius, nearest first
+		std::vector<GeneratedTile> m_generated;
+		std::mutex m_generatedMutex;
+		std::vector<unsigned int> m_lodOffsets;
+		std::vector<DrawElementsIndirectCommand> m_commands;
+		std::vector<AABB> m_changedBounds;
+		int m_verticesPerTile = 0;
+		int m_numResident = 0;
+		int m_numPending = 0;
+		unsigned int m_vao = 0;
+		unsigned int m_vbo = 0;
+		unsigned int m_ebo = 0;
+		unsigned int m_indirectBuffer = 0;
+		unsigned int m_indirectCapacity = 0; //Commands
+	};
+}
@@ -5,6 +5,7 @@
 #include "texture.h"
 #include "external/glad.h"
 #include "external/stb_image.h"
+#include "textureCompression.h"
 
 static int getTextureFormat(int numComponents) {
 	switch (numComponents) {
@@ -52,5 +53,31 @@ namespace ew {
 		stbi_image_free(data);
 		return texture;
 	}
+	unsigned int loadCompressedTexture(const char* filePath) {
+		return loadCompressedTexture(filePath, GL_REPEAT, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
+	}
+	unsigned int loadCompressedTexture(const char* filePath, int wrapMode, int magFilter, int minFilter) {
+		CompressedTexture compressed;
+		if (!readCompressedTexture(filePath, &compressed)) {
+			return 0;
+		}
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		int format = getCompressedGLFormat(compressed.format);
+		glTexStorage2D(GL_TEXTURE_2D, compressed.levels.size(), format, compressed.levels[0].width, compressed.levels[0].height);
+		//Blocks are uploaded as is, the driver doesn't touch them
+		for (size_t i = 0; i < compressed.levels.size(); i++) {
+			const CompressedLevel& level = compressed.levels[i];
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, format, level.data.size(), level.data.data());
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return texture;
+	}
 }
 
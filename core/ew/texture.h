@@ -7,4 +7,7 @@
 namespace ew {
 	unsigned int loadTexture(const char* filePath);
 	unsigned int loadTexture(const char* filePath, int wrapMode, int magFilter, int minFilter, bool mipmap);
+	//Loads a .ewtex file written by textureBaker. Mip levels come from the file, nothing is generated at runtime
+	unsigned int loadCompressedTexture(const char* filePath);
+	unsigned int loadCompressedTexture(const char* filePath, int wrapMode, int magFilter, int minFilter);
 }
@@ -0,0 +1,666 @@
+/*
+*	Block compression (BC1/BC5/BC7) and the .ewtex container with a precomputed mip chain
+*/
+
+#include "textureCompression.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "external/glad.h"
+
+//S3TC is an extension, not core GL, so glad doesn't define it
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+namespace ew {
+	int getBlockSize(TextureCompression format)
+	{
+		return format == TextureCompression::BC1 ? 8 : 16;
+	}
+
+	size_t getCompressedSize(TextureCompression format, int width, int height)
+	{
+		size_t blocksX = (width + 3) / 4;
+		size_t blocksY = (height + 3) / 4;
+		return blocksX * blocksY * getBlockSize(format);
+	}
+
+	int getCompressedGLFormat(TextureCompression format)
+	{
+		switch (format) {
+		case TextureCompression::BC1:
+			return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case TextureCompression::BC5:
+			return GL_COMPRESSED_RG_RGTC2;
+		default:
+			return GL_COMPRESSED_RGBA_BPTC_UNORM;
+		}
+	}
+
+	static int clampInt(int v, int min, int max) {
+		return v < min ? min : (v > max ? max : v);
+	}
+
+	/// <summary>
+	/// Mean and principal axis of numPixels points with numChannels components,
+	/// found with a few rounds of power iteration on the covariance matrix.
+	/// </summary>
+	static void principalAxis(const float* values, int numPixels, int numChannels, float* mean, float* axis) {
+		float covariance[4][4] = {};
+		for (int c = 0; c < numChannels; c++)
+		{
+			mean[c] = 0.0f;
+			for (int i = 0; i < numPixels; i++)
+			{
+				mean[c] += values[i * numChannels + c];
+			}
+			mean[c] /= numPixels;
+		}
+		for (int i = 0; i < numPixels; i++)
+		{
+			for (int a = 0; a < numChannels; a++)
+			{
+				for (int b = 0; b < numChannels; b++)
+				{
+					covariance[a][b] += (values[i * numChannels + a] - mean[a]) * (values[i * numChannels + b] - mean[b]);
+				}
+			}
+		}
+		for (int c = 0; c < numChannels; c++)
+		{
+			axis[c] = 1.0f;
+		}
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {};
+			float length = 0.0f;
+			for (int a = 0; a < numChannels; a++)
+			{
+				for (int b = 0; b < numChannels; b++)
+				{
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length += next[a] * next[a];
+			}
+			//Flat block, any axis works
+			if (length < 1e-12f) {
+				break;
+			}
+			length = sqrtf(length);
+			for (int c = 0; c < numChannels; c++)
+			{
+				axis[c] = next[c] / length;
+			}
+		}
+	}
+
+	//Endpoints at the extremes of the block projected onto its principal axis
+	static void fitEndpoints(const float* values, int numPixels, int numChannels, float* endpoint0, float* endpoint1) {
+		float mean[4], axis[4];
+		principalAxis(values, numPixels, numChannels, mean, axis);
+		float minT = 0.0f, maxT = 0.0f;
+		for (int i = 0; i < numPixels; i++)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < numChannels; c++)
+			{
+				t += (values[i * numChannels + c] - mean[c]) * axis[c];
+			}
+			minT = t < minT ? t : minT;
+			maxT = t > maxT ? t : maxT;
+		}
+		for (int c = 0; c < numChannels; c++)
+		{
+			endpoint0[c] = fminf(fmaxf(mean[c] + axis[c] * maxT, 0.0f), 255.0f);
+			endpoint1[c] = fminf(fmaxf(mean[c] + axis[c] * minT, 0.0f), 255.0f);
+		}
+	}
+
+	static int nearestPaletteIndex(const unsigned char* pixel, const int palette[][4], int paletteSize, int numChannels) {
+		int bestIndex = 0;
+		int bestError = 0x7fffffff;
+		for (int i = 0; i < paletteSize; i++)
+		{
+			int error = 0;
+			for (int c = 0; c < numChannels; c++)
+			{
+				int d = pixel[c] - palette[i][c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				bestIndex = i;
+			}
+		}
+		return bestIndex;
+	}
+
+	//Little endian bit stream used by BC7
+	static void writeBits(unsigned char* block, int* position, uint32_t value, int count) {
+		for (int i = 0; i < count; i++, (*position)++)
+		{
+			block[*position / 8] |= ((value >> i) & 1) << (*position % 8);
+		}
+	}
+
+	static uint32_t readBits(const unsigned char* block, int* position, int count) {
+		uint32_t value = 0;
+		for (int i = 0; i < count; i++, (*position)++)
+		{
+			value |= ((block[*position / 8] >> (*position % 8)) & 1u) << i;
+		}
+		return value;
+	}
+
+	static uint16_t packRGB565(const float* color) {
+		int r = clampInt((int)(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+		int g = clampInt((int)(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+		int b = clampInt((int)(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	static void unpackRGB565(uint16_t packed, int* color) {
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+		color[3] = 255;
+	}
+
+	static void bc1Palette(uint16_t color0, uint16_t color1, int palette[4][4]) {
+		unpackRGB565(color0, palette[0]);
+		unpackRGB565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			if (color0 > color1) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else {
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = color0 > color1 ? 255 : 0;
+	}
+
+	/// <summary>
+	/// BC1: two RGB565 endpoints and a 2 bit index per texel. Always uses the 4 color mode.
+	/// </summary>
+	void encodeBlockBC1(const unsigned char* pixels, unsigned char* block)
+	{
+		float colors[16 * 3];
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				colors[i * 3 + c] = pixels[i * 4 + c];
+			}
+		}
+		float endpoint0[3], endpoint1[3];
+		fitEndpoints(colors, 16, 3, endpoint0, endpoint1);
+		uint16_t color0 = packRGB565(endpoint0);
+		uint16_t color1 = packRGB565(endpoint1);
+		//color0 > color1 selects the 4 color mode
+		if (color0 < color1) {
+			uint16_t temp = color0;
+			color0 = color1;
+			color1 = temp;
+		}
+		uint32_t indices = 0;
+		if (color0 != color1) {
+			int palette[4][4];
+			bc1Palette(color0, color1, palette);
+			for (int i = 0; i < 16; i++)
+			{
+				indices |= (uint32_t)nearestPaletteIndex(&pixels[i * 4], palette, 4, 3) << (i * 2);
+			}
+		}
+		block[0] = color0 & 0xff;
+		block[1] = color0 >> 8;
+		block[2] = color1 & 0xff;
+		block[3] = color1 >> 8;
+		for (int i = 0; i < 4; i++)
+		{
+			block[4 + i] = (indices >> (i * 8)) & 0xff;
+		}
+	}
+
+	void decodeBlockBC1(const unsigned char* block, unsigned char* pixels)
+	{
+		uint16_t color0 = block[0] | (block[1] << 8);
+		uint16_t color1 = block[2] | (block[3] << 8);
+		uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+		int palette[4][4];
+		bc1Palette(color0, color1, palette);
+		for (int i = 0; i < 16; i++)
+		{
+			int index = (indices >> (i * 2)) & 3;
+			for (int c = 0; c < 4; c++)
+			{
+				pixels[i * 4 + c] = (unsigned char)palette[index][c];
+			}
+		}
+	}
+
+	//BC4: one channel, two 8 bit endpoints and a 3 bit index per texel. Encodes the 8 value mode.
+	static void encodeBlockBC4(const unsigned char* pixels, int channel, unsigned char* block) {
+		int maxValue = 0, minValue = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			int v = pixels[i * 4 + channel];
+			maxValue = v > maxValue ? v : maxValue;
+			minValue = v < minValue ? v : minValue;
+		}
+		uint64_t indices = 0;
+		if (maxValue != minValue) {
+			int palette[8][4];
+			palette[0][0] = maxValue;
+			palette[1][0] = minValue;
+			for (int i = 2; i < 8; i++)
+			{
+				palette[i][0] = ((8 - i) * maxValue + (i - 1) * minValue) / 7;
+			}
+			for (int i = 0; i < 16; i++)
+			{
+				unsigned char v = pixels[i * 4 + channel];
+				indices |= (uint64_t)nearestPaletteIndex(&v, palette, 8, 1) << (i * 3);
+			}
+		}
+		block[0] = (unsigned char)maxValue;
+		block[1] = (unsigned char)minValue;
+		for (int i = 0; i < 6; i++)
+		{
+			block[2 + i] = (indices >> (i * 8)) & 0xff;
+		}
+	}
+
+	static void decodeBlockBC4(const unsigned char* block, int channel, unsigned char* pixels) {
+		int palette[8];
+		palette[0] = block[0];
+		palette[1] = block[1];
+		if (palette[0] > palette[1]) {
+			for (int i = 2; i < 8; i++)
+			{
+				palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1]) / 7;
+			}
+		}
+		else {
+			for (int i = 2; i < 6; i++)
+			{
+				palette[i] = ((6 - i) * palette[0] + (i - 1) * palette[1]) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; i++)
+		{
+			indices |= (uint64_t)block[2 + i] << (i * 8);
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			pixels[i * 4 + channel] = (unsigned char)palette[(indices >> (i * 3)) & 7];
+		}
+	}
+
+	/// <summary>
+	/// BC5: a BC4 block for red followed by one for green
+	/// </summary>
+	void encodeBlockBC5(const unsigned char* pixels, unsigned char* block)
+	{
+		encodeBlockBC4(pixels, 0, block);
+		encodeBlockBC4(pixels, 1, block + 8);
+	}
+
+	void decodeBlockBC5(const unsigned char* block, unsigned char* pixels)
+	{
+		decodeBlockBC4(block, 0, pixels);
+		decodeBlockBC4(block + 8, 1, pixels);
+		for (int i = 0; i < 16; i++)
+		{
+			pixels[i * 4 + 2] = 0;
+			pixels[i * 4 + 3] = 255;
+		}
+	}
+
+	static const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	//Mode 6 endpoint channel: 7 bits plus a p-bit shared by the whole endpoint
+	static void quantizeBC7Endpoint(const float* endpoint, int* quantized, int* pBit) {
+		int bestError = 0x7fffffff;
+		for (int p = 0; p < 2; p++)
+		{
+			int q[4];
+			int error = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				q[c] = clampInt((int)((endpoint[c] - p) * 0.5f + 0.5f), 0, 127);
+				int d = ((q[c] << 1) | p) - (int)(endpoint[c] + 0.5f);
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				*pBit = p;
+				memcpy(quantized, q, sizeof(q));
+			}
+		}
+	}
+
+	/// <summary>
+	/// BC7 mode 6: one RGBA subset with 7 bit + p-bit endpoints and 4 bit indices
+	/// </summary>
+	void encodeBlockBC7(const unsigned char* pixels, unsigned char* block)
+	{
+		float colors[16 * 4];
+		for (int i = 0; i < 16 * 4; i++)
+		{
+			colors[i] = pixels[i];
+		}
+		float endpoints[2][4];
+		fitEndpoints(colors, 16, 4, endpoints[0], endpoints[1]);
+		int quantized[2][4];
+		int pBits[2];
+		quantizeBC7Endpoint(endpoints[0], quantized[0], &pBits[0]);
+		quantizeBC7Endpoint(endpoints[1], quantized[1], &pBits[1]);
+
+		int palette[16][4];
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				int e0 = (quantized[0][c] << 1) | pBits[0];
+				int e1 = (quantized[1][c] << 1) | pBits[1];
+				palette[i][c] = ((64 - BC7_WEIGHTS4[i]) * e0 + BC7_WEIGHTS4[i] * e1 + 32) >> 6;
+			}
+		}
+		int indices[16];
+		for (int i = 0; i < 16; i++)
+		{
+			indices[i] = nearestPaletteIndex(&pixels[i * 4], palette, 16, 4);
+		}
+		//The first texel's index is stored without its top bit, so it has to be < 8
+		if (indices[0] >= 8) {
+			for (int c = 0; c < 4; c++)
+			{
+				int temp = quantized[0][c];
+				quantized[0][c] = quantized[1][c];
+				quantized[1][c] = temp;
+			}
+			int temp = pBits[0];
+			pBits[0] = pBits[1];
+			pBits[1] = temp;
+			for (int i = 0; i < 16; i++)
+			{
+				indices[i] = 15 - indices[i];
+			}
+		}
+
+		memset(block, 0, 16);
+		int position = 0;
+		writeBits(block, &position, 1 << 6, 7); //Mode 6
+		for (int c = 0; c < 4; c++)
+		{
+			writeBits(block, &position, quantized[0][c], 7);
+			writeBits(block, &position, quantized[1][c], 7);
+		}
+		writeBits(block, &position, pBits[0], 1);
+		writeBits(block, &position, pBits[1], 1);
+		for (int i = 0; i < 16; i++)
+		{
+			writeBits(block, &position, indices[i], i == 0 ? 3 : 4);
+		}
+	}
+
+	/// <summary>
+	/// Decodes mode 6 blocks, the only mode encodeBlockBC7 writes. Other modes decode to magenta.
+	/// </summary>
+	void decodeBlockBC7(const unsigned char* block, unsigned char* pixels)
+	{
+		int position = 0;
+		if (readBits(block, &position, 7) != (1 << 6)) {
+			for (int i = 0; i < 16; i++)
+			{
+				pixels[i * 4 + 0] = 255;
+				pixels[i * 4 + 1] = 0;
+				pixels[i * 4 + 2] = 255;
+				pixels[i * 4 + 3] = 255;
+			}
+			return;
+		}
+		int endpoints[2][4];
+		for (int c = 0; c < 4; c++)
+		{
+			endpoints[0][c] = readBits(block, &position, 7) << 1;
+			endpoints[1][c] = readBits(block, &position, 7) << 1;
+		}
+		int p0 = readBits(block, &position, 1);
+		int p1 = readBits(block, &position, 1);
+		for (int c = 0; c < 4; c++)
+		{
+			endpoints[0][c] |= p0;
+			endpoints[1][c] |= p1;
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			int weight = BC7_WEIGHTS4[readBits(block, &position, i == 0 ? 3 : 4)];
+			for (int c = 0; c < 4; c++)
+			{
+				pixels[i * 4 + c] = (unsigned char)(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+			}
+		}
+	}
+
+	std::vector<Image> buildMipChain(const Image& image)
+	{
+		std::vector<Image> levels;
+		levels.push_back(image);
+		while (levels.back().width > 1 || levels.back().height > 1) {
+			const Image& src = levels.back();
+			Image dst;
+			dst.width = src.width > 1 ? src.width / 2 : 1;
+			dst.height = src.height > 1 ? src.height / 2 : 1;
+			dst.pixels.resize((size_t)dst.width * dst.height * 4);
+			for (int y = 0; y < dst.height; y++)
+			{
+				//Odd sizes clamp, so the last row/column is weighted a little more
+				int y0 = y * 2;
+				int y1 = clampInt(y * 2 + 1, 0, src.height - 1);
+				for (int x = 0; x < dst.width; x++)
+				{
+					int x0 = x * 2;
+					int x1 = clampInt(x * 2 + 1, 0, src.width - 1);
+					for (int c = 0; c < 4; c++)
+					{
+						int sum = src.pixels[((size_t)y0 * src.width + x0) * 4 + c] + src.pixels[((size_t)y0 * src.width + x1) * 4 + c]
+							+ src.pixels[((size_t)y1 * src.width + x0) * 4 + c] + src.pixels[((size_t)y1 * src.width + x1) * 4 + c];
+						dst.pixels[((size_t)y * dst.width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+					}
+				}
+			}
+			levels.push_back(dst);
+		}
+		return levels;
+	}
+
+	CompressedLevel compressImage(const Image& image, TextureCompression format)
+	{
+		CompressedLevel level;
+		level.width = image.width;
+		level.height = image.height;
+		level.data.resize(getCompressedSize(format, image.width, image.height));
+		int blockSize = getBlockSize(format);
+		int blocksX = (image.width + 3) / 4;
+		int blocksY = (image.height + 3) / 4;
+		unsigned char pixels[16 * 4];
+		for (int by = 0; by < blocksY; by++)
+		{
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				for (int i = 0; i < 16; i++)
+				{
+					int x = clampInt(bx * 4 + i % 4, 0, image.width - 1);
+					int y = clampInt(by * 4 + i / 4, 0, image.height - 1);
+					memcpy(&pixels[i * 4], &image.pixels[((size_t)y * image.width + x) * 4], 4);
+				}
+				unsigned char* block = &level.data[((size_t)by * blocksX + bx) * blockSize];
+				switch (format) {
+				case TextureCompression::BC1:
+					encodeBlockBC1(pixels, block);
+					break;
+				case TextureCompression::BC5:
+					encodeBlockBC5(pixels, block);
+					break;
+				default:
+					encodeBlockBC7(pixels, block);
+					break;
+				}
+			}
+		}
+		return level;
+	}
+
+	Image decompressLevel(const CompressedLevel& level, TextureCompression format)
+	{
+		Image image;
+		image.width = level.width;
+		image.height = level.height;
+		image.pixels.resize((size_t)level.width * level.height * 4);
+		int blockSize = getBlockSize(format);
+		int blocksX = (level.width + 3) / 4;
+		int blocksY = (level.height + 3) / 4;
+		unsigned char pixels[16 * 4];
+		for (int by = 0; by < blocksY; by++)
+		{
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				const unsigned char* block = &level.data[((size_t)by * blocksX + bx) * blockSize];
+				switch (format) {
+				case TextureCompression::BC1:
+					decodeBlockBC1(block, pixels);
+					break;
+				case TextureCompression::BC5:
+					decodeBlockBC5(block, pixels);
+					break;
+				default:
+					decodeBlockBC7(block, pixels);
+					break;
+				}
+				for (int i = 0; i < 16; i++)
+				{
+					int x = bx * 4 + i % 4;
+					int y = by * 4 + i / 4;
+					if (x < level.width && y < level.height) {
+						memcpy(&image.pixels[((size_t)y * level.width + x) * 4], &pixels[i * 4], 4);
+					}
+				}
+			}
+		}
+		return image;
+	}
+
+	CompressedTexture compressTexture(const Image& image, TextureCompression format, bool mipmap)
+	{
+		CompressedTexture texture;
+		texture.format = format;
+		if (mipmap) {
+			for (const Image& level : buildMipChain(image))
+			{
+				texture.levels.push_back(compressImage(level, format));
+			}
+		}
+		else {
+			texture.levels.push_back(compressImage(image, format));
+		}
+		return texture;
+	}
+
+	bool writeCompressedTexture(const std::string& filePath, const CompressedTexture& texture)
+	{
+		TextureFileHeader header;
+		header.magic = TEXTURE_FILE_MAGIC;
+		header.version = TEXTURE_FILE_VERSION;
+		header.format = (uint32_t)texture.format;
+		header.numLevels = (uint32_t)texture.levels.size();
+
+		std::vector<TextureFileLevel> levels(texture.levels.size());
+		uint64_t offset = sizeof(TextureFileHeader) + sizeof(TextureFileLevel) * levels.size();
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			levels[i].offset = offset;
+			levels[i].size = texture.levels[i].data.size();
+			levels[i].width = texture.levels[i].width;
+			levels[i].height = texture.levels[i].height;
+			offset += levels[i].size;
+		}
+
+		FILE* file = fopen(filePath.c_str(), "wb");
+		if (file == NULL) {
+			printf("Failed to write texture %s\n", filePath.c_str());
+			return false;
+		}
+		bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+		if (!levels.empty()) {
+			success &= fwrite(levels.data(), sizeof(TextureFileLevel), levels.size(), file) == levels.size();
+		}
+		for (const CompressedLevel& level : texture.levels)
+		{
+			success &= fwrite(level.data.data(), 1, level.data.size(), file) == level.data.size();
+		}
+		success &= fclose(file) == 0;
+		if (!success) {
+			printf("Failed to write texture %s\n", filePath.c_str());
+			remove(filePath.c_str());
+		}
+		return success;
+	}
+
+	bool readCompressedTexture(const std::string& filePath, CompressedTexture* texture)
+	{
+		FILE* file = fopen(filePath.c_str(), "rb");
+		if (file == NULL) {
+			printf("Failed to open texture %s\n", filePath.c_str());
+			return false;
+		}
+		TextureFileHeader header;
+		bool valid = fread(&header, sizeof(header), 1, file) == 1
+			&& header.magic == TEXTURE_FILE_MAGIC
+			&& header.version == TEXTURE_FILE_VERSION
+			&& header.format >= (uint32_t)TextureCompression::BC1 && header.format <= (uint32_t)TextureCompression::BC7
+			&& header.numLevels > 0 && header.numLevels <= 32;
+		std::vector<TextureFileLevel> levels(valid ? header.numLevels : 0);
+		valid = valid && fread(levels.data(), sizeof(TextureFileLevel), levels.size(), file) == levels.size();
+		if (valid) {
+			texture->format = (TextureCompression)header.format;
+			texture->levels.resize(levels.size());
+		}
+		for (size_t i = 0; valid && i < levels.size(); i++)
+		{
+			CompressedLevel& level = texture->levels[i];
+			level.width = (int)levels[i].width;
+			level.height = (int)levels[i].height;
+			valid = level.width > 0 && level.height > 0;
+			//Each level halves the one above, rounding down to at least 1, and the chain ends at 1x1
+			if (valid && i > 0) {
+				const CompressedLevel& above = texture->levels[i - 1];
+				valid = (above.width > 1 || above.height > 1)
+					&& level.width == (above.width > 1 ? above.width / 2 : 1) && level.height == (above.height > 1 ? above.height / 2 : 1);
+			}
+			valid = valid && levels[i].size == getCompressedSize(texture->format, level.width, level.height)
+				&& fseek(file, (long)levels[i].offset, SEEK_SET) == 0;
+			if (valid) {
+				level.data.resize((size_t)levels[i].size);
+				valid = fread(level.data.data(), 1, level.data.size(), file) == level.data.size();
+			}
+		}
+		fclose(file);
+		if (!valid) {
+			printf("Invalid texture file %s\n", filePath.c_str());
+		}
+		return valid;
+	}
+}
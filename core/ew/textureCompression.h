@@ -0,0 +1,76 @@
+/*
+*	Block compression (BC1/BC5/BC7) and the .ewtex container with a precomputed mip chain
+*/
+
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ew {
+	enum class TextureCompression : uint32_t {
+		BC1 = 1, //RGB, 8 bytes per 4x4 block
+		BC5 = 2, //RG only (e.g. normal maps), 16 bytes per block
+		BC7 = 3  //RGBA, 16 bytes per block. Only mode 6 is encoded, any mode decodes in hardware
+	};
+
+	//Uncompressed RGBA8 image
+	struct Image {
+		int width = 0;
+		int height = 0;
+		std::vector<unsigned char> pixels;
+	};
+
+	struct CompressedLevel {
+		int width = 0;
+		int height = 0;
+		std::vector<unsigned char> data;
+	};
+
+	struct CompressedTexture {
+		TextureCompression format = TextureCompression::BC7;
+		std::vector<CompressedLevel> levels; //levels[0] is full resolution
+	};
+
+	//File layout: TextureFileHeader, numLevels TextureFileLevel, then the level payloads
+	const uint32_t TEXTURE_FILE_MAGIC = 0x58545745; //"EWTX"
+	const uint32_t TEXTURE_FILE_VERSION = 1;
+
+	struct TextureFileHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t format; //TextureCompression
+		uint32_t numLevels;
+	};
+
+	struct TextureFileLevel {
+		uint64_t offset; //Bytes from the start of the file
+		uint64_t size;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	int getBlockSize(TextureCompression format);
+	size_t getCompressedSize(TextureCompression format, int width, int height);
+	//GL internal format for glTexStorage2D / glCompressedTexSubImage2D
+	int getCompressedGLFormat(TextureCompression format);
+
+	//Every level down to 1x1, each a 2x2 box filter of the one above
+	std::vector<Image> buildMipChain(const Image& image);
+
+	//Single blocks. pixels is 16 RGBA8 texels in row order
+	void encodeBlockBC1(const unsigned char* pixels, unsigned char* block);
+	void decodeBlockBC1(const unsigned char* block, unsigned char* pixels);
+	void encodeBlockBC5(const unsigned char* pixels, unsigned char* block);
+	void decodeBlockBC5(const unsigned char* block, unsigned char* pixels);
+	void encodeBlockBC7(const unsigned char* pixels, unsigned char* block);
+	void decodeBlockBC7(const unsigned char* block, unsigned char* pixels);
+
+	//Whole images. Edge blocks of sizes that aren't a multiple of 4 repeat the last row/column
+	CompressedLevel compressImage(const Image& image, TextureCompression format);
+	Image decompressLevel(const CompressedLevel& level, TextureCompression format);
+	CompressedTexture compressTexture(const Image& image, TextureCompression format, bool mipmap);
+
+	bool writeCompressedTexture(const std::string& filePath, const CompressedTexture& texture);
+	bool readCompressedTexture(const std::string& filePath, CompressedTexture* texture);
+}
@@ -0,0 +1,124 @@
+/*
+*	Fixed size pool of worker threads
+*/
+
+#include "threadPool.h"
+#include <atomic>
+#include <memory>
+
+namespace ew {
+	ThreadPool::ThreadPool(int numThreads)
+	{
+		if (numThreads <= 0) {
+			numThreads = (int)std::thread::hardware_concurrency() - 1;
+			numThreads = numThreads < 1 ? 1 : numThreads;
+		}
+		m_threads.reserve(numThreads);
+		for (int i = 0; i < numThreads; i++)
+		{
+			m_threads.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	/// <summary>
+	/// Finishes every queued job, then joins the workers
+	/// </summary>
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		m_jobAvailable.notify_all();
+		for (std::thread& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+
+	void ThreadPool::submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push_back(std::move(job));
+		}
+		m_jobAvailable.notify_one();
+	}
+
+	void ThreadPool::waitIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_idle.wait(lock, [this]() { return m_jobs.empty() && m_activeJobs == 0; });
+	}
+
+	/// <summary>
+	/// Queues up to one job per worker. Each job claims batches until none are left, so a job that only starts after
+	/// the calling thread has claimed everything returns without touching fn. Batch state is shared with the jobs,
+	/// which can outlive this call
+	/// </summary>
+	void ThreadPool::parallelFor(int count, int batchSize, const std::function<void(int begin, int end)>& fn)
+	{
+		if (count <= 0) {
+			return;
+		}
+		struct Batches {
+			std::atomic<int> next{ 0 };
+			int numDone = 0;
+			std::mutex mutex;
+			std::condition_variable done;
+		};
+		batchSize = batchSize < 1 ? 1 : batchSize;
+		int numBatches = (count + batchSize - 1) / batchSize;
+		std::shared_ptr<Batches> batches = std::make_shared<Batches>();
+		const std::function<void(int, int)>* function = &fn;
+		auto runBatches = [batches, function, count, batchSize, numBatches]() {
+			int numRun = 0;
+			for (int batch = batches->next++; batch < numBatches; batch = batches->next++)
+			{
+				int begin = batch * batchSize;
+				(*function)(begin, begin + batchSize < count ? begin + batchSize : count);
+				numRun++;
+			}
+			if (numRun > 0) {
+				std::lock_guard<std::mutex> lock(batches->mutex);
+				batches->numDone += numRun;
+				if (batches->numDone == numBatches) {
+					batches->done.notify_all();
+				}
+			}
+		};
+		int numJobs = numBatches - 1 < getNumThreads() ? numBatches - 1 : getNumThreads();
+		for (int i = 0; i < numJobs; i++)
+		{
+			submit(runBatches);
+		}
+		runBatches();
+		std::unique_lock<std::mutex> lock(batches->mutex);
+		batches->done.wait(lock, [&]() { return batches->numDone == numBatches; });
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_jobAvailable.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+				if (m_jobs.empty()) {
+					return;
+				}
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+				m_activeJobs++;
+			}
+			job();
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_activeJobs--;
+				if (m_jobs.empty() && m_activeJobs == 0) {
+					m_idle.notify_all();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,40 @@
+/*
+*	Fixed size pool of worker threads
+*/
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ew {
+	//Runs submitted jobs on worker threads in FIFO order. Jobs must not touch GL, only the main thread has a context.
+	class ThreadPool {
+	public:
+		//0 threads = one per hardware thread, minus the main thread
+		explicit ThreadPool(int numThreads = 0);
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		void submit(std::function<void()> job);
+		//Blocks until the queue is empty and no job is running
+		void waitIdle();
+		//Calls fn(begin, end) over [0, count) in batches of batchSize, on the workers and the calling thread.
+		//Returns once every batch is done. Unlike waitIdle it doesn't wait for unrelated jobs, and the calling thread
+		//keeps working through batches, so it finishes even if the workers are busy
+		void parallelFor(int count, int batchSize, const std::function<void(int begin, int end)>& fn);
+		inline int getNumThreads()const { return (int)m_threads.size(); }
+	private:
+		void workerLoop();
+		std::vector<std::thread> m_threads;
+		std::deque<std::function<void()>> m_jobs;
+		std::mutex m_mutex;
+		std::condition_variable m_jobAvailable;
+		std::condition_variable m_idle;
+		int m_activeJobs = 0;
+		bool m_stopping = false;
+	};
+}
@@ -0,0 +1,20 @@
+#version 450
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec3 vNormal;
+layout(location = 7) in vec3 vPositionScale;
+layout(location = 8) in vec3 vPositionOffset;
+layout(location = 9) in uint vBaseInstance;
+
+layout(std430, binding = 0) readonly buffer InstanceData{
+	mat4 _Models[];
+};
+uniform int _InstanceOffset;
+uniform mat4 _ViewProjection;
+
+out vec3 Normal;
+
+void main(){
+	vec3 pos = vPos * vPositionScale + vPositionOffset;
+	Normal = vNormal;
+	gl_Position = _ViewProjection * _Models[_InstanceOffset + vBaseInstance + gl_InstanceID] * vec4(pos, 1.0);
+}
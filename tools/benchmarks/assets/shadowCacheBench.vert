@@ -0,0 +1,12 @@
+#version 450
+layout(location = 0) in vec3 vPos;
+layout(location = 7) in vec3 vPositionScale;
+layout(location = 8) in vec3 vPositionOffset;
+
+uniform mat4 _ViewProjection;
+uniform mat4 _Model;
+
+void main(){
+	vec3 pos = vPos * vPositionScale + vPositionOffset;
+	gl_Position = _ViewProjection * _Model * vec4(pos, 1.0);
+}
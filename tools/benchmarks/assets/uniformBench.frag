@@ -0,0 +1,22 @@
+#version 450
+#define MAX_POINT_LIGHTS 256
+out vec4 FragColor;
+
+in vec2 UV;
+
+struct PointLight{
+	vec3 position;
+	float radius;
+	vec4 color;
+};
+uniform PointLight _PointLights[MAX_POINT_LIGHTS];
+
+//Every light has to contribute or the compiler strips the array
+void main(){
+	vec3 light = vec3(0);
+	for(int i = 0; i < MAX_POINT_LIGHTS; i++){
+		float d = distance(_PointLights[i].position, vec3(UV,0));
+		light += _PointLights[i].color.rgb * max(_PointLights[i].radius - d, 0.0);
+	}
+	FragColor = vec4(light,1.0);
+}
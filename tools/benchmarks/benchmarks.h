@@ -0,0 +1,55 @@
+#pragma once
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+//Runs fn iterations times and returns the average time per iteration in microseconds
+template<typename Fn>
+double measureMicroseconds(int iterations, Fn fn) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		fn();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+//Every benchmark with random inputs seeds the same way, so runs are repeatable
+inline void seedRandom() {
+	srand(1234);
+}
+inline float randomRange(float min, float max) {
+	return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+//Failed correctness checks so far. coreBenchmarks exits with 1 if there are any
+inline int& getNumFailedChecks() {
+	static int numFailed = 0;
+	return numFailed;
+}
+//Counts a failed check and passes the result through, so it can sit in the line that prints it
+inline bool check(bool passed) {
+	if (!passed) {
+		getNumFailedChecks()++;
+	}
+	return passed;
+}
+
+//Benchmarks that need a GL context expect one to be current
+void runUniformBenchmark();
+void runLightCullingBenchmark();
+void runPackingBenchmark();
+void runFrustumCullingBenchmark();
+void runMeshCacheBenchmark();
+void runTextureLoadingBenchmark();
+void runMeshOptimizerBenchmark();
+void runLodBenchmark();
+void runGeometryArenaBenchmark();
+void runInstanceCullingBenchmark();
+void runOcclusionBenchmark();
+void runProcGenBenchmark();
+void runTerrainBenchmark();
+void runShadowCascadesBenchmark();
+void runShaderCacheBenchmark();
+void runShaderBatchBenchmark();
+void runGpuProfilerBenchmark();
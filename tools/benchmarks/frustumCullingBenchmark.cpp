@@ -0,0 +1,57 @@
+#include <stdlib.h>
+#include <vector>
+
+#include <ew/frustum.h>
+#include <ew/camera.h>
+
+#include "benchmarks.h"
+
+/// <summary>
+/// Culls 100k random bounding spheres against a camera frustum, one sphere at a time from an
+/// array of structs and in batches from SoA arrays, and checks both agree.
+/// </summary>
+void runFrustumCullingBenchmark() {
+	const int NUM_INSTANCES = 100000;
+	const int ITERATIONS = 100;
+	seedRandom();
+
+	std::vector<ew::BoundingSphere> spheres(NUM_INSTANCES);
+	ew::SphereBoundsSoA bounds;
+	for (ew::BoundingSphere& sphere : spheres) {
+		sphere.center = glm::vec3(randomRange(-200, 200), randomRange(-20, 20), randomRange(-200, 200));
+		sphere.radius = randomRange(0.5f, 5.0f);
+		bounds.push_back(sphere);
+	}
+
+	ew::Camera camera;
+	camera.position = glm::vec3(0, 10, 0);
+	camera.target = glm::vec3(50, 0, 50);
+	camera.aspectRatio = 16.0f / 9.0f;
+	ew::Frustum frustum = ew::extractFrustum(camera.projectionMatrix() * camera.viewMatrix());
+
+	std::vector<unsigned int> scalarVisible(NUM_INSTANCES);
+	std::vector<unsigned int> batchVisible(NUM_INSTANCES);
+	int numScalarVisible = 0;
+	int numBatchVisible = 0;
+
+	double scalarTime = measureMicroseconds(ITERATIONS, [&]() {
+		numScalarVisible = 0;
+		for (int i = 0; i < NUM_INSTANCES; i++) {
+			if (ew::frustumIntersectsSphere(frustum, spheres[i].center, spheres[i].radius)) {
+				scalarVisible[numScalarVisible++] = i;
+			}
+		}
+	});
+	double batchTime = measureMicroseconds(ITERATIONS, [&]() {
+		numBatchVisible = ew::cullSpheres(frustum, bounds, batchVisible.data());
+	});
+
+	bool match = numScalarVisible == numBatchVisible;
+	for (int i = 0; match && i < numBatchVisible; i++) {
+		match = scalarVisible[i] == batchVisible[i];
+	}
+	printf("%d instances, %d visible\n", NUM_INSTANCES, numBatchVisible);
+	printf("AoS, one at a time: %8.1f us\n", scalarTime);
+	printf("SoA, batched:       %8.1f us (%.2fx)\n", batchTime, scalarTime / batchTime);
+	printf("Results %s\n", check(match) ? "match" : "DIFFER");
+}
@@ -0,0 +1,106 @@
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/geometryArena.h>
+#include <ew/procGen.h>
+#include <ew/shader.h>
+#include <ew/instanceBuffer.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "benchmarks.h"
+
+//Reads back the color attachment of the bound framebuffer
+static std::vector<unsigned char> readPixels(int width, int height) {
+	std::vector<unsigned char> pixels(width * height * 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	return pixels;
+}
+
+/// <summary>
+/// Draws 512 different meshes once each as one draw call per ew::Mesh and as a single GeometryArena multi-draw,
+/// and checks both images match. The arena's allocator is checked without GL by coreChecks.
+/// </summary>
+void runGeometryArenaBenchmark() {
+	const int GRID = 8;
+	const int NUM_MESHES = GRID * GRID * GRID;
+	const int ITERATIONS = 20;
+	const int SIZE = 256;
+	std::vector<ew::Mesh> meshes(NUM_MESHES);
+	std::vector<int> handles(NUM_MESHES);
+	std::vector<glm::mat4> transforms(NUM_MESHES);
+	ew::GeometryArena arena(1 << 20, 1 << 22);
+	for (int i = 0; i < NUM_MESHES; i++) {
+		int subdivisions = 4 + i % 13;
+		ew::MeshData meshData = i % 3 == 0 ? ew::createSphere(0.4f, subdivisions)
+			: i % 3 == 1 ? ew::createCylinder(0.3f, 0.6f, subdivisions) : ew::createPlane(0.6f, 0.6f, subdivisions);
+		meshes[i].load(meshData);
+		handles[i] = arena.add(meshData);
+		transforms[i] = glm::translate(glm::mat4(1.0f), glm::vec3(i % GRID, (i / GRID) % GRID, i / (GRID * GRID)) - glm::vec3(GRID / 2));
+	}
+	//Churn: removing and re-adding a few meshes reuses their ranges
+	for (int i = 0; i < NUM_MESHES; i += 7) {
+		ew::MeshData meshData = i % 3 == 0 ? ew::createSphere(0.4f, 4 + i % 13)
+			: i % 3 == 1 ? ew::createCylinder(0.3f, 0.6f, 4 + i % 13) : ew::createPlane(0.6f, 0.6f, 4 + i % 13);
+		arena.remove(handles[i]);
+		handles[i] = arena.add(meshData);
+	}
+
+	unsigned int fbo, colorBuffer, depthBuffer;
+	glCreateFramebuffers(1, &fbo);
+	glCreateTextures(GL_TEXTURE_2D, 1, &colorBuffer);
+	glTextureStorage2D(colorBuffer, 1, GL_RGBA8, SIZE, SIZE);
+	glCreateRenderbuffers(1, &depthBuffer);
+	glNamedRenderbufferStorage(depthBuffer, GL_DEPTH_COMPONENT24, SIZE, SIZE);
+	glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, colorBuffer, 0);
+	glNamedFramebufferRenderbuffer(fbo, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, SIZE, SIZE);
+	glEnable(GL_DEPTH_TEST);
+
+	ew::Shader shader = ew::Shader("assets/arenaBench.vert", "assets/arenaBench.frag");
+	shader.use();
+	glm::mat4 view = glm::lookAt(glm::vec3(10, 8, 12), glm::vec3(0), glm::vec3(0, 1, 0));
+	shader.setMat4("_ViewProjection", glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f) * view);
+	ew::InstanceBuffer instanceBuffer(transforms);
+	instanceBuffer.bind(0);
+
+	//Per mesh draws pick their transform with _InstanceOffset, the arena with each command's baseInstance
+	ew::UniformLocation instanceOffset = shader.getUniformLocation("_InstanceOffset");
+	double perMesh = measureMicroseconds(ITERATIONS, [&]() {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		for (int i = 0; i < NUM_MESHES; i++) {
+			shader.setInt(instanceOffset, i);
+			meshes[i].draw();
+		}
+		glFinish();
+	});
+	std::vector<unsigned char> perMeshPixels = readPixels(SIZE, SIZE);
+
+	std::vector<ew::DrawElementsIndirectCommand> commands;
+	double multiDraw = measureMicroseconds(ITERATIONS, [&]() {
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		shader.setInt(instanceOffset, 0);
+		commands.clear();
+		for (int i = 0; i < NUM_MESHES; i++) {
+			arena.addDrawCommand(commands, handles[i], 0, 1, i);
+		}
+		arena.draw(commands);
+		glFinish();
+	});
+	std::vector<unsigned char> multiDrawPixels = readPixels(SIZE, SIZE);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	glDisable(GL_DEPTH_TEST);
+
+	const ew::RangeAllocator& vertices = arena.getVertexAllocator();
+	printf("%d meshes, arena holds %u vertices in %d free blocks\n", NUM_MESHES, vertices.getUsed(), vertices.getNumFreeBlocks());
+	printf("  one draw per Mesh:      %8.1f us\n", perMesh);
+	printf("  one multi-draw indirect: %8.1f us\n", multiDraw);
+	printf("  images %s\n", check(perMeshPixels == multiDrawPixels) ? "match" : "DIFFER");
+	unsigned int usedVertices = vertices.getUsed();
+	bool emptyRejected = arena.add(ew::MeshData()) == -1 && vertices.getUsed() == usedVertices;
+	printf("  empty mesh %s\n", check(emptyRejected) ? "rejected" : "ADDED");
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/gpuProfiler.h>
+
+#include "benchmarks.h"
+
+/// <summary>
+/// Profiles frames of nested scopes around clears of a 2048x2048 target. Checks that scopes nest inside their parents
+/// and their frame, that reading results back never drops a frame at the normal latency, and what a scope costs the CPU.
+/// Then writes the history as a Chrome trace.
+/// </summary>
+void runGpuProfilerBenchmark() {
+	const int NUM_FRAMES = 100;
+	const int SIZE = 2048;
+	const char* TRACE_PATH = "gpuProfilerTrace.json";
+
+	ew::GpuProfiler profiler;
+	if (!profiler.create()) {
+		printf("Timer queries unavailable, every profiler call is a no-op\n");
+		return;
+	}
+	//CPU cost of a scope, filling frames of a second profiler. Queries are slower the first time they're used,
+	//so the first round of frames doesn't count
+	ew::GpuProfiler costProfiler;
+	costProfiler.create();
+	double scopeTime = 0.0;
+	for (int i = 0; i < ew::GPU_PROFILER_FRAMES + 16; i++) {
+		costProfiler.beginFrame();
+		double time = measureMicroseconds(ew::MAX_GPU_SCOPES, [&]() {
+			costProfiler.beginScope("Scope");
+			costProfiler.endScope();
+		});
+		scopeTime += i < ew::GPU_PROFILER_FRAMES ? 0.0 : time / 16.0;
+		costProfiler.endFrame();
+	}
+
+	unsigned int texture, fbo;
+	glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+	glTextureStorage2D(texture, 1, GL_RGBA8, SIZE, SIZE);
+	glCreateFramebuffers(1, &fbo);
+	glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, texture, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, SIZE, SIZE);
+
+	for (int frame = 0; frame < NUM_FRAMES; frame++) {
+		profiler.beginFrame();
+		profiler.beginScope("Clears");
+		for (int i = 0; i < 4; i++) {
+			profiler.beginScope("Clear");
+			glClearColor(i * 0.25f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+			profiler.endScope();
+		}
+		profiler.endScope();
+		profiler.beginScope("Empty");
+		profiler.endScope();
+		profiler.endFrame();
+	}
+	//Lets the last frames in flight resolve
+	glFinish();
+	for (int i = 0; i < ew::GPU_PROFILER_FRAMES; i++) {
+		profiler.beginFrame();
+		profiler.endFrame();
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &texture);
+
+	bool nested = true;
+	int numScopes = 0;
+	for (const ew::GpuFrameTiming& frame : profiler.getHistory()) {
+		for (const ew::GpuScopeTiming& scope : frame.scopes) {
+			uint64_t parentBegin = scope.parent < 0 ? frame.begin : frame.scopes[scope.parent].begin;
+			uint64_t parentEnd = scope.parent < 0 ? frame.end : frame.scopes[scope.parent].end;
+			nested &= scope.begin <= scope.end && scope.begin >= parentBegin && scope.end <= parentEnd;
+			numScopes++;
+		}
+	}
+	std::vector<float> clears, frames;
+	profiler.getScopeHistory("Clear", &clears);
+	profiler.getFrameHistory(&frames);
+	float averageClears = 0.0f, averageFrame = 0.0f;
+	for (size_t i = 0; i < frames.size(); i++) {
+		averageClears += clears[i] / frames.size();
+		averageFrame += frames[i] / frames.size();
+	}
+	printf("%d frames, %d resolved with %d scopes, %d dropped\n", NUM_FRAMES + ew::GPU_PROFILER_FRAMES,
+		(int)profiler.getHistory().size(), numScopes, profiler.getNumDroppedFrames());
+	printf("  GPU frame %.3f ms, 4 clears %.3f ms\n", averageFrame, averageClears);
+	printf("  Scopes %s\n", check(nested) ? "nest inside their parents" : "DO NOT NEST");
+	printf("  beginScope + endScope: %.3f us\n", scopeTime);
+
+	if (profiler.writeChromeTrace(TRACE_PATH)) {
+		printf("  Wrote a trace of %d frames to %s\n", (int)profiler.getHistory().size(), TRACE_PATH);
+	}
+}
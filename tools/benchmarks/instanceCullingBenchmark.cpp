@@ -0,0 +1,91 @@
+#include <stdlib.h>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/instanceCulling.h>
+#include <ew/meshCache.h>
+
+#include "benchmarks.h"
+
+static bool sameResult(const ew::CullResult& a, const ew::CullResult& b) {
+	if (a.numVisible != b.numVisible || a.commands.size() != b.commands.size() || a.instanceIds != b.instanceIds) {
+		return false;
+	}
+	for (size_t c = 0; c < a.commands.size(); c++) {
+		if (a.commands[c].instanceCount != b.commands[c].instanceCount || a.commands[c].baseInstance != b.commands[c].baseInstance
+			|| a.commands[c].count != b.commands[c].count || a.commands[c].firstIndex != b.commands[c].firstIndex) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Culls 100k instances of 16 mesh types with 4 LODs each, on the CPU with ew::cullInstances and on the GPU
+/// with instanceCull.comp (from assignment3's assets, which share bin/assets), and checks the outputs are identical.
+/// </summary>
+void runInstanceCullingBenchmark() {
+	const int NUM_INSTANCES = 100000;
+	const int NUM_MESH_TYPES = 16;
+	const int ITERATIONS = 20;
+	seedRandom();
+
+	ew::CullScene scene;
+	for (int type = 0; type < NUM_MESH_TYPES; type++) {
+		float errors[ew::MAX_CULL_LODS] = { 0.0f, 0.01f, 0.04f, 0.16f };
+		unsigned int meshType = scene.addMeshType(errors, 1 + type % ew::MAX_CULL_LODS, randomRange(0.5f, 2.0f));
+		for (int lod = 0; lod < scene.meshTypes[meshType].numLods; lod++) {
+			//Two meshes per type, like a Model with two sub-meshes
+			for (int mesh = 0; mesh < 2; mesh++) {
+				unsigned int count = 3 * (1000 >> lod);
+				scene.addCommand({ count, 0, (unsigned int)(type * 10000 + lod * 1000 + mesh), 0, 0 }, meshType, lod);
+			}
+		}
+	}
+	for (int i = 0; i < NUM_INSTANCES; i++) {
+		ew::BoundingSphere sphere;
+		sphere.center = glm::vec3(randomRange(-200, 200), randomRange(-20, 20), randomRange(-200, 200));
+		sphere.radius = scene.meshTypes[i % NUM_MESH_TYPES].radius * randomRange(0.5f, 3.0f);
+		scene.addInstance(rand() % NUM_MESH_TYPES, sphere);
+	}
+
+	ew::Camera camera;
+	camera.position = glm::vec3(0, 10, 0);
+	camera.target = glm::vec3(50, 0, 50);
+	camera.aspectRatio = 16.0f / 9.0f;
+	ew::Frustum frustum = ew::extractFrustum(camera.projectionMatrix() * camera.viewMatrix());
+	ew::LodSelector lodSelector = ew::createLodSelector(camera, 1080.0f);
+
+	ew::CullResult cpuResult;
+	double cpuTime = measureMicroseconds(ITERATIONS, [&]() {
+		ew::cullInstances(scene, &frustum, &lodSelector, &cpuResult);
+	});
+	printf("%d instances, %d commands, %d visible\n", NUM_INSTANCES, (int)scene.commands.size(), cpuResult.numVisible);
+	printf("  CPU reference:   %8.1f us\n", cpuTime);
+
+	const char* shaderPath = "assets/instanceCull.comp";
+	if (ew::hashFile(shaderPath) == 0) {
+		printf("%s not found, build assignment3 to copy it into bin/assets\n", shaderPath);
+		return;
+	}
+	ew::Shader cullShader = ew::Shader(shaderPath);
+	ew::GpuInstanceCuller culler;
+	culler.upload(scene);
+	bool identical = true;
+	//Every combination of culling and LOD selection, including none at all
+	for (int mode = 0; mode < 4; mode++) {
+		const ew::Frustum* modeFrustum = mode & 1 ? &frustum : nullptr;
+		const ew::LodSelector* modeSelector = mode & 2 ? &lodSelector : nullptr;
+		ew::CullResult reference, gpuResult;
+		ew::cullInstances(scene, modeFrustum, modeSelector, &reference);
+		culler.cull(cullShader, modeFrustum, modeSelector);
+		culler.download(&gpuResult);
+		identical &= sameResult(reference, gpuResult);
+	}
+	double gpuTime = measureMicroseconds(ITERATIONS, [&]() {
+		culler.cull(cullShader, &frustum, &lodSelector);
+		glFinish();
+	});
+	printf("  GPU compute:     %8.1f us\n", gpuTime);
+	printf("  GPU output %s the CPU reference\n", check(identical) ? "matches" : "DIFFERS FROM");
+}
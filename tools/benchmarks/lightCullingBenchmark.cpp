@@ -0,0 +1,50 @@
+#include <stdlib.h>
+#include <vector>
+
+#include <ew/lightCulling.h>
+
+#include "benchmarks.h"
+
+/// <summary>
+/// Times ew::cullLightsTiled for random camera/light setups. coreChecks checks the tile lists it builds.
+/// </summary>
+void runLightCullingBenchmark() {
+	const int SCREEN_WIDTH = 1920;
+	const int SCREEN_HEIGHT = 1080;
+	const int TILE_SIZE = 16;
+	const int MAX_LIGHTS_PER_TILE = 1024;
+	const int NUM_CONFIGS = 8;
+	int lightCounts[] = { 256, 1024, 4096 };
+	seedRandom();
+
+	for (int numLights : lightCounts) {
+		ew::LightGrid grid;
+		double totalTime = 0.0;
+		size_t totalAssignments = 0;
+		for (int config = 0; config < NUM_CONFIGS; config++) {
+			std::vector<ew::PointLight> lights(numLights);
+			for (ew::PointLight& light : lights) {
+				light.position = glm::vec3(randomRange(-100, 100), randomRange(-5, 5), randomRange(-100, 100));
+				light.radius = randomRange(1, 15);
+				light.color = glm::vec4(1);
+			}
+			ew::Camera camera;
+			camera.position = glm::vec3(randomRange(-50, 50), randomRange(1, 30), randomRange(-50, 50));
+			camera.target = glm::vec3(randomRange(-50, 50), 0, randomRange(-50, 50));
+			camera.fov = randomRange(40, 90);
+			camera.orthographic = config % 4 == 3;
+			camera.orthoHeight = 40.0f;
+			camera.aspectRatio = (float)SCREEN_WIDTH / SCREEN_HEIGHT;
+
+			totalTime += measureMicroseconds(1, [&]() {
+				ew::cullLightsTiled(lights.data(), numLights, camera, SCREEN_WIDTH, SCREEN_HEIGHT, TILE_SIZE, MAX_LIGHTS_PER_TILE, &grid);
+			});
+			for (unsigned int count : grid.lightCounts) {
+				totalAssignments += count;
+			}
+		}
+		int numTiles = ((SCREEN_WIDTH + TILE_SIZE - 1) / TILE_SIZE) * ((SCREEN_HEIGHT + TILE_SIZE - 1) / TILE_SIZE);
+		printf("%5d lights: %8.1f us per cull, %6.1f lights per tile\n",
+			numLights, totalTime / NUM_CONFIGS, (double)totalAssignments / (NUM_CONFIGS * numTiles));
+	}
+}
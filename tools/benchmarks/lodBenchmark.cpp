@@ -0,0 +1,52 @@
+#include <stdio.h>
+
+#include <ew/procGen.h>
+#include <ew/meshOptimizer.h>
+#include <ew/meshSimplifier.h>
+#include <ew/model.h>
+#include <ew/meshCache.h>
+#include <ew/lod.h>
+
+#include "benchmarks.h"
+
+//Generates a LOD chain and reports each level's error next to a brute force measurement of it
+static void reportLods(const char* name, ew::MeshData meshData) {
+	ew::optimizeMesh(meshData);
+	double time = measureMicroseconds(1, [&]() {
+		ew::generateLods(meshData);
+	});
+	printf("%s: %d vertices, %d LODs in %.1f ms\n", name, (int)meshData.vertices.size(), (int)meshData.lods.size(), time / 1000.0);
+	for (const ew::MeshLod& lod : meshData.lods) {
+		float measured = ew::measureSimplificationError(meshData.vertices.data(), meshData.indices.data(), meshData.lods[0].numIndices,
+			meshData.indices.data() + lod.firstIndex, lod.numIndices);
+		ew::VertexCacheStats stats = ew::analyzeVertexCache(meshData.indices.data() + lod.firstIndex, lod.numIndices, meshData.vertices.size());
+		printf("  %6u triangles  error %.5f  measured %.5f  ACMR %.3f\n", lod.numIndices / 3, lod.error, measured, stats.acmr);
+	}
+}
+
+/// <summary>
+/// LOD chain generation on procedural meshes (coreChecks checks their errors are upper bounds),
+/// then the LODs Suzanne gets on import and the distances they switch at for a 720p, 60 degree camera.
+/// </summary>
+void runLodBenchmark() {
+	reportLods("sphere", ew::createSphere(1.0f, 64));
+	reportLods("cylinder", ew::createCylinder(1.0f, 2.0f, 64));
+	reportLods("plane", ew::createPlane(10.0f, 10.0f, 64));
+	printf("\n");
+
+	const char* modelPath = "assets/Suzanne.obj";
+	if (ew::hashFile(modelPath) == 0) {
+		printf("%s not found, build assignment3 to copy it into bin/assets\n", modelPath);
+		return;
+	}
+	ew::Model model(modelPath, false);
+	ew::Camera camera;
+	camera.fov = 60.0f;
+	ew::LodSelector selector = ew::createLodSelector(camera, 720.0f);
+	for (int i = 0; i < model.getNumLods(); i++) {
+		//getMaxLodError grows linearly with distance from the bounds
+		ew::BoundingSphere atUnitDistance = { camera.position + glm::vec3(0, 0, -1.0f - model.getBoundingSphere().radius), model.getBoundingSphere().radius };
+		float errorPerUnit = ew::getMaxLodError(selector, atUnitDistance);
+		printf("Suzanne LOD %d: error %.4f, used from %.1f units\n", i, model.getLodError(i), model.getLodError(i) / errorPerUnit);
+	}
+}
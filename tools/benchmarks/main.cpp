@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <ew/external/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "benchmarks.h"
+
+struct Benchmark {
+	const char* name;
+	void (*run)();
+};
+
+Benchmark benchmarks[] = {
+	{ "uniforms", runUniformBenchmark },
+	{ "lightCulling", runLightCullingBenchmark },
+	{ "packing", runPackingBenchmark },
+	{ "frustumCulling", runFrustumCullingBenchmark },
+	{ "meshCache", runMeshCacheBenchmark },
+	{ "textureLoading", runTextureLoadingBenchmark },
+	{ "meshOptimizer", runMeshOptimizerBenchmark },
+	{ "lod", runLodBenchmark },
+	{ "geometryArena", runGeometryArenaBenchmark },
+	{ "instanceCulling", runInstanceCullingBenchmark },
+	{ "occlusion", runOcclusionBenchmark },
+	{ "procGen", runProcGenBenchmark },
+	{ "terrain", runTerrainBenchmark },
+	{ "shadowCascades", runShadowCascadesBenchmark },
+	{ "shaderCache", runShaderCacheBenchmark },
+	{ "shaderBatch", runShaderBatchBenchmark },
+	{ "gpuProfiler", runGpuProfilerBenchmark },
+};
+
+/// <summary>
+/// Creates a hidden window so GL benchmarks have a context to run in
+/// </summary>
+GLFWwindow* initHiddenWindow() {
+	if (!glfwInit()) {
+		printf("GLFW failed to init!\n");
+		return nullptr;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "Benchmarks", NULL, NULL);
+	if (window == NULL) {
+		printf("GLFW failed to create window\n");
+		return nullptr;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGL(glfwGetProcAddress)) {
+		printf("GLAD Failed to load GL headers\n");
+		return nullptr;
+	}
+	return window;
+}
+
+//Usage: coreBenchmarks [name...]
+//Runs every benchmark when no names are given. Run from the bin directory so assets/ resolves.
+//Exits with 1 if any correctness check failed.
+int main(int argc, char** argv) {
+	if (initHiddenWindow() == nullptr) {
+		return 1;
+	}
+	printf("GL_RENDERER: %s\n", glGetString(GL_RENDERER));
+	for (const Benchmark& benchmark : benchmarks) {
+		bool selected = argc <= 1;
+		for (int i = 1; i < argc; i++) {
+			selected |= strcmp(argv[i], benchmark.name) == 0;
+		}
+		if (selected) {
+			printf("\n[%s]\n", benchmark.name);
+			benchmark.run();
+		}
+	}
+	glfwTerminate();
+	if (getNumFailedChecks() > 0) {
+		printf("\n%d checks FAILED\n", getNumFailedChecks());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,33 @@
+#include <stdio.h>
+
+#include <ew/model.h>
+#include <ew/meshCache.h>
+
+#include "benchmarks.h"
+
+/// <summary>
+/// Compares importing a model with Assimp against loading it from the binary mesh cache.
+/// Both times include the GPU upload. Suzanne.obj comes from assignment3's assets, which share bin/assets.
+/// </summary>
+void runMeshCacheBenchmark() {
+	const char* modelPath = "assets/Suzanne.obj";
+	const int ITERATIONS = 20;
+	if (ew::hashFile(modelPath) == 0) {
+		printf("%s not found, build assignment3 to copy it into bin/assets\n", modelPath);
+		return;
+	}
+
+	double importTime = measureMicroseconds(ITERATIONS, [&]() {
+		ew::Model model(modelPath, false);
+	});
+	//First cached load writes the cache if it's missing or stale
+	ew::Model warmup(modelPath);
+	double cachedTime = measureMicroseconds(ITERATIONS, [&]() {
+		ew::Model model(modelPath);
+	});
+	double hashTime = measureMicroseconds(ITERATIONS, [&]() {
+		ew::hashFile(modelPath);
+	});
+	printf("Assimp import: %10.1f us\n", importTime);
+	printf("Mesh cache:    %10.1f us (%.1fx), %.1f us of that hashing the source\n", cachedTime, importTime / cachedTime, hashTime);
+}
@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include <ew/procGen.h>
+#include <ew/meshOptimizer.h>
+
+#include "benchmarks.h"
+
+static void shuffleTriangles(ew::MeshData& meshData) {
+	int numTriangles = (int)meshData.indices.size() / 3;
+	for (int t = numTriangles - 1; t > 0; t--) {
+		int other = rand() % (t + 1);
+		for (int k = 0; k < 3; k++) {
+			std::swap(meshData.indices[t * 3 + k], meshData.indices[other * 3 + k]);
+		}
+	}
+}
+
+//Rotates a triangle so its smallest index comes first, keeping the winding
+static void canonicalTriangle(unsigned int a, unsigned int b, unsigned int c, std::vector<unsigned int>& out) {
+	if (b < a && b < c) {
+		std::swap(a, b);
+		std::swap(b, c);
+	}
+	else if (c < a && c < b) {
+		std::swap(a, c);
+		std::swap(b, c);
+	}
+	out.push_back(a);
+	out.push_back(b);
+	out.push_back(c);
+}
+
+//Decodes strips back into triangles the way GL_TRIANGLE_STRIP with primitive restart does
+static std::vector<unsigned int> stripsToTriangles(const std::vector<unsigned int>& strips) {
+	std::vector<unsigned int> triangles;
+	size_t start = 0;
+	for (size_t i = 0; i <= strips.size(); i++) {
+		if (i < strips.size() && strips[i] != ew::STRIP_RESTART_INDEX) {
+			continue;
+		}
+		for (size_t n = 0; start + n + 2 < i; n++) {
+			const unsigned int* v = &strips[start + n];
+			if (n % 2 == 0) {
+				canonicalTriangle(v[0], v[1], v[2], triangles);
+			}
+			else {
+				canonicalTriangle(v[1], v[0], v[2], triangles);
+			}
+		}
+		start = i + 1;
+	}
+	return triangles;
+}
+
+//Sorted list of canonical triangles, for comparing triangle sets regardless of order
+static std::vector<unsigned int> sortTriangles(const std::vector<unsigned int>& triangles) {
+	std::vector<unsigned int> canonical;
+	for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+		canonicalTriangle(triangles[t], triangles[t + 1], triangles[t + 2], canonical);
+	}
+	std::vector<size_t> order(canonical.size() / 3);
+	for (size_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return std::lexicographical_compare(&canonical[a * 3], &canonical[a * 3 + 3], &canonical[b * 3], &canonical[b * 3 + 3]);
+	});
+	std::vector<unsigned int> sorted;
+	for (size_t i : order) {
+		sorted.insert(sorted.end(), &canonical[i * 3], &canonical[i * 3 + 3]);
+	}
+	return sorted;
+}
+
+//Optimizes a copy and checks it still has the same triangles once its indices are mapped back through the vertex remap.
+//Shuffled inputs must not come out with a worse ACMR
+static void reportOptimization(const char* name, const ew::MeshData& original, bool shuffled) {
+	ew::MeshData meshData = original;
+	ew::MeshOptimizationStats stats;
+	std::vector<unsigned int> remap;
+	double time = measureMicroseconds(1, [&]() {
+		stats = ew::optimizeMesh(meshData, &remap);
+	});
+	std::vector<unsigned int> originalVertices(meshData.vertices.size());
+	bool preserved = remap.size() == original.vertices.size();
+	for (size_t v = 0; preserved && v < remap.size(); v++) {
+		if (remap[v] != ew::UNUSED_VERTEX) {
+			preserved = remap[v] < meshData.vertices.size() && memcmp(&meshData.vertices[remap[v]], &original.vertices[v], sizeof(ew::Vertex)) == 0;
+			if (preserved) {
+				originalVertices[remap[v]] = (unsigned int)v;
+			}
+		}
+	}
+	std::vector<unsigned int> mapped;
+	for (unsigned int index : meshData.indices) {
+		mapped.push_back(originalVertices[index]);
+	}
+	preserved = preserved && sortTriangles(mapped) == sortTriangles(original.indices);
+	bool improved = !shuffled || stats.after.acmr <= stats.before.acmr;
+	printf("%-18s %7d tris  ACMR %.3f -> %.3f%s  ATVR %.3f -> %.3f  %8.1f us  %s\n", name, (int)meshData.indices.size() / 3,
+		stats.before.acmr, stats.after.acmr, check(improved) ? "" : " (WORSE)", stats.before.atvr, stats.after.atvr, time,
+		check(preserved) ? "same triangles" : "TRIANGLES CHANGED");
+}
+
+static void reportIndexBuffers(const char* name, ew::MeshData meshData) {
+	ew::optimizeMesh(meshData);
+	std::vector<unsigned int> strips;
+	double time = measureMicroseconds(1, [&]() {
+		strips = ew::generateTriangleStrips(meshData.indices.data(), meshData.indices.size(), meshData.vertices.size());
+	});
+	int indexSize = ew::getIndexSize(meshData.vertices.size());
+	bool preserved = sortTriangles(stripsToTriangles(strips)) == sortTriangles(meshData.indices);
+	ew::VertexCacheStats listStats = ew::analyzeVertexCache(meshData.indices.data(), meshData.indices.size(), meshData.vertices.size());
+	printf("%-18s %6d verts  %d byte indices  list %8d -> %8d bytes  strip %8d bytes (%.2f indices/tri, ACMR %.3f, %s)  %8.1f us\n", name,
+		(int)meshData.vertices.size(), indexSize, (int)meshData.indices.size() * 4, (int)meshData.indices.size() * indexSize, (int)strips.size() * indexSize,
+		(float)strips.size() / (meshData.indices.size() / 3), listStats.acmr, check(preserved) ? "same triangles" : "TRIANGLES CHANGED", time);
+}
+
+/// <summary>
+/// Runs ew::optimizeMesh on procedural meshes, both in generated order and with triangles shuffled
+/// to stand in for badly ordered imported meshes, and checks the triangles survive. Cache stats use a 16 entry FIFO.
+/// Then compares index buffer sizes of triangle lists and generated strips.
+/// </summary>
+void runMeshOptimizerBenchmark() {
+	seedRandom();
+	ew::MeshData sphere = ew::createSphere(1.0f, 128);
+	ew::MeshData plane = ew::createPlane(10.0f, 10.0f, 256);
+	reportOptimization("sphere", sphere, false);
+	reportOptimization("plane", plane, false);
+	shuffleTriangles(sphere);
+	shuffleTriangles(plane);
+	reportOptimization("sphere (shuffled)", sphere, true);
+	reportOptimization("plane (shuffled)", plane, true);
+
+	//Index buffer size as 32 bit lists vs narrowed strips, after optimizeMesh
+	printf("\n");
+	reportIndexBuffers("plane 5", ew::createPlane(10.0f, 10.0f, 5));
+	reportIndexBuffers("sphere 8", ew::createSphere(1.0f, 8));
+	reportIndexBuffers("sphere 64", ew::createSphere(1.0f, 64));
+	reportIndexBuffers("plane 256", plane);
+}
@@ -0,0 +1,133 @@
+#include <string.h>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/occlusion.h>
+#include <ew/instanceCulling.h>
+#include <ew/camera.h>
+#include <ew/procGen.h>
+#include <ew/meshCache.h>
+
+#include "benchmarks.h"
+
+static bool samePyramid(const ew::HiZPyramid& a, const ew::HiZPyramid& b) {
+	if (a.getNumLevels() != b.getNumLevels()) {
+		return false;
+	}
+	for (int level = 0; level < a.getNumLevels(); level++) {
+		if (a.sizes[level] != b.sizes[level]
+			|| memcmp(a.levels[level].data(), b.levels[level].data(), sizeof(float) * a.levels[level].size()) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool sameResult(const ew::CullResult& a, const ew::CullResult& b) {
+	if (a.numVisible != b.numVisible || a.instanceIds != b.instanceIds || a.commands.size() != b.commands.size()) {
+		return false;
+	}
+	for (size_t c = 0; c < a.commands.size(); c++) {
+		if (a.commands[c].instanceCount != b.commands[c].instanceCount || a.commands[c].baseInstance != b.commands[c].baseInstance) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Software rasterizes a 64x64 grid of spheres seen from just above the ground, builds its Hi-Z pyramid on the CPU
+/// and with hiZ.comp, then occlusion culls the same spheres with ew::cullInstances and instanceCull.comp.
+/// Both pyramids and both cull results must be bit identical. Shaders come from assignment3's assets.
+/// </summary>
+void runOcclusionBenchmark() {
+	const int GRID_SIZE = 64;
+	const int WIDTH = 512;
+	const int HEIGHT = 288;
+	const int ITERATIONS = 20;
+
+	ew::MeshData sphere = ew::createSphere(1.0f, 8);
+	ew::CullScene scene;
+	float lodError = 0.0f;
+	unsigned int meshType = scene.addMeshType(&lodError, 1, 1.0f);
+	scene.addCommand({ (unsigned int)sphere.indices.size(), 0, 0, 0, 0 }, meshType, 0);
+	std::vector<glm::mat4> transforms;
+	for (int z = 0; z < GRID_SIZE; z++) {
+		for (int x = 0; x < GRID_SIZE; x++) {
+			float scale = 0.6f + 0.4f * ((x * 7 + z * 13) % 5) / 4.0f;
+			glm::vec3 position = glm::vec3((x - GRID_SIZE / 2) * 3.0f, scale, z * 3.0f);
+			glm::mat4 transform = glm::mat4(scale);
+			transform[3] = glm::vec4(position, 1.0f);
+			transforms.push_back(transform);
+			scene.addInstance(meshType, { position, scale });
+		}
+	}
+
+	ew::Camera camera;
+	camera.position = glm::vec3(0, 1.5f, -6.0f);
+	camera.target = glm::vec3(0, 1.0f, 50.0f);
+	camera.aspectRatio = (float)WIDTH / HEIGHT;
+	glm::mat4 viewProjection = camera.projectionMatrix() * camera.viewMatrix();
+	ew::Frustum frustum = ew::extractFrustum(viewProjection);
+
+	ew::DepthBuffer depthBuffer;
+	double rasterTime = measureMicroseconds(1, [&]() {
+		ew::clearDepthBuffer(&depthBuffer, WIDTH, HEIGHT);
+		for (const glm::mat4& transform : transforms) {
+			ew::rasterizeDepth(&depthBuffer, viewProjection * transform, sphere.vertices.data(), sphere.indices.data(), sphere.indices.size());
+		}
+	});
+	ew::HiZPyramid cpuPyramid;
+	double buildTime = measureMicroseconds(ITERATIONS, [&]() {
+		ew::buildHiZ(depthBuffer.depth.data(), WIDTH, HEIGHT, viewProjection, &cpuPyramid);
+	});
+	ew::CullResult frustumResult, occlusionResult;
+	ew::cullInstances(scene, &frustum, nullptr, &frustumResult);
+	double cullTime = measureMicroseconds(ITERATIONS, [&]() {
+		ew::cullInstances(scene, &frustum, nullptr, &occlusionResult, &cpuPyramid);
+	});
+	printf("%d spheres, %dx%d depth, %d in the frustum, %d not occluded\n", GRID_SIZE * GRID_SIZE, WIDTH, HEIGHT,
+		frustumResult.numVisible, occlusionResult.numVisible);
+	printf("  Software rasterization: %8.1f us\n", rasterTime);
+	printf("  CPU Hi-Z build:         %8.1f us\n", buildTime);
+	printf("  CPU occlusion cull:     %8.1f us\n", cullTime);
+
+	const char* hiZPath = "assets/hiZ.comp";
+	const char* cullPath = "assets/instanceCull.comp";
+	if (ew::hashFile(hiZPath) == 0 || ew::hashFile(cullPath) == 0) {
+		printf("%s or %s not found, build assignment3 to copy them into bin/assets\n", hiZPath, cullPath);
+		return;
+	}
+	//The software depth stands in for a rendered depth buffer, so both sides start from the same values
+	unsigned int depthTexture;
+	glCreateTextures(GL_TEXTURE_2D, 1, &depthTexture);
+	glTextureStorage2D(depthTexture, 1, GL_R32F, WIDTH, HEIGHT);
+	glTextureSubImage2D(depthTexture, 0, 0, 0, WIDTH, HEIGHT, GL_RED, GL_FLOAT, depthBuffer.depth.data());
+
+	ew::Shader hiZShader = ew::Shader(hiZPath);
+	ew::Shader cullShader = ew::Shader(cullPath);
+	ew::HiZBuffer hiZ;
+	hiZ.build(hiZShader, depthTexture, WIDTH, HEIGHT, viewProjection);
+	ew::HiZPyramid gpuPyramid;
+	hiZ.download(&gpuPyramid);
+
+	ew::GpuInstanceCuller culler;
+	culler.upload(scene);
+	ew::CullResult gpuResult;
+	culler.cull(cullShader, &frustum, nullptr, &hiZ);
+	culler.download(&gpuResult);
+
+	double gpuBuildTime = measureMicroseconds(ITERATIONS, [&]() {
+		hiZ.build(hiZShader, depthTexture, WIDTH, HEIGHT, viewProjection);
+		glFinish();
+	});
+	double gpuCullTime = measureMicroseconds(ITERATIONS, [&]() {
+		culler.cull(cullShader, &frustum, nullptr, &hiZ);
+		glFinish();
+	});
+	printf("  GPU Hi-Z build:         %8.1f us\n", gpuBuildTime);
+	printf("  GPU occlusion cull:     %8.1f us\n", gpuCullTime);
+	printf("  GPU pyramid %s the CPU reference\n", check(samePyramid(cpuPyramid, gpuPyramid)) ? "matches" : "DIFFERS FROM");
+	printf("  GPU cull %s the CPU reference\n", check(sameResult(occlusionResult, gpuResult)) ? "matches" : "DIFFERS FROM");
+	glDeleteTextures(1, &depthTexture);
+}
@@ -0,0 +1,70 @@
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+#include <ew/packing.h>
+
+#include "benchmarks.h"
+
+static double angleDegrees(const glm::vec3& a, const glm::vec3& b) {
+	//atan2 of cross and dot in double, acos of a float dot can't resolve the tiny errors of RG16
+	double cx = (double)a.y * b.z - (double)a.z * b.y;
+	double cy = (double)a.z * b.x - (double)a.x * b.z;
+	double cz = (double)a.x * b.y - (double)a.y * b.x;
+	double cosine = (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z;
+	return atan2(sqrt(cx * cx + cy * cy + cz * cz), cosine) * 180.0 / 3.14159265358979;
+}
+
+/// <summary>
+/// Round trips normals through octahedral encoding at G-buffer precisions, reports the angular error and times it.
+/// coreChecks bounds the error and checks the PACKED vertex format.
+/// </summary>
+void runPackingBenchmark() {
+	const int NUM_RANDOM = 1000000;
+	seedRandom();
+
+	std::vector<glm::vec3> normals;
+	for (int x = -1; x <= 1; x++) {
+		for (int y = -1; y <= 1; y++) {
+			for (int z = -1; z <= 1; z++) {
+				if (x != 0 || y != 0 || z != 0) {
+					normals.push_back(glm::normalize(glm::vec3(x, y, z)));
+				}
+			}
+		}
+	}
+	while ((int)normals.size() < NUM_RANDOM) {
+		glm::vec3 n = glm::vec3(randomRange(-1, 1), randomRange(-1, 1), randomRange(-1, 1));
+		float length = glm::length(n);
+		if (length > 0.001f && length <= 1.0f) {
+			normals.push_back(n / length);
+		}
+	}
+
+	//0 bits = unquantized float
+	int bitCounts[] = { 0, 16, 8 };
+	for (int bits : bitCounts) {
+		double maxError = 0.0;
+		double totalError = 0.0;
+		for (const glm::vec3& n : normals) {
+			glm::vec2 e = ew::octEncode(n);
+			if (bits > 0) {
+				e = glm::vec2(ew::quantizeSnorm(e.x, bits), ew::quantizeSnorm(e.y, bits));
+			}
+			glm::vec3 decoded = ew::octDecode(e);
+			double error = angleDegrees(n, decoded);
+			maxError = error > maxError ? error : maxError;
+			totalError += error;
+		}
+		printf("%s: max error %.5f deg, mean error %.5f deg\n", bits == 0 ? "float " : bits == 16 ? "RG16  " : "RG8   ",
+			maxError, totalError / normals.size());
+	}
+
+	glm::vec3 sum = glm::vec3(0);
+	double roundTripTime = measureMicroseconds(1, [&]() {
+		for (const glm::vec3& n : normals) {
+			sum += ew::octDecode(ew::octEncode(n));
+		}
+	});
+	printf("%.2f ns per encode+decode (checksum %.1f)\n", roundTripTime * 1000.0 / normals.size(), sum.x + sum.y + sum.z);
+}
@@ -0,0 +1,59 @@
+#include <string.h>
+#include <vector>
+
+#include <ew/procGen.h>
+#include <ew/meshCache.h>
+
+#include "benchmarks.h"
+
+static uint64_t hashMesh(const ew::Vertex* vertices, int numVertices, const unsigned int* indices, int numIndices) {
+	return ew::hashBytes(indices, sizeof(unsigned int) * numIndices, ew::hashBytes(vertices, sizeof(ew::Vertex) * numVertices));
+}
+
+/// <summary>
+/// Generates planes and spheres from 8 to 4096 subdivisions three ways: into a new MeshData, into reused buffers,
+/// and into reused buffers across a thread pool. Both buffer outputs must hash the same as the MeshData. The buffers are
+/// filled with 0xFF bytes before the threaded run, so it can't pass by leaving the single threaded output in place.
+/// </summary>
+void runProcGenBenchmark() {
+	const int MIN_SUBDIVISIONS = 8;
+	const int MAX_SUBDIVISIONS = 4096;
+	ew::ThreadPool threadPool;
+	//Sized once for the largest mesh, which is what the buffer versions are for
+	std::vector<ew::Vertex> vertices(ew::getPlaneVertexCount(MAX_SUBDIVISIONS));
+	std::vector<unsigned int> indices(ew::getPlaneIndexCount(MAX_SUBDIVISIONS));
+	printf("%d worker threads\n", threadPool.getNumThreads());
+	printf("%-7s %6s %10s %14s %14s %14s %8s\n", "mesh", "subdiv", "vertices", "MeshData us", "buffer us", "threaded us", "speedup");
+	for (int shape = 0; shape < 2; shape++) {
+		const char* name = shape == 0 ? "plane" : "sphere";
+		for (int subdivisions = MIN_SUBDIVISIONS; subdivisions <= MAX_SUBDIVISIONS; subdivisions *= 2) {
+			int numVertices = shape == 0 ? ew::getPlaneVertexCount(subdivisions) : ew::getSphereVertexCount(subdivisions);
+			int numIndices = shape == 0 ? ew::getPlaneIndexCount(subdivisions) : ew::getSphereIndexCount(subdivisions);
+			//Roughly 16M vertices per measurement
+			int iterations = (1 << 24) / numVertices;
+			iterations = iterations < 1 ? 1 : iterations > 1000 ? 1000 : iterations;
+			auto generate = [&](ew::ThreadPool* pool) {
+				if (shape == 0) {
+					ew::createPlane(10.0f, 10.0f, subdivisions, vertices.data(), indices.data(), pool);
+				}
+				else {
+					ew::createSphere(1.0f, subdivisions, vertices.data(), indices.data(), pool);
+				}
+			};
+			ew::MeshData meshData;
+			double meshDataTime = measureMicroseconds(iterations, [&]() {
+				meshData = shape == 0 ? ew::createPlane(10.0f, 10.0f, subdivisions) : ew::createSphere(1.0f, subdivisions);
+			});
+			bool valid = (int)meshData.vertices.size() == numVertices && (int)meshData.indices.size() == numIndices;
+			uint64_t meshDataHash = hashMesh(meshData.vertices.data(), meshData.vertices.size(), meshData.indices.data(), meshData.indices.size());
+			double bufferTime = measureMicroseconds(iterations, [&]() { generate(nullptr); });
+			valid &= hashMesh(vertices.data(), numVertices, indices.data(), numIndices) == meshDataHash;
+			memset(vertices.data(), 0xFF, sizeof(ew::Vertex) * numVertices);
+			memset(indices.data(), 0xFF, sizeof(unsigned int) * numIndices);
+			double threadedTime = measureMicroseconds(iterations, [&]() { generate(&threadPool); });
+			valid &= hashMesh(vertices.data(), numVertices, indices.data(), numIndices) == meshDataHash;
+			printf("%-7s %6d %10d %14.1f %14.1f %14.1f %7.2fx%s\n", name, subdivisions, numVertices, meshDataTime, bufferTime, threadedTime,
+				meshDataTime / threadedTime, check(valid) ? "" : "  BUFFER OUTPUT DIFFERS FROM MESHDATA");
+		}
+	}
+}
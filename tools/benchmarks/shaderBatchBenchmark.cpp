@@ -0,0 +1,54 @@
+#include <stdio.h>
+
+#include <ew/programCache.h>
+
+#include "benchmarks.h"
+#include "shaderPrograms.h"
+
+/// <summary>
+/// Compiles every assignment3 program one after another, then all at once with ew::ShaderBatch, with the program cache off.
+/// Shows how long the batch kept the calling thread busy and when each program finished, and checks the batch built the same programs.
+/// Drivers keep their own shader caches, so whichever goes second may compile faster. Shaders come from assignment3's assets.
+/// </summary>
+void runShaderBatchBenchmark() {
+	if (!hasScenePrograms()) {
+		return;
+	}
+	const std::vector<std::vector<std::string>>& programs = getScenePrograms();
+	bool wasCacheEnabled = ew::isProgramCacheEnabled();
+	ew::setProgramCacheEnabled(false);
+	printf("GL_KHR_parallel_shader_compile: %s\n", ew::hasParallelShaderCompile() ? "yes" : "no");
+
+	std::vector<ew::Shader> compiled;
+	double sequentialTime = measureMicroseconds(1, [&]() {
+		for (const std::vector<std::string>& stages : programs) {
+			compiled.push_back(buildProgram(stages));
+		}
+	});
+
+	ew::ShaderBatch batch;
+	for (const std::vector<std::string>& stages : programs) {
+		addProgram(batch, stages);
+	}
+	double submitTime = measureMicroseconds(1, [&]() { batch.submit(); });
+	//A frame that finds nothing finished yet should cost next to nothing
+	bool doneOnFirstPoll = false;
+	double firstPollTime = measureMicroseconds(1, [&]() { doneOnFirstPoll = batch.poll(); });
+	int numPolls = 1;
+	double batchTime = submitTime + firstPollTime + measureMicroseconds(1, [&]() {
+		while (!batch.poll()) {
+			numPolls++;
+		}
+	});
+	batch.printStats();
+
+	bool allMatch = true;
+	for (size_t i = 0; i < programs.size(); i++) {
+		allMatch &= batch.isReady((int)i) && getActiveUniforms(compiled[i].getId()) == getActiveUniforms(batch.get((int)i).getId());
+	}
+	printf("  One at a time: %8.2f ms\n", sequentialTime / 1000.0);
+	printf("  Batched:       %8.2f ms, submit %.2f ms, first poll %.2f ms%s, %d polls\n", batchTime / 1000.0,
+		submitTime / 1000.0, firstPollTime / 1000.0, doneOnFirstPoll ? " (finished everything)" : "", numPolls);
+	printf("  Batched programs %s the ones compiled one at a time\n", check(allMatch) ? "match" : "DIFFER FROM");
+	ew::setProgramCacheEnabled(wasCacheEnabled);
+}
@@ -0,0 +1,64 @@
+#include <stdio.h>
+
+#include <ew/external/glad.h>
+#include <ew/programCache.h>
+#include <ew/meshCache.h>
+
+#include "benchmarks.h"
+#include "shaderPrograms.h"
+
+/// <summary>
+/// Builds every assignment3 program three ways: compiled with the cache off, compiled into an empty cache,
+/// and loaded from the cache that left behind. Loaded programs must expose the same active uniforms as compiled ones.
+/// Where the driver has binary formats, the cold build must also leave a cache file that loadProgramBinary accepts.
+/// Shaders come from assignment3's assets.
+/// </summary>
+void runShaderCacheBenchmark() {
+	if (!hasScenePrograms()) {
+		return;
+	}
+	int numBinaryFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numBinaryFormats);
+
+	printf("%-52s %12s %12s %12s\n", "program", "no cache ms", "cold ms", "warm ms");
+	double totals[3] = {};
+	bool allMatch = true;
+	bool allCached = true;
+	for (const std::vector<std::string>& stages : getScenePrograms()) {
+		std::string cachePath = ew::getProgramCachePath(stages);
+		remove(cachePath.c_str());
+		ew::setProgramCacheEnabled(false);
+		ew::Shader compiled = buildProgram(stages);
+		double uncachedTime = measureMicroseconds(1, [&]() { buildProgram(stages); });
+		ew::setProgramCacheEnabled(true);
+		double coldTime = measureMicroseconds(1, [&]() { buildProgram(stages); });
+		if (numBinaryFormats > 0) {
+			std::vector<std::string> sources;
+			for (const std::string& stage : stages) {
+				sources.push_back(ew::loadShaderSourceFromFile(stage));
+			}
+			unsigned int cachedProgram = ew::loadProgramBinary(cachePath, ew::hashProgramSources(sources));
+			allCached &= ew::hashFile(cachePath) != 0 && cachedProgram != 0;
+			glDeleteProgram(cachedProgram);
+		}
+		ew::Shader loaded = buildProgram(stages);
+		double warmTime = measureMicroseconds(1, [&]() { buildProgram(stages); });
+		allMatch &= getActiveUniforms(compiled.getId()) == getActiveUniforms(loaded.getId());
+		std::string name = stages[0];
+		for (size_t i = 1; i < stages.size(); i++) {
+			name += " + " + stages[i].substr(stages[i].find_last_of('/') + 1);
+		}
+		printf("%-52s %12.2f %12.2f %12.2f\n", name.c_str(), uncachedTime / 1000.0, coldTime / 1000.0, warmTime / 1000.0);
+		totals[0] += uncachedTime;
+		totals[1] += coldTime;
+		totals[2] += warmTime;
+	}
+	printf("%-52s %12.2f %12.2f %12.2f\n", "total", totals[0] / 1000.0, totals[1] / 1000.0, totals[2] / 1000.0);
+	printf("Cached programs %s the compiled ones\n", check(allMatch) ? "match" : "DIFFER FROM");
+	if (numBinaryFormats > 0) {
+		printf("Cache files %s\n", check(allCached) ? "written and loadable for every program" : "MISSING OR REJECTED");
+	}
+	else {
+		printf("The driver has no program binary formats, so nothing is cached\n");
+	}
+}
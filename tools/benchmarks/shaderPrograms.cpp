@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <algorithm>
+
+#include <ew/external/glad.h>
+#include <ew/meshCache.h>
+
+#include "shaderPrograms.h"
+
+const std::vector<std::vector<std::string>>& getScenePrograms() {
+	static const std::vector<std::vector<std::string>> programs = {
+		{ "assets/lit.vert", "assets/lit.frag" },
+		{ "assets/blur.vert", "assets/blur.frag" },
+		{ "assets/depthOnly.vert", "assets/shadowCascades.geom", "assets/depthOnly.frag" },
+		{ "assets/depthOnlyInstanced.vert", "assets/shadowCascades.geom", "assets/depthOnly.frag" },
+		{ "assets/geo.vert", "assets/geo.frag" },
+		{ "assets/geoInstanced.vert", "assets/geo.frag" },
+		{ "assets/deferredLit.vert", "assets/deferredLit.frag" },
+		{ "assets/lightOrb.vert", "assets/lightOrb.frag" },
+		{ "assets/lightVolume.vert", "assets/lightVolume.frag" },
+		{ "assets/lightVolume.vert", "assets/depthOnly.frag" },
+		{ "assets/lightCull.comp" },
+		{ "assets/instanceCull.comp" },
+		{ "assets/hiZ.comp" },
+	};
+	return programs;
+}
+
+bool hasScenePrograms() {
+	const std::string& path = getScenePrograms()[0][0];
+	if (ew::hashFile(path) == 0) {
+		printf("%s not found, build assignment3 to copy it into bin/assets\n", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+ew::Shader buildProgram(const std::vector<std::string>& stages) {
+	if (stages.size() == 1) {
+		return ew::Shader(stages[0]);
+	}
+	if (stages.size() == 2) {
+		return ew::Shader(stages[0], stages[1]);
+	}
+	return ew::Shader(stages[0], stages[1], stages[2]);
+}
+
+int addProgram(ew::ShaderBatch& batch, const std::vector<std::string>& stages) {
+	if (stages.size() == 1) {
+		return batch.add(stages[0]);
+	}
+	if (stages.size() == 2) {
+		return batch.add(stages[0], stages[1]);
+	}
+	return batch.add(stages[0], stages[1], stages[2]);
+}
+
+std::vector<std::string> getActiveUniforms(unsigned int program) {
+	int numUniforms = 0;
+	int maxNameLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniforms);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::vector<char> name(maxNameLength + 1);
+	std::vector<std::string> uniforms;
+	for (int i = 0; i < numUniforms; i++) {
+		int size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(program, i, (GLsizei)name.size(), NULL, &size, &type, name.data());
+		char description[64];
+		snprintf(description, sizeof(description), " 0x%x[%d] at %d", type, size, glGetUniformLocation(program, name.data()));
+		uniforms.push_back(name.data() + std::string(description));
+	}
+	std::sort(uniforms.begin(), uniforms.end());
+	return uniforms;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include <ew/shader.h>
+
+//Stage paths of every program assignment3's Scene builds, in the order of its shader enum
+const std::vector<std::vector<std::string>>& getScenePrograms();
+//Prints where to get them and returns false if assignment3's shaders aren't in bin/assets
+bool hasScenePrograms();
+//Picks the ew::Shader constructor or ShaderBatch::add overload for the number of stages
+ew::Shader buildProgram(const std::vector<std::string>& stages);
+int addProgram(ew::ShaderBatch& batch, const std::vector<std::string>& stages);
+//Name, type, array size and location of every active uniform, sorted by name
+std::vector<std::string> getActiveUniforms(unsigned int program);
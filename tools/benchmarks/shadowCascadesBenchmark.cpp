@@ -0,0 +1,247 @@
+#include <math.h>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/shadowCascades.h>
+#include <ew/shadowCache.h>
+#include <ew/procGen.h>
+#include <ew/shader.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "benchmarks.h"
+
+//Axis aligned box standing in for a static shadow caster
+struct BoxCaster {
+	glm::vec3 center;
+	glm::vec3 size;
+};
+
+static ew::AABB getBounds(const BoxCaster& box) {
+	ew::AABB bounds;
+	bounds.min = box.center - box.size * 0.5f;
+	bounds.max = box.center + box.size * 0.5f;
+	return bounds;
+}
+
+/// <summary>
+/// Clears each cascade in mask within its rectangle and redraws every box into it, scissored to that rectangle
+/// like the assignment3 static caster pass
+/// </summary>
+static void drawCasters(ew::Shader& shader, ew::Mesh& cube, const std::vector<BoxCaster>& boxes, const ew::ShadowCascades& cascades,
+	unsigned int fbo, unsigned int depthArray, unsigned int mask, const glm::ivec4* rects) {
+	float clearDepth = 1.0f;
+	for (int i = 0; i < cascades.numCascades; i++) {
+		if ((mask & (1u << i)) == 0) {
+			continue;
+		}
+		const glm::ivec4& rect = rects[i];
+		glClearTexSubImage(depthArray, 0, rect.x, rect.y, i, rect.z, rect.w, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
+		glNamedFramebufferTextureLayer(fbo, GL_DEPTH_ATTACHMENT, depthArray, 0, i);
+		glScissor(rect.x, rect.y, rect.z, rect.w);
+		shader.setMat4("_ViewProjection", cascades.viewProjections[i]);
+		for (const BoxCaster& box : boxes) {
+			shader.setMat4("_Model", glm::scale(glm::translate(glm::mat4(1.0f), box.center), box.size));
+			cube.draw();
+		}
+	}
+}
+
+/// <summary>
+/// Moves static boxes around and redraws only the rectangles ew::ShadowCache marks dirty, checking every frame
+/// that the cached cascades match a full redraw bit for bit (read back with glGetTextureImage).
+/// Every 10th frame the camera steps too, so some cascades are redrawn in full between partial ones
+/// </summary>
+static void checkPartialRedraws(ew::Camera camera, const glm::vec3& lightDirection) {
+	const int NUM_FRAMES = 30;
+	const int NUM_BOXES = 64;
+	ew::ShadowCascadeSettings settings;
+	settings.resolution = 1024;
+	ew::ShadowCascades cascades;
+	ew::ShadowCache cache;
+	glm::ivec4 dirtyRects[ew::MAX_SHADOW_CASCADES];
+	glm::ivec4 fullRects[ew::MAX_SHADOW_CASCADES];
+	for (glm::ivec4& rect : fullRects) {
+		rect = glm::ivec4(0, 0, settings.resolution, settings.resolution);
+	}
+
+	seedRandom();
+	std::vector<BoxCaster> boxes(NUM_BOXES);
+	boxes[0] = { glm::vec3(0, -1.1f, -20), glm::vec3(100, 0.2f, 100) }; //Ground
+	for (int i = 1; i < NUM_BOXES; i++) {
+		boxes[i].size = glm::vec3(randomRange(0.5f, 2), randomRange(0.5f, 4), randomRange(0.5f, 2));
+		boxes[i].center = glm::vec3(randomRange(-15, 15), boxes[i].size.y * 0.5f - 1.0f, randomRange(-40, 4));
+	}
+
+	unsigned int fbo, cachedMap, referenceMap;
+	glCreateFramebuffers(1, &fbo);
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &cachedMap);
+	glTextureStorage3D(cachedMap, 1, GL_DEPTH_COMPONENT16, settings.resolution, settings.resolution, ew::MAX_SHADOW_CASCADES);
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &referenceMap);
+	glTextureStorage3D(referenceMap, 1, GL_DEPTH_COMPONENT16, settings.resolution, settings.resolution, ew::MAX_SHADOW_CASCADES);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glDrawBuffer(GL_NONE);
+	glViewport(0, 0, settings.resolution, settings.resolution);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_DEPTH_CLAMP);
+	glEnable(GL_SCISSOR_TEST);
+	ew::Shader shader = ew::Shader("assets/shadowCacheBench.vert", "assets/shadowCacheBench.frag");
+	shader.use();
+	ew::Mesh cube = ew::Mesh(ew::createCube(1.0f));
+
+	size_t texelsPerMap = (size_t)settings.resolution * settings.resolution * ew::MAX_SHADOW_CASCADES;
+	std::vector<unsigned short> cached(texelsPerMap);
+	std::vector<unsigned short> reference(texelsPerMap);
+	unsigned long long redrawnTexels = 0;
+	unsigned long long cascadeTexels = 0;
+	int differingTexels = 0;
+	for (int frame = 0; frame < NUM_FRAMES; frame++) {
+		if (frame % 10 == 9) {
+			camera.position.x += 0.5f;
+		}
+		BoxCaster& moved = boxes[1 + frame % (NUM_BOXES - 1)];
+		cache.invalidate(getBounds(moved));
+		moved.center += glm::vec3(randomRange(-3, 3), 0, randomRange(-3, 3));
+		cache.invalidate(getBounds(moved));
+
+		ew::fitShadowCascades(camera, lightDirection, settings, &cascades);
+		unsigned int mask = cache.update(cascades, dirtyRects);
+		drawCasters(shader, cube, boxes, cascades, fbo, cachedMap, mask, dirtyRects);
+		drawCasters(shader, cube, boxes, cascades, fbo, referenceMap, (1u << cascades.numCascades) - 1, fullRects);
+		for (int i = 0; i < cascades.numCascades; i++) {
+			redrawnTexels += (mask & (1u << i)) ? (unsigned long long)dirtyRects[i].z * dirtyRects[i].w : 0;
+			cascadeTexels += (unsigned long long)settings.resolution * settings.resolution;
+		}
+
+		glGetTextureImage(cachedMap, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, (GLsizei)(cached.size() * sizeof(unsigned short)), cached.data());
+		glGetTextureImage(referenceMap, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, (GLsizei)(reference.size() * sizeof(unsigned short)), reference.data());
+		size_t usedTexels = (size_t)settings.resolution * settings.resolution * cascades.numCascades;
+		for (size_t i = 0; i < usedTexels; i++) {
+			differingTexels += cached[i] != reference[i] ? 1 : 0;
+		}
+	}
+	printf("  Partial redraws over %d frames: %.1f%% of cascade texels redrawn, %d texels differ from a full redraw\n",
+		NUM_FRAMES, 100.0 * redrawnTexels / cascadeTexels, differingTexels);
+	check(differingTexels == 0);
+
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_DEPTH_CLAMP);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &cachedMap);
+	glDeleteTextures(1, &referenceMap);
+}
+
+//How far p lies outside the [-1, 1] x/y range of viewProjection, in clip units
+static float outsideBox(const glm::mat4& viewProjection, const glm::vec3& p) {
+	glm::vec4 clip = viewProjection * glm::vec4(p, 1.0f);
+	return glm::max(glm::max(fabsf(clip.x), fabsf(clip.y)) - 1.0f, 0.0f);
+}
+
+/// <summary>
+/// Fits 4 cascades to a camera that turns and walks through the scene, checking that each cascade covers its slice
+/// of the view, that the texel grid stays put in world space, and that shadow texels per screen pixel stay roughly
+/// constant from the first cascade to the last. Then counts how many cascade redraws a static shadow cache skips
+/// while the camera stands still, walks and turns, and checks its partial redraws against full ones on the GPU.
+/// </summary>
+void runShadowCascadesBenchmark() {
+	const int ITERATIONS = 10000;
+	const int NUM_FRAMES = 600;
+	const float SCREEN_HEIGHT = 720.0f;
+
+	ew::ShadowCascadeSettings settings;
+	ew::ShadowCascades cascades;
+	ew::Camera camera;
+	camera.position = glm::vec3(0, 2, 5);
+	camera.target = glm::vec3(0, 0, -20);
+	glm::vec3 lightDirection = glm::vec3(-0.3f, -1.0f, -0.2f);
+
+	double fitTime = measureMicroseconds(ITERATIONS, [&]() {
+		ew::fitShadowCascades(camera, lightDirection, settings, &cascades);
+	});
+	printf("%d cascades of %dx%d, %.2f to %.0f\n", cascades.numCascades, settings.resolution, settings.resolution,
+		camera.nearPlane, cascades.splitDepths[cascades.numCascades - 1]);
+	printf("  Fit: %6.2f us\n", fitTime);
+
+	//Screen pixels are 2 * depth * tan(fov / 2) / height world units wide at each depth
+	float pixelsPerDepth = 2.0f * tanf(glm::radians(camera.fov) * 0.5f) / SCREEN_HEIGHT;
+	printf("  %-8s %10s %14s %22s\n", "cascade", "ends at", "texel size", "texels per pixel at end");
+	for (int i = 0; i < cascades.numCascades; i++) {
+		float pixelSize = cascades.splitDepths[i] * pixelsPerDepth;
+		printf("  %-8d %10.2f %14.4f %22.2f\n", i, cascades.splitDepths[i], cascades.texelSizes[i], pixelSize / cascades.texelSizes[i]);
+	}
+
+	//Walk and turn. Every slice corner must land inside its box, and a fixed world point must always
+	//land at the same sub-texel position, or shadow edges would crawl
+	float worstOutside = 0.0f;
+	float worstTexelDrift = 0.0f;
+	float firstFraction[ew::MAX_SHADOW_CASCADES][2];
+	glm::mat4 inverseProjection;
+	for (int frame = 0; frame < NUM_FRAMES; frame++) {
+		float angle = frame * 0.01f;
+		camera.position = glm::vec3(frame * 0.037f, 2.0f + sinf(frame * 0.05f), 5.0f - frame * 0.021f);
+		camera.target = camera.position + glm::vec3(sinf(angle), -0.2f, -cosf(angle));
+		ew::fitShadowCascades(camera, lightDirection, settings, &cascades);
+		inverseProjection = glm::inverse(camera.projectionMatrix() * camera.viewMatrix());
+		float sliceStart = camera.nearPlane;
+		for (int i = 0; i < cascades.numCascades; i++) {
+			for (int corner = 0; corner < 8; corner++) {
+				//Perspective depth of the slice end in NDC
+				float depth = corner & 4 ? cascades.splitDepths[i] : sliceStart;
+				glm::vec4 clipDepth = camera.projectionMatrix() * glm::vec4(0, 0, -depth, 1);
+				glm::vec4 ndc = glm::vec4(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, clipDepth.z / clipDepth.w, 1.0f);
+				glm::vec4 world = inverseProjection * ndc;
+				worstOutside = glm::max(worstOutside, outsideBox(cascades.viewProjections[i], glm::vec3(world) / world.w));
+			}
+			sliceStart = cascades.splitDepths[i];
+			glm::vec4 origin = cascades.viewProjections[i] * glm::vec4(0, 0, 0, 1);
+			for (int axis = 0; axis < 2; axis++) {
+				float texels = (origin[axis] * 0.5f + 0.5f) * settings.resolution;
+				float fraction = texels - floorf(texels);
+				if (frame == 0) {
+					firstFraction[i][axis] = fraction;
+				}
+				float drift = fabsf(fraction - firstFraction[i][axis]);
+				worstTexelDrift = glm::max(worstTexelDrift, glm::min(drift, 1.0f - drift));
+			}
+		}
+	}
+	printf("  Over %d frames: slice corners at most %.5f outside their cascade, texel grid drifted at most %.4f texels\n",
+		NUM_FRAMES, worstOutside, worstTexelDrift);
+	printf("  Cascades %s\n", check(worstOutside < 1e-4f && worstTexelDrift < 0.01f) ? "are stable and cover the view" : "SHIMMER OR MISS PART OF THE VIEW");
+
+	//60 frames each of standing still, walking at 1.5m/s and turning at 30 degrees/s
+	ew::ShadowCache cache;
+	glm::ivec4 dirtyRects[ew::MAX_SHADOW_CASCADES];
+	const char* phases[] = { "standing", "walking", "turning" };
+	camera.position = glm::vec3(0, 2, 5);
+	float yaw = 0.0f;
+	for (int phase = 0; phase < 3; phase++) {
+		unsigned long long redrawn = cache.getStats().totalRedrawn;
+		unsigned long long skipped = cache.getStats().totalSkipped;
+		int redrawsPerCascade[ew::MAX_SHADOW_CASCADES] = {};
+		for (int frame = 0; frame < 60; frame++) {
+			if (phase == 1) {
+				camera.position.z -= 1.5f / 60.0f;
+			}
+			else if (phase == 2) {
+				yaw += glm::radians(30.0f) / 60.0f;
+			}
+			camera.target = camera.position + glm::vec3(sinf(yaw), -0.2f, -cosf(yaw));
+			ew::fitShadowCascades(camera, lightDirection, settings, &cascades);
+			unsigned int mask = cache.update(cascades, dirtyRects);
+			for (int i = 0; i < cascades.numCascades; i++) {
+				redrawsPerCascade[i] += (mask >> i) & 1;
+			}
+		}
+		printf("  Cached shadows, %-8s: %3llu of %3llu cascade redraws skipped, redraws per cascade", phases[phase],
+			cache.getStats().totalSkipped - skipped, cache.getStats().totalSkipped - skipped + cache.getStats().totalRedrawn - redrawn);
+		for (int i = 0; i < cascades.numCascades; i++) {
+			printf(" %d", redrawsPerCascade[i]);
+		}
+		printf("\n");
+	}
+
+	camera.position = glm::vec3(0, 2, 5);
+	camera.target = glm::vec3(0, 0, -20);
+	checkPartialRedraws(camera, lightDirection);
+}
@@ -0,0 +1,57 @@
+#include <ew/terrain.h>
+
+#include "benchmarks.h"
+
+/// <summary>
+/// Times tile generation, then flies a camera 20km across a noise terrain, updating the stream every 10m.
+/// GPU memory must stay what was allocated up front however far it goes, and every slot must be filled at the end.
+/// coreChecks checks the tiles and indices themselves.
+/// </summary>
+void runTerrainBenchmark() {
+	const int ITERATIONS = 20;
+	const int NUM_UPDATES = 2000;
+	const float STEP = 10.0f;
+
+	ew::NoiseSettings noise;
+	noise.amplitude = 20.0f;
+	ew::TerrainSettings settings;
+	settings.height = ew::createNoiseHeightFunction(noise);
+	settings.loadRadius = 8;
+
+	ew::TerrainTileData tile;
+	double generateTime = measureMicroseconds(ITERATIONS, [&]() {
+		ew::generateTerrainTile(settings, glm::ivec2(3, -7), &tile);
+	});
+	printf("%dx%d quad tiles, %d vertices each\n", settings.tileQuads, settings.tileQuads, (int)tile.vertices.size());
+	printf("  Generate one tile: %8.1f us\n", generateTime);
+	printf("  LOD errors:");
+	for (int lod = 0; lod < settings.numLods; lod++) {
+		printf(" %.4f", tile.lodErrors[lod]);
+	}
+	printf("\n");
+
+	ew::ThreadPool threadPool;
+	ew::Terrain terrain(settings, threadPool);
+	glm::vec3 camera = glm::vec3(0.0f, 30.0f, 0.0f);
+	double loadTime = measureMicroseconds(1, [&]() {
+		terrain.finishLoading(camera);
+	});
+	printf("  %d slots, %.1f MB of GPU buffers\n", terrain.getNumSlots(), terrain.getGpuBytes() / (1024.0 * 1024.0));
+	printf("  Initial load:      %8.1f us\n", loadTime);
+
+	size_t gpuBytes = terrain.getGpuBytes();
+	bool constantGpuBytes = true;
+	int maxResident = 0;
+	int maxPending = 0;
+	double updateTime = measureMicroseconds(NUM_UPDATES, [&]() {
+		camera.x += STEP;
+		terrain.update(camera);
+		constantGpuBytes &= terrain.getGpuBytes() == gpuBytes;
+		maxResident = maxResident > terrain.getNumResidentTiles() ? maxResident : terrain.getNumResidentTiles();
+		maxPending = maxPending > terrain.getNumPendingTiles() ? maxPending : terrain.getNumPendingTiles();
+	});
+	terrain.finishLoading(camera);
+	printf("  Update while moving: %6.1f us, at most %d resident and %d pending tiles\n", updateTime, maxResident, maxPending);
+	printf("  GPU memory %s after %.0fm\n", check(constantGpuBytes && terrain.getGpuBytes() == gpuBytes) ? "unchanged" : "CHANGED", camera.x);
+	printf("  %s\n", check(terrain.getNumResidentTiles() == terrain.getNumSlots()) ? "Every slot resident after loading" : "SLOTS LEFT EMPTY after loading");
+}
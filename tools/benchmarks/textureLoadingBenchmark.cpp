@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <thread>
+
+#include <ew/external/glad.h>
+#include <ew/texture.h>
+#include <ew/asyncTexture.h>
+
+#include "benchmarks.h"
+
+/// <summary>
+/// Loads the Rock037 maps with ew::loadTexture one after another, then with AsyncTextureLoader
+/// at increasing thread counts. The maps come from assignment3's assets, which share bin/assets.
+/// </summary>
+void runTextureLoadingBenchmark() {
+	const char* texturePaths[] = {
+		"assets/Rock037_2K-PNG/Rock037.png",
+		"assets/Rock037_2K-PNG/Rock037_2K-PNG_AmbientOcclusion.png",
+		"assets/Rock037_2K-PNG/Rock037_2K-PNG_Roughness.png",
+	};
+	//Each map is loaded this many times so there's enough work to spread across threads
+	const int REPEATS = 4;
+	const int numTextures = sizeof(texturePaths) / sizeof(texturePaths[0]) * REPEATS;
+	FILE* file = fopen(texturePaths[0], "rb");
+	if (file == NULL) {
+		printf("%s not found, build assignment3 to copy it into bin/assets\n", texturePaths[0]);
+		return;
+	}
+	fclose(file);
+
+	std::vector<unsigned int> textures;
+	double syncTime = measureMicroseconds(1, [&]() {
+		for (int i = 0; i < numTextures; i++) {
+			textures.push_back(ew::loadTexture(texturePaths[i % 3]));
+		}
+		glFinish();
+	});
+	glDeleteTextures((int)textures.size(), textures.data());
+	printf("%d textures, ew::loadTexture:       %8.1f ms\n", numTextures, syncTime / 1000.0);
+
+	int maxThreads = (int)std::thread::hardware_concurrency();
+	for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+		ew::ThreadPool threadPool(numThreads);
+		ew::AsyncTextureLoader loader(threadPool);
+		std::vector<int> handles;
+		double asyncTime = measureMicroseconds(1, [&]() {
+			for (int i = 0; i < numTextures; i++) {
+				handles.push_back(loader.load(texturePaths[i % 3]));
+			}
+			loader.finishAll();
+			glFinish();
+		});
+		for (int handle : handles) {
+			unsigned int texture = loader.getTexture(handle);
+			glDeleteTextures(1, &texture);
+		}
+		printf("%d textures, async with %2d threads: %8.1f ms (%.2fx)\n", numTextures, numThreads, asyncTime / 1000.0, syncTime / asyncTime);
+	}
+}
@@ -0,0 +1,65 @@
+#include <string>
+#include <vector>
+
+#include <ew/external/glad.h>
+#include <ew/shader.h>
+
+#include "benchmarks.h"
+
+static const int NUM_LIGHTS = 256;
+static const int ITERATIONS = 200;
+
+/// <summary>
+/// Uploads 256 point lights (768 uniforms) per iteration, the same pattern as assignment3's deferred pass,
+/// using driver lookups, cached string lookups and pre-resolved handles.
+/// </summary>
+void runUniformBenchmark() {
+	ew::Shader shader = ew::Shader("assets/uniformBench.vert", "assets/uniformBench.frag");
+	shader.use();
+	unsigned int program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, (int*)&program);
+
+	glm::vec3 position = glm::vec3(1.0f, 2.0f, 3.0f);
+	glm::vec4 color = glm::vec4(1.0f);
+
+	double driverLookup = measureMicroseconds(ITERATIONS, [&]() {
+		for (int i = 0; i < NUM_LIGHTS; i++) {
+			std::string prefix = "_PointLights[" + std::to_string(i) + "]";
+			glUniform3f(glGetUniformLocation(program, (prefix + ".position").c_str()), position.x, position.y, position.z);
+			glUniform1f(glGetUniformLocation(program, (prefix + ".radius").c_str()), 10.0f);
+			glUniform4f(glGetUniformLocation(program, (prefix + ".color").c_str()), color.x, color.y, color.z, color.w);
+		}
+	});
+
+	double stringLookup = measureMicroseconds(ITERATIONS, [&]() {
+		for (int i = 0; i < NUM_LIGHTS; i++) {
+			shader.setVec3("_PointLights[" + std::to_string(i) + "].position", position);
+			shader.setFloat("_PointLights[" + std::to_string(i) + "].radius", 10.0f);
+			shader.setVec4("_PointLights[" + std::to_string(i) + "].color", color);
+		}
+	});
+
+	struct LightUniforms {
+		ew::UniformLocation position, radius, color;
+	};
+	std::vector<LightUniforms> handles(NUM_LIGHTS);
+	for (int i = 0; i < NUM_LIGHTS; i++) {
+		std::string prefix = "_PointLights[" + std::to_string(i) + "]";
+		handles[i].position = shader.getUniformLocation(prefix + ".position");
+		handles[i].radius = shader.getUniformLocation(prefix + ".radius");
+		handles[i].color = shader.getUniformLocation(prefix + ".color");
+	}
+	double handleLookup = measureMicroseconds(ITERATIONS, [&]() {
+		for (int i = 0; i < NUM_LIGHTS; i++) {
+			shader.setVec3(handles[i].position, position);
+			shader.setFloat(handles[i].radius, 10.0f);
+			shader.setVec4(handles[i].color, color);
+		}
+	});
+	glFinish();
+
+	printf("%d uniforms per upload, average of %d uploads\n", NUM_LIGHTS * 3, ITERATIONS);
+	printf("  glGetUniformLocation + string building: %8.1f us\n", driverLookup);
+	printf("  cached string setters:                  %8.1f us\n", stringLookup);
+	printf("  UniformLocation handles:                %8.1f us\n", handleLookup);
+}
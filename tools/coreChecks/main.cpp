@@ -0,0 +1,680 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <ew/geometryArena.h>
+#include <ew/lightCulling.h>
+#include <ew/packing.h>
+#include <ew/mesh.h>
+#include <ew/procGen.h>
+#include <ew/meshOptimizer.h>
+#include <ew/meshSimplifier.h>
+#include <ew/instanceCulling.h>
+#include <ew/occlusion.h>
+#include <ew/textureCompression.h>
+#include <ew/terrain.h>
+
+//Every check with random inputs seeds with srand(1234) first, so failures are repeatable
+static float randomRange(float min, float max) {
+	return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+/// <summary>
+/// Random allocate/free churn checked against a per-element owner table. Fails on overlapping or out of range
+/// allocations, on bad frees, or if freeing everything doesn't merge back into one block
+/// </summary>
+bool checkRangeAllocator() {
+	const unsigned int CAPACITY = 1 << 16;
+	const int OPERATIONS = 100000;
+	srand(1234);
+	ew::RangeAllocator allocator(CAPACITY);
+	std::vector<int> owner(CAPACITY, -1);
+	struct Allocation {
+		unsigned int offset, size;
+	};
+	std::vector<Allocation> live;
+	unsigned int used = 0;
+	bool valid = true;
+	for (int op = 0; op < OPERATIONS && valid; op++) {
+		//Biased towards allocating until about half full, then churns
+		if (live.empty() || (rand() % 100) < (used < CAPACITY / 2 ? 60 : 45)) {
+			unsigned int size = 1 + rand() % 1024;
+			unsigned int offset = allocator.allocate(size);
+			if (offset == ew::RangeAllocator::INVALID_OFFSET) {
+				continue;
+			}
+			if (offset + size > CAPACITY) {
+				valid = false;
+				break;
+			}
+			for (unsigned int i = offset; i < offset + size; i++) {
+				valid &= owner[i] == -1;
+				owner[i] = op;
+			}
+			live.push_back(Allocation{ offset, size });
+			used += size;
+		}
+		else {
+			int index = rand() % live.size();
+			Allocation allocation = live[index];
+			live[index] = live.back();
+			live.pop_back();
+			valid &= allocator.free(allocation.offset);
+			for (unsigned int i = allocation.offset; i < allocation.offset + allocation.size; i++) {
+				owner[i] = -1;
+			}
+			used -= allocation.size;
+		}
+		valid &= allocator.getUsed() == used;
+	}
+	valid &= !allocator.free(CAPACITY + 1);
+	for (const Allocation& allocation : live) {
+		valid &= allocator.free(allocation.offset);
+	}
+	valid &= !live.empty() && !allocator.free(live[0].offset);
+	valid &= allocator.getNumFreeBlocks() == 1 && allocator.getLargestFreeBlock() == CAPACITY && allocator.getUsed() == 0;
+	return valid;
+}
+
+//Nearest point to p of the infinite pyramid from the origin through four unit edge rays, given in order around it
+static glm::vec3 nearestPointOnPyramid(const glm::vec3 edges[4], const glm::vec3& p) {
+	glm::vec3 axis = edges[0] + edges[1] + edges[2] + edges[3];
+	bool inside = true;
+	for (int i = 0; i < 4; i++) {
+		glm::vec3 normal = glm::cross(edges[i], edges[(i + 1) % 4]);
+		inside &= glm::dot(normal, p) * glm::dot(normal, axis) >= 0.0f;
+	}
+	if (inside) {
+		return p;
+	}
+	//Outside, the nearest point is on a face or an edge ray
+	glm::vec3 nearest = glm::vec3(0);
+	float nearestDistance = glm::length(p);
+	auto consider = [&](const glm::vec3& q) {
+		float distance = glm::length(p - q);
+		if (distance < nearestDistance) {
+			nearest = q;
+			nearestDistance = distance;
+		}
+	};
+	for (int i = 0; i < 4; i++) {
+		const glm::vec3& a = edges[i];
+		const glm::vec3& b = edges[(i + 1) % 4];
+		consider(a * glm::max(glm::dot(p, a), 0.0f));
+		//Projection onto the face's plane, kept if it lands between the two edges
+		glm::vec3 normal = glm::normalize(glm::cross(a, b));
+		glm::vec3 q = p - normal * glm::dot(p, normal);
+		float ab = glm::dot(a, b);
+		float qa = glm::dot(q, a);
+		float qb = glm::dot(q, b);
+		float determinant = 1.0f - ab * ab;
+		if ((qa - ab * qb) / determinant >= 0.0f && (qb - ab * qa) / determinant >= 0.0f) {
+			consider(q);
+		}
+	}
+	return nearest;
+}
+
+//Where a tile starts and ends in NDC, from pixels. Clamped at the screen edge like partial tiles are
+static void tileRange(int tile, int tileSize, int screenSize, float* ndcMin, float* ndcMax) {
+	*ndcMin = 2.0f * tile * tileSize / screenSize - 1.0f;
+	*ndcMax = 2.0f * glm::min((tile + 1) * tileSize, screenSize) / screenSize - 1.0f;
+}
+
+//How a light relates to the part of a tile between the near and far planes, found without any tile planes:
+//1 if the sphere definitely reaches it, -1 if it definitely doesn't, 0 if it's too close to tell
+static int classifyLight(const ew::Camera& camera, float x0, float x1, float y0, float y1, const glm::vec3& viewCenter, float radius) {
+	const float MARGIN = 1e-3f;
+	glm::vec3 nearest;
+	if (camera.orthographic) {
+		float halfHeight = camera.orthoHeight * 0.5f;
+		float halfWidth = halfHeight * camera.aspectRatio;
+		glm::vec3 boxMin = glm::vec3(x0 * halfWidth, y0 * halfHeight, -camera.farPlane);
+		glm::vec3 boxMax = glm::vec3(x1 * halfWidth, y1 * halfHeight, -camera.nearPlane);
+		float distance = glm::length(glm::clamp(viewCenter, boxMin, boxMax) - viewCenter);
+		return distance < radius * (1.0f - MARGIN) ? 1 : distance > radius * (1.0f + MARGIN) ? -1 : 0;
+	}
+	float tanHalfFov = tanf(glm::radians(camera.fov) * 0.5f);
+	float xs[4] = { x0, x1, x1, x0 };
+	float ys[4] = { y0, y0, y1, y1 };
+	glm::vec3 edges[4];
+	for (int i = 0; i < 4; i++) {
+		edges[i] = glm::normalize(glm::vec3(xs[i] * tanHalfFov * camera.aspectRatio, ys[i] * tanHalfFov, -1.0f));
+	}
+	nearest = nearestPointOnPyramid(edges, viewCenter);
+	float distance = glm::length(nearest - viewCenter);
+	if (distance > radius * (1.0f + MARGIN)) {
+		return -1;
+	}
+	//Reaching the pyramid only counts if it does so between the near and far planes
+	float depth = -nearest.z;
+	bool inDepthRange = depth > camera.nearPlane && depth < camera.farPlane;
+	return distance < radius * (1.0f - MARGIN) && inDepthRange ? 1 : 0;
+}
+
+/// <summary>
+/// Checks every ew::cullLightsTiled tile list against a brute force test of every light against every tile frustum.
+/// Those frustums come from ew::computeTileFrustum like the culler's, so the lists are also checked against tile pyramids
+/// built straight from the camera's field of view: no light that reaches a tile may be missing from its list
+/// </summary>
+bool checkLightCulling() {
+	const int SCREEN_WIDTH = 960;
+	const int SCREEN_HEIGHT = 540;
+	const int TILE_SIZE = 16;
+	const int MAX_LIGHTS_PER_TILE = 1024;
+	const int NUM_CONFIGS = 4;
+	int lightCounts[] = { 256, 1024 };
+	srand(1234);
+
+	bool valid = true;
+	for (int numLights : lightCounts) {
+		for (int config = 0; config < NUM_CONFIGS; config++) {
+			std::vector<ew::PointLight> lights(numLights);
+			for (ew::PointLight& light : lights) {
+				light.position = glm::vec3(randomRange(-100, 100), randomRange(-5, 5), randomRange(-100, 100));
+				light.radius = randomRange(1, 15);
+				light.color = glm::vec4(1);
+			}
+			ew::Camera camera;
+			camera.position = glm::vec3(randomRange(-50, 50), randomRange(1, 30), randomRange(-50, 50));
+			camera.target = glm::vec3(randomRange(-50, 50), 0, randomRange(-50, 50));
+			camera.fov = randomRange(40, 90);
+			camera.orthographic = config % 4 == 3;
+			camera.orthoHeight = 40.0f;
+			camera.aspectRatio = (float)SCREEN_WIDTH / SCREEN_HEIGHT;
+			ew::LightGrid grid;
+			ew::cullLightsTiled(lights.data(), numLights, camera, SCREEN_WIDTH, SCREEN_HEIGHT, TILE_SIZE, MAX_LIGHTS_PER_TILE, &grid);
+
+			glm::mat4 view = camera.viewMatrix();
+			glm::mat4 inverseProjection = glm::inverse(camera.projectionMatrix());
+			std::vector<glm::vec3> viewCenters(numLights);
+			for (int i = 0; i < numLights; i++) {
+				viewCenters[i] = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+			}
+			std::vector<int> listedInTile(numLights, -1);
+			for (int y = 0; y < grid.tilesY; y++) {
+				for (int x = 0; x < grid.tilesX; x++) {
+					ew::TileFrustum frustum = ew::computeTileFrustum(inverseProjection, SCREEN_WIDTH, SCREEN_HEIGHT, TILE_SIZE, x, y);
+					std::vector<unsigned int> expected;
+					for (int i = 0; i < numLights && (int)expected.size() < MAX_LIGHTS_PER_TILE; i++) {
+						if (ew::sphereIntersectsTile(frustum, viewCenters[i], lights[i].radius)) {
+							expected.push_back(i);
+						}
+					}
+					int tile = y * grid.tilesX + x;
+					const unsigned int* actual = &grid.lightIndices[tile * MAX_LIGHTS_PER_TILE];
+					valid &= expected.size() == grid.lightCounts[tile];
+					for (size_t i = 0; valid && i < expected.size(); i++) {
+						valid &= expected[i] == actual[i];
+					}
+
+					//Independent of the tile planes. Extras are lights near tile corners that the plane test can't reject,
+					//so only misses fail
+					for (unsigned int i = 0; i < grid.lightCounts[tile]; i++) {
+						listedInTile[actual[i]] = tile;
+					}
+					float x0, x1, y0, y1;
+					tileRange(x, TILE_SIZE, SCREEN_WIDTH, &x0, &x1);
+					tileRange(y, TILE_SIZE, SCREEN_HEIGHT, &y0, &y1);
+					bool full = grid.lightCounts[tile] == MAX_LIGHTS_PER_TILE;
+					for (int i = 0; i < numLights; i++) {
+						int reach = classifyLight(camera, x0, x1, y0, y1, viewCenters[i], lights[i].radius);
+						valid &= reach != 1 || listedInTile[i] == tile || full;
+					}
+				}
+			}
+		}
+	}
+	return valid;
+}
+
+static double angleDegrees(const glm::vec3& a, const glm::vec3& b) {
+	//atan2 of cross and dot in double, acos of a float dot can't resolve the tiny errors of RG16
+	double cx = (double)a.y * b.z - (double)a.z * b.y;
+	double cy = (double)a.z * b.x - (double)a.x * b.z;
+	double cz = (double)a.x * b.y - (double)a.y * b.x;
+	double cosine = (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z;
+	return atan2(sqrt(cx * cx + cy * cy + cz * cz), cosine) * 180.0 / 3.14159265358979;
+}
+
+/// <summary>
+/// Round trips normals through octahedral encoding unquantized and at RG16/RG8, bounding the angular error per bit depth.
+/// Covers random directions plus the axes and octant diagonals, where the fold is most likely to go wrong.
+/// Then checks ew::VertexFormat::PACKED against its error bounds: half a 16 bit step of the AABB per position axis,
+/// half a 10 bit step per normal component and half a half float ulp (2^-11 relative) per uv
+/// </summary>
+bool checkPacking() {
+	const int NUM_NORMALS = 200000;
+	srand(1234);
+	std::vector<glm::vec3> normals;
+	for (int x = -1; x <= 1; x++) {
+		for (int y = -1; y <= 1; y++) {
+			for (int z = -1; z <= 1; z++) {
+				if (x != 0 || y != 0 || z != 0) {
+					normals.push_back(glm::normalize(glm::vec3(x, y, z)));
+				}
+			}
+		}
+	}
+	while ((int)normals.size() < NUM_NORMALS) {
+		glm::vec3 n = glm::vec3(randomRange(-1, 1), randomRange(-1, 1), randomRange(-1, 1));
+		float length = glm::length(n);
+		if (length > 0.001f && length <= 1.0f) {
+			normals.push_back(n / length);
+		}
+	}
+
+	bool valid = true;
+	//0 bits = unquantized float. The worst quantized cases measure just under 3 * sqrt(2) half steps of the snorm grid
+	int bitCounts[] = { 0, 16, 8 };
+	for (int bits : bitCounts) {
+		double halfStep = bits == 0 ? 0.0 : 0.5 / ((1 << (bits - 1)) - 1) * 180.0 / 3.14159265358979;
+		double bound = bits == 0 ? 1e-3 : halfStep * 4.5;
+		for (const glm::vec3& n : normals) {
+			glm::vec2 e = ew::octEncode(n);
+			if (bits > 0) {
+				e = glm::vec2(ew::quantizeSnorm(e.x, bits), ew::quantizeSnorm(e.y, bits));
+			}
+			valid &= angleDegrees(n, ew::octDecode(e)) <= bound;
+		}
+	}
+
+	std::vector<ew::Vertex> vertices(normals.size());
+	for (size_t i = 0; i < vertices.size(); i++) {
+		vertices[i].pos = glm::vec3(randomRange(-3, 5), randomRange(0, 0.01f), randomRange(-100, 20));
+		vertices[i].normal = normals[i];
+		vertices[i].uv = glm::vec2(randomRange(-8, 8), randomRange(0, 1));
+	}
+	ew::AABB bounds = ew::computeAABB(vertices.data(), (int)vertices.size());
+	glm::vec3 positionBound = (bounds.max - bounds.min) * (0.5f / 65535.0f);
+	for (const ew::Vertex& v : vertices) {
+		ew::Vertex unpacked = ew::unpackVertex(ew::packVertex(v, bounds), bounds);
+		for (int i = 0; i < 3; i++) {
+			//Tolerance for float rounding in the dequantize multiply-add
+			valid &= fabsf(unpacked.pos[i] - v.pos[i]) <= positionBound[i] * 1.01f + 1e-6f;
+			valid &= fabsf(unpacked.normal[i] - v.normal[i]) <= 0.5f / 511.0f + 1e-6f;
+		}
+		for (int i = 0; i < 2; i++) {
+			valid &= fabsf(unpacked.uv[i] - v.uv[i]) <= glm::max(fabsf(v.uv[i]) * (1.0f / 2048.0f), 1.0f / 16777216.0f);
+		}
+	}
+
+	//Exact half float cases: powers of two, the largest half, subnormals and overflow
+	const float exactHalves[] = { 0.0f, 1.0f, -2.0f, 0.5f, 65504.0f, 6.103515625e-05f, 5.9604644775390625e-08f };
+	for (float h : exactHalves) {
+		valid &= ew::unpackHalf(ew::packHalf(h)) == h;
+	}
+	valid &= ew::packHalf(1e6f) == 0x7C00;
+	return valid;
+}
+
+/// <summary>
+/// Generates LOD chains for procedural meshes and checks each level's reported error against a brute force measurement.
+/// The reported error is an upper bound, so it must never be below the measured one
+/// </summary>
+bool checkLodErrors() {
+	ew::MeshData meshes[] = { ew::createSphere(1.0f, 64), ew::createCylinder(1.0f, 2.0f, 64), ew::createPlane(10.0f, 10.0f, 64) };
+	bool valid = true;
+	for (ew::MeshData& meshData : meshes) {
+		ew::optimizeMesh(meshData);
+		ew::generateLods(meshData);
+		valid &= !meshData.lods.empty();
+		for (const ew::MeshLod& lod : meshData.lods) {
+			float measured = ew::measureSimplificationError(meshData.vertices.data(), meshData.indices.data(), meshData.lods[0].numIndices,
+				meshData.indices.data() + lod.firstIndex, lod.numIndices);
+			valid &= lod.error >= measured * 0.999f;
+		}
+	}
+	return valid;
+}
+
+/// <summary>
+/// Culls random instances of mesh types with up to 4 LODs with ew::cullInstances, with and without the frustum and LOD selection,
+/// and checks the commands and instance ids against a per-instance reference built on ew::frustumIntersectsSphere:
+/// every command of a bin draws the bin's visible instances in instance order, with bins laid out one after another
+/// </summary>
+bool checkInstanceCulling() {
+	const int NUM_INSTANCES = 20000;
+	const int NUM_MESH_TYPES = 16;
+	srand(1234);
+	ew::CullScene scene;
+	for (int type = 0; type < NUM_MESH_TYPES; type++) {
+		float errors[ew::MAX_CULL_LODS] = { 0.0f, 0.01f, 0.04f, 0.16f };
+		unsigned int meshType = scene.addMeshType(errors, 1 + type % ew::MAX_CULL_LODS, randomRange(0.5f, 2.0f));
+		for (int lod = 0; lod < scene.meshTypes[meshType].numLods; lod++) {
+			for (int mesh = 0; mesh < 2; mesh++) {
+				scene.addCommand({ 3u * (1000 >> lod), 0, (unsigned int)(type * 10000 + lod * 1000 + mesh), 0, 0 }, meshType, lod);
+			}
+		}
+	}
+	for (int i = 0; i < NUM_INSTANCES; i++) {
+		ew::BoundingSphere sphere;
+		sphere.center = glm::vec3(randomRange(-200, 200), randomRange(-20, 20), randomRange(-200, 200));
+		sphere.radius = scene.meshTypes[i % NUM_MESH_TYPES].radius * randomRange(0.5f, 3.0f);
+		scene.addInstance(rand() % NUM_MESH_TYPES, sphere);
+	}
+	ew::Camera camera;
+	camera.position = glm::vec3(0, 10, 0);
+	camera.target = glm::vec3(50, 0, 50);
+	camera.aspectRatio = 16.0f / 9.0f;
+	ew::Frustum frustum = ew::extractFrustum(camera.projectionMatrix() * camera.viewMatrix());
+	ew::LodSelector lodSelector = ew::createLodSelector(camera, 1080.0f);
+
+	bool valid = true;
+	for (int mode = 0; mode < 4; mode++) {
+		const ew::Frustum* modeFrustum = mode & 1 ? &frustum : nullptr;
+		const ew::LodSelector* modeSelector = mode & 2 ? &lodSelector : nullptr;
+		std::vector<std::vector<unsigned int>> binInstances(scene.getNumBins());
+		for (int i = 0; i < NUM_INSTANCES; i++) {
+			const ew::CullInstance& instance = scene.instances[i];
+			ew::BoundingSphere bounds = { glm::vec3(instance.sphere), instance.sphere.w };
+			if (modeFrustum != nullptr && !ew::frustumIntersectsSphere(frustum, bounds.center, bounds.radius)) {
+				continue;
+			}
+			//Coarsest LOD whose object space error fits the budget
+			const ew::CullMeshType& meshType = scene.meshTypes[instance.meshType];
+			int lod = 0;
+			if (modeSelector != nullptr) {
+				float maxError = ew::getMaxLodError(lodSelector, bounds) / (bounds.radius / meshType.radius);
+				while (lod + 1 < meshType.numLods && meshType.lodErrors[lod + 1] <= maxError) {
+					lod++;
+				}
+			}
+			binInstances[instance.meshType * ew::MAX_CULL_LODS + lod].push_back(i);
+		}
+		std::vector<unsigned int> expectedIds;
+		std::vector<unsigned int> binOffsets;
+		for (const std::vector<unsigned int>& instances : binInstances) {
+			binOffsets.push_back(expectedIds.size());
+			expectedIds.insert(expectedIds.end(), instances.begin(), instances.end());
+		}
+
+		ew::CullResult result;
+		ew::cullInstances(scene, modeFrustum, modeSelector, &result);
+		valid &= result.numVisible == (int)expectedIds.size() && result.instanceIds == expectedIds;
+		valid &= result.commands.size() == scene.commands.size();
+		for (size_t c = 0; valid && c < scene.commands.size(); c++) {
+			unsigned int bin = scene.commandBins[c];
+			const ew::DrawElementsIndirectCommand& command = result.commands[c];
+			valid &= command.instanceCount == binInstances[bin].size() && command.baseInstance == binOffsets[bin];
+			valid &= command.count == scene.commands[c].count && command.firstIndex == scene.commands[c].firstIndex
+				&& command.baseVertex == scene.commands[c].baseVertex;
+		}
+	}
+	return valid;
+}
+
+/// <summary>
+/// Checks the software rasterizer's coverage and depth on screen aligned and sloped quads, that every Hi-Z texel is the farthest
+/// of the depth pixels it covers (clamped on odd sized levels, the way ew::isOccluded reads them), and that every sphere
+/// of a 64x64 grid that isOccluded rejects is behind other spheres at every pixel it would have drawn
+/// </summary>
+bool checkHiZOcclusion() {
+	const int WIDTH = 512;
+	const int HEIGHT = 288;
+	const int GRID_SIZE = 64;
+	bool valid = true;
+
+	//Identity transform, so vertices are NDC. The sloped quad's NDC depth equals its NDC x
+	float slopes[] = { 0.0f, 1.0f };
+	for (float slope : slopes) {
+		ew::Vertex quad[4];
+		glm::vec2 corners[4] = { glm::vec2(-0.5f, -0.5f), glm::vec2(0.5f, -0.5f), glm::vec2(0.5f, 0.5f), glm::vec2(-0.5f, 0.5f) };
+		for (int i = 0; i < 4; i++) {
+			quad[i].pos = glm::vec3(corners[i], corners[i].x * slope);
+		}
+		unsigned int indices[6] = { 0, 1, 2, 2, 3, 0 };
+		ew::DepthBuffer depthBuffer;
+		ew::clearDepthBuffer(&depthBuffer, WIDTH, HEIGHT);
+		ew::rasterizeDepth(&depthBuffer, glm::mat4(1.0f), quad, indices, 6);
+		for (int y = 0; y < HEIGHT; y++) {
+			for (int x = 0; x < WIDTH; x++) {
+				float px = x + 0.5f;
+				float py = y + 0.5f;
+				bool inside = px >= WIDTH * 0.25f && px <= WIDTH * 0.75f && py >= HEIGHT * 0.25f && py <= HEIGHT * 0.75f;
+				float ndcX = px / WIDTH * 2.0f - 1.0f;
+				float expected = inside ? ndcX * slope * 0.5f + 0.5f : 1.0f;
+				valid &= fabsf(depthBuffer.depth[y * WIDTH + x] - expected) <= 1e-5f;
+			}
+		}
+	}
+
+	ew::MeshData sphere = ew::createSphere(1.0f, 8);
+	std::vector<glm::mat4> transforms;
+	for (int z = 0; z < GRID_SIZE; z++) {
+		for (int x = 0; x < GRID_SIZE; x++) {
+			float scale = 0.6f + 0.4f * ((x * 7 + z * 13) % 5) / 4.0f;
+			glm::mat4 transform = glm::mat4(scale);
+			transform[3] = glm::vec4((x - GRID_SIZE / 2) * 3.0f, scale, z * 3.0f, 1.0f);
+			transforms.push_back(transform);
+		}
+	}
+	ew::Camera camera;
+	camera.position = glm::vec3(0, 1.5f, -6.0f);
+	camera.target = glm::vec3(0, 1.0f, 50.0f);
+	camera.aspectRatio = (float)WIDTH / HEIGHT;
+	glm::mat4 viewProjection = camera.projectionMatrix() * camera.viewMatrix();
+	ew::DepthBuffer depthBuffer;
+	ew::clearDepthBuffer(&depthBuffer, WIDTH, HEIGHT);
+	for (const glm::mat4& transform : transforms) {
+		ew::rasterizeDepth(&depthBuffer, viewProjection * transform, sphere.vertices.data(), sphere.indices.data(), sphere.indices.size());
+	}
+	ew::HiZPyramid pyramid;
+	ew::buildHiZ(depthBuffer.depth.data(), WIDTH, HEIGHT, viewProjection, &pyramid);
+
+	//Random depth with odd sizes, where most levels fold in a leftover row or column
+	const int RANDOM_WIDTH = 301;
+	const int RANDOM_HEIGHT = 173;
+	srand(1234);
+	std::vector<float> randomDepth(RANDOM_WIDTH * RANDOM_HEIGHT);
+	for (float& depth : randomDepth) {
+		depth = randomRange(0, 1);
+	}
+	ew::HiZPyramid randomPyramid;
+	ew::buildHiZ(randomDepth.data(), RANDOM_WIDTH, RANDOM_HEIGHT, viewProjection, &randomPyramid);
+	valid &= randomPyramid.getNumLevels() == ew::getHiZLevels(RANDOM_WIDTH, RANDOM_HEIGHT);
+	for (int level = 0; valid && level < randomPyramid.getNumLevels(); level++) {
+		glm::ivec2 size = randomPyramid.sizes[level];
+		valid &= size == glm::max(glm::ivec2(RANDOM_WIDTH >> level, RANDOM_HEIGHT >> level), glm::ivec2(1));
+		std::vector<float> farthest(size.x * size.y, 0.0f);
+		for (int y = 0; y < RANDOM_HEIGHT; y++) {
+			for (int x = 0; x < RANDOM_WIDTH; x++) {
+				float& texel = farthest[glm::min(y >> level, size.y - 1) * size.x + glm::min(x >> level, size.x - 1)];
+				texel = glm::max(texel, randomDepth[y * RANDOM_WIDTH + x]);
+			}
+		}
+		valid &= randomPyramid.levels[level] == farthest;
+	}
+
+	//An occluded sphere is behind its own box's nearest depth, which is behind everything drawn over the box
+	int numOccluded = 0;
+	ew::DepthBuffer alone;
+	for (const glm::mat4& transform : transforms) {
+		float radius = transform[0][0];
+		glm::vec3 center = glm::vec3(transform[3]);
+		if (!ew::isOccluded(pyramid, ew::AABB{ center - radius, center + radius })) {
+			continue;
+		}
+		numOccluded++;
+		ew::clearDepthBuffer(&alone, WIDTH, HEIGHT);
+		ew::rasterizeDepth(&alone, viewProjection * transform, sphere.vertices.data(), sphere.indices.data(), sphere.indices.size());
+		for (int i = 0; i < WIDTH * HEIGHT; i++) {
+			valid &= alone.depth[i] == 1.0f || depthBuffer.depth[i] < alone.depth[i];
+		}
+	}
+	return valid && numOccluded > 0;
+}
+
+//Peak signal to noise ratio over the first numChannels channels, like textureBaker reports
+static double computePSNR(const ew::Image& a, const ew::Image& b, int numChannels) {
+	double squaredError = 0.0;
+	size_t numPixels = (size_t)a.width * a.height;
+	for (size_t i = 0; i < numPixels; i++) {
+		for (int c = 0; c < numChannels; c++) {
+			double d = (double)a.pixels[i * 4 + c] - b.pixels[i * 4 + c];
+			squaredError += d * d;
+		}
+	}
+	double meanSquaredError = squaredError / (numPixels * numChannels);
+	return meanSquaredError == 0.0 ? INFINITY : 10.0 * log10(255.0 * 255.0 / meanSquaredError);
+}
+
+/// <summary>
+/// Encodes a gradient with noise on top, sized so the edge blocks are partial, to BC1, BC5 and BC7 with mips and decodes every level.
+/// Full resolution must reach a PSNR floor for the format over the channels it stores, about half a dB under what the encoders reach.
+/// Coarse mips aren't held to it: their blocks span most of the gradient, whose channels run in different directions
+/// </summary>
+bool checkTextureCompression() {
+	const int WIDTH = 130;
+	const int HEIGHT = 70;
+	srand(1234);
+	ew::Image image;
+	image.width = WIDTH;
+	image.height = HEIGHT;
+	image.pixels.resize(WIDTH * HEIGHT * 4);
+	for (int y = 0; y < HEIGHT; y++) {
+		for (int x = 0; x < WIDTH; x++) {
+			float gradients[4] = { (float)x / WIDTH, (float)y / HEIGHT, (float)(x + y) / (WIDTH + HEIGHT), 1.0f - (float)x / WIDTH };
+			for (int c = 0; c < 4; c++) {
+				float value = gradients[c] * 255.0f + randomRange(-4, 4);
+				image.pixels[(y * WIDTH + x) * 4 + c] = (unsigned char)glm::clamp(value + 0.5f, 0.0f, 255.0f);
+			}
+		}
+	}
+	struct FormatFloor {
+		ew::TextureCompression format;
+		int numChannels;
+		double minPSNR;
+	};
+	FormatFloor floors[] = { { ew::TextureCompression::BC1, 3, 38.5 }, { ew::TextureCompression::BC5, 2, 52.0 }, { ew::TextureCompression::BC7, 4, 40.0 } };
+	std::vector<ew::Image> sourceLevels = ew::buildMipChain(image);
+	bool valid = true;
+	for (const FormatFloor& floor : floors) {
+		ew::CompressedTexture texture = ew::compressTexture(image, floor.format, true);
+		valid &= texture.levels.size() == sourceLevels.size();
+		for (size_t i = 0; valid && i < sourceLevels.size(); i++) {
+			ew::Image decoded = ew::decompressLevel(texture.levels[i], floor.format);
+			valid &= decoded.width == sourceLevels[i].width && decoded.height == sourceLevels[i].height;
+			if (valid && i == 0) {
+				valid = computePSNR(sourceLevels[i], decoded, floor.numChannels) >= floor.minPSNR;
+			}
+		}
+	}
+	return valid;
+}
+
+/// <summary>
+/// Writes a mip chain to an .ewtex file and reads it back, then checks files whose sizes are valid for their levels' dimensions
+/// but whose dimensions aren't a mip chain, or are zero, get rejected
+/// </summary>
+bool checkTextureFile() {
+	const char* path = "coreChecks.ewtex";
+	ew::Image image;
+	image.width = 40;
+	image.height = 12;
+	image.pixels.assign(image.width * image.height * 4, 128);
+	ew::CompressedTexture texture = ew::compressTexture(image, ew::TextureCompression::BC1, true);
+	ew::CompressedTexture read;
+	bool valid = ew::writeCompressedTexture(path, texture) && ew::readCompressedTexture(path, &read)
+		&& read.format == texture.format && read.levels.size() == texture.levels.size();
+	for (size_t i = 0; valid && i < read.levels.size(); i++) {
+		valid = read.levels[i].width == texture.levels[i].width && read.levels[i].height == texture.levels[i].height
+			&& read.levels[i].data == texture.levels[i].data;
+	}
+
+	//Level 1 rounded up instead of down, a level past 1x1, and an empty top level
+	ew::CompressedTexture invalid[3] = { texture, texture, texture };
+	invalid[0].levels[1].width = 21;
+	invalid[1].levels.push_back(invalid[1].levels.back());
+	invalid[2].levels.resize(1);
+	invalid[2].levels[0].width = 0;
+	for (ew::CompressedTexture& bad : invalid) {
+		for (ew::CompressedLevel& level : bad.levels) {
+			level.data.resize(ew::getCompressedSize(bad.format, level.width, level.height));
+		}
+		valid &= ew::writeCompressedTexture(path, bad) && !ew::readCompressedTexture(path, &read);
+	}
+	remove(path);
+	return valid;
+}
+
+/// <summary>
+/// Checks neighbouring terrain tiles generate byte identical vertices along their shared edges, on both axes and across zero,
+/// and that every LOD's range of the shared index buffer only references the tile's vertices, for every tile size 16 bit indices allow
+/// </summary>
+bool checkTerrainTiles() {
+	ew::NoiseSettings noise;
+	noise.amplitude = 20.0f;
+	ew::TerrainSettings settings;
+	settings.height = ew::createNoiseHeightFunction(noise);
+	int quads = settings.tileQuads;
+	int columns = quads + 1;
+	bool valid = true;
+	glm::ivec2 coords[] = { glm::ivec2(3, -7), glm::ivec2(-1, -1) };
+	for (glm::ivec2 coord : coords) {
+		ew::TerrainTileData tile, right, above;
+		ew::generateTerrainTile(settings, coord, &tile);
+		ew::generateTerrainTile(settings, coord + glm::ivec2(1, 0), &right);
+		ew::generateTerrainTile(settings, coord + glm::ivec2(0, 1), &above);
+		for (int k = 0; k < columns; k++) {
+			valid &= memcmp(&tile.vertices[k * columns + quads], &right.vertices[k * columns], sizeof(ew::Vertex)) == 0;
+			valid &= memcmp(&tile.vertices[quads * columns + k], &above.vertices[k], sizeof(ew::Vertex)) == 0;
+		}
+	}
+
+	std::vector<unsigned short> indices;
+	std::vector<unsigned int> lodOffsets;
+	for (int tileQuads = 1; tileQuads <= 128; tileQuads *= 2) {
+		unsigned int numVertices = ew::getTerrainTileVertexCount(tileQuads);
+		//Terrain clamps numLods so the coarsest LOD still has one quad
+		for (int numLods = 1; numLods <= ew::MAX_TERRAIN_LODS && (1 << (numLods - 1)) <= tileQuads; numLods++) {
+			ew::generateTerrainIndices(tileQuads, numLods, &indices, &lodOffsets);
+			valid &= (int)lodOffsets.size() == numLods + 1 && lodOffsets[0] == 0 && lodOffsets.back() == indices.size();
+			for (int lod = 0; valid && lod < numLods; lod++) {
+				valid &= lodOffsets[lod + 1] > lodOffsets[lod] && (lodOffsets[lod + 1] - lodOffsets[lod]) % 3 == 0;
+				for (unsigned int i = lodOffsets[lod]; valid && i < lodOffsets[lod + 1]; i++) {
+					valid &= indices[i] < numVertices;
+				}
+			}
+		}
+	}
+	return valid;
+}
+
+struct Check {
+	const char* name;
+	bool (*run)();
+};
+
+Check checks[] = {
+	{ "rangeAllocator", checkRangeAllocator },
+	{ "lightCulling", checkLightCulling },
+	{ "packing", checkPacking },
+	{ "lodErrors", checkLodErrors },
+	{ "instanceCulling", checkInstanceCulling },
+	{ "hiZOcclusion", checkHiZOcclusion },
+	{ "textureCompression", checkTextureCompression },
+	{ "textureFile", checkTextureFile },
+	{ "terrainTiles", checkTerrainTiles },
+};
+
+//Usage: coreChecks [name...]
+//Correctness checks for core code that runs without a GL context. Runs every check when no names are given.
+//Exits with 1 if any fail, so ctest catches them. coreBenchmarks only checks GPU output against these CPU paths.
+int main(int argc, char** argv) {
+	int numFailed = 0;
+	for (const Check& check : checks) {
+		bool selected = argc <= 1;
+		for (int i = 1; i < argc; i++) {
+			selected |= strcmp(argv[i], check.name) == 0;
+		}
+		if (selected) {
+			bool passed = check.run();
+			printf("[%s] %s\n", check.name, passed ? "passed" : "FAILED");
+			numFailed += passed ? 0 : 1;
+		}
+	}
+	return numFailed > 0 ? 1 : 0;
+}
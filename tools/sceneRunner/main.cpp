@@ -0,0 +1,373 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+//Before glad, whose bundled khrplatform.h lacks what egl.h needs
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "scene.h"
+
+//Fixed step between frames, so every run sees the same camera positions and moving monkey
+const float FRAME_TIME = 1.0f / 60.0f;
+
+struct CameraKey {
+	float time;
+	glm::vec3 position;
+	glm::vec3 target;
+};
+
+//Overview, a dive into the grid, a walk down one row, a turn, and back up. Loops every 10 seconds
+const CameraKey CAMERA_PATH[] = {
+	{ 0.0f, glm::vec3(0.0f, 30.0f, 60.0f), glm::vec3(0.0f, 0.0f, 0.0f) },
+	{ 3.0f, glm::vec3(0.0f, 4.0f, 20.0f), glm::vec3(0.0f, 0.0f, 0.0f) },
+	{ 5.0f, glm::vec3(11.25f, 2.0f, 6.0f), glm::vec3(11.25f, 0.0f, -20.0f) },
+	{ 7.0f, glm::vec3(11.25f, 2.0f, -18.0f), glm::vec3(-10.0f, 0.0f, -30.0f) },
+	{ 9.0f, glm::vec3(-20.0f, 10.0f, -10.0f), glm::vec3(0.0f, 0.0f, 0.0f) },
+	{ 10.0f, glm::vec3(0.0f, 30.0f, 60.0f), glm::vec3(0.0f, 0.0f, 0.0f) },
+};
+
+/// <summary>
+/// Eases between the keys around time, so the camera settles briefly on each one
+/// </summary>
+void moveCamera(ew::Camera* camera, float time) {
+	const int numKeys = sizeof(CAMERA_PATH) / sizeof(CAMERA_PATH[0]);
+	time = fmodf(time, CAMERA_PATH[numKeys - 1].time);
+	int key = 0;
+	while (key < numKeys - 2 && CAMERA_PATH[key + 1].time <= time) {
+		key++;
+	}
+	const CameraKey& a = CAMERA_PATH[key];
+	const CameraKey& b = CAMERA_PATH[key + 1];
+	float t = (time - a.time) / (b.time - a.time);
+	t = t * t * (3.0f - 2.0f * t);
+	camera->position = glm::mix(a.position, b.position, t);
+	camera->target = glm::mix(a.target, b.target, t);
+}
+
+/// <summary>
+/// A GL 4.5 core context with no surface, on the Mesa surfaceless platform when it's there
+/// </summary>
+bool createHeadlessContext() {
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	EGLDisplay display = EGL_NO_DISPLAY;
+	if (getPlatformDisplay != NULL) {
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+		printf("EGL failed to init!\n");
+		return false;
+	}
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		printf("EGL has no desktop OpenGL\n");
+		return false;
+	}
+	//Everything renders into framebuffer objects, so the context needs no config (EGL_KHR_no_config_context)
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+		printf("EGL failed to create a surfaceless GL 4.5 context: 0x%x\n", eglGetError());
+		return false;
+	}
+	if (!gladLoadGL((GLADloadfunc)eglGetProcAddress)) {
+		printf("GLAD Failed to load GL headers\n");
+		return false;
+	}
+	return true;
+}
+
+struct TimingStats {
+	int count; //Frames with a time
+	double mean, min, p50, p90, p95, p99, max;
+};
+
+/// <summary>
+/// Nearest rank percentiles, so every value is one a frame actually took
+/// </summary>
+TimingStats computeStats(std::vector<double> values) {
+	TimingStats stats = {};
+	stats.count = (int)values.size();
+	if (values.empty()) {
+		return stats;
+	}
+	std::sort(values.begin(), values.end());
+	auto percentile = [&](double p) {
+		size_t rank = (size_t)ceil(p / 100.0 * values.size());
+		return values[std::max(rank, (size_t)1) - 1];
+	};
+	for (double value : values) {
+		stats.mean += value / values.size();
+	}
+	stats.min = values.front();
+	stats.p50 = percentile(50);
+	stats.p90 = percentile(90);
+	stats.p95 = percentile(95);
+	stats.p99 = percentile(99);
+	stats.max = values.back();
+	return stats;
+}
+
+void printStats(const char* name, const TimingStats& stats) {
+	printf("%-20s %8d %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n", name, stats.count, stats.mean, stats.min, stats.p50, stats.p90, stats.p95, stats.p99, stats.max);
+}
+
+void writeStats(FILE* file, const char* name, const TimingStats& stats, bool last) {
+	fprintf(file, "\t\t");
+	ew::writeJsonString(file, name);
+	fprintf(file, ": { \"frames\": %d, \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+		stats.count, stats.mean, stats.min, stats.p50, stats.p90, stats.p95, stats.p99, stats.max, last ? "" : ",");
+}
+
+//Milliseconds per measured frame. GPU times stay negative until the profiler resolves their frame
+struct FrameTimings {
+	double cpu = 0.0; //update and render, recording commands
+	double frame = 0.0; //Including waiting for the GPU to finish
+	double gpu = -1.0;
+	std::vector<double> scopes; //Indexed like scopeNames, scopes sharing a name add up. Negative for scopes that didn't run
+};
+
+//Usage: sceneRunner [--frames N] [--warmup N] [--width W] [--height H] [--csv path] [--json path]
+//                   [--lights N] [--lighting 0-3] [--terrain] [--moving-monkey] [--no-shadow-cache] [--gpu-culling]
+//Flies a fixed camera path through the assignment3 scene offscreen and writes per frame timings to the CSV,
+//percentiles of them to the JSON. Run from the directory holding assignment3's assets.
+int main(int argc, char** argv) {
+	int numFrames = 600;
+	int numWarmupFrames = 60;
+	const char* csvPath = "sceneTimings.csv";
+	const char* jsonPath = "sceneTimings.json";
+	screenWidth = 1280;
+	screenHeight = 720;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--frames") == 0 && hasValue) {
+			numFrames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--warmup") == 0 && hasValue) {
+			numWarmupFrames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--width") == 0 && hasValue) {
+			screenWidth = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--height") == 0 && hasValue) {
+			screenHeight = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--csv") == 0 && hasValue) {
+			csvPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--json") == 0 && hasValue) {
+			jsonPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--lights") == 0 && hasValue) {
+			numPointLights = glm::clamp(atoi(argv[++i]), 0, MAX_POINT_LIGHTS);
+		}
+		else if (strcmp(argv[i], "--lighting") == 0 && hasValue) {
+			lightingMode = glm::clamp(atoi(argv[++i]), 0, NUM_LIGHTING_MODES - 1);
+		}
+		else if (strcmp(argv[i], "--terrain") == 0) {
+			useTerrain = true;
+		}
+		else if (strcmp(argv[i], "--moving-monkey") == 0) {
+			useMovingMonkey = true;
+		}
+		else if (strcmp(argv[i], "--no-shadow-cache") == 0) {
+			useShadowCache = false;
+		}
+		else if (strcmp(argv[i], "--gpu-culling") == 0) {
+			useGpuCulling = true;
+		}
+		else {
+			printf("Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+	if (numFrames < 1 || numWarmupFrames < 0 || screenWidth < 1 || screenHeight < 1) {
+		printf("Need at least one frame and a positive resolution\n");
+		return 1;
+	}
+
+	if (!createHeadlessContext()) {
+		return 1;
+	}
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	printf("%s, %dx%d, %d frames after %d warmup\n", renderer, screenWidth, screenHeight, numFrames, numWarmupFrames);
+	if (!gpuProfiler.create()) {
+		printf("Timer queries are unavailable, only CPU times will be recorded\n");
+	}
+
+	ew::setShaderCompilerThreads((ew::GLProcLoader)eglGetProcAddress, 0xFFFFFFFF);
+	ew::ShaderBatch shaderBatch;
+	addSceneShaders(shaderBatch);
+	shaderBatch.submit();
+	Scene scene(shaderBatch);
+	camera.aspectRatio = (float)screenWidth / screenHeight;
+	camera.fov = 60.0f;
+
+	//Stands in for the window. The scene's last pass blurs into it
+	unsigned int outputFramebuffer, outputTexture;
+	glCreateTextures(GL_TEXTURE_2D, 1, &outputTexture);
+	glTextureStorage2D(outputTexture, 1, GL_RGBA8, screenWidth, screenHeight);
+	glCreateFramebuffers(1, &outputFramebuffer);
+	glNamedFramebufferTexture(outputFramebuffer, GL_COLOR_ATTACHMENT0, outputTexture, 0);
+	GLenum fboStatus = glCheckNamedFramebufferStatus(outputFramebuffer, GL_FRAMEBUFFER);
+	if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
+		printf("Output framebuffer incomplete: %d\n", fboStatus);
+		return 1;
+	}
+
+	std::vector<FrameTimings> frames(numFrames);
+	std::vector<const char*> scopeNames;
+	//Copies GPU times out of every profiler frame resolved since the last call. Profiler frames count from 0 with the warmup
+	uint64_t nextResolvedFrame = numWarmupFrames;
+	auto collectGpuTimes = [&]() {
+		for (const ew::GpuFrameTiming& timing : gpuProfiler.getHistory()) {
+			if (timing.frame < nextResolvedFrame || timing.frame >= (uint64_t)(numWarmupFrames + numFrames)) {
+				continue;
+			}
+			nextResolvedFrame = timing.frame + 1;
+			FrameTimings& frame = frames[timing.frame - numWarmupFrames];
+			frame.gpu = timing.getMilliseconds();
+			for (const ew::GpuScopeTiming& scope : timing.scopes) {
+				size_t index = 0;
+				while (index < scopeNames.size() && strcmp(scopeNames[index], scope.name) != 0) {
+					index++;
+				}
+				if (index == scopeNames.size()) {
+					scopeNames.push_back(scope.name);
+				}
+				frame.scopes.resize(scopeNames.size(), -1.0);
+				frame.scopes[index] = std::max(frame.scopes[index], 0.0) + scope.getMilliseconds();
+			}
+		}
+	};
+
+	for (int i = 0; i < numWarmupFrames + numFrames; i++) {
+		float time = i * FRAME_TIME;
+		auto start = std::chrono::high_resolution_clock::now();
+		gpuProfiler.beginFrame();
+		moveCamera(&camera, time);
+		scene.update(time);
+		scene.render(outputFramebuffer);
+		gpuProfiler.endFrame();
+		auto submitted = std::chrono::high_resolution_clock::now();
+		//Stands in for the swap. Every frame is finished before the next starts, so none queue up behind it
+		glFinish();
+		auto finished = std::chrono::high_resolution_clock::now();
+		collectGpuTimes();
+		if (i >= numWarmupFrames) {
+			FrameTimings& frame = frames[i - numWarmupFrames];
+			frame.cpu = std::chrono::duration<double, std::milli>(submitted - start).count();
+			frame.frame = std::chrono::duration<double, std::milli>(finished - start).count();
+		}
+	}
+	//Everything has finished, one more frame reads back the rest
+	gpuProfiler.beginFrame();
+	collectGpuTimes();
+	gpuProfiler.endFrame();
+
+	std::vector<double> cpuTimes, frameTimes, gpuTimes;
+	//Only frames a scope ran in count toward its stats, passes that were switched off don't pull them toward 0
+	std::vector<std::vector<double>> scopeTimes(scopeNames.size());
+	for (FrameTimings& frame : frames) {
+		cpuTimes.push_back(frame.cpu);
+		frameTimes.push_back(frame.frame);
+		frame.scopes.resize(scopeNames.size(), -1.0);
+		if (frame.gpu >= 0.0) {
+			gpuTimes.push_back(frame.gpu);
+			for (size_t i = 0; i < scopeNames.size(); i++) {
+				if (frame.scopes[i] >= 0.0) {
+					scopeTimes[i].push_back(frame.scopes[i]);
+				}
+			}
+		}
+	}
+
+	FILE* csv = fopen(csvPath, "w");
+	if (csv == NULL) {
+		printf("Failed to open %s\n", csvPath);
+		return 1;
+	}
+	fprintf(csv, "frame,cpu_ms,frame_ms,gpu_ms");
+	for (const char* name : scopeNames) {
+		fprintf(csv, ",%s_ms", name);
+	}
+	fprintf(csv, "\n");
+	for (int i = 0; i < numFrames; i++) {
+		const FrameTimings& frame = frames[i];
+		fprintf(csv, "%d,%.4f,%.4f", i, frame.cpu, frame.frame);
+		//Empty GPU cells for frames the profiler never resolved, and for scopes that didn't run
+		if (frame.gpu < 0.0) {
+			fprintf(csv, ",");
+		}
+		else {
+			fprintf(csv, ",%.4f", frame.gpu);
+		}
+		for (double milliseconds : frame.scopes) {
+			if (milliseconds < 0.0) {
+				fprintf(csv, ",");
+			}
+			else {
+				fprintf(csv, ",%.4f", milliseconds);
+			}
+		}
+		fprintf(csv, "\n");
+	}
+	fclose(csv);
+
+	TimingStats cpuStats = computeStats(cpuTimes);
+	TimingStats frameStats = computeStats(frameTimes);
+	TimingStats gpuStats = computeStats(gpuTimes);
+	FILE* json = fopen(jsonPath, "w");
+	if (json == NULL) {
+		printf("Failed to open %s\n", jsonPath);
+		return 1;
+	}
+	fprintf(json, "{\n\t\"settings\": {\n");
+	fprintf(json, "\t\t\"renderer\": ");
+	ew::writeJsonString(json, renderer);
+	fprintf(json, ",\n");
+	fprintf(json, "\t\t\"width\": %d,\n\t\t\"height\": %d,\n", screenWidth, screenHeight);
+	fprintf(json, "\t\t\"frames\": %d,\n\t\t\"warmupFrames\": %d,\n", numFrames, numWarmupFrames);
+	fprintf(json, "\t\t\"pointLights\": %d,\n\t\t\"lightingMode\": ", numPointLights);
+	ew::writeJsonString(json, lightingModeNames[lightingMode]);
+	fprintf(json, ",\n");
+	fprintf(json, "\t\t\"terrain\": %s,\n\t\t\"movingMonkey\": %s,\n", useTerrain ? "true" : "false", useMovingMonkey ? "true" : "false");
+	fprintf(json, "\t\t\"shadowCache\": %s,\n\t\t\"gpuCulling\": %s\n\t},\n", useShadowCache ? "true" : "false", useGpuCulling ? "true" : "false");
+	fprintf(json, "\t\"milliseconds\": {\n");
+	writeStats(json, "cpu", cpuStats, false);
+	writeStats(json, "frame", frameStats, gpuTimes.empty());
+	if (!gpuTimes.empty()) {
+		writeStats(json, "gpu", gpuStats, scopeNames.empty());
+	}
+	for (size_t i = 0; i < scopeNames.size(); i++) {
+		writeStats(json, scopeNames[i], computeStats(scopeTimes[i]), i + 1 == scopeNames.size());
+	}
+	fprintf(json, "\t},\n\t\"gpuFramesResolved\": %d,\n\t\"droppedGpuFrames\": %d\n}\n", (int)gpuTimes.size(), gpuProfiler.getNumDroppedFrames());
+	fclose(json);
+
+	printf("%-20s %8s %8s %8s %8s %8s %8s %8s %8s\n", "ms", "frames", "mean", "min", "p50", "p90", "p95", "p99", "max");
+	printStats("CPU", cpuStats);
+	printStats("Frame", frameStats);
+	if (!gpuTimes.empty()) {
+		printStats("GPU", gpuStats);
+		for (size_t i = 0; i < scopeNames.size(); i++) {
+			std::string name = "  " + std::string(scopeNames[i]);
+			printStats(name.c_str(), computeStats(scopeTimes[i]));
+		}
+	}
+	printf("Wrote %s and %s\n", csvPath, jsonPath);
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include <ew/external/stb_image.h>
+#include <ew/textureCompression.h>
+
+/// <summary>
+/// Peak signal to noise ratio over the channels the format stores
+/// </summary>
+double computePSNR(const ew::Image& a, const ew::Image& b, int numChannels) {
+	double squaredError = 0.0;
+	size_t numPixels = (size_t)a.width * a.height;
+	for (size_t i = 0; i < numPixels; i++) {
+		for (int c = 0; c < numChannels; c++) {
+			double d = (double)a.pixels[i * 4 + c] - b.pixels[i * 4 + c];
+			squaredError += d * d;
+		}
+	}
+	double meanSquaredError = squaredError / (numPixels * numChannels);
+	return meanSquaredError == 0.0 ? INFINITY : 10.0 * log10(255.0 * 255.0 / meanSquaredError);
+}
+
+//Usage: textureBaker <input image> <output.ewtex> [bc1|bc5|bc7] [--no-mips]
+//Reads the output back and decodes it on the CPU to report the error of every level.
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		printf("Usage: textureBaker <input image> <output.ewtex> [bc1|bc5|bc7] [--no-mips]\n");
+		return 1;
+	}
+	ew::TextureCompression format = ew::TextureCompression::BC7;
+	int numChannels = 4;
+	bool mipmap = true;
+	for (int i = 3; i < argc; i++) {
+		if (strcmp(argv[i], "bc1") == 0) {
+			format = ew::TextureCompression::BC1;
+			numChannels = 3;
+		}
+		else if (strcmp(argv[i], "bc5") == 0) {
+			format = ew::TextureCompression::BC5;
+			numChannels = 2;
+		}
+		else if (strcmp(argv[i], "bc7") == 0) {
+			format = ew::TextureCompression::BC7;
+			numChannels = 4;
+		}
+		else if (strcmp(argv[i], "--no-mips") == 0) {
+			mipmap = false;
+		}
+		else {
+			printf("Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	ew::Image image;
+	int numComponents;
+	unsigned char* data = stbi_load(argv[1], &image.width, &image.height, &numComponents, 4);
+	if (data == NULL) {
+		printf("Failed to load image %s\n", argv[1]);
+		return 1;
+	}
+	image.pixels.assign(data, data + (size_t)image.width * image.height * 4);
+	stbi_image_free(data);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	ew::CompressedTexture texture = ew::compressTexture(image, format, mipmap);
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	if (!ew::writeCompressedTexture(argv[2], texture)) {
+		return 1;
+	}
+
+	//Round trip through the file
+	ew::CompressedTexture readBack;
+	if (!ew::readCompressedTexture(argv[2], &readBack)) {
+		return 1;
+	}
+	std::vector<ew::Image> sourceLevels = mipmap ? ew::buildMipChain(image) : std::vector<ew::Image>(1, image);
+	if (readBack.levels.size() != sourceLevels.size()) {
+		printf("Level count mismatch: wrote %d, read %d\n", (int)sourceLevels.size(), (int)readBack.levels.size());
+		return 1;
+	}
+	size_t compressedBytes = 0;
+	size_t uncompressedBytes = 0;
+	for (size_t i = 0; i < readBack.levels.size(); i++) {
+		ew::Image decoded = ew::decompressLevel(readBack.levels[i], readBack.format);
+		printf("Level %2d: %4dx%-4d PSNR %6.2f dB\n", (int)i, decoded.width, decoded.height, computePSNR(sourceLevels[i], decoded, numChannels));
+		compressedBytes += readBack.levels[i].data.size();
+		uncompressedBytes += sourceLevels[i].pixels.size();
+	}
+	printf("%s: %.1f KB -> %.1f KB (%.1fx smaller than RGBA8), encoded in %.2f s\n", argv[2],
+		uncompressedBytes / 1024.0, compressedBytes / 1024.0, (double)uncompressedBytes / compressedBytes, seconds);
+	return 0;
+}